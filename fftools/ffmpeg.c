@@ -3793,6 +3793,26 @@ static int transcode_init(void)
             goto dump_format;
         }
 
+    /* the packets of inputs which are only stream copied are never decoded,
+     * so they may reference memory mapped input without zeroed padding */
+    for (i = 0; i < nb_input_files; i++) {
+        InputFile *ifile = input_files[i];
+        int unpadded = 1;
+
+        for (j = 0; j < ifile->nb_streams; j++)
+            if (input_streams[ifile->ist_index + j]->decoding_needed)
+                unpadded = 0;
+        for (j = 0; j < nb_output_streams; j++) {
+            ost = output_streams[j];
+            if (ost->bsf_ctx &&
+                ost->source_index >= ifile->ist_index &&
+                ost->source_index <  ifile->ist_index + ifile->nb_streams)
+                unpadded = 0;
+        }
+        if (unpadded)
+            ifile->ctx->flags |= AVFMT_FLAG_UNPADDED;
+    }
+
     /*
      * initialize stream copy and subtitle/data streams.
      * Encoded AVFrame based streams will get initialized as follows:
@@ -41,6 +41,7 @@
 #include "libavutil/parseutils.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/threadpool.h"
 
 #define DEFAULT_PASS_LOGFILENAME_PREFIX "ffmpeg2pass"
 
@@ -3219,6 +3220,15 @@ static int opt_filter_complex(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+static int opt_thread_pool(void *optctx, const char *opt, const char *arg)
+{
+    int ret = av_thread_pool_set_size(parse_number_or_die(opt, arg, OPT_INT, INT_MIN, INT_MAX));
+    if (ret < 0)
+        av_log(NULL, AV_LOG_FATAL, "Failed to set up the shared thread pool: %s\n",
+               av_err2str(ret));
+    return ret;
+}
+
 static int opt_filter_complex_script(void *optctx, const char *opt, const char *arg)
 {
     uint8_t *graph_desc = read_file(arg);
@@ -3581,6 +3591,8 @@ const OptionDef options[] = {
         "set stream filtergraph", "filter_graph" },
     { "filter_threads",  HAS_ARG | OPT_INT,                          { &filter_nbthreads },
         "number of non-complex filter threads" },
+    { "thread_pool",     HAS_ARG | OPT_EXPERT,                       { .func_arg = opt_thread_pool },
+        "run slice threading on a shared pool of this many threads", "number" },
     { "filter_script",  HAS_ARG | OPT_STRING | OPT_SPEC | OPT_OUTPUT, { .off = OFFSET(filter_scripts) },
         "read stream filtergraph description from a file", "filename" },
     { "reinit_filter",  HAS_ARG | OPT_INT | OPT_SPEC | OPT_INPUT,    { .off = OFFSET(reinit_filters) },
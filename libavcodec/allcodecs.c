@@ -24,6 +24,9 @@
  * Provide registration of all codecs, parsers and bitstream filters for libavcodec.
  */
 
+#include <stdatomic.h>
+#include <stdint.h>
+
 #include "config.h"
 #include "libavutil/thread.h"
 #include "avcodec.h"
@@ -848,21 +851,42 @@ AVCodec * codec_list[] = {
 #include "libavcodec/codec_list.c"
 #endif
 
-static AVOnce av_codec_static_init = AV_ONCE_INIT;
-static void av_codec_init_static(void)
+/* Per-codec static data is set up the first time a codec is handed out
+ * rather than for all codecs at once, so that looking up a single codec does
+ * not pay for the initialization of every external library wrapper. */
+static atomic_int codec_static_done[FF_ARRAY_ELEMS(codec_list)];
+static AVMutex codec_static_mutex = AV_MUTEX_INITIALIZER;
+
+static const AVCodec *codec_init_static(uintptr_t i)
 {
-    for (int i = 0; codec_list[i]; i++) {
-        if (codec_list[i]->init_static_data)
-            codec_list[i]->init_static_data((AVCodec*)codec_list[i]);
+    AVCodec *c = (AVCodec*)codec_list[i];
+
+    if (c && c->init_static_data &&
+        !atomic_load_explicit(&codec_static_done[i], memory_order_acquire)) {
+        ff_mutex_lock(&codec_static_mutex);
+        if (!atomic_load_explicit(&codec_static_done[i], memory_order_relaxed)) {
+            c->init_static_data(c);
+            atomic_store_explicit(&codec_static_done[i], 1, memory_order_release);
+        }
+        ff_mutex_unlock(&codec_static_mutex);
     }
+    return c;
+}
+
+static const AVCodec *codec_iterate_uninit(uintptr_t *i)
+{
+    const AVCodec *c = codec_list[*i];
+
+    if (c)
+        (*i)++;
+
+    return c;
 }
 
 const AVCodec *av_codec_iterate(void **opaque)
 {
     uintptr_t i = (uintptr_t)*opaque;
-    const AVCodec *c = codec_list[i];
-
-    ff_thread_once(&av_codec_static_init, av_codec_init_static);
+    const AVCodec *c = codec_init_static(i);
 
     if (c)
         *opaque = (void*)(i + 1);
@@ -938,17 +962,20 @@ static int codec_supports_format(const AVCodec * const p, const enum AVPixelForm
 AVCodec *avcodec_find_decoder_by_id_and_fmt(enum AVCodecID id, enum AVPixelFormat fmt)
 {
     const AVCodec *p, *experimental = NULL;
-    void *i = 0;
+    uintptr_t i = 0;
 
     id= remap_deprecated_codec_id(id);
-    while ((p = av_codec_iterate(&i))) {
-        if (av_codec_is_decoder(p) && p->id == id && codec_supports_format(p, fmt)) {
+    while ((p = codec_iterate_uninit(&i))) {
+        if (!av_codec_is_decoder(p) || p->id != id)
+            continue;
+        /* pix_fmts may only be filled in by init_static_data() */
+        codec_init_static(i - 1);
+        if (codec_supports_format(p, fmt)) {
             if (p->capabilities & AV_CODEC_CAP_EXPERIMENTAL && !experimental) {
                 experimental = p;
             } else
                 return (AVCodec *)p;
         }
-        p = p->next;
     }
     return (AVCodec *)experimental;
 }
@@ -956,22 +983,23 @@ AVCodec *avcodec_find_decoder_by_id_and_fmt(enum AVCodecID id, enum AVPixelForma
 static AVCodec *find_codec(enum AVCodecID id, int (*x)(const AVCodec *))
 {
     const AVCodec *p, *experimental = NULL;
-    void *i = 0;
+    uintptr_t i = 0, experimental_idx = 0;
 
     id = remap_deprecated_codec_id(id);
 
-    while ((p = av_codec_iterate(&i))) {
+    while ((p = codec_iterate_uninit(&i))) {
         if (!x(p))
             continue;
         if (p->id == id) {
             if (p->capabilities & AV_CODEC_CAP_EXPERIMENTAL && !experimental) {
-                experimental = p;
+                experimental     = p;
+                experimental_idx = i - 1;
             } else
-                return (AVCodec*)p;
+                return (AVCodec*)codec_init_static(i - 1);
         }
     }
 
-    return (AVCodec*)experimental;
+    return experimental ? (AVCodec*)codec_init_static(experimental_idx) : NULL;
 }
 
 AVCodec *avcodec_find_encoder(enum AVCodecID id)
@@ -986,17 +1014,17 @@ AVCodec *avcodec_find_decoder(enum AVCodecID id)
 
 static AVCodec *find_codec_by_name(const char *name, int (*x)(const AVCodec *))
 {
-    void *i = 0;
+    uintptr_t i = 0;
     const AVCodec *p;
 
     if (!name)
         return NULL;
 
-    while ((p = av_codec_iterate(&i))) {
+    while ((p = codec_iterate_uninit(&i))) {
         if (!x(p))
             continue;
         if (strcmp(name, p->name) == 0)
-            return (AVCodec*)p;
+            return (AVCodec*)codec_init_static(i - 1);
     }
 
     return NULL;
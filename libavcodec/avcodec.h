@@ -2382,6 +2382,17 @@ typedef struct AVCodecContext {
      * - decoding: unused
      */
     int (*get_encode_buffer)(struct AVCodecContext *s, AVPacket *pkt, int flags);
+
+    /**
+     * Priority of the slice threading jobs of this context when they run on
+     * the process-wide thread pool (see av_thread_pool_set_size()). Jobs of
+     * contexts with a higher priority are run first.
+     * Has no effect otherwise.
+     *
+     * - encoding: Set by user.
+     * - decoding: Set by user.
+     */
+    int thread_priority;
 } AVCodecContext;
 
 #if FF_API_CODEC_GET_SET
@@ -46,6 +46,7 @@
 #define MAX_LPC_PRECISION  15
 #define MIN_LPC_SHIFT       0
 #define MAX_LPC_SHIFT      15
+#define MAX_ENCODE_JOBS    32
 
 enum CodingMode {
     CODING_MODE_RICE  = 4,
@@ -92,7 +93,7 @@ typedef struct FlacSubframe {
 } FlacSubframe;
 
 typedef struct FlacFrame {
-    FlacSubframe subframes[FLAC_MAX_CHANNELS];
+    FlacSubframe *subframes;
     int blocksize;
     int bs_code[2];
     uint8_t crc8;
@@ -100,9 +101,22 @@ typedef struct FlacFrame {
     int verbatim_only;
 } FlacFrame;
 
+/**
+ * State for encoding one frame. With slice threading, one job per thread
+ * is run in parallel on consecutive input frames.
+ */
+typedef struct FlacEncodeJob {
+    FlacFrame frame;
+    LPCContext lpc_ctx;
+    PutBitContext pb;
+    AVFrame *input;
+    AVPacket *pkt;
+    uint32_t frame_count;   ///< coded frame number
+    int max_framesize;      ///< verbatim fallback threshold
+} FlacEncodeJob;
+
 typedef struct FlacEncodeContext {
     AVClass *class;
-    PutBitContext pb;
     int channels;
     int samplerate;
     int sr_code[2];
@@ -114,10 +128,8 @@ typedef struct FlacEncodeContext {
     uint32_t frame_count;
     uint64_t sample_count;
     uint8_t md5sum[16];
-    FlacFrame frame;
     CompressionOptions options;
     AVCodecContext *avctx;
-    LPCContext lpc_ctx;
     struct AVMD5 *md5ctx;
     uint8_t *md5_buffer;
     unsigned int md5_buffer_size;
@@ -126,6 +138,13 @@ typedef struct FlacEncodeContext {
 
     int flushed;
     int64_t next_pts;
+
+    FlacEncodeJob *jobs;
+    int nb_jobs;
+    int nb_queued;          ///< input frames waiting to be encoded
+    int nb_encoded;         ///< encoded packets not yet returned
+    int next_output;
+    int last_blocksize;
 } FlacEncodeContext;
 
 
@@ -454,8 +473,24 @@ FF_ENABLE_DEPRECATION_WARNINGS
         }
     }
 
-    ret = ff_lpc_init(&s->lpc_ctx, avctx->frame_size,
-                      s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+    s->nb_jobs = avctx->active_thread_type & FF_THREAD_SLICE ?
+                 av_clip(avctx->thread_count, 1, MAX_ENCODE_JOBS) : 1;
+    s->jobs    = av_calloc(s->nb_jobs, sizeof(*s->jobs));
+    if (!s->jobs)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_jobs; i++) {
+        FlacEncodeJob *job = &s->jobs[i];
+
+        job->frame.subframes = av_calloc(channels, sizeof(*job->frame.subframes));
+        job->input           = av_frame_alloc();
+        job->pkt             = av_packet_alloc();
+        if (!job->frame.subframes || !job->input || !job->pkt)
+            return AVERROR(ENOMEM);
+        ret = ff_lpc_init(&job->lpc_ctx, avctx->frame_size,
+                          s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+        if (ret < 0)
+            return ret;
+    }
 
     ff_bswapdsp_init(&s->bdsp);
     ff_flacdsp_init(&s->flac_dsp, avctx->sample_fmt, channels,
@@ -467,12 +502,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
 }
 
 
-static void init_frame(FlacEncodeContext *s, int nb_samples)
+static void init_frame(FlacEncodeContext *s, FlacFrame *frame, int nb_samples)
 {
     int i, ch;
-    FlacFrame *frame;
-
-    frame = &s->frame;
 
     for (i = 0; i < 16; i++) {
         if (nb_samples == ff_flac_blocksize_table[i]) {
@@ -512,16 +544,15 @@ static void init_frame(FlacEncodeContext *s, int nb_samples)
 /**
  * Copy channel-interleaved input samples into separate subframes.
  */
-static void copy_samples(FlacEncodeContext *s, const void *samples)
+static void copy_samples(FlacEncodeContext *s, FlacFrame *frame,
+                         const void *samples)
 {
     int i, j, ch;
-    FlacFrame *frame;
     int shift = av_get_bytes_per_sample(s->avctx->sample_fmt) * 8 -
                 s->avctx->bits_per_raw_sample;
 
 #define COPY_SAMPLES(bits) do {                                     \
     const int ## bits ## _t *samples0 = samples;                    \
-    frame = &s->frame;                                              \
     for (i = 0, j = 0; i < frame->blocksize; i++)                   \
         for (ch = 0; ch < s->channels; ch++, j++)                   \
             frame->subframes[ch].samples[i] = samples0[j] >> shift; \
@@ -548,8 +579,8 @@ static uint64_t rice_count_exact(const int32_t *res, int n, int k)
 }
 
 
-static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
-                                     int pred_order)
+static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacFrame *frame,
+                                     FlacSubframe *sub, int pred_order)
 {
     int p, porder, psize;
     int i, part_end;
@@ -565,7 +596,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
     if (sub->type == FLAC_SUBFRAME_CONSTANT) {
         count += sub->obits;
     } else if (sub->type == FLAC_SUBFRAME_VERBATIM) {
-        count += s->frame.blocksize * sub->obits;
+        count += frame->blocksize * sub->obits;
     } else {
         /* warm-up samples */
         count += pred_order * sub->obits;
@@ -579,7 +610,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
 
         /* partition order */
         porder = sub->rc.porder;
-        psize  = s->frame.blocksize >> porder;
+        psize  = frame->blocksize >> porder;
         count += 4;
 
         /* residual */
@@ -590,7 +621,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
             count += sub->rc.coding_mode;
             count += rice_count_exact(&sub->residual[i], part_end - i, k);
             i = part_end;
-            part_end = FFMIN(s->frame.blocksize, part_end + psize);
+            part_end = FFMIN(frame->blocksize, part_end + psize);
         }
     }
 
@@ -751,19 +782,19 @@ static int get_max_p_order(int max_porder, int n, int order)
 }
 
 
-static uint64_t find_subframe_rice_params(FlacEncodeContext *s,
+static uint64_t find_subframe_rice_params(FlacEncodeContext *s, FlacFrame *frame,
                                           FlacSubframe *sub, int pred_order)
 {
     int pmin = get_max_p_order(s->options.min_partition_order,
-                               s->frame.blocksize, pred_order);
+                               frame->blocksize, pred_order);
     int pmax = get_max_p_order(s->options.max_partition_order,
-                               s->frame.blocksize, pred_order);
+                               frame->blocksize, pred_order);
 
     uint64_t bits = 8 + pred_order * sub->obits + 2 + sub->rc.coding_mode;
     if (sub->type == FLAC_SUBFRAME_LPC)
         bits += 4 + 5 + pred_order * s->options.lpc_coeff_precision;
     bits += calc_rice_params(&sub->rc, sub->rc_udata, sub->rc_sums, pmin, pmax, sub->residual,
-                             s->frame.blocksize, pred_order, s->options.exact_rice_parameters);
+                             frame->blocksize, pred_order, s->options.exact_rice_parameters);
     return bits;
 }
 
@@ -819,7 +850,7 @@ static void encode_residual_fixed(int32_t *res, const int32_t *smp, int n,
 }
 
 
-static int encode_residual_ch(FlacEncodeContext *s, int ch)
+static int encode_residual_ch(FlacEncodeContext *s, FlacEncodeJob *job, int ch)
 {
     int i, n;
     int min_order, max_order, opt_order, omethod;
@@ -829,7 +860,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
     int shift[MAX_LPC_ORDER];
     int32_t *res, *smp;
 
-    frame = &s->frame;
+    frame = &job->frame;
     sub   = &frame->subframes[ch];
     res   = sub->residual;
     smp   = sub->samples;
@@ -842,14 +873,14 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
     if (i == n) {
         sub->type = sub->type_code = FLAC_SUBFRAME_CONSTANT;
         res[0] = smp[0];
-        return subframe_count_exact(s, sub, 0);
+        return subframe_count_exact(s, frame, sub, 0);
     }
 
     /* VERBATIM */
     if (frame->verbatim_only || n < 5) {
         sub->type = sub->type_code = FLAC_SUBFRAME_VERBATIM;
         memcpy(res, smp, n * sizeof(int32_t));
-        return subframe_count_exact(s, sub, 0);
+        return subframe_count_exact(s, frame, sub, 0);
     }
 
     min_order  = s->options.min_prediction_order;
@@ -867,7 +898,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         bits[0]   = UINT32_MAX;
         for (i = min_order; i <= max_order; i++) {
             encode_residual_fixed(res, smp, n, i);
-            bits[i] = find_subframe_rice_params(s, sub, i);
+            bits[i] = find_subframe_rice_params(s, frame, sub, i);
             if (bits[i] < bits[opt_order])
                 opt_order = i;
         }
@@ -875,14 +906,14 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         sub->type_code = sub->type | sub->order;
         if (sub->order != max_order) {
             encode_residual_fixed(res, smp, n, sub->order);
-            find_subframe_rice_params(s, sub, sub->order);
+            find_subframe_rice_params(s, frame, sub, sub->order);
         }
-        return subframe_count_exact(s, sub, sub->order);
+        return subframe_count_exact(s, frame, sub, sub->order);
     }
 
     /* LPC */
     sub->type = FLAC_SUBFRAME_LPC;
-    opt_order = ff_lpc_calc_coefs(&s->lpc_ctx, smp, n, min_order, max_order,
+    opt_order = ff_lpc_calc_coefs(&job->lpc_ctx, smp, n, min_order, max_order,
                                   s->options.lpc_coeff_precision, coefs, shift, s->options.lpc_type,
                                   s->options.lpc_passes, omethod,
                                   MIN_LPC_SHIFT, MAX_LPC_SHIFT, 0);
@@ -909,7 +940,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
                 s->flac_dsp.lpc32_encode(res, smp, n, order+1, coefs[order],
                                          shift[order]);
             }
-            bits[i] = find_subframe_rice_params(s, sub, order+1);
+            bits[i] = find_subframe_rice_params(s, frame, sub, order+1);
             if (bits[i] < bits[opt_index]) {
                 opt_index = i;
                 opt_order = order;
@@ -927,7 +958,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
             } else {
                 s->flac_dsp.lpc32_encode(res, smp, n, i+1, coefs[i], shift[i]);
             }
-            bits[i] = find_subframe_rice_params(s, sub, i+1);
+            bits[i] = find_subframe_rice_params(s, frame, sub, i+1);
             if (bits[i] < bits[opt_order])
                 opt_order = i;
         }
@@ -949,7 +980,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
                 } else {
                     s->flac_dsp.lpc16_encode(res, smp, n, i+1, coefs[i], shift[i]);
                 }
-                bits[i] = find_subframe_rice_params(s, sub, i+1);
+                bits[i] = find_subframe_rice_params(s, frame, sub, i+1);
                 if (bits[i] < bits[opt_order])
                     opt_order = i;
             }
@@ -990,7 +1021,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
                 } else {
                     s->flac_dsp.lpc32_encode(res, smp, n, opt_order, lpc_try, shift[opt_order-1]);
                 }
-                score = find_subframe_rice_params(s, sub, opt_order);
+                score = find_subframe_rice_params(s, frame, sub, opt_order);
                 if (score < best_score) {
                     best_score = score;
                     memcpy(coefs[opt_order-1], lpc_try, sizeof(*coefs));
@@ -1012,13 +1043,13 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         s->flac_dsp.lpc32_encode(res, smp, n, sub->order, sub->coefs, sub->shift);
     }
 
-    find_subframe_rice_params(s, sub, sub->order);
+    find_subframe_rice_params(s, frame, sub, sub->order);
 
-    return subframe_count_exact(s, sub, sub->order);
+    return subframe_count_exact(s, frame, sub, sub->order);
 }
 
 
-static int count_frame_header(FlacEncodeContext *s)
+static int count_frame_header(FlacEncodeContext *s, FlacEncodeJob *job)
 {
     uint8_t av_unused tmp;
     int count;
@@ -1036,12 +1067,12 @@ static int count_frame_header(FlacEncodeContext *s)
     count = 32;
 
     /* coded frame number */
-    PUT_UTF8(s->frame_count, tmp, count += 8;)
+    PUT_UTF8(job->frame_count, tmp, count += 8;)
 
     /* explicit block size */
-    if (s->frame.bs_code[0] == 6)
+    if (job->frame.bs_code[0] == 6)
         count += 8;
-    else if (s->frame.bs_code[0] == 7)
+    else if (job->frame.bs_code[0] == 7)
         count += 16;
 
     /* explicit sample rate */
@@ -1054,15 +1085,15 @@ static int count_frame_header(FlacEncodeContext *s)
 }
 
 
-static int encode_frame(FlacEncodeContext *s)
+static int encode_frame(FlacEncodeContext *s, FlacEncodeJob *job)
 {
     int ch;
     uint64_t count;
 
-    count = count_frame_header(s);
+    count = count_frame_header(s, job);
 
     for (ch = 0; ch < s->channels; ch++)
-        count += encode_residual_ch(s, ch);
+        count += encode_residual_ch(s, job, ch);
 
     count += (8 - (count & 7)) & 7; // byte alignment
     count += 16;                    // CRC-16
@@ -1074,15 +1105,15 @@ static int encode_frame(FlacEncodeContext *s)
 }
 
 
-static void remove_wasted_bits(FlacEncodeContext *s)
+static void remove_wasted_bits(FlacEncodeContext *s, FlacFrame *frame)
 {
     int ch, i;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &frame->subframes[ch];
         int32_t v         = 0;
 
-        for (i = 0; i < s->frame.blocksize; i++) {
+        for (i = 0; i < frame->blocksize; i++) {
             v |= sub->samples[i];
             if (v & 1)
                 break;
@@ -1091,7 +1122,7 @@ static void remove_wasted_bits(FlacEncodeContext *s)
         if (v && !(v & 1)) {
             v = ff_ctz(v);
 
-            for (i = 0; i < s->frame.blocksize; i++)
+            for (i = 0; i < frame->blocksize; i++)
                 sub->samples[i] >>= v;
 
             sub->wasted = v;
@@ -1150,13 +1181,11 @@ static int estimate_stereo_mode(const int32_t *left_ch, const int32_t *right_ch,
 /**
  * Perform stereo channel decorrelation.
  */
-static void channel_decorrelation(FlacEncodeContext *s)
+static void channel_decorrelation(FlacEncodeContext *s, FlacFrame *frame)
 {
-    FlacFrame *frame;
     int32_t *left, *right;
     int i, n;
 
-    frame = &s->frame;
     n     = frame->blocksize;
     left  = frame->subframes[0].samples;
     right = frame->subframes[1].samples;
@@ -1202,96 +1231,96 @@ static void write_utf8(PutBitContext *pb, uint32_t val)
 }
 
 
-static void write_frame_header(FlacEncodeContext *s)
+static void write_frame_header(FlacEncodeContext *s, FlacEncodeJob *job)
 {
-    FlacFrame *frame;
+    FlacFrame *frame = &job->frame;
+    PutBitContext *pb = &job->pb;
     int crc;
 
-    frame = &s->frame;
-
-    put_bits(&s->pb, 16, 0xFFF8);
-    put_bits(&s->pb, 4, frame->bs_code[0]);
-    put_bits(&s->pb, 4, s->sr_code[0]);
+    put_bits(pb, 16, 0xFFF8);
+    put_bits(pb, 4, frame->bs_code[0]);
+    put_bits(pb, 4, s->sr_code[0]);
 
     if (frame->ch_mode == FLAC_CHMODE_INDEPENDENT)
-        put_bits(&s->pb, 4, s->channels-1);
+        put_bits(pb, 4, s->channels-1);
     else
-        put_bits(&s->pb, 4, frame->ch_mode + FLAC_MAX_CHANNELS - 1);
+        put_bits(pb, 4, frame->ch_mode + FLAC_MAX_CHANNELS - 1);
 
-    put_bits(&s->pb, 3, s->bps_code);
-    put_bits(&s->pb, 1, 0);
-    write_utf8(&s->pb, s->frame_count);
+    put_bits(pb, 3, s->bps_code);
+    put_bits(pb, 1, 0);
+    write_utf8(pb, job->frame_count);
 
     if (frame->bs_code[0] == 6)
-        put_bits(&s->pb, 8, frame->bs_code[1]);
+        put_bits(pb, 8, frame->bs_code[1]);
     else if (frame->bs_code[0] == 7)
-        put_bits(&s->pb, 16, frame->bs_code[1]);
+        put_bits(pb, 16, frame->bs_code[1]);
 
     if (s->sr_code[0] == 12)
-        put_bits(&s->pb, 8, s->sr_code[1]);
+        put_bits(pb, 8, s->sr_code[1]);
     else if (s->sr_code[0] > 12)
-        put_bits(&s->pb, 16, s->sr_code[1]);
+        put_bits(pb, 16, s->sr_code[1]);
 
-    flush_put_bits(&s->pb);
-    crc = av_crc(av_crc_get_table(AV_CRC_8_ATM), 0, s->pb.buf,
-                 put_bits_count(&s->pb) >> 3);
-    put_bits(&s->pb, 8, crc);
+    flush_put_bits(pb);
+    crc = av_crc(av_crc_get_table(AV_CRC_8_ATM), 0, pb->buf,
+                 put_bits_count(pb) >> 3);
+    put_bits(pb, 8, crc);
 }
 
 
-static void write_subframes(FlacEncodeContext *s)
+static void write_subframes(FlacEncodeContext *s, FlacEncodeJob *job)
 {
+    PutBitContext *pb = &job->pb;
     int ch;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &job->frame.subframes[ch];
         int i, p, porder, psize;
         int32_t *part_end;
         int32_t *res       =  sub->residual;
-        int32_t *frame_end = &sub->residual[s->frame.blocksize];
+        int32_t *frame_end = &sub->residual[job->frame.blocksize];
 
         /* subframe header */
-        put_bits(&s->pb, 1, 0);
-        put_bits(&s->pb, 6, sub->type_code);
-        put_bits(&s->pb, 1, !!sub->wasted);
+        put_bits(pb, 1, 0);
+        put_bits(pb, 6, sub->type_code);
+        put_bits(pb, 1, !!sub->wasted);
         if (sub->wasted)
-            put_bits(&s->pb, sub->wasted, 1);
+            put_bits(pb, sub->wasted, 1);
 
         /* subframe */
         if (sub->type == FLAC_SUBFRAME_CONSTANT) {
-            put_sbits(&s->pb, sub->obits, res[0]);
+            put_sbits(pb, sub->obits, res[0]);
         } else if (sub->type == FLAC_SUBFRAME_VERBATIM) {
             while (res < frame_end)
-                put_sbits(&s->pb, sub->obits, *res++);
+                put_sbits(pb, sub->obits, *res++);
         } else {
             /* warm-up samples */
             for (i = 0; i < sub->order; i++)
-                put_sbits(&s->pb, sub->obits, *res++);
+                put_sbits(pb, sub->obits, *res++);
 
             /* LPC coefficients */
             if (sub->type == FLAC_SUBFRAME_LPC) {
                 int cbits = s->options.lpc_coeff_precision;
-                put_bits( &s->pb, 4, cbits-1);
-                put_sbits(&s->pb, 5, sub->shift);
+                put_bits( pb, 4, cbits-1);
+                put_sbits(pb, 5, sub->shift);
                 for (i = 0; i < sub->order; i++)
-                    put_sbits(&s->pb, cbits, sub->coefs[i]);
+                    put_sbits(pb, cbits, sub->coefs[i]);
             }
 
             /* rice-encoded block */
-            put_bits(&s->pb, 2, sub->rc.coding_mode - 4);
+            put_bits(pb, 2, sub->rc.coding_mode - 4);
 
             /* partition order */
             porder  = sub->rc.porder;
-            psize   = s->frame.blocksize >> porder;
-            put_bits(&s->pb, 4, porder);
+            psize   = job->frame.blocksize >> porder;
+            put_bits(pb, 4, porder);
 
             /* residual */
             part_end  = &sub->residual[psize];
             for (p = 0; p < 1 << porder; p++) {
                 int k = sub->rc.params[p];
-                put_bits(&s->pb, sub->rc.coding_mode, k);
+                put_bits(pb, sub->rc.coding_mode, k);
                 while (res < part_end)
-                    set_sr_golomb_flac(&s->pb, *res++, k, INT32_MAX, 0);
+                    set_sr_golomb_flac(pb, *res++, k, INT32_MAX, 0);
                 part_end = FFMIN(frame_end, part_end + psize);
             }
         }
@@ -1299,31 +1328,33 @@ static void write_subframes(FlacEncodeContext *s)
 }
 
 
-static void write_frame_footer(FlacEncodeContext *s)
+static void write_frame_footer(FlacEncodeJob *job)
 {
+    PutBitContext *pb = &job->pb;
     int crc;
-    flush_put_bits(&s->pb);
-    crc = av_bswap16(av_crc(av_crc_get_table(AV_CRC_16_ANSI), 0, s->pb.buf,
-                            put_bits_count(&s->pb)>>3));
-    put_bits(&s->pb, 16, crc);
-    flush_put_bits(&s->pb);
+    flush_put_bits(pb);
+    crc = av_bswap16(av_crc(av_crc_get_table(AV_CRC_16_ANSI), 0, pb->buf,
+                            put_bits_count(pb)>>3));
+    put_bits(pb, 16, crc);
+    flush_put_bits(pb);
 }
 
 
-static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
+static int write_frame(FlacEncodeContext *s, FlacEncodeJob *job, AVPacket *avpkt)
 {
-    init_put_bits(&s->pb, avpkt->data, avpkt->size);
-    write_frame_header(s);
-    write_subframes(s);
-    write_frame_footer(s);
-    return put_bits_count(&s->pb) >> 3;
+    init_put_bits(&job->pb, avpkt->data, avpkt->size);
+    write_frame_header(s, job);
+    write_subframes(s, job);
+    write_frame_footer(job);
+    return put_bits_count(&job->pb) >> 3;
 }
 
 
-static int update_md5_sum(FlacEncodeContext *s, const void *samples)
+static int update_md5_sum(FlacEncodeContext *s, const void *samples,
+                          int nb_samples)
 {
     const uint8_t *buf;
-    int buf_size = s->frame.blocksize * s->channels *
+    int buf_size = nb_samples * s->channels *
                    ((s->avctx->bits_per_raw_sample + 7) / 8);
 
     if (s->avctx->bits_per_raw_sample > 16 || HAVE_BIGENDIAN) {
@@ -1344,7 +1375,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++) {
+        for (i = 0; i < nb_samples * s->channels; i++) {
             int32_t v = samples0[i] >> 8;
             AV_WL24(tmp + 3*i, v);
         }
@@ -1356,14 +1387,131 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 }
 
 
+static int encode_frame_job(AVCodecContext *avctx, void *arg)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacEncodeJob *job   = arg;
+    const AVFrame *frame = job->input;
+    int frame_bytes, out_bytes, ret;
+
+    init_frame(s, &job->frame, frame->nb_samples);
+
+    copy_samples(s, &job->frame, frame->data[0]);
+
+    channel_decorrelation(s, &job->frame);
+
+    remove_wasted_bits(s, &job->frame);
+
+    frame_bytes = encode_frame(s, job);
+
+    /* Fall back on verbatim mode if the compressed frame is larger than it
+       would be if encoded uncompressed. */
+    if (frame_bytes < 0 || frame_bytes > job->max_framesize) {
+        job->frame.verbatim_only = 1;
+        frame_bytes = encode_frame(s, job);
+        if (frame_bytes < 0) {
+            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
+            return frame_bytes;
+        }
+    }
+
+    if ((ret = av_new_packet(job->pkt, frame_bytes)) < 0)
+        return ret;
+
+    out_bytes = write_frame(s, job, job->pkt);
+    av_shrink_packet(job->pkt, out_bytes);
+
+    return 0;
+}
+
+/**
+ * Encode all queued frames, in parallel if slice threading is enabled.
+ * Only the MD5 sum and the stream statistics depend on the previous frames,
+ * they are updated afterwards in coding order.
+ */
+static int encode_queued_frames(AVCodecContext *avctx)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    int rets[MAX_ENCODE_JOBS];
+    int i, ret;
+
+    avctx->execute(avctx, encode_frame_job, s->jobs, rets, s->nb_queued,
+                   sizeof(*s->jobs));
+
+    for (i = 0; i < s->nb_queued; i++) {
+        FlacEncodeJob *job = &s->jobs[i];
+        AVFrame *frame     = job->input;
+
+        if (rets[i] < 0)
+            return rets[i];
+
+        s->sample_count += frame->nb_samples;
+        if ((ret = update_md5_sum(s, frame->data[0], frame->nb_samples)) < 0) {
+            av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+            return ret;
+        }
+        if (job->pkt->size > s->max_encoded_framesize)
+            s->max_encoded_framesize = job->pkt->size;
+        if (job->pkt->size < s->min_framesize)
+            s->min_framesize = job->pkt->size;
+
+        job->pkt->pts      = frame->pts;
+        job->pkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
+
+        s->next_pts = job->pkt->pts + job->pkt->duration;
+
+        av_frame_unref(frame);
+    }
+
+    s->nb_encoded = s->nb_queued;
+    s->nb_queued  = 0;
+    return 0;
+}
+
+
 static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                              const AVFrame *frame, int *got_packet_ptr)
 {
     FlacEncodeContext *s;
-    int frame_bytes, out_bytes, ret;
+    int ret;
 
     s = avctx->priv_data;
 
+    if (frame) {
+        FlacEncodeJob *job = &s->jobs[s->nb_queued];
+
+        /* change max_framesize for small final frame */
+        if (frame->nb_samples < s->last_blocksize) {
+            s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
+                                                          s->channels,
+                                                          avctx->bits_per_raw_sample);
+        }
+        s->last_blocksize = frame->nb_samples;
+
+        if ((ret = av_frame_ref(job->input, frame)) < 0)
+            return ret;
+        job->frame_count   = s->frame_count++;
+        job->max_framesize = s->max_framesize;
+        s->nb_queued++;
+    }
+
+    /* one frame per job is queued before encoding, the resulting packets
+     * are returned while the next frames are queued */
+    if (!s->nb_encoded && s->nb_queued &&
+        (!frame || s->nb_queued == s->nb_jobs)) {
+        if ((ret = encode_queued_frames(avctx)) < 0)
+            return ret;
+    }
+
+    if (s->next_output < s->nb_encoded) {
+        av_packet_move_ref(avpkt, s->jobs[s->next_output++].pkt);
+        if (s->next_output == s->nb_encoded)
+            s->next_output = s->nb_encoded = 0;
+
+        *got_packet_ptr = 1;
+        return 0;
+    }
+
     /* when the last block is reached, update the header in extradata */
     if (!frame) {
         s->max_framesize = s->max_encoded_framesize;
@@ -1388,61 +1536,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
             *got_packet_ptr = 1;
             s->flushed = 1;
         }
-
-        return 0;
-    }
-
-    /* change max_framesize for small final frame */
-    if (frame->nb_samples < s->frame.blocksize) {
-        s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
-                                                      s->channels,
-                                                      avctx->bits_per_raw_sample);
-    }
-
-    init_frame(s, frame->nb_samples);
-
-    copy_samples(s, frame->data[0]);
-
-    channel_decorrelation(s);
-
-    remove_wasted_bits(s);
-
-    frame_bytes = encode_frame(s);
-
-    /* Fall back on verbatim mode if the compressed frame is larger than it
-       would be if encoded uncompressed. */
-    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
-        s->frame.verbatim_only = 1;
-        frame_bytes = encode_frame(s);
-        if (frame_bytes < 0) {
-            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
-            return frame_bytes;
-        }
-    }
-
-    if ((ret = ff_alloc_packet2(avctx, avpkt, frame_bytes, 0)) < 0)
-        return ret;
-
-    out_bytes = write_frame(s, avpkt);
-
-    s->frame_count++;
-    s->sample_count += frame->nb_samples;
-    if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
-        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
-        return ret;
     }
-    if (out_bytes > s->max_encoded_framesize)
-        s->max_encoded_framesize = out_bytes;
-    if (out_bytes < s->min_framesize)
-        s->min_framesize = out_bytes;
-
-    avpkt->pts      = frame->pts;
-    avpkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
-    avpkt->size     = out_bytes;
 
-    s->next_pts = avpkt->pts + avpkt->duration;
-
-    *got_packet_ptr = 1;
     return 0;
 }
 
@@ -1453,7 +1548,17 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
         FlacEncodeContext *s = avctx->priv_data;
         av_freep(&s->md5ctx);
         av_freep(&s->md5_buffer);
-        ff_lpc_end(&s->lpc_ctx);
+        if (s->jobs) {
+            int i;
+            for (i = 0; i < s->nb_jobs; i++) {
+                FlacEncodeJob *job = &s->jobs[i];
+                av_freep(&job->frame.subframes);
+                av_frame_free(&job->input);
+                av_packet_free(&job->pkt);
+                ff_lpc_end(&job->lpc_ctx);
+            }
+            av_freep(&s->jobs);
+        }
     }
     av_freep(&avctx->extradata);
     avctx->extradata_size = 0;
@@ -1508,7 +1613,8 @@ AVCodec ff_flac_encoder = {
     .init           = flac_encode_init,
     .encode2        = flac_encode_frame,
     .close          = flac_encode_close,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_S16,
                                                      AV_SAMPLE_FMT_S32,
                                                      AV_SAMPLE_FMT_NONE },
@@ -121,7 +121,7 @@ static inline unsigned int show_bits(GetBitContext *s, int n);
  */
 
 #if CACHED_BITSTREAM_READER
-#   define MIN_CACHE_BITS 64
+#   define MIN_CACHE_BITS 32
 #elif defined LONG_BITSTREAM_READER
 #   define MIN_CACHE_BITS 32
 #else
@@ -214,6 +214,105 @@ static inline unsigned int show_bits(GetBitContext *s, int n);
 
 #define GET_CACHE(name, gb) ((uint32_t) name ## _cache)
 
+#else /* CACHED_BITSTREAM_READER */
+
+/*
+ * The macros work on a local copy of the 64-bit cache, which is refilled
+ * 32 bits at a time, so UPDATE_CACHE() only touches memory every other
+ * call or so. Skipped bits are always shifted out of the cache, so
+ * LAST_SKIP_BITS() is the same as SKIP_BITS().
+ */
+
+#define OPEN_READER_NOSIZE(name, gb)                    \
+    unsigned int name ## _index     = (gb)->index;      \
+    unsigned int name ## _bits_left = (gb)->bits_left;  \
+    uint64_t     name ## _cache     = (gb)->cache
+
+#define OPEN_READER(name, gb) OPEN_READER_NOSIZE(name, gb)
+
+#define BITS_AVAILABLE(name, gb) 1
+
+#define CLOSE_READER(name, gb)                          \
+    do {                                                \
+        (gb)->index     = name ## _index;               \
+        (gb)->bits_left = name ## _bits_left;           \
+        (gb)->cache     = name ## _cache;               \
+    } while (0)
+
+#if UNCHECKED_BITSTREAM_READER
+#   define CAN_REFILL(name, gb) 1
+#else
+#   define CAN_REFILL(name, gb) \
+    (name ## _index >> 3 < (gb)->buffer_end - (gb)->buffer)
+#endif
+
+#define UPDATE_CACHE_LE(name, gb)                                           \
+    do {                                                                    \
+        if (name ## _bits_left < 32 && CAN_REFILL(name, gb)) {              \
+            name ## _cache |= (uint64_t)AV_RL32((gb)->buffer +              \
+                                                (name ## _index >> 3)) <<   \
+                              name ## _bits_left;                           \
+            name ## _index     += 32;                                       \
+            name ## _bits_left += 32;                                       \
+        }                                                                   \
+    } while (0)
+
+#define UPDATE_CACHE_BE(name, gb)                                           \
+    do {                                                                    \
+        if (name ## _bits_left < 32 && CAN_REFILL(name, gb)) {              \
+            name ## _cache |= (uint64_t)AV_RB32((gb)->buffer +              \
+                                                (name ## _index >> 3)) <<   \
+                              (32 - name ## _bits_left);                    \
+            name ## _index     += 32;                                       \
+            name ## _bits_left += 32;                                       \
+        }                                                                   \
+    } while (0)
+
+#ifdef BITSTREAM_READER_LE
+
+# define UPDATE_CACHE(name, gb) UPDATE_CACHE_LE(name, gb)
+
+# define SKIP_CACHE(name, gb, num) name ## _cache >>= (num)
+
+#else
+
+# define UPDATE_CACHE(name, gb) UPDATE_CACHE_BE(name, gb)
+
+# define SKIP_CACHE(name, gb, num) name ## _cache <<= (num)
+
+#endif
+
+#define SKIP_COUNTER(name, gb, num) name ## _bits_left -= (num)
+
+#define BITS_LEFT(name, gb) \
+    ((int)((gb)->size_in_bits - (name ## _index - name ## _bits_left)))
+
+#define SKIP_BITS(name, gb, num)                \
+    do {                                        \
+        SKIP_CACHE(name, gb, num);              \
+        SKIP_COUNTER(name, gb, num);            \
+    } while (0)
+
+#define LAST_SKIP_BITS(name, gb, num) SKIP_BITS(name, gb, num)
+
+#define SHOW_UBITS_LE(name, gb, num) zero_extend(name ## _cache, num)
+#define SHOW_SBITS_LE(name, gb, num) sign_extend(name ## _cache, num)
+
+#define SHOW_UBITS_BE(name, gb, num) \
+    ((uint32_t)(name ## _cache >> (64 - (num))))
+#define SHOW_SBITS_BE(name, gb, num) \
+    ((int32_t)((int64_t)name ## _cache >> (64 - (num))))
+
+#ifdef BITSTREAM_READER_LE
+#   define SHOW_UBITS(name, gb, num) SHOW_UBITS_LE(name, gb, num)
+#   define SHOW_SBITS(name, gb, num) SHOW_SBITS_LE(name, gb, num)
+#   define GET_CACHE(name, gb) ((uint32_t) name ## _cache)
+#else
+#   define SHOW_UBITS(name, gb, num) SHOW_UBITS_BE(name, gb, num)
+#   define SHOW_SBITS(name, gb, num) SHOW_SBITS_BE(name, gb, num)
+#   define GET_CACHE(name, gb) ((uint32_t)(name ## _cache >> 32))
+#endif
+
 #endif
 
 static inline int get_bits_count(const GetBitContext *s)
@@ -695,7 +794,7 @@ static inline const uint8_t *align_get_bits(GetBitContext *s)
     int n = -get_bits_count(s) & 7;
     if (n)
         skip_bits(s, n);
-    return s->buffer + (s->index >> 3);
+    return s->buffer + (get_bits_count(s) >> 3);
 }
 
 /**
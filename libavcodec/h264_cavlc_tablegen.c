@@ -0,0 +1,69 @@
+/*
+ * Generate a header file for hardcoded H.264 CAVLC tables
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include "tableprint_vlc.h"
+#include "libavutil/intmath.c"
+#include "libavutil/log2_tab.c"
+#define CONFIG_HARDCODED_TABLES 0
+#include "h264_cavlc_tablegen.h"
+
+static void write_vlc_array(const char *name, const VLC *vlc, int nb, int first)
+{
+    printf("static const VLC %s[%d] = {{\n", name, nb);
+    for (int i = 0; i < nb; i++) {
+        if (i < first)
+            printf("    0\n");
+        else
+            write_vlc_type(&vlc[i], h264_cavlc_vlc_table, "h264_cavlc_vlc_table");
+        printf(i == nb - 1 ? "}};\n" : "}, {\n");
+    }
+}
+
+int main(void)
+{
+    h264_cavlc_init_vlc();
+
+    write_fileheader();
+
+    WRITE_2D_ARRAY("static const", VLC_TYPE, h264_cavlc_vlc_table);
+
+    WRITE_VLC_TYPE("static const", chroma_dc_coeff_token_vlc, h264_cavlc_vlc_table);
+    WRITE_VLC_TYPE("static const", chroma422_dc_coeff_token_vlc, h264_cavlc_vlc_table);
+    WRITE_VLC_ARRAY("static const", coeff_token_vlc, h264_cavlc_vlc_table);
+    WRITE_VLC_TYPE("static const", run7_vlc, h264_cavlc_vlc_table);
+
+    /* entry 0 of these is never used */
+    write_vlc_array("chroma_dc_total_zeros_vlc", chroma_dc_total_zeros_vlc,
+                    FF_ARRAY_ELEMS(chroma_dc_total_zeros_vlc), 1);
+    write_vlc_array("chroma422_dc_total_zeros_vlc", chroma422_dc_total_zeros_vlc,
+                    FF_ARRAY_ELEMS(chroma422_dc_total_zeros_vlc), 1);
+    write_vlc_array("total_zeros_vlc", total_zeros_vlc,
+                    FF_ARRAY_ELEMS(total_zeros_vlc), 1);
+    write_vlc_array("run_vlc", run_vlc, FF_ARRAY_ELEMS(run_vlc), 1);
+
+    printf("static const int8_t cavlc_level_tab[7][%d][2] = {{\n", 1 << LEVEL_TAB_BITS);
+    for (int i = 0; i < 7; i++) {
+        write_int8_t_2d_array(cavlc_level_tab[i], 1 << LEVEL_TAB_BITS, 2);
+        printf(i == 6 ? "}};\n" : "}, {\n");
+    }
+
+    return 0;
+}
@@ -25,12 +25,14 @@
 
 #include "libavutil/attributes.h"
 #include "libavutil/common.h"
+#include "libavutil/cpu.h"
 #include "libavutil/display.h"
 #include "libavutil/internal.h"
 #include "libavutil/mastering_display_metadata.h"
 #include "libavutil/md5.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/stereo3d.h"
 #include "libavutil/timecode.h"
 
@@ -44,6 +46,7 @@
 #include "hevcdec.h"
 #include "hwconfig.h"
 #include "profiles.h"
+#include "pthread_pool.h"
 
 const uint8_t ff_hevc_pel_weight[65] = { [2] = 0, [4] = 1, [6] = 2, [8] = 3, [12] = 4, [16] = 5, [24] = 6, [32] = 7, [48] = 8, [64] = 9 };
 
@@ -2560,6 +2563,29 @@ static int hls_slice_data(HEVCContext *s)
     s->avctx->execute(s->avctx, hls_decode_entry, arg, ret , 1, sizeof(int));
     return ret[0];
 }
+
+static void wpp_await_progress(HEVCContext *s, int ctb_row, int thread, int shift)
+{
+#if HAVE_THREADS
+    if (s->wpp_pool) {
+        ff_row_progress_await(s->wpp_progress, ctb_row, thread, shift);
+        return;
+    }
+#endif
+    ff_thread_await_progress2(s->avctx, ctb_row, thread, shift);
+}
+
+static void wpp_report_progress(HEVCContext *s, int ctb_row, int thread, int n)
+{
+#if HAVE_THREADS
+    if (s->wpp_pool) {
+        ff_row_progress_report(s->wpp_progress, ctb_row, thread, n);
+        return;
+    }
+#endif
+    ff_thread_report_progress2(s->avctx, ctb_row, thread, n);
+}
+
 static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int job, int self_id)
 {
     HEVCContext *s1  = avctxt->priv_data, *s;
@@ -2589,10 +2615,10 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int
 
         hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
 
-        ff_thread_await_progress2(s->avctx, ctb_row, thread, SHIFT_CTB_WPP);
+        wpp_await_progress(s1, ctb_row, thread, SHIFT_CTB_WPP);
 
         if (atomic_load(&s1->wpp_err)) {
-            ff_thread_report_progress2(s->avctx, ctb_row , thread, SHIFT_CTB_WPP);
+            wpp_report_progress(s1, ctb_row, thread, SHIFT_CTB_WPP);
             return 0;
         }
 
@@ -2610,18 +2636,18 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int
         ctb_addr_ts++;
 
         ff_hevc_save_states(s, ctb_addr_ts);
-        ff_thread_report_progress2(s->avctx, ctb_row, thread, 1);
+        wpp_report_progress(s1, ctb_row, thread, 1);
         ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
 
         if (!more_data && (x_ctb+ctb_size) < s->ps.sps->width && ctb_row != s->sh.num_entry_point_offsets) {
             atomic_store(&s1->wpp_err, 1);
-            ff_thread_report_progress2(s->avctx, ctb_row ,thread, SHIFT_CTB_WPP);
+            wpp_report_progress(s1, ctb_row, thread, SHIFT_CTB_WPP);
             return 0;
         }
 
         if ((x_ctb+ctb_size) >= s->ps.sps->width && (y_ctb+ctb_size) >= s->ps.sps->height ) {
             ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
-            ff_thread_report_progress2(s->avctx, ctb_row , thread, SHIFT_CTB_WPP);
+            wpp_report_progress(s1, ctb_row, thread, SHIFT_CTB_WPP);
             return ctb_addr_ts;
         }
         ctb_addr_rs       = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
@@ -2631,16 +2657,39 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int
             break;
         }
     }
-    ff_thread_report_progress2(s->avctx, ctb_row ,thread, SHIFT_CTB_WPP);
+    wpp_report_progress(s1, ctb_row, thread, SHIFT_CTB_WPP);
 
     return 0;
 error:
     s->tab_slice_address[ctb_addr_rs] = -1;
     atomic_store(&s1->wpp_err, 1);
-    ff_thread_report_progress2(s->avctx, ctb_row ,thread, SHIFT_CTB_WPP);
+    wpp_report_progress(s1, ctb_row, thread, SHIFT_CTB_WPP);
     return ret;
 }
 
+#if HAVE_THREADS
+static void wpp_thread_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    HEVCContext *s = priv;
+    s->wpp_ret[jobnr] = hls_decode_entry_wpp(s->avctx, s->wpp_arg, jobnr, threadnr);
+}
+
+/* Each frame thread runs its rows through a context of its own on the pool */
+static int wpp_thread_init(HEVCContext *s)
+{
+    int ret;
+
+    if (s->wpp_thread)
+        return 0;
+    ret = avpriv_slicethread_create_pooled(&s->wpp_thread, s->wpp_pool, s,
+                                           wpp_thread_worker, s->threads_number);
+    if (ret < 0)
+        return ret;
+    avpriv_slicethread_set_priority(s->wpp_thread, s->avctx->thread_priority);
+    return 0;
+}
+#endif
+
 static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
 {
     const uint8_t *data = nal->data;
@@ -2667,7 +2716,17 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         goto error;
     }
 
-    ff_alloc_entries(s->avctx, s->sh.num_entry_point_offsets + 1);
+#if HAVE_THREADS
+    if (s->wpp_pool) {
+        res = wpp_thread_init(s);
+        if (res >= 0)
+            res = ff_row_progress_alloc(&s->wpp_progress, s->sh.num_entry_point_offsets + 1,
+                                        s->threads_number);
+    } else
+#endif
+        res = ff_alloc_entries(s->avctx, s->sh.num_entry_point_offsets + 1);
+    if (res < 0)
+        goto error;
 
     for (i = 1; i < s->threads_number; i++) {
         if (s->sList[i] && s->HEVClcList[i])
@@ -2727,15 +2786,28 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
     }
 
     atomic_store(&s->wpp_err, 0);
-    ff_reset_entries(s->avctx);
+#if HAVE_THREADS
+    if (s->wpp_pool)
+        ff_row_progress_reset(s->wpp_progress);
+    else
+#endif
+        ff_reset_entries(s->avctx);
 
     for (i = 0; i <= s->sh.num_entry_point_offsets; i++) {
         arg[i] = i;
         ret[i] = 0;
     }
 
-    if (s->ps.pps->entropy_coding_sync_enabled_flag)
-        s->avctx->execute2(s->avctx, hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
+    if (s->ps.pps->entropy_coding_sync_enabled_flag) {
+#if HAVE_THREADS
+        if (s->wpp_pool) {
+            s->wpp_arg = arg;
+            s->wpp_ret = ret;
+            avpriv_slicethread_execute(s->wpp_thread, s->sh.num_entry_point_offsets + 1, 0);
+        } else
+#endif
+            s->avctx->execute2(s->avctx, hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
+    }
 
     for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
         res += ret[i];
@@ -3491,6 +3563,13 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
     av_freep(&s->HEVClcList);
     av_freep(&s->sList);
 
+#if HAVE_THREADS
+    avpriv_slicethread_free(&s->wpp_thread);
+    ff_row_progress_free(&s->wpp_progress);
+#endif
+    s->wpp_pool = NULL;
+    av_buffer_unref(&s->wpp_pool_ref);
+
     ff_h2645_packet_uninit(&s->pkt);
 
     ff_hevc_reset_sei(&s->sei);
@@ -3608,6 +3687,11 @@ static int hevc_update_thread_context(AVCodecContext *dst,
     s->threads_number      = s0->threads_number;
     s->threads_type        = s0->threads_type;
 
+    ret = av_buffer_replace(&s->wpp_pool_ref, s0->wpp_pool_ref);
+    if (ret < 0)
+        return ret;
+    s->wpp_pool = s0->wpp_pool;
+
     if (s0->eos) {
         s->seq_decode = (s->seq_decode + 1) & 0xff;
         s->max_ra = INT_MAX;
@@ -3654,6 +3738,38 @@ static int hevc_update_thread_context(AVCodecContext *dst,
 }
 #endif
 
+#if HAVE_THREADS
+static void wpp_pool_free(void *opaque, uint8_t *data)
+{
+    AVSliceThreadPool *pool = (AVSliceThreadPool *)data;
+    avpriv_slicethread_pool_free(&pool);
+}
+
+/* Only the first frame thread creates the pool, the others get a
+ * reference to it in hevc_update_thread_context(). */
+static av_cold int wpp_pool_init(HEVCContext *s, int nb_workers)
+{
+    AVSliceThreadPool *pool;
+    int ret;
+
+    ret = avpriv_slicethread_pool_alloc(&pool, nb_workers);
+    if (ret < 0)
+        return ret;
+
+    s->wpp_pool_ref = av_buffer_create((uint8_t *)pool, sizeof(pool),
+                                       wpp_pool_free, NULL, 0);
+    if (!s->wpp_pool_ref) {
+        avpriv_slicethread_pool_free(&pool);
+        return AVERROR(ENOMEM);
+    }
+    s->wpp_pool = pool;
+
+    av_log(s->avctx, AV_LOG_DEBUG, "Decoding WPP rows on %d shared threads\n", ret);
+
+    return 0;
+}
+#endif
+
 static av_cold int hevc_decode_init(AVCodecContext *avctx)
 {
     HEVCContext *s = avctx->priv_data;
@@ -3661,7 +3777,19 @@ static av_cold int hevc_decode_init(AVCodecContext *avctx)
 
     if(avctx->active_thread_type & FF_THREAD_SLICE)
         s->threads_number = avctx->thread_count;
-    else
+    else if (HAVE_THREADS && (avctx->active_thread_type & FF_THREAD_FRAME) &&
+             avctx->thread_count > 1 && s->wpp_threads) {
+        int nb_workers = s->wpp_threads > 0 ? s->wpp_threads :
+                         FFMIN(av_cpu_count(), MAX_WPP_THREADS);
+        s->threads_number = nb_workers + 1;
+#if HAVE_THREADS
+        if (!avctx->internal->is_copy) {
+            ret = wpp_pool_init(s, nb_workers);
+            if (ret < 0)
+                return ret;
+        }
+#endif
+    } else
         s->threads_number = 1;
 
     if((avctx->active_thread_type & FF_THREAD_FRAME) && avctx->thread_count > 1)
@@ -3708,6 +3836,8 @@ static const AVOption options[] = {
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { "strict-displaywin", "stricly apply default display window size", OFFSET(apply_defdispwin),
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
+    { "wpp_threads", "Threads decoding WPP rows for all frame threads (-1 = auto, 0 = off)",
+        OFFSET(wpp_threads), AV_OPT_TYPE_INT, {.i64 = 0}, -1, MAX_WPP_THREADS, PAR },
     { NULL },
 };
 
@@ -44,6 +44,7 @@
 #include "videodsp.h"
 
 #define SHIFT_CTB_WPP 2
+#define MAX_WPP_THREADS 64
 
 //TODO: check if this is really the maximum
 #define MAX_TRANSFORM_DEPTH 5
@@ -557,6 +558,15 @@ typedef struct HEVCContext {
     int enable_parallel_tiles;
     atomic_int wpp_err;
 
+    /* WPP rows of all frame threads are decoded on a shared pool when
+     * frame threading is combined with wpp_threads */
+    AVBufferRef *wpp_pool_ref;
+    struct AVSliceThreadPool *wpp_pool;
+    struct AVSliceThread *wpp_thread;
+    struct FFRowProgress *wpp_progress;
+    int *wpp_arg;               ///< job arguments and results of the rows
+    int *wpp_ret;               ///< being decoded on wpp_thread
+
     const uint8_t *data;
 
     H2645Packet pkt;
@@ -567,6 +577,7 @@ typedef struct HEVCContext {
     int is_nalff;           ///< this flag is != 0 if bitstream is encapsulated
                             ///< as a format defined in 14496-15
     int apply_defdispwin;
+    int wpp_threads;
 
     int nal_length_size;    ///< Number of bytes used for nal length (1, 2 or 4)
     int nuh_layer_id;
@@ -83,6 +83,12 @@
  * internal logic derive them from AVCodecInternal.last_pkt_props.
  */
 #define FF_CODEC_CAP_SETS_FRAME_PROPS       (1 << 8)
+/**
+ * The slice threading jobs of the codec wait for each other, so they need
+ * all their threads running at once with threadnr == jobnr, which the shared
+ * thread pool does not provide. The codec keeps threads of its own.
+ */
+#define FF_CODEC_CAP_SLICE_THREAD_CONCURRENT_JOBS (1 << 9)
 
 /**
  * AVCodec.codec_tags termination value
@@ -105,6 +105,11 @@ typedef struct {
    double *layer_rates;
 } Jpeg2000Tile;
 
+/** a row of code-blocks of a band, the unit of parallel tier-1 coding */
+typedef struct {
+    int tileno, compno, reslevelno, bandno, cblky;
+} Jpeg2000CblkRow;
+
 typedef struct {
     AVClass *class;
     AVCodecContext *avctx;
@@ -129,6 +134,8 @@ typedef struct {
     Jpeg2000QuantStyle  qntsty;
 
     Jpeg2000Tile *tile;
+    Jpeg2000CblkRow *cblk_rows;
+    int nb_cblk_rows;
     int layer_rates[100];
     uint8_t compression_rate_enc; ///< Is compression done using compression ratio?
 
@@ -502,6 +509,63 @@ static int init_tiles(Jpeg2000EncoderContext *s)
     return 0;
 }
 
+/**
+ * List the code-block rows to be coded and allocate their buffers, so that
+ * tier-1 coding does not need to allocate anything.
+ */
+static int init_cblk_rows(Jpeg2000EncoderContext *s)
+{
+    int tileno, compno, reslevelno, bandno, cblky, cblkno, n = 0, pass;
+    Jpeg2000CodingStyle *codsty = &s->codsty;
+
+    for (pass = 0; pass < 2; pass++) {
+        for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++) {
+            for (compno = 0; compno < s->ncomponents; compno++) {
+                Jpeg2000Component *comp = s->tile[tileno].comp + compno;
+
+                for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++) {
+                    Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+
+                    for (bandno = 0; bandno < reslevel->nbands; bandno++) {
+                        Jpeg2000Band *band = reslevel->band + bandno;
+                        Jpeg2000Prec *prec = band->prec;
+
+                        if (band->coord[0][0] == band->coord[0][1] ||
+                            band->coord[1][0] == band->coord[1][1])
+                            continue;
+
+                        for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++, n++) {
+                            if (!pass)
+                                continue;
+                            s->cblk_rows[n] = (Jpeg2000CblkRow) {
+                                tileno, compno, reslevelno, bandno, cblky
+                            };
+                        }
+                        if (!pass)
+                            continue;
+                        for (cblkno = 0; cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height; cblkno++) {
+                            Jpeg2000Cblk *cblk = prec->cblk + cblkno;
+
+                            cblk->data   = av_malloc(1 + 8192);
+                            cblk->passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof(*cblk->passes));
+                            if (!cblk->data || !cblk->passes)
+                                return AVERROR(ENOMEM);
+                        }
+                    }
+                }
+            }
+        }
+        if (!pass) {
+            s->cblk_rows = av_malloc_array(n, sizeof(*s->cblk_rows));
+            if (!s->cblk_rows)
+                return AVERROR(ENOMEM);
+            s->nb_cblk_rows = n;
+            n = 0;
+        }
+    }
+    return 0;
+}
+
 #define COPY_FRAME(D, PIXEL)                                                                                                \
     static void copy_frame_ ##D(Jpeg2000EncoderContext *s)                                                                  \
     {                                                                                                                       \
@@ -1399,84 +1463,112 @@ static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
     }
 }
 
-static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+static int dwt_tile_comp(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
 {
-    int compno, reslevelno, bandno, ret;
-    Jpeg2000T1Context t1;
-    Jpeg2000CodingStyle *codsty = &s->codsty;
-    for (compno = 0; compno < s->ncomponents; compno++){
-        Jpeg2000Component *comp = s->tile[tileno].comp + compno;
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+    Jpeg2000Component *comp   = s->tile[jobnr / s->ncomponents].comp +
+                                jobnr % s->ncomponents;
 
-        t1.stride = (1<<codsty->log2_cblk_width) + 2;
+    return ff_dwt_encode(&comp->dwt, comp->i_data);
+}
 
-        av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
-        if ((ret = ff_dwt_encode(&comp->dwt, comp->i_data)) < 0)
-            return ret;
-        av_log(s->avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
+static int encode_cblk_row(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    Jpeg2000EncoderContext *s  = avctx->priv_data;
+    const Jpeg2000CblkRow *row = &s->cblk_rows[jobnr];
+    Jpeg2000CodingStyle *codsty = &s->codsty;
+    Jpeg2000Tile *tile          = s->tile + row->tileno;
+    Jpeg2000Component *comp     = tile->comp + row->compno;
+    Jpeg2000ResLevel *reslevel  = comp->reslevel + row->reslevelno;
+    Jpeg2000Band *band          = reslevel->band + row->bandno;
+    Jpeg2000Prec *prec          = band->prec; // we support only 1 precinct per band ATM in the encoder
+    int reslevelno = row->reslevelno, bandno = row->bandno;
+    int cblkx, cblkno, xx0, x0, xx1, y0, yy0, yy1, yend, bandpos;
+    Jpeg2000T1Context t1;
 
-        for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++){
-            Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+    t1.stride = (1<<codsty->log2_cblk_width) + 2;
 
-            for (bandno = 0; bandno < reslevel->nbands ; bandno++){
-                Jpeg2000Band *band = reslevel->band + bandno;
-                Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
-                int cblkx, cblky, cblkno=0, xx0, x0, xx1, y0, yy0, yy1, bandpos;
-                yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
-                y0 = yy0;
-                yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
-                            band->coord[1][1]) - band->coord[1][0] + yy0;
+    y0   = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
+    yend = band->coord[1][1] - band->coord[1][0] + y0;
+    yy1  = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
+                 band->coord[1][1]) - band->coord[1][0] + y0;
+    yy0  = y0;
+    if (row->cblky) {
+        yy0 = FFMIN(yy1 + ((row->cblky - 1) << band->log2_cblk_height), yend);
+        yy1 = FFMIN(yy1 + ( row->cblky      << band->log2_cblk_height), yend);
+    }
 
-                if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
-                    continue;
+    bandpos = bandno + (reslevelno > 0);
 
-                bandpos = bandno + (reslevelno > 0);
-
-                for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++){
-                    if (reslevelno == 0 || bandno == 1)
-                        xx0 = 0;
-                    else
-                        xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
-                    x0 = xx0;
-                    xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
-                                band->coord[0][1]) - band->coord[0][0] + xx0;
-
-                    for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
-                        int y, x;
-                        if (codsty->transform == FF_DWT53){
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
-                                }
-                            }
-                        } else{
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
-                                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
-                                    ptr++;
-                                }
-                            }
-                        }
-                        if (!prec->cblk[cblkno].data)
-                            prec->cblk[cblkno].data = av_malloc(1 + 8192);
-                        if (!prec->cblk[cblkno].passes)
-                            prec->cblk[cblkno].passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof (*prec->cblk[cblkno].passes));
-                        if (!prec->cblk[cblkno].data || !prec->cblk[cblkno].passes)
-                            return AVERROR(ENOMEM);
-                        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
-                                    bandpos, codsty->nreslevels - reslevelno - 1);
-                        xx0 = xx1;
-                        xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
-                    }
-                    yy0 = yy1;
-                    yy1 = FFMIN(yy1 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
+    if (reslevelno == 0 || bandno == 1)
+        xx0 = 0;
+    else
+        xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
+    x0 = xx0;
+    xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
+                band->coord[0][1]) - band->coord[0][0] + xx0;
+
+    cblkno = row->cblky * prec->nb_codeblocks_width;
+    for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
+        int y, x;
+        if (codsty->transform == FF_DWT53){
+            for (y = yy0; y < yy1; y++){
+                int *ptr = t1.data + (y-yy0)*t1.stride;
+                for (x = xx0; x < xx1; x++){
+                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
+                }
+            }
+        } else{
+            for (y = yy0; y < yy1; y++){
+                int *ptr = t1.data + (y-yy0)*t1.stride;
+                for (x = xx0; x < xx1; x++){
+                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
+                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
+                    ptr++;
                 }
             }
         }
-        av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
+        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
+                    bandpos, codsty->nreslevels - reslevelno - 1);
+        xx0 = xx1;
+        xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
     }
+    return 0;
+}
+
+/**
+ * Transform all tile components and code all code-blocks of the picture,
+ * in parallel when slice threading is enabled.
+ */
+static int encode_tier1(Jpeg2000EncoderContext *s)
+{
+    AVCodecContext *avctx = s->avctx;
+    int nb_comps = s->numXtiles * s->numYtiles * s->ncomponents;
+    int *rets, i, ret = 0;
+
+    rets = av_malloc_array(nb_comps, sizeof(*rets));
+    if (!rets)
+        return AVERROR(ENOMEM);
+
+    av_log(avctx, AV_LOG_DEBUG,"dwt\n");
+    avctx->execute2(avctx, dwt_tile_comp, NULL, rets, nb_comps);
+    for (i = 0; i < nb_comps; i++)
+        if (rets[i] < 0)
+            ret = rets[i];
+    av_free(rets);
+    if (ret < 0)
+        return ret;
+
+    av_log(avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
+    avctx->execute2(avctx, encode_cblk_row, NULL, NULL, s->nb_cblk_rows);
+    av_log(avctx, AV_LOG_DEBUG, "after tier1\n");
+
+    return 0;
+}
+
+static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+{
+    int ret;
 
     av_log(s->avctx, AV_LOG_DEBUG, "rate control\n");
     if (s->compression_rate_enc)
@@ -1495,6 +1587,7 @@ static void cleanup(Jpeg2000EncoderContext *s)
     int tileno, compno;
     Jpeg2000CodingStyle *codsty = &s->codsty;
 
+    av_freep(&s->cblk_rows);
     if (!s->tile)
         return;
     for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++){
@@ -1626,6 +1719,9 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         bytestream_put_buffer(&s->buf, "jp2c", 4);
     }
 
+    if ((ret = encode_tier1(s)) < 0)
+        return ret;
+
     if (s->buf_end - s->buf < 2)
         return -1;
     bytestream_put_be16(&s->buf, JPEG2000_SOC);
@@ -1793,6 +1889,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
     init_quantization(s);
     if ((ret=init_tiles(s)) < 0)
         return ret;
+    if ((ret = init_cblk_rows(s)) < 0)
+        return ret;
 
     av_log(s->avctx, AV_LOG_DEBUG, "after init\n");
 
@@ -1848,6 +1946,7 @@ AVCodec ff_jpeg2000_encoder = {
     .init           = j2kenc_init,
     .encode2        = encode_frame,
     .close          = j2kenc_destroy,
+    .capabilities   = AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_YUV444P, AV_PIX_FMT_GRAY8,
         AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P,
@@ -76,6 +76,45 @@ static inline void extend97_int(int32_t *p, int i0, int i1)
     }
 }
 
+/* row k of a column block */
+#define COL(p, k) ((p) + (k) * FF_DWT_COLS)
+
+static void lift53_odd_c(int32_t *dst, const int32_t *src0,
+                         const int32_t *src1, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[i] -= (src0[i] + src1[i]) >> 1;
+}
+
+static void lift53_even_c(int32_t *dst, const int32_t *src0,
+                          const int32_t *src1, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[i] += (src0[i] + src1[i] + 2) >> 2;
+}
+
+static void lift97_int_sub_c(int32_t *dst, const int32_t *src0,
+                             const int32_t *src1, int n, int coef)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[i] -= (coef * (int64_t)(src0[i] + src1[i]) + (1 << 15)) >> 16;
+}
+
+static void lift97_int_add_c(int32_t *dst, const int32_t *src0,
+                             const int32_t *src1, int n, int coef)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[i] += (coef * (int64_t)(src0[i] + src1[i]) + (1 << 15)) >> 16;
+}
+
 static void sd_1d53(int *p, int i0, int i1)
 {
     int i;
@@ -94,11 +133,35 @@ static void sd_1d53(int *p, int i0, int i1)
         p[2*i] += (p[2*i-1] + p[2*i+1] + 2) >> 2;
 }
 
+/* sd_1d53() on the n first columns of a column block */
+static void sd_1d53_cols(DWTContext *s, int32_t *p, int i0, int i1, int n)
+{
+    int i;
+
+    if (i1 <= i0 + 1) {
+        if (i0 == 1)
+            for (i = 0; i < n; i++)
+                COL(p, 1)[i] <<= 1;
+        return;
+    }
+
+    memcpy(COL(p, i0 - 1), COL(p, i0 + 1), n * sizeof(*p));
+    memcpy(COL(p, i1),     COL(p, i1 - 2), n * sizeof(*p));
+    memcpy(COL(p, i0 - 2), COL(p, i0 + 2), n * sizeof(*p));
+    memcpy(COL(p, i1 + 1), COL(p, i1 - 3), n * sizeof(*p));
+
+    for (i = ((i0+1)>>1) - 1; i < (i1+1)>>1; i++)
+        s->lift53_odd(COL(p, 2*i+1), COL(p, 2*i), COL(p, 2*i+2), n);
+    for (i = ((i0+1)>>1); i < (i1+1)>>1; i++)
+        s->lift53_even(COL(p, 2*i), COL(p, 2*i-1), COL(p, 2*i+1), n);
+}
+
 static void dwt_encode53(DWTContext *s, int *t)
 {
     int lev,
         w = s->linelen[s->ndeclevels-1][0];
     int *line = s->i_linebuf;
+    int32_t *col = s->i_colbuf + 3 * FF_DWT_COLS;
     line += 3;
 
     for (lev = s->ndeclevels-1; lev >= 0; lev--){
@@ -109,21 +172,22 @@ static void dwt_encode53(DWTContext *s, int *t)
             lp;
         int *l;
 
-        // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
+        // VER_SD, FF_DWT_COLS columns at a time
+        l = COL(col, mv);
+        for (lp = 0; lp < lh; lp += FF_DWT_COLS) {
+            int n = FFMIN(FF_DWT_COLS, lh - lp);
             int i, j = 0;
 
             for (i = 0; i < lv; i++)
-                l[i] = t[w*i + lp];
+                memcpy(COL(l, i), &t[w*i + lp], n * sizeof(*t));
 
-            sd_1d53(line, mv, mv + lv);
+            sd_1d53_cols(s, col, mv, mv + lv, n);
 
             // copy back and deinterleave
             for (i =   mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
+                memcpy(&t[w*j + lp], COL(l, i), n * sizeof(*t));
             for (i = 1-mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
+                memcpy(&t[w*j + lp], COL(l, i), n * sizeof(*t));
         }
 
         // HOR_SD
@@ -245,6 +309,37 @@ static void sd_1d97_int(int *p, int i0, int i1)
         p[2 * i]     += (I_LFTG_DELTA * (p[2 * i - 1] + p[2 * i + 1]) + (1 << 15)) >> 16;
 }
 
+/* sd_1d97_int() on the n first columns of a column block */
+static void sd_1d97_int_cols(DWTContext *s, int32_t *p, int i0, int i1, int n)
+{
+    int i, j;
+
+    if (i1 <= i0 + 1) {
+        if (i0 == 1)
+            for (j = 0; j < n; j++)
+                COL(p, 1)[j] = (COL(p, 1)[j] * I_LFTG_X + (1<<14)) >> 15;
+        else
+            for (j = 0; j < n; j++)
+                COL(p, 0)[j] = (COL(p, 0)[j] * I_LFTG_K + (1<<15)) >> 16;
+        return;
+    }
+
+    for (i = 1; i <= 4; i++) {
+        memcpy(COL(p, i0 - i),     COL(p, i0 + i),     n * sizeof(*p));
+        memcpy(COL(p, i1 + i - 1), COL(p, i1 - i - 1), n * sizeof(*p));
+    }
+    i0++; i1++;
+
+    for (i = (i0>>1) - 2; i < (i1>>1) + 1; i++)
+        s->lift97_int_sub(COL(p, 2*i+1), COL(p, 2*i),   COL(p, 2*i+2), n, I_LFTG_ALPHA);
+    for (i = (i0>>1) - 1; i < (i1>>1) + 1; i++)
+        s->lift97_int_sub(COL(p, 2*i),   COL(p, 2*i-1), COL(p, 2*i+1), n, I_LFTG_BETA);
+    for (i = (i0>>1) - 1; i < (i1>>1); i++)
+        s->lift97_int_add(COL(p, 2*i+1), COL(p, 2*i),   COL(p, 2*i+2), n, I_LFTG_GAMMA);
+    for (i = (i0>>1); i < (i1>>1); i++)
+        s->lift97_int_add(COL(p, 2*i),   COL(p, 2*i-1), COL(p, 2*i+1), n, I_LFTG_DELTA);
+}
+
 static void dwt_encode97_int(DWTContext *s, int *t)
 {
     int lev;
@@ -252,6 +347,7 @@ static void dwt_encode97_int(DWTContext *s, int *t)
     int h = s->linelen[s->ndeclevels-1][1];
     int i;
     int *line = s->i_linebuf;
+    int32_t *col = s->i_colbuf + 5 * FF_DWT_COLS;
     line += 5;
 
     for (i = 0; i < w * h; i++)
@@ -265,21 +361,23 @@ static void dwt_encode97_int(DWTContext *s, int *t)
             lp;
         int *l;
 
-        // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
+        // VER_SD, FF_DWT_COLS columns at a time
+        l = COL(col, mv);
+        for (lp = 0; lp < lh; lp += FF_DWT_COLS) {
+            int n = FFMIN(FF_DWT_COLS, lh - lp);
+            int i, j = 0, k;
 
             for (i = 0; i < lv; i++)
-                l[i] = t[w*i + lp];
+                memcpy(COL(l, i), &t[w*i + lp], n * sizeof(*t));
 
-            sd_1d97_int(line, mv, mv + lv);
+            sd_1d97_int_cols(s, col, mv, mv + lv, n);
 
             // copy back and deinterleave
             for (i =   mv; i < lv; i+=2, j++)
-                t[w*j + lp] = ((l[i] * I_LFTG_X) + (1 << 15)) >> 16;
+                for (k = 0; k < n; k++)
+                    t[w*j + lp + k] = ((COL(l, i)[k] * I_LFTG_X) + (1 << 15)) >> 16;
             for (i = 1-mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
+                memcpy(&t[w*j + lp], COL(l, i), n * sizeof(*t));
         }
 
         // HOR_SD
@@ -575,6 +673,14 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
     default:
         return -1;
     }
+
+    s->lift53_odd     = lift53_odd_c;
+    s->lift53_even    = lift53_even_c;
+    s->lift97_int_sub = lift97_int_sub_c;
+    s->lift97_int_add = lift97_int_add_c;
+    if (ARCH_X86)
+        ff_jpeg2000dwt_init_x86(s);
+
     return 0;
 }
 
@@ -583,6 +689,13 @@ int ff_dwt_encode(DWTContext *s, void *t)
     if (s->ndeclevels == 0)
         return 0;
 
+    if (s->type != FF_DWT97 && !s->i_colbuf) {
+        int lv = s->linelen[s->ndeclevels - 1][1];
+        s->i_colbuf = av_mallocz_array((lv + 12) * FF_DWT_COLS, sizeof(*s->i_colbuf));
+        if (!s->i_colbuf)
+            return AVERROR(ENOMEM);
+    }
+
     switch(s->type){
         case FF_DWT97:
             dwt_encode97_float(s, t); break;
@@ -621,4 +734,5 @@ void ff_dwt_destroy(DWTContext *s)
 {
     av_freep(&s->f_linebuf);
     av_freep(&s->i_linebuf);
+    av_freep(&s->i_colbuf);
 }
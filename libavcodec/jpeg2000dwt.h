@@ -30,6 +30,7 @@
 #include <stdint.h>
 
 #define FF_DWT_MAX_DECLVLS 32 ///< max number of decomposition levels
+#define FF_DWT_COLS        32 ///< columns processed at once by the forward vertical transforms
 #define F_LFTG_K      1.230174104914001f
 #define F_LFTG_X      0.812893066115961f
 
@@ -48,6 +49,23 @@ typedef struct DWTContext {
     uint8_t type;                        ///< 0 for 9/7; 1 for 5/3
     int32_t *i_linebuf;                  ///< int buffer used by transform
     float   *f_linebuf;                  ///< float buffer used by transform
+    int32_t *i_colbuf;                   ///< column block buffer used by the forward transforms
+
+    /**
+     * Lifting steps of the forward integer transforms, applied to the n
+     * first elements of a row of a column block. Implementations may
+     * process up to FF_DWT_COLS elements; n > 0.
+     * dst[i] -= (src0[i] + src1[i]) >> 1
+     */
+    void (*lift53_odd)(int32_t *dst, const int32_t *src0, const int32_t *src1, int n);
+    /** dst[i] += (src0[i] + src1[i] + 2) >> 2 */
+    void (*lift53_even)(int32_t *dst, const int32_t *src0, const int32_t *src1, int n);
+    /** dst[i] -= (coef * (int64_t)(src0[i] + src1[i]) + (1 << 15)) >> 16 */
+    void (*lift97_int_sub)(int32_t *dst, const int32_t *src0, const int32_t *src1,
+                           int n, int coef);
+    /** dst[i] += (coef * (int64_t)(src0[i] + src1[i]) + (1 << 15)) >> 16 */
+    void (*lift97_int_add)(int32_t *dst, const int32_t *src0, const int32_t *src1,
+                           int n, int coef);
 } DWTContext;
 
 /**
@@ -65,4 +83,6 @@ int ff_dwt_decode(DWTContext *s, void *t);
 
 void ff_dwt_destroy(DWTContext *s);
 
+void ff_jpeg2000dwt_init_x86(DWTContext *s);
+
 #endif /* AVCODEC_JPEG2000DWT_H */
@@ -46,6 +46,7 @@
 #include "jpeglsdec.h"
 #include "profiles.h"
 #include "put_bits.h"
+#include "thread.h"
 #include "tiff.h"
 #include "exif.h"
 #include "bytestream.h"
@@ -707,7 +708,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
                 s->avctx->pix_fmt,
                 AV_PIX_FMT_NONE,
             };
-            s->hwaccel_pix_fmt = ff_get_format(s->avctx, pix_fmts);
+            s->hwaccel_pix_fmt = ff_thread_get_format(s->avctx, pix_fmts);
             if (s->hwaccel_pix_fmt < 0)
                 return AVERROR(EINVAL);
 
@@ -723,7 +724,8 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
         }
 
         av_frame_unref(s->picture_ptr);
-        if (ff_get_buffer(s->avctx, s->picture_ptr, AV_GET_BUFFER_FLAG_REF) < 0)
+        if (ff_thread_get_buffer(s->avctx, &(ThreadFrame){ .f = s->picture_ptr },
+                                 AV_GET_BUFFER_FLAG_REF) < 0)
             return -1;
         s->picture_ptr->pict_type = AV_PICTURE_TYPE_I;
         s->picture_ptr->key_frame = 1;
@@ -769,6 +771,12 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
         if (!s->hwaccel_picture_private)
             return AVERROR(ENOMEM);
 
+        /* no hwaccel calls may happen before the setup is finished */
+        if (!s->setup_finished) {
+            ff_thread_finish_setup(s->avctx);
+            s->setup_finished = 1;
+        }
+
         ret = s->avctx->hwaccel->start_frame(s->avctx, s->raw_image_buffer,
                                              s->raw_image_buffer_size);
         if (ret < 0)
@@ -778,10 +786,11 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     return 0;
 }
 
-static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
+static inline int mjpeg_decode_dc(MJpegDecodeContext *s, GetBitContext *gb,
+                                  int dc_index)
 {
     int code;
-    code = get_vlc2(&s->gb, s->vlcs[0][dc_index].table, 9, 2);
+    code = get_vlc2(gb, s->vlcs[0][dc_index].table, 9, 2);
     if (code < 0 || code > 16) {
         av_log(s->avctx, AV_LOG_WARNING,
                "mjpeg_decode_dc: bad vlc: %d:%d (%p)\n",
@@ -790,47 +799,48 @@ static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
     }
 
     if (code)
-        return get_xbits(&s->gb, code);
+        return get_xbits(gb, code);
     else
         return 0;
 }
 
 /* decode block and dequantize */
-static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
+static int decode_block(MJpegDecodeContext *s, GetBitContext *gb, int *last_dc,
+                        int16_t *block, int component,
                         int dc_index, int ac_index, uint16_t *quant_matrix)
 {
     int code, i, j, level, val;
 
     /* DC coef */
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
     }
-    val = val * (unsigned)quant_matrix[0] + s->last_dc[component];
+    val = val * (unsigned)quant_matrix[0] + last_dc[component];
     val = av_clip_int16(val);
-    s->last_dc[component] = val;
+    last_dc[component] = val;
     block[0] = val;
     /* AC coefs */
     i = 0;
-    {OPEN_READER(re, &s->gb);
+    {OPEN_READER(re, gb);
     do {
-        UPDATE_CACHE(re, &s->gb);
-        GET_VLC(code, re, &s->gb, s->vlcs[1][ac_index].table, 9, 2);
+        UPDATE_CACHE(re, gb);
+        GET_VLC(code, re, gb, s->vlcs[1][ac_index].table, 9, 2);
 
         i += ((unsigned)code) >> 4;
             code &= 0xf;
         if (code) {
             if (code > MIN_CACHE_BITS - 16)
-                UPDATE_CACHE(re, &s->gb);
+                UPDATE_CACHE(re, gb);
 
             {
-                int cache = GET_CACHE(re, &s->gb);
+                int cache = GET_CACHE(re, gb);
                 int sign  = (~cache) >> 31;
                 level     = (NEG_USR32(sign ^ cache,code) ^ sign) - sign;
             }
 
-            LAST_SKIP_BITS(re, &s->gb, code);
+            LAST_SKIP_BITS(re, gb, code);
 
             if (i > 63) {
                 av_log(s->avctx, AV_LOG_ERROR, "error count: %d\n", i);
@@ -840,24 +850,25 @@ static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
             block[j] = level * quant_matrix[i];
         }
     } while (i < 63);
-    CLOSE_READER(re, &s->gb);}
+    CLOSE_READER(re, gb);}
 
     return 0;
 }
 
-static int decode_dc_progressive(MJpegDecodeContext *s, int16_t *block,
+static int decode_dc_progressive(MJpegDecodeContext *s, GetBitContext *gb,
+                                 int *last_dc, int16_t *block,
                                  int component, int dc_index,
                                  uint16_t *quant_matrix, int Al)
 {
     unsigned val;
     s->bdsp.clear_block(block);
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
     }
-    val = (val * (quant_matrix[0] << Al)) + s->last_dc[component];
-    s->last_dc[component] = val;
+    val = (val * (quant_matrix[0] << Al)) + last_dc[component];
+    last_dc[component] = val;
     block[0] = val;
     return 0;
 }
@@ -1145,7 +1156,7 @@ static int ljpeg_decode_rgb_scan(MJpegDecodeContext *s, int nb_components, int p
                 topleft[i] = top[i];
                 top[i]     = buffer[mb_x][i];
 
-                dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                 if(dc == 0xFFFFF)
                     return -1;
 
@@ -1279,7 +1290,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for(j=0; j<n; j++) {
                         int pred, dc;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1350,7 +1361,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for (j = 0; j < n; j++) {
                         int pred;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1419,17 +1430,174 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
+typedef struct MJpegScanContext {
+    int nb_components;
+    int Ah, Al;
+    uint8_t *data[MAX_COMPONENTS];
+    const uint8_t *reference_data[MAX_COMPONENTS];
+    int linesize[MAX_COMPONENTS];
+    int chroma_width, chroma_height;
+    int bytes_per_pixel;
+
+    /* restart interval slices */
+    int nb_segments;
+    int segments_per_job;
+    int end_bits;
+} MJpegScanContext;
+
+static int decode_mcu(MJpegDecodeContext *s, const MJpegScanContext *sc,
+                      GetBitContext *gb, int *last_dc, int16_t *block,
+                      int mb_x, int mb_y, int copy_mb)
+{
+    int i;
+
+    for (i = 0; i < sc->nb_components; i++) {
+        uint8_t *ptr;
+        int n, h, v, x, y, c, j;
+        int block_offset;
+        n = s->nb_blocks[i];
+        c = s->comp_index[i];
+        h = s->h_scount[i];
+        v = s->v_scount[i];
+        x = 0;
+        y = 0;
+        for (j = 0; j < n; j++) {
+            block_offset = (((sc->linesize[c] * (v * mb_y + y) * 8) +
+                             (h * mb_x + x) * 8 * sc->bytes_per_pixel) >> s->avctx->lowres);
+
+            if (s->interlaced && s->bottom_field)
+                block_offset += sc->linesize[c] >> 1;
+            if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? sc->chroma_width  : s->width)
+                && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? sc->chroma_height : s->height)) {
+                ptr = sc->data[c] + block_offset;
+            } else
+                ptr = NULL;
+            if (!s->progressive) {
+                if (copy_mb) {
+                    if (ptr)
+                        mjpeg_copy_block(s, ptr, sc->reference_data[c] + block_offset,
+                                        sc->linesize[c], s->avctx->lowres);
+
+                } else {
+                    s->bdsp.clear_block(block);
+                    if (decode_block(s, gb, last_dc, block, i,
+                                     s->dc_index[i], s->ac_index[i],
+                                     s->quant_matrixes[s->quant_sindex[i]]) < 0) {
+                        av_log(s->avctx, AV_LOG_ERROR,
+                               "error y=%d x=%d\n", mb_y, mb_x);
+                        return AVERROR_INVALIDDATA;
+                    }
+                    if (ptr) {
+                        s->idsp.idct_put(ptr, sc->linesize[c], block);
+                        if (s->bits & 7)
+                            shift_output(s, ptr, sc->linesize[c]);
+                    }
+                }
+            } else {
+                int block_idx  = s->block_stride[c] * (v * mb_y + y) +
+                                 (h * mb_x + x);
+                int16_t *pblock = s->blocks[c][block_idx];
+                if (sc->Ah)
+                    pblock[0] += get_bits1(gb) *
+                                 s->quant_matrixes[s->quant_sindex[i]][0] << sc->Al;
+                else if (decode_dc_progressive(s, gb, last_dc, pblock, i, s->dc_index[i],
+                                               s->quant_matrixes[s->quant_sindex[i]],
+                                               sc->Al) < 0) {
+                    av_log(s->avctx, AV_LOG_ERROR,
+                           "error y=%d x=%d\n", mb_y, mb_x);
+                    return AVERROR_INVALIDDATA;
+                }
+            }
+            ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
+            ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
+                    mb_x, mb_y, x, y, c, s->bottom_field,
+                    (v * mb_y + y) * 8, (h * mb_x + x) * 8);
+            if (++x == h) {
+                x = 0;
+                y++;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Check that the restart markers recorded while unescaping the scan split it
+ * into the expected number of intervals, numbered RST0..RST7 in sequence, so
+ * that the intervals can be decoded independently.
+ */
+static int scan_restart_segments(MJpegDecodeContext *s)
+{
+    int nb_mbs = s->mb_width * s->mb_height;
+    int nb_segments, i;
+
+    if (!s->restart_interval || s->nb_rst < 0 ||
+        s->gb.buffer != s->buffer || s->avctx->codec_id == AV_CODEC_ID_THP)
+        return 0;
+
+    nb_segments = (nb_mbs + s->restart_interval - 1) / s->restart_interval;
+    if (nb_segments < 2 || s->nb_rst != nb_segments - 1)
+        return 0;
+
+    for (i = 0; i < s->nb_rst; i++) {
+        if (s->rst_offsets[i] * 8 < get_bits_count(&s->gb) ||
+            s->buffer[s->rst_offsets[i]] != RST0 + (i & 7))
+            return 0;
+    }
+    return nb_segments;
+}
+
+static int decode_scan_slice(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    MJpegScanContext  *sc = arg;
+    int nb_mbs = s->mb_width * s->mb_height;
+    int first  = jobnr * sc->segments_per_job;
+    int last   = FFMIN(first + sc->segments_per_job, sc->nb_segments);
+    LOCAL_ALIGNED_32(int16_t, block, [64]);
+    int seg, ret = 0;
+
+    for (seg = first; seg < last; seg++) {
+        GetBitContext gb = s->gb;
+        int last_dc[MAX_COMPONENTS];
+        int mb = seg * s->restart_interval;
+        int mb_end = FFMIN(mb + s->restart_interval, nb_mbs);
+        int i, start = 0;
+
+        /* the first interval starts right after the SOS header, the others
+         * right after the marker ending the previous one */
+        if (seg) {
+            start = s->rst_offsets[seg - 1] + 1;
+            init_get_bits8(&gb, s->buffer + start,
+                           s->gb.buffer_end - s->buffer - start);
+        }
+        for (i = 0; i < sc->nb_components; i++)
+            last_dc[i] = (4 << s->bits);
+
+        for (; mb < mb_end; mb++) {
+            if (get_bits_left(&gb) < 0) {
+                av_log(avctx, AV_LOG_ERROR, "overread %d\n", -get_bits_left(&gb));
+                ret = AVERROR_INVALIDDATA;
+                break;
+            }
+            if ((ret = decode_mcu(s, sc, &gb, last_dc, block,
+                                  mb % s->mb_width, mb / s->mb_width, 0)) < 0)
+                break;
+        }
+        if (seg == sc->nb_segments - 1 && ret >= 0)
+            sc->end_bits = start * 8 + get_bits_count(&gb);
+    }
+    return ret;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
                              int mb_bitmask_size,
                              const AVFrame *reference)
 {
-    int i, mb_x, mb_y, chroma_h_shift, chroma_v_shift, chroma_width, chroma_height;
-    uint8_t *data[MAX_COMPONENTS];
-    const uint8_t *reference_data[MAX_COMPONENTS];
-    int linesize[MAX_COMPONENTS];
+    int i, mb_x, mb_y, chroma_h_shift, chroma_v_shift;
+    MJpegScanContext sc = { 0 };
     GetBitContext mb_bitmask_gb = {0}; // initialize to silence gcc warning
-    int bytes_per_pixel = 1 + (s->bits > 8);
 
     if (mb_bitmask) {
         if (mb_bitmask_size != (s->mb_width * s->mb_height + 7)>>3) {
@@ -1443,20 +1611,51 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
 
     av_pix_fmt_get_chroma_sub_sample(s->avctx->pix_fmt, &chroma_h_shift,
                                      &chroma_v_shift);
-    chroma_width  = AV_CEIL_RSHIFT(s->width,  chroma_h_shift);
-    chroma_height = AV_CEIL_RSHIFT(s->height, chroma_v_shift);
+    sc.nb_components   = nb_components;
+    sc.Ah              = Ah;
+    sc.Al              = Al;
+    sc.chroma_width    = AV_CEIL_RSHIFT(s->width,  chroma_h_shift);
+    sc.chroma_height   = AV_CEIL_RSHIFT(s->height, chroma_v_shift);
+    sc.bytes_per_pixel = 1 + (s->bits > 8);
 
     for (i = 0; i < nb_components; i++) {
         int c   = s->comp_index[i];
-        data[c] = s->picture_ptr->data[c];
-        reference_data[c] = reference ? reference->data[c] : NULL;
-        linesize[c] = s->linesize[c];
+        sc.data[c] = s->picture_ptr->data[c];
+        sc.reference_data[c] = reference ? reference->data[c] : NULL;
+        sc.linesize[c] = s->linesize[c];
         s->coefs_finished[c] |= 1;
     }
 
+    /* Restart intervals are independent, decode them in parallel. */
+    if (!mb_bitmask && !s->progressive &&
+        s->avctx->active_thread_type & FF_THREAD_SLICE &&
+        s->avctx->thread_count > 1 &&
+        (sc.nb_segments = scan_restart_segments(s)) > 0) {
+        int nb_jobs = FFMIN(s->avctx->thread_count, sc.nb_segments);
+        int *rets = av_malloc_array(nb_jobs, sizeof(*rets));
+        int ret = 0;
+
+        if (!rets)
+            return AVERROR(ENOMEM);
+
+        sc.segments_per_job = (sc.nb_segments + nb_jobs - 1) / nb_jobs;
+        nb_jobs             = (sc.nb_segments + sc.segments_per_job - 1) / sc.segments_per_job;
+        sc.end_bits         = get_bits_count(&s->gb);
+
+        s->avctx->execute2(s->avctx, decode_scan_slice, &sc, rets, nb_jobs);
+        for (i = 0; i < nb_jobs; i++)
+            if (rets[i] < 0)
+                ret = rets[i];
+        av_free(rets);
+
+        skip_bits_long(&s->gb, sc.end_bits - get_bits_count(&s->gb));
+        return ret;
+    }
+
     for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
         for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
             const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
+            int ret;
 
             if (s->restart_interval && !s->restart_count)
                 s->restart_count = s->restart_interval;
@@ -1466,73 +1665,9 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                        -get_bits_left(&s->gb));
                 return AVERROR_INVALIDDATA;
             }
-            for (i = 0; i < nb_components; i++) {
-                uint8_t *ptr;
-                int n, h, v, x, y, c, j;
-                int block_offset;
-                n = s->nb_blocks[i];
-                c = s->comp_index[i];
-                h = s->h_scount[i];
-                v = s->v_scount[i];
-                x = 0;
-                y = 0;
-                for (j = 0; j < n; j++) {
-                    block_offset = (((linesize[c] * (v * mb_y + y) * 8) +
-                                     (h * mb_x + x) * 8 * bytes_per_pixel) >> s->avctx->lowres);
-
-                    if (s->interlaced && s->bottom_field)
-                        block_offset += linesize[c] >> 1;
-                    if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? chroma_width  : s->width)
-                        && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? chroma_height : s->height)) {
-                        ptr = data[c] + block_offset;
-                    } else
-                        ptr = NULL;
-                    if (!s->progressive) {
-                        if (copy_mb) {
-                            if (ptr)
-                                mjpeg_copy_block(s, ptr, reference_data[c] + block_offset,
-                                                linesize[c], s->avctx->lowres);
-
-                        } else {
-                            s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
-                                             s->dc_index[i], s->ac_index[i],
-                                             s->quant_matrixes[s->quant_sindex[i]]) < 0) {
-                                av_log(s->avctx, AV_LOG_ERROR,
-                                       "error y=%d x=%d\n", mb_y, mb_x);
-                                return AVERROR_INVALIDDATA;
-                            }
-                            if (ptr) {
-                                s->idsp.idct_put(ptr, linesize[c], s->block);
-                                if (s->bits & 7)
-                                    shift_output(s, ptr, linesize[c]);
-                            }
-                        }
-                    } else {
-                        int block_idx  = s->block_stride[c] * (v * mb_y + y) +
-                                         (h * mb_x + x);
-                        int16_t *block = s->blocks[c][block_idx];
-                        if (Ah)
-                            block[0] += get_bits1(&s->gb) *
-                                        s->quant_matrixes[s->quant_sindex[i]][0] << Al;
-                        else if (decode_dc_progressive(s, block, i, s->dc_index[i],
-                                                       s->quant_matrixes[s->quant_sindex[i]],
-                                                       Al) < 0) {
-                            av_log(s->avctx, AV_LOG_ERROR,
-                                   "error y=%d x=%d\n", mb_y, mb_x);
-                            return AVERROR_INVALIDDATA;
-                        }
-                    }
-                    ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
-                    ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
-                            mb_x, mb_y, x, y, c, s->bottom_field,
-                            (v * mb_y + y) * 8, (h * mb_x + x) * 8);
-                    if (++x == h) {
-                        x = 0;
-                        y++;
-                    }
-                }
-            }
+            if ((ret = decode_mcu(s, &sc, &s->gb, s->last_dc, s->block,
+                                  mb_x, mb_y, copy_mb)) < 0)
+                return ret;
 
             handle_rstn(s, nb_components);
         }
@@ -2214,6 +2349,8 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
     if (!s->buffer)
         return AVERROR(ENOMEM);
 
+    s->nb_rst = -1;
+
     /* unescape buffer of SOS, use special treatment for JPEG-LS */
     if (start_code == SOS && !s->ls) {
         const uint8_t *src = *buf_ptr;
@@ -2233,6 +2370,10 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
             ptr = buf_end;
             copy_data_segment(0);
         } else {
+            /* restart markers are only located for slice threading */
+            if (s->avctx->active_thread_type & FF_THREAD_SLICE)
+                s->nb_rst = 0;
+
             while (ptr < buf_end) {
                 uint8_t x = *(ptr++);
 
@@ -2257,6 +2398,15 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                         copy_data_segment(1);
                         if (x)
                             break;
+                    } else if (s->nb_rst >= 0) {
+                        /* offset of the RSTn byte in the unescaped buffer */
+                        int *offsets = av_fast_realloc(s->rst_offsets, &s->rst_offsets_size,
+                                                       (s->nb_rst + 1) * sizeof(*s->rst_offsets));
+                        if (offsets) {
+                            s->rst_offsets = offsets;
+                            s->rst_offsets[s->nb_rst++] = (dst - s->buffer) + (ptr - 1 - src);
+                        } else
+                            s->nb_rst = -1;
                     }
                 }
             }
@@ -2391,12 +2541,35 @@ static int mjpeg_get_packet(AVCodecContext *avctx)
     }
 #endif
 
-    s->buf_size = s->pkt->size;
+    return 0;
+}
 
+/**
+ * Check whether Huffman or quantisation tables are defined after the
+ * current scan. The next frame thread inherits the tables, so it may only
+ * start once they are final. Entropy coded data cannot contain these
+ * markers; a match inside another marker segment only delays the setup.
+ */
+static int tables_follow(const uint8_t *buf, const uint8_t *buf_end)
+{
+    while (buf_end - buf >= 2) {
+        const uint8_t *p = memchr(buf, 0xff, buf_end - buf - 1);
+        if (!p)
+            break;
+        if (p[1] == DHT || p[1] == DQT)
+            return 1;
+        buf = p + 1;
+    }
     return 0;
 }
 
-int ff_mjpeg_receive_frame(AVCodecContext *avctx, AVFrame *frame)
+/**
+ * Decode one JPEG picture.
+ * @return 0 if a picture was output, AVERROR(EAGAIN) if none was, or a
+ *         negative error code
+ */
+static int mjpeg_decode_packet(AVCodecContext *avctx, AVFrame *frame,
+                               const AVPacket *pkt)
 {
     MJpegDecodeContext *s = avctx->priv_data;
     const uint8_t *buf_end, *buf_ptr;
@@ -2408,22 +2581,17 @@ int ff_mjpeg_receive_frame(AVCodecContext *avctx, AVFrame *frame)
     int ret = 0;
     int is16bit;
 
-    if (avctx->codec_id == AV_CODEC_ID_SMVJPEG && s->smv_next_frame > 0)
-        return smv_process_frame(avctx, frame);
-
     av_dict_free(&s->exif_metadata);
     av_freep(&s->stereo3d);
     s->adobe_transform = -1;
+    s->setup_finished  = 0;
 
     if (s->iccnum != 0)
         reset_icc_profile(s);
 
-    ret = mjpeg_get_packet(avctx);
-    if (ret < 0)
-        return ret;
-
-    buf_ptr = s->pkt->data;
-    buf_end = s->pkt->data + s->pkt->size;
+    s->buf_size = pkt->size;
+    buf_ptr = pkt->data;
+    buf_end = pkt->data + pkt->size;
     while (buf_ptr < buf_end) {
         /* find start next marker */
         start_code = ff_mjpeg_find_marker(s, &buf_ptr, buf_end,
@@ -2435,7 +2603,7 @@ int ff_mjpeg_receive_frame(AVCodecContext *avctx, AVFrame *frame)
         } else if (unescaped_buf_size > INT_MAX / 8) {
             av_log(avctx, AV_LOG_ERROR,
                    "MJPEG packet 0x%x too big (%d/%d), corrupt data?\n",
-                   start_code, unescaped_buf_size, s->pkt->size);
+                   start_code, unescaped_buf_size, pkt->size);
             return AVERROR_INVALIDDATA;
         }
         av_log(avctx, AV_LOG_DEBUG, "marker=%x avail_size_in_buf=%"PTRDIFF_SPECIFIER"\n",
@@ -2586,7 +2754,7 @@ eoi_parser:
                 return ret;
             s->got_picture = 0;
 
-            frame->pkt_dts = s->pkt->dts;
+            frame->pkt_dts = pkt->dts;
 
             if (!s->lossless && avctx->debug & FF_DEBUG_QP) {
                 int qp = FFMAX3(s->qscale[0],
@@ -2607,6 +2775,19 @@ eoi_parser:
                 break;
             }
 
+            /* Let the next frame thread start once the tables preceding the
+             * first scan are known, unless more tables follow for later
+             * scans. Interlaced pictures may continue in the next packet and
+             * progressive ones usually redefine tables between scans, so
+             * those are only handed over when done. */
+            if (!s->setup_finished && s->got_picture &&
+                !s->interlaced && !s->progressive &&
+                avctx->active_thread_type & FF_THREAD_FRAME &&
+                !tables_follow(buf_ptr, buf_end)) {
+                ff_thread_finish_setup(avctx);
+                s->setup_finished = 1;
+            }
+
             if ((ret = ff_mjpeg_decode_sos(s, NULL, 0, NULL)) < 0 &&
                 (avctx->err_recognition & AV_EF_EXPLODE))
                 goto fail;
@@ -2887,6 +3068,121 @@ the_end_no_picture:
     return ret;
 }
 
+int ff_mjpeg_receive_frame(AVCodecContext *avctx, AVFrame *frame)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    int ret;
+
+    if (avctx->codec_id == AV_CODEC_ID_SMVJPEG && s->smv_next_frame > 0)
+        return smv_process_frame(avctx, frame);
+
+    ret = mjpeg_get_packet(avctx);
+    if (ret < 0)
+        return ret;
+
+    return mjpeg_decode_packet(avctx, frame, s->pkt);
+}
+
+#if CONFIG_MJPEG_DECODER || CONFIG_THP_DECODER
+static int mjpeg_decode_frame(AVCodecContext *avctx, void *data,
+                              int *got_frame, AVPacket *avpkt)
+{
+    int ret = mjpeg_decode_packet(avctx, data, avpkt);
+
+    if (ret == AVERROR(EAGAIN))
+        return avpkt->size;
+    if (ret < 0)
+        return ret;
+
+    *got_frame = 1;
+    return avpkt->size;
+}
+
+#if HAVE_THREADS
+static int update_huffman_tables(MJpegDecodeContext *dst,
+                                 const MJpegDecodeContext *src)
+{
+    int class, index, ret;
+
+    for (class = 0; class < 2; class++) {
+        for (index = 0; index < 4; index++) {
+            const uint8_t *lengths = src->raw_huffman_lengths[class][index];
+            const uint8_t *values  = src->raw_huffman_values[class][index];
+            uint8_t bits_table[17] = { 0 };
+            int i, n = 0;
+
+            for (i = 0; i < 16; i++)
+                n += lengths[i];
+            if (!n ||
+                (!memcmp(dst->raw_huffman_lengths[class][index], lengths, 16) &&
+                 !memcmp(dst->raw_huffman_values[class][index], values, n)))
+                continue;
+
+            memcpy(bits_table + 1, lengths, 16);
+            ff_free_vlc(&dst->vlcs[class][index]);
+            if ((ret = ff_mjpeg_build_vlc(&dst->vlcs[class][index], bits_table,
+                                          values, class > 0, dst->avctx)) < 0)
+                return ret;
+            if (class > 0) {
+                ff_free_vlc(&dst->vlcs[2][index]);
+                if ((ret = ff_mjpeg_build_vlc(&dst->vlcs[2][index], bits_table,
+                                              values, 0, dst->avctx)) < 0)
+                    return ret;
+            }
+            memcpy(dst->raw_huffman_lengths[class][index], lengths, 16);
+            memcpy(dst->raw_huffman_values[class][index],  values,  256);
+        }
+    }
+    return 0;
+}
+
+static int mjpeg_update_thread_context(AVCodecContext *dst,
+                                       const AVCodecContext *src)
+{
+    MJpegDecodeContext *s = dst->priv_data, *s1 = src->priv_data;
+    int ret;
+
+    if (dst == src)
+        return 0;
+
+    /* tables persist across pictures when a stream omits them */
+    memcpy(s->quant_matrixes, s1->quant_matrixes, sizeof(s->quant_matrixes));
+    memcpy(s->qscale,         s1->qscale,         sizeof(s->qscale));
+    if ((ret = update_huffman_tables(s, s1)) < 0)
+        return ret;
+
+    /* The first field of an interlaced picture is completed by the
+     * second one in the next packet. */
+    s->got_picture = 0;
+    if (s1->interlaced && s1->got_picture &&
+        s1->bottom_field == !s1->interlace_polarity) {
+        av_frame_unref(s->picture_ptr);
+        if ((ret = av_frame_ref(s->picture_ptr, s1->picture_ptr)) < 0)
+            return ret;
+
+        s->width         = s1->width;
+        s->height        = s1->height;
+        s->bits          = s1->bits;
+        s->nb_components = s1->nb_components;
+        s->rgb           = s1->rgb;
+        s->first_picture = s1->first_picture;
+        s->pix_desc      = s1->pix_desc;
+        s->got_picture   = 1;
+        memcpy(s->h_count,  s1->h_count,  sizeof(s->h_count));
+        memcpy(s->v_count,  s1->v_count,  sizeof(s->v_count));
+        memcpy(s->linesize, s1->linesize, sizeof(s->linesize));
+        s->hwaccel_pix_fmt    = s1->hwaccel_pix_fmt;
+        s->hwaccel_sw_pix_fmt = s1->hwaccel_sw_pix_fmt;
+    }
+    s->interlaced         = s1->interlaced;
+    s->bottom_field       = s1->bottom_field;
+    s->interlace_polarity = s1->interlace_polarity;
+
+    return 0;
+}
+#endif
+#endif
+
 /* mxpeg may call the following function (with a blank MJpegDecodeContext)
  * even without having called ff_mjpeg_decode_init(). */
 av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
@@ -2909,6 +3205,7 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     av_frame_free(&s->smv_frame);
 
     av_freep(&s->buffer);
+    av_freep(&s->rst_offsets);
     av_freep(&s->stereo3d);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
@@ -2963,9 +3260,11 @@ AVCodec ff_mjpeg_decoder = {
     .priv_data_size = sizeof(MJpegDecodeContext),
     .init           = ff_mjpeg_decode_init,
     .close          = ff_mjpeg_decode_end,
-    .receive_frame  = ff_mjpeg_receive_frame,
+    .decode         = mjpeg_decode_frame,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(mjpeg_update_thread_context),
     .flush          = decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .max_lowres     = 3,
     .priv_class     = &mjpegdec_class,
     .profiles       = NULL_IF_CONFIG_SMALL(ff_mjpeg_profiles),
@@ -2991,9 +3290,10 @@ AVCodec ff_thp_decoder = {
     .priv_data_size = sizeof(MJpegDecodeContext),
     .init           = ff_mjpeg_decode_init,
     .close          = ff_mjpeg_decode_end,
-    .receive_frame  = ff_mjpeg_receive_frame,
+    .decode         = mjpeg_decode_frame,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(mjpeg_update_thread_context),
     .flush          = decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
     .max_lowres     = 3,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_INIT_CLEANUP |
                       FF_CODEC_CAP_SETS_PKT_DTS,
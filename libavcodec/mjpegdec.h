@@ -122,6 +122,9 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *rst_offsets;   ///< offsets of the RSTn markers in the unescaped scan
+    unsigned int rst_offsets_size;
+    int nb_rst;         ///< number of rst_offsets, -1 if they were not located
 
     int buggy_avid;
     int cs_itu601;
@@ -131,6 +134,7 @@ typedef struct MJpegDecodeContext {
     int mjpb_skiptosod;
 
     int cur_scan; /* current scan, used by JPEG-LS */
+    int setup_finished; ///< ff_thread_finish_setup() was called for the current packet
     int flipped; /* true if picture is flipped */
 
     uint16_t (*ljpeg_buffer)[4];
@@ -0,0 +1,128 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Row progress of jobs run on a shared slice thread pool
+ * @see doc/multithreading.txt
+ */
+
+#include <string.h>
+
+#include "config.h"
+
+#include "pthread_pool.h"
+
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+
+struct FFRowProgress {
+    int *entries;
+    int nb_entries;
+    int nb_locks;
+    pthread_mutex_t *mutex;
+    pthread_cond_t  *cond;
+};
+
+int ff_row_progress_alloc(FFRowProgress **pp, int nb_rows, int nb_locks)
+{
+    FFRowProgress *p = *pp;
+    int i;
+
+    if (p && p->nb_locks == nb_locks) {
+        if (p->nb_entries < nb_rows) {
+            int *entries = av_realloc_array(p->entries, nb_rows, sizeof(*p->entries));
+            if (!entries)
+                return AVERROR(ENOMEM);
+            p->entries = entries;
+        }
+        p->nb_entries = nb_rows;
+        return 0;
+    }
+
+    ff_row_progress_free(pp);
+
+    p = av_mallocz(sizeof(*p));
+    if (!p)
+        return AVERROR(ENOMEM);
+
+    p->entries = av_malloc_array(nb_rows,  sizeof(*p->entries));
+    p->mutex   = av_malloc_array(nb_locks, sizeof(*p->mutex));
+    p->cond    = av_malloc_array(nb_locks, sizeof(*p->cond));
+    if (!p->entries || !p->mutex || !p->cond) {
+        av_free(p->entries);
+        av_free(p->mutex);
+        av_free(p->cond);
+        av_free(p);
+        return AVERROR(ENOMEM);
+    }
+
+    for (i = 0; i < nb_locks; i++) {
+        pthread_mutex_init(&p->mutex[i], NULL);
+        pthread_cond_init(&p->cond[i], NULL);
+    }
+    p->nb_entries = nb_rows;
+    p->nb_locks   = nb_locks;
+
+    *pp = p;
+    return 0;
+}
+
+void ff_row_progress_free(FFRowProgress **pp)
+{
+    FFRowProgress *p = *pp;
+    int i;
+
+    if (!p)
+        return;
+
+    for (i = 0; i < p->nb_locks; i++) {
+        pthread_mutex_destroy(&p->mutex[i]);
+        pthread_cond_destroy(&p->cond[i]);
+    }
+    av_freep(&p->entries);
+    av_freep(&p->mutex);
+    av_freep(&p->cond);
+    av_freep(pp);
+}
+
+void ff_row_progress_reset(FFRowProgress *p)
+{
+    memset(p->entries, 0, p->nb_entries * sizeof(*p->entries));
+}
+
+void ff_row_progress_report(FFRowProgress *p, int row, int thread, int n)
+{
+    pthread_mutex_lock(&p->mutex[thread]);
+    p->entries[row] += n;
+    pthread_cond_broadcast(&p->cond[thread]);
+    pthread_mutex_unlock(&p->mutex[thread]);
+}
+
+void ff_row_progress_await(FFRowProgress *p, int row, int thread, int shift)
+{
+    if (!row)
+        return;
+
+    thread = thread ? thread - 1 : p->nb_locks - 1;
+
+    pthread_mutex_lock(&p->mutex[thread]);
+    while (p->entries[row - 1] - p->entries[row] < shift)
+        pthread_cond_wait(&p->cond[thread], &p->mutex[thread]);
+    pthread_mutex_unlock(&p->mutex[thread]);
+}
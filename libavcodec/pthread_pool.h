@@ -0,0 +1,42 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Row progress for slice-level jobs (e.g. WPP rows) of frame threads run on
+ * a slice thread pool shared between them, see
+ * avpriv_slicethread_create_pooled().
+ */
+
+#ifndef AVCODEC_PTHREAD_POOL_H
+#define AVCODEC_PTHREAD_POOL_H
+
+typedef struct FFRowProgress FFRowProgress;
+
+/**
+ * (Re)allocate progress counters for nb_rows rows, protected by nb_locks
+ * mutex/condition pairs. Same semantics as ff_alloc_entries(), but not tied
+ * to the slice threading context of an AVCodecContext.
+ */
+int ff_row_progress_alloc(FFRowProgress **p, int nb_rows, int nb_locks);
+void ff_row_progress_free(FFRowProgress **p);
+void ff_row_progress_reset(FFRowProgress *p);
+void ff_row_progress_report(FFRowProgress *p, int row, int thread, int n);
+void ff_row_progress_await(FFRowProgress *p, int row, int thread, int shift);
+
+#endif /* AVCODEC_PTHREAD_POOL_H */
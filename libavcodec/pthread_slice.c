@@ -131,6 +131,7 @@ int ff_slice_thread_init(AVCodecContext *avctx)
     SliceThreadContext *c;
     int thread_count = avctx->thread_count;
     void (*mainfunc)(void *);
+    int flags;
 
     // We cannot do this in the encoder init as the threads are created before
     if (av_codec_is_encoder(avctx->codec) &&
@@ -156,7 +157,9 @@ int ff_slice_thread_init(AVCodecContext *avctx)
 
     avctx->internal->thread_ctx = c = av_mallocz(sizeof(*c));
     mainfunc = avctx->codec->caps_internal & FF_CODEC_CAP_SLICE_THREAD_HAS_MF ? &main_function : NULL;
-    if (!c || (thread_count = avpriv_slicethread_create(&c->thread, avctx, worker_func, mainfunc, thread_count)) <= 1) {
+    flags    = avctx->codec->caps_internal & FF_CODEC_CAP_SLICE_THREAD_CONCURRENT_JOBS ?
+               AVPRIV_SLICETHREAD_FLAG_CONCURRENT_JOBS : 0;
+    if (!c || (thread_count = avpriv_slicethread_create2(&c->thread, avctx, worker_func, mainfunc, thread_count, flags)) <= 1) {
         if (c)
             avpriv_slicethread_free(&c->thread);
         av_freep(&avctx->internal->thread_ctx);
@@ -165,6 +168,7 @@ int ff_slice_thread_init(AVCodecContext *avctx)
         return 0;
     }
     avctx->thread_count = thread_count;
+    avpriv_slicethread_set_priority(c->thread, avctx->thread_priority);
 
     avctx->execute = thread_execute;
     avctx->execute2 = thread_execute2;
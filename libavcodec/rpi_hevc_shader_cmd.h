@@ -30,14 +30,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma pack(push, 4)
 
-#if RPI_QPU_EMU_C && RPI_QPU_EMU_Y
-// If mixed then we are just confused and get a lot of warnings....
-typedef const uint8_t * qpu_mc_src_addr_t;
-typedef uint8_t * qpu_mc_dst_addr_t;
-#else
+// VideoCore bus addresses - the ARM executor maps them back to ARM addresses
 typedef uint32_t qpu_mc_src_addr_t;
 typedef uint32_t qpu_mc_dst_addr_t;
-#endif
 
 typedef struct qpu_mc_src_s
 {
@@ -30,9 +30,91 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "libavutil/rpi_sand_fns.h"
 #include "rpi_hevc_shader_cmd.h"
 #include "rpi_hevc_shader_template.h"
+#include "rpi_zc_frames.h"
+
+// The command stream holds VideoCore bus addresses (it is the same stream
+// that would be given to the QPUs) so we need to map them back to ARM
+// addresses.  Only the current frame, the refs used by this job and the
+// dummy block can be referenced.
+// The buffers are still GPU memory from the firmware, so this only
+// replaces the QPUs, it does not make the decoder run off the Pi.
+typedef struct shader_mem_s
+{
+    uint32_t vc;
+    uint32_t size;
+    uint8_t * arm;
+} shader_mem_t;
+
+typedef struct shader_mem_map_s
+{
+    unsigned int n;
+    unsigned int last;
+    shader_mem_t mem[(HEVC_DPB_ELS + 1) * 3 + 1];
+} shader_mem_map_t;
+
+static void mem_map_add(shader_mem_map_t * const map, const GPU_MEM_PTR_T * const gm)
+{
+    shader_mem_t * const m = map->mem + map->n++;
+    m->vc = gm->vc;
+    m->size = gm->numbytes;
+    m->arm = gm->arm;
+}
+
+static void mem_map_add_frame(shader_mem_map_t * const map, const AVFrame * const frame)
+{
+    if (frame == NULL || frame->buf[0] == NULL)
+        return;
+
+    if (gpu_is_buf1(frame)) {
+        mem_map_add(map, gpu_buf1_gmem(frame));
+    }
+    else {
+        for (unsigned int i = 0; i != 3 && frame->buf[i] != NULL; ++i)
+            mem_map_add(map, gpu_buf3_gmem(frame, i));
+    }
+}
+
+static void mem_map_init(shader_mem_map_t * const map, const HEVCRpiContext * const s, uint32_t ref_mask)
+{
+    map->n = 0;
+    map->last = 0;
+
+    map->mem[map->n++] = (shader_mem_t){
+        .vc = s->qpu_dummy_frame_qpu,
+        .size = QPU_DUMMY_SIZE,
+        .arm = qpu_dummy_arm()
+    };
+    mem_map_add_frame(map, s->frame);
+    while (ref_mask != 0) {
+        const unsigned int i = ff_ctz(ref_mask);
+        mem_map_add_frame(map, s->DPB[i].frame);
+        ref_mask &= ref_mask - 1;
+    }
+}
+
+static uint8_t * mem_map_arm(shader_mem_map_t * const map, const uint32_t vc)
+{
+    const shader_mem_t * m = map->mem + map->last;
+
+    if (vc - m->vc < m->size)
+        return m->arm + (vc - m->vc);
+
+    for (unsigned int i = 0; i != map->n; ++i) {
+        m = map->mem + i;
+        if (vc - m->vc < m->size) {
+            map->last = i;
+            return m->arm + (vc - m->vc);
+        }
+    }
+
+    // Address not in any buffer we know about
+    av_assert0(0);
+    return NULL;
+}
 
 typedef struct shader_track_s
 {
+    shader_mem_map_t * map;
     const union qpu_mc_pred_cmd_u *qpu_mc_curr;
     const struct qpu_mc_src_s *last_l0;
     const struct qpu_mc_src_s *last_l1;
@@ -63,12 +145,12 @@ static inline int32_t ext(int32_t x, unsigned int shl, unsigned int shr)
     return (x << shl) >> shr;
 }
 
-static inline int woff_p(HEVCRpiContext *const s, int32_t x)
+static inline int woff_p(const HEVCRpiContext *const s, int32_t x)
 {
     return ext(x, 0, 17 + s->ps.sps->bit_depth - 8);
 }
 
-static inline int woff_b(HEVCRpiContext *const s, int32_t x)
+static inline int woff_b(const HEVCRpiContext *const s, int32_t x)
 {
     return ext(x - 0x10000, 0, 16 + s->ps.sps->bit_depth - 8);
 }
@@ -31,11 +31,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 struct HEVCRpiContext;
 struct HEVCRpiInterPredEnv;
 
-void ff_hevc_rpi_shader_c8(struct HEVCRpiContext *const s,
+void ff_hevc_rpi_shader_c8(const struct HEVCRpiContext *const s,
+                  const uint32_t ref_mask,
                   const struct HEVCRpiInterPredEnv *const ipe_y,
                   const struct HEVCRpiInterPredEnv *const ipe_c);
 
-void ff_hevc_rpi_shader_c16(struct HEVCRpiContext *const s,
+void ff_hevc_rpi_shader_c16(const struct HEVCRpiContext *const s,
+                  const uint32_t ref_mask,
                   const struct HEVCRpiInterPredEnv *const ipe_y,
                   const struct HEVCRpiInterPredEnv *const ipe_c);
 
@@ -101,7 +101,7 @@ static void FUNC(get_patch_y)(const shader_track_t * const st,
     }
 
     dst += dl + dt * dst_stride;
-    FUNC(av_rpi_sand_to_planar_y)(dst, dst_stride, (const uint8_t *)src->base, st->stride1, st->stride2, x, y, w, h);
+    FUNC(av_rpi_sand_to_planar_y)(dst, dst_stride, mem_map_arm(st->map, src->base), st->stride1, st->stride2, x, y, w, h);
 
     // Edge dup
     if (dl != 0)
@@ -166,7 +166,7 @@ static void FUNC(get_patch_c)(const shader_track_t * const st,
 
     dst_u += dl + dt * dst_stride;
     dst_v += dl + dt * dst_stride;
-    FUNC(av_rpi_sand_to_planar_c)(dst_u, dst_stride, dst_v, dst_stride, (const uint8_t *)src->base, st->stride1, st->stride2, x, y, w, h);
+    FUNC(av_rpi_sand_to_planar_c)(dst_u, dst_stride, dst_v, dst_stride, mem_map_arm(st->map, src->base), st->stride1, st->stride2, x, y, w, h);
 
     // Edge dup
     if (dl != 0)
@@ -230,10 +230,15 @@ void FUNC(rpi_sand_dump)(const char * const name,
 }
 
 
-void FUNC(ff_hevc_rpi_shader_c)(HEVCRpiContext *const s,
+void FUNC(ff_hevc_rpi_shader_c)(const HEVCRpiContext *const s,
+                  const uint32_t ref_mask,
                   const HEVCRpiInterPredEnv *const ipe_y,
                   const HEVCRpiInterPredEnv *const ipe_c)
 {
+    shader_mem_map_t map;
+
+    mem_map_init(&map, s, ref_mask);
+
     for (int c_idx = 0; c_idx < 2; ++c_idx)
     {
         const HEVCRpiInterPredEnv *const ipe = c_idx == 0 ? ipe_y : ipe_c;
@@ -244,6 +249,9 @@ void FUNC(ff_hevc_rpi_shader_c)(HEVCRpiContext *const s,
             continue;
         }
 
+        for (unsigned int i = 0; i != QPU_N_MAX; ++i)
+            tracka[i].map = &map;
+
         do {
             for (unsigned int i = 0; i != ipe->n; ++i) {
                 const HEVCRpiInterPredQ * const q = ipe->q + i;
@@ -300,11 +308,11 @@ void FUNC(ff_hevc_rpi_shader_c)(HEVCRpiContext *const s,
 
                         // wo[offset] = offset*2+1
                         s->hevcdsp.put_hevc_qpel_uni_w[wtoidx(w1)][(c->mymx21 & 0xff00) != 0][(c->mymx21 & 0xff) != 0](
-                            (uint8_t *)c->dst_addr, st->stride1, patch_y1 + 3 * (PATCH_STRIDE + PW), PATCH_STRIDE,
+                            mem_map_arm(st->map, c->dst_addr), st->stride1, patch_y1 + 3 * (PATCH_STRIDE + PW), PATCH_STRIDE,
                             c->h, QPU_MC_DENOM, wweight(c->wo1), woff_p(s, c->wo1), (c->mymx21 & 0xff), ((c->mymx21 >> 8) & 0xff), w1);
                         if (w2 > 0) {
                             s->hevcdsp.put_hevc_qpel_uni_w[wtoidx(w2)][(c->mymx21 & 0xff000000) != 0][(c->mymx21 & 0xff0000) != 0](
-                                (uint8_t *)c->dst_addr + 8 * PW, st->stride1, patch_y2 + 3 * (PATCH_STRIDE + PW), PATCH_STRIDE,
+                                mem_map_arm(st->map, c->dst_addr) + 8 * PW, st->stride1, patch_y2 + 3 * (PATCH_STRIDE + PW), PATCH_STRIDE,
                                 c->h, QPU_MC_DENOM, wweight(c->wo2), woff_p(s, c->wo2), ((c->mymx21 >> 16) & 0xff), ((c->mymx21 >> 24) & 0xff), w2);
                         }
                         st->last_l0 = &c->next_src1;
@@ -332,7 +340,7 @@ void FUNC(ff_hevc_rpi_shader_c)(HEVCRpiContext *const s,
                            c->h, (c->mymx21 & 0xff), ((c->mymx21 >> 8) & 0xff), c->w);
 
                         s->hevcdsp.put_hevc_qpel_bi_w[wtoidx(c->w)][(c->mymx21 & 0xff000000) != 0][(c->mymx21 & 0xff0000) != 0](
-                            (uint8_t *)c->dst_addr, st->stride1, patch_y2 + 3 * (PATCH_STRIDE + PW), PATCH_STRIDE, patch_y3,
+                            mem_map_arm(st->map, c->dst_addr), st->stride1, patch_y2 + 3 * (PATCH_STRIDE + PW), PATCH_STRIDE, patch_y3,
                             c->h, QPU_MC_DENOM, wweight(c->wo1), wweight(c->wo2),
                             0, woff_b(s, c->wo2), ((c->mymx21 >> 16) & 0xff), ((c->mymx21 >> 24) & 0xff), c->w);
                         st->last_l0 = &c->next_src1;
@@ -351,7 +359,7 @@ void FUNC(ff_hevc_rpi_shader_c)(HEVCRpiContext *const s,
 
                         // wo[offset] = offset*2+1
                         s->hevcdsp.put_hevc_qpel_uni_w[wtoidx(c->w)][0][0](
-                            (uint8_t *)c->dst_addr, st->stride1, patch_y1, PATCH_STRIDE,
+                            mem_map_arm(st->map, c->dst_addr), st->stride1, patch_y1, PATCH_STRIDE,
                             c->h, QPU_MC_DENOM, wweight(c->wo1), woff_p(s, c->wo1), 0, 0, c->w);
 
                         st->last_l0 = &c->next_src1;
@@ -380,7 +388,7 @@ void FUNC(ff_hevc_rpi_shader_c)(HEVCRpiContext *const s,
                            c->h, 0, 0, c->w);
 
                         s->hevcdsp.put_hevc_qpel_bi_w[wtoidx(c->w)][0][0](
-                            (uint8_t *)c->dst_addr, st->stride1, patch_y2, PATCH_STRIDE, patch_y3,
+                            mem_map_arm(st->map, c->dst_addr), st->stride1, patch_y2, PATCH_STRIDE, patch_y3,
                             c->h, QPU_MC_DENOM, wweight(c->wo1), wweight(c->wo2),
                             0, woff_b(s, c->wo2), 0, 0, c->w);
                         st->last_l0 = &c->next_src1;
@@ -406,7 +414,7 @@ void FUNC(ff_hevc_rpi_shader_c)(HEVCRpiContext *const s,
                             patch_v3, 8 * PW, patch_v1 + PATCH_STRIDE + PW, PATCH_STRIDE,
                             c->h, QPU_MC_DENOM, wweight(c->wo_v), woff_p(s, c->wo_v), mx, my, c->w);
 
-                        FUNC(av_rpi_planar_to_sand_c)((uint8_t *)c->dst_addr_c, st->stride1, st->stride2, patch_u3, 8 * PW, patch_v3, 8 * PW, 0, 0, c->w * PW, c->h);
+                        FUNC(av_rpi_planar_to_sand_c)(mem_map_arm(st->map, c->dst_addr_c), st->stride1, st->stride2, patch_u3, 8 * PW, patch_v3, 8 * PW, 0, 0, c->w * PW, c->h);
 
                         st->last_l0 = &c->next_src;
                         cmd = (const qpu_mc_pred_cmd_t *)(c + 1);
@@ -430,7 +438,7 @@ void FUNC(ff_hevc_rpi_shader_c)(HEVCRpiContext *const s,
                             patch_v3, 8 * PW, patch_v1 + PATCH_STRIDE + PW, PATCH_STRIDE,
                             c->h, QPU_MC_DENOM, wweight(c->wo_v), woff_p(s, c->wo_v), mx, my, c->w);
 
-                        FUNC(av_rpi_planar_to_sand_c)((uint8_t *)c->dst_addr_c, st->stride1, st->stride2, patch_u3, 8 * PW, patch_v3, 8 * PW, 0, 0, c->w * PW, c->h);
+                        FUNC(av_rpi_planar_to_sand_c)(mem_map_arm(st->map, c->dst_addr_c), st->stride1, st->stride2, patch_u3, 8 * PW, patch_v3, 8 * PW, 0, 0, c->w * PW, c->h);
 
                         st->last_l1 = &c->next_src;
                         cmd = (const qpu_mc_pred_cmd_t *)(c + 1);
@@ -470,7 +478,7 @@ void FUNC(ff_hevc_rpi_shader_c)(HEVCRpiContext *const s,
                             c->h, QPU_MC_DENOM, c->weight_v1, wweight(c->wo_v2),
                             0, woff_b(s, c->wo_v2), mx2, my2, c->w);
 
-                        FUNC(av_rpi_planar_to_sand_c)((uint8_t *)c->dst_addr_c, st->stride1, st->stride2, patch_u3, 8 * PW, patch_v3, 8 * PW, 0, 0, c->w * PW, c->h);
+                        FUNC(av_rpi_planar_to_sand_c)(mem_map_arm(st->map, c->dst_addr_c), st->stride1, st->stride2, patch_u3, 8 * PW, patch_v3, 8 * PW, 0, 0, c->w * PW, c->h);
 
                         st->last_l0 = &c->next_src1;
                         st->last_l1 = &c->next_src2;
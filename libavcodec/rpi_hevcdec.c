@@ -33,6 +33,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/stereo3d.h"
+#include "libavutil/time.h"
 
 #include "decode.h"
 #include "bswapdsp.h"
@@ -431,11 +432,106 @@ static void pass_queue_submit_job(HEVCRpiPassQueue * const pq)
     sem_post(&pq->sem_in);
 }
 
+static inline HEVCRpiPipeStats * pipe_stats(const HEVCRpiContext * const s)
+{
+    return !s->pipeline_stats ? NULL : &s->jbc->jbg->stats;
+}
+
+static inline int64_t pipe_stats_now(const HEVCRpiPipeStats * const ps)
+{
+    return ps == NULL ? 0 : av_gettime_relative();
+}
+
+static void pipe_stats_submit(HEVCRpiPipeStats * const ps)
+{
+    unsigned int depth, max;
+
+    if (ps == NULL)
+        return;
+
+    depth = atomic_fetch_add(&ps->queue_depth, 1) + 1;
+    atomic_fetch_add(&ps->jobs_submitted, 1);
+    atomic_fetch_add(&ps->queue_depth_sum, depth);
+
+    max = atomic_load(&ps->queue_depth_max);
+    while (depth > max && !atomic_compare_exchange_weak(&ps->queue_depth_max, &max, depth))
+        /* loop */;
+}
+
+static void pipe_stats_pass_done(HEVCRpiPipeStats * const ps, const unsigned int pass_n,
+                                 const int64_t t_wait, const int64_t t_start)
+{
+    HEVCRpiPassStats * const pst = ps->pass + pass_n;
+    const int64_t t_end = av_gettime_relative();
+
+    atomic_fetch_add(&pst->idle_us, t_start - t_wait);
+    atomic_fetch_add(&pst->busy_us, t_end - t_start);
+    atomic_fetch_add(&pst->jobs, 1);
+    if (pass_n == RPI_PASSES - 1)
+        atomic_fetch_sub(&ps->queue_depth, 1);
+}
+
+static void pipe_stats_export(const HEVCRpiContext * const s, AVFrame * const frame)
+{
+    const HEVCRpiPipeStats * const ps = pipe_stats(s);
+    const unsigned int submitted = ps == NULL ? 0 : atomic_load(&ps->jobs_submitted);
+    char key[64];
+    unsigned int i;
+
+    if (ps == NULL)
+        return;
+
+    for (i = 0; i != RPI_PASSES; ++i) {
+        const HEVCRpiPassStats * const pst = ps->pass + i;
+        snprintf(key, sizeof(key), "lavc.hevc_rpi.pass%u.busy_us", i);
+        av_dict_set_int(&frame->metadata, key, atomic_load(&pst->busy_us), 0);
+        snprintf(key, sizeof(key), "lavc.hevc_rpi.pass%u.idle_us", i);
+        av_dict_set_int(&frame->metadata, key, atomic_load(&pst->idle_us), 0);
+        snprintf(key, sizeof(key), "lavc.hevc_rpi.pass%u.jobs", i);
+        av_dict_set_int(&frame->metadata, key, atomic_load(&pst->jobs), 0);
+    }
+    av_dict_set_int(&frame->metadata, "lavc.hevc_rpi.jobs", submitted, 0);
+    av_dict_set_int(&frame->metadata, "lavc.hevc_rpi.queue_depth_max", atomic_load(&ps->queue_depth_max), 0);
+    snprintf(key, sizeof(key), "%.2f",
+             submitted == 0 ? 0.0 : (double)atomic_load(&ps->queue_depth_sum) / submitted);
+    av_dict_set(&frame->metadata, "lavc.hevc_rpi.queue_depth_avg", key, 0);
+    av_dict_set_int(&frame->metadata, "lavc.hevc_rpi.slot_waits", atomic_load(&ps->slot_waits), 0);
+    av_dict_set_int(&frame->metadata, "lavc.hevc_rpi.slot_wait_us", atomic_load(&ps->slot_wait_us), 0);
+    av_dict_set_int(&frame->metadata, "lavc.hevc_rpi.pool_waits", atomic_load(&ps->pool_waits), 0);
+    av_dict_set_int(&frame->metadata, "lavc.hevc_rpi.pool_wait_us", atomic_load(&ps->pool_wait_us), 0);
+}
+
+static void pipe_stats_log(const HEVCRpiContext * const s)
+{
+    const HEVCRpiPipeStats * const ps = pipe_stats(s);
+    const unsigned int submitted = ps == NULL ? 0 : atomic_load(&ps->jobs_submitted);
+    unsigned int i;
+
+    if (ps == NULL)
+        return;
+
+    for (i = 0; i != RPI_PASSES; ++i) {
+        const HEVCRpiPassStats * const pst = ps->pass + i;
+        av_log(s->avctx, AV_LOG_INFO, "Pass %u: jobs %u, busy %"PRIu64"us, idle %"PRIu64"us\n", i,
+               atomic_load(&pst->jobs), (uint64_t)atomic_load(&pst->busy_us), (uint64_t)atomic_load(&pst->idle_us));
+    }
+    av_log(s->avctx, AV_LOG_INFO, "Jobs %u, queue depth avg %.2f max %u/%d, slot waits %u (%"PRIu64"us), pool waits %u (%"PRIu64"us)\n",
+           submitted, submitted == 0 ? 0.0 : (double)atomic_load(&ps->queue_depth_sum) / submitted,
+           atomic_load(&ps->queue_depth_max), RPI_MAX_JOBS,
+           atomic_load(&ps->slot_waits), (uint64_t)atomic_load(&ps->slot_wait_us),
+           atomic_load(&ps->pool_waits), (uint64_t)atomic_load(&ps->pool_wait_us));
+}
+
 static inline void pass_queue_do_all(HEVCRpiContext * const s, HEVCRpiJob * const jb)
 {
+    HEVCRpiPipeStats * const ps = pipe_stats(s);
+
     // Do the various passes - common with the worker code
     for (unsigned int i = 0; i != RPI_PASSES; ++i) {
+        const int64_t t_start = pipe_stats_now(ps);
         s->passq[i].worker(s, jb);
+        if (ps != NULL)
+            pipe_stats_pass_done(ps, i, t_start, t_start);
     }
 }
 
@@ -531,8 +627,16 @@ static HEVCRpiJob * job_alloc(HEVCRpiJobCtl * const jbc, HEVCRpiLocalContext * c
 
     if (jb == NULL)  // Need to wait
     {
+        HEVCRpiPipeStats * const ps = pipe_stats(lc->context);
+        const int64_t t_wait = pipe_stats_now(ps);
+
         rpi_sem_wait(&lc->jw_sem);
         jb = lc->jw_job;  // Set by free code
+
+        if (ps != NULL) {
+            atomic_fetch_add(&ps->pool_waits, 1);
+            atomic_fetch_add(&ps->pool_wait_us, av_gettime_relative() - t_wait);
+        }
     }
 
     return jb;
@@ -656,6 +760,8 @@ static inline void worker_submit_job(HEVCRpiContext *const s, HEVCRpiLocalContex
     jb->waited = !lc->last_progress_good;
     lc->jb0 = NULL;
 
+    pipe_stats_submit(pipe_stats(s));
+
     if (s->offload_recon)
     {
         pthread_mutex_lock(&jbc->in_lock);
@@ -686,7 +792,20 @@ static inline void worker_pass0_ready(const HEVCRpiContext * const s, HEVCRpiLoc
         return;
 
     if (s->offload_recon)
-        rpi_sem_wait(&jbc->sem_out);  // This sem will stop this frame grabbing too much
+    {
+        HEVCRpiPipeStats * const ps = pipe_stats(s);
+
+        // This sem will stop this frame grabbing too much
+        if (ps == NULL)
+            rpi_sem_wait(&jbc->sem_out);
+        else if (sem_trywait(&jbc->sem_out) != 0)
+        {
+            const int64_t t_wait = av_gettime_relative();
+            rpi_sem_wait(&jbc->sem_out);
+            atomic_fetch_add(&ps->slot_waits, 1);
+            atomic_fetch_add(&ps->slot_wait_us, av_gettime_relative() - t_wait);
+        }
+    }
 
     lc->jb0 = job_alloc(jbc, lc);
 
@@ -748,13 +867,20 @@ static void * pass_worker(void *arg)
 
     for (;;)
     {
+        HEVCRpiPipeStats * const ps = pipe_stats(s);
+        const int64_t t_wait = pipe_stats_now(ps);
+        int64_t t_start;
+
         rpi_sem_wait(&pq->sem_in);
 
         if (pq->terminate)
             break;
 
+        t_start = pipe_stats_now(ps);
         pq->worker(s, s->jbc->offloadq[pass_queue_inc_job_n(pq)]);
         // * should really set jb->passes_done here
+        if (ps != NULL)
+            pipe_stats_pass_done(ps, pq->pass_n, t_wait, t_start);
 
         sem_post(pq->psem_out);
     }
@@ -2513,16 +2639,8 @@ static int rpi_inter_pred_alloc(HEVCRpiInterPredEnv * const ipe,
 }
 
 
-#if RPI_QPU_EMU_Y
-#define get_mc_address_y(f) ((f)->data[0])
-#else
 #define get_mc_address_y(f) get_vc_address_y(f)
-#endif
-#if RPI_QPU_EMU_C
-#define get_mc_address_u(f) ((f)->data[1])
-#else
 #define get_mc_address_u(f) get_vc_address_u(f)
-#endif
 
 static inline uint32_t pack_wo_p(const int off, const int mul)
 {
@@ -2668,11 +2786,7 @@ rpi_pred_y(const HEVCRpiContext *const s, HEVCRpiJob * const jb,
             {
                 src2->x = MC_DUMMY_X;
                 src2->y = MC_DUMMY_Y;
-#if RPI_QPU_EMU_Y
-                src2->base = s->qpu_dummy_frame_emu;
-#else
                 src2->base = s->qpu_dummy_frame_qpu;
-#endif
             }
             else
             {
@@ -3049,12 +3163,14 @@ static void hls_prediction_unit(const HEVCRpiContext * const s, HEVCRpiLocalCont
         if (!ref0)
             return;
         hevc_await_progress(s, lc, ref0, current_mv.xy[0], y0, nPbH);
+        jb->ref_mask |= 1U << ref0->dpb_no;
     }
     if (current_mv.pred_flag & PF_L1) {
         ref1 = refPicList[1].ref[current_mv.ref_idx[1]];
         if (!ref1)
             return;
         hevc_await_progress(s, lc, ref1, current_mv.xy[1], y0, nPbH);
+        jb->ref_mask |= 1U << ref1->dpb_no;
     }
 
     if (current_mv.pred_flag == PF_L0) {
@@ -3777,12 +3893,12 @@ static void rpi_begin(const HEVCRpiContext * const s, HEVCRpiJob * const jb, con
     for (i = 0; i != FF_ARRAY_ELEMS(jb->progress_req); ++i) {
         jb->progress_req[i] = -1;
     }
+    jb->ref_mask = 0;
 
     worker_pic_reset(&jb->coeffs);
 }
 
 
-#if !RPI_QPU_EMU_Y || !RPI_QPU_EMU_C
 static unsigned int mc_terminate_add_qpu(const HEVCRpiContext * const s,
                                      const vpu_qpu_job_h vqj,
                                      rpi_cache_flush_env_t * const rfe,
@@ -3842,9 +3958,9 @@ static unsigned int mc_terminate_add_qpu(const HEVCRpiContext * const s,
 
     return 1;
 }
-#endif
 
-#if RPI_QPU_EMU_Y || RPI_QPU_EMU_C
+// As mc_terminate_add_qpu but the Qs are run on the ARM by
+// ff_hevc_rpi_shader_c8/16 in worker_core so nothing is added to the job
 static unsigned int mc_terminate_add_emu(const HEVCRpiContext * const s,
                                      const vpu_qpu_job_h vqj,
                                      rpi_cache_flush_env_t * const rfe,
@@ -3865,15 +3981,15 @@ static unsigned int mc_terminate_add_emu(const HEVCRpiContext * const s,
         qpu_mc_src_t *const p0 = yp->last_l0;
         qpu_mc_src_t *const p1 = yp->last_l1;
 
-        yp->qpu_mc_curr->data[-1] = yp->code_exit;
+        qpu_mc_link_set(yp->qpu_mc_curr, yp->code_exit);
 
-        // Need to set the srcs for L0 & L1 to something that can be (pointlessly) prefetched
+        // Keep the stream identical to the one we would send to the QPUs
         p0->x = MC_DUMMY_X;
         p0->y = MC_DUMMY_Y;
-        p0->base = s->qpu_dummy_frame_emu;
+        p0->base = s->qpu_dummy_frame_qpu;
         p1->x = MC_DUMMY_X;
         p1->y = MC_DUMMY_Y;
-        p1->base = s->qpu_dummy_frame_emu;
+        p1->base = s->qpu_dummy_frame_qpu;
 
         yp->last_l0 = NULL;
         yp->last_l1 = NULL;
@@ -3881,19 +3997,16 @@ static unsigned int mc_terminate_add_emu(const HEVCRpiContext * const s,
 
     return 1;
 }
-#endif
-
 
-#if RPI_QPU_EMU_Y
-#define mc_terminate_add_y mc_terminate_add_emu
-#else
-#define mc_terminate_add_y mc_terminate_add_qpu
-#endif
-#if RPI_QPU_EMU_C
-#define mc_terminate_add_c mc_terminate_add_emu
-#else
-#define mc_terminate_add_c mc_terminate_add_qpu
-#endif
+static unsigned int mc_terminate_add(const HEVCRpiContext * const s,
+                                     const vpu_qpu_job_h vqj,
+                                     rpi_cache_flush_env_t * const rfe,
+                                     HEVCRpiInterPredEnv * const ipe)
+{
+    return s->qpu_emu ?
+        mc_terminate_add_emu(s, vqj, rfe, ipe) :
+        mc_terminate_add_qpu(s, vqj, rfe, ipe);
+}
 
 
 static void flush_frame(HEVCRpiContext *s,AVFrame *frame)
@@ -3977,12 +4090,12 @@ static void worker_core(const HEVCRpiContext * const s, HEVCRpiJob * const jb)
         }
     }
 
-    pred_c = mc_terminate_add_c(s, vqj, jb->rfe, &jb->chroma_ip);
+    pred_c = mc_terminate_add(s, vqj, jb->rfe, &jb->chroma_ip);
 
 // We could take a sync here and try to locally overlap QPU processing with ARM
 // but testing showed a slightly negative benefit with noticable extra complexity
 
-    pred_y = mc_terminate_add_y(s, vqj, jb->rfe, &jb->luma_ip);
+    pred_y = mc_terminate_add(s, vqj, jb->rfe, &jb->luma_ip);
 
     // Returns 0 if nothing to do, 1 if sync added
 #if RPI_WORKER_WAIT_PASS_0
@@ -4009,37 +4122,26 @@ static void worker_core(const HEVCRpiContext * const s, HEVCRpiJob * const jb)
 
     vpu_qpu_job_finish(vqj);
 
-    // We always work on a rectangular block
-    if (pred_y || pred_c)
+    if (!s->qpu_emu)
     {
-        rpi_cache_flush_add_frame_block(jb->rfe, s->frame, RPI_CACHE_FLUSH_MODE_INVALIDATE,
-                                        jb->bounds.x, jb->bounds.y, jb->bounds.w, jb->bounds.h,
-                                        ctx_vshift(s, 1), pred_y, pred_c);
-    }
-
-    // If we have emulated VPU ops - do it here
-#if RPI_QPU_EMU_Y || RPI_QPU_EMU_C
-    if (av_rpi_is_sand8_frame(s->frame))
-    {
-#if RPI_QPU_EMU_Y && RPI_QPU_EMU_C
-        ff_hevc_rpi_shader_c8(s, &jb->luma_ip, &jb->chroma_ip);
-#elif RPI_QPU_EMU_Y
-        ff_hevc_rpi_shader_c8(s, &jb->luma_ip, NULL);
-#else
-        ff_hevc_rpi_shader_c8(s, NULL, &jb->chroma_ip);
-#endif
+        // We always work on a rectangular block
+        if (pred_y || pred_c)
+        {
+            rpi_cache_flush_add_frame_block(jb->rfe, s->frame, RPI_CACHE_FLUSH_MODE_INVALIDATE,
+                                            jb->bounds.x, jb->bounds.y, jb->bounds.w, jb->bounds.h,
+                                            ctx_vshift(s, 1), pred_y, pred_c);
+        }
     }
-    else
+    else if (pred_y || pred_c)
     {
-#if RPI_QPU_EMU_Y && RPI_QPU_EMU_C
-        ff_hevc_rpi_shader_c16(s, &jb->luma_ip, &jb->chroma_ip);
-#elif RPI_QPU_EMU_Y
-        ff_hevc_rpi_shader_c16(s, &jb->luma_ip, NULL);
-#else
-        ff_hevc_rpi_shader_c16(s, NULL, &jb->chroma_ip);
-#endif
+        // Run the inter-pred Qs here on the ARM
+        // Refs have reached the required progress & the ARM writes the
+        // prediction so there is nothing to invalidate
+        if (av_rpi_is_sand8_frame(s->frame))
+            ff_hevc_rpi_shader_c8(s, jb->ref_mask, &jb->luma_ip, &jb->chroma_ip);
+        else
+            ff_hevc_rpi_shader_c16(s, jb->ref_mask, &jb->luma_ip, &jb->chroma_ip);
     }
-#endif
 
 #if RPI_WORKER_WAIT_PASS_0
     if (do_wait)
@@ -5619,6 +5721,8 @@ static int hevc_rpi_decode_frame(AVCodecContext *avctx, void *data, int *got_out
 
     if (!avpkt->size) {
         ret = ff_hevc_rpi_output_frame(s, data, 1);
+        if (ret > 0)
+            pipe_stats_export(s, data);
         if (ret < 0)
             return ret;
 
@@ -5657,6 +5761,7 @@ static int hevc_rpi_decode_frame(AVCodecContext *avctx, void *data, int *got_out
 
     if (s->output_frame->buf[0]) {
         av_frame_move_ref(data, s->output_frame);
+        pipe_stats_export(s, data);
         *got_output = 1;
     }
 
@@ -5705,6 +5810,10 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
     bit_threads_kill(s);
 #endif
 
+    // Stats are shared between frame threads so only report them once
+    if (s->jbc != NULL && !avctx->internal->is_copy)
+        pipe_stats_log(s);
+
     hevc_exit_worker(s);
     for (i = 0; i != 2; ++i) {
         ff_hevc_rpi_progress_kill_state(s->progress_states + i);
@@ -5762,15 +5871,7 @@ static av_cold int hevc_init_context(AVCodecContext *avctx)
         goto fail;
     s->qpu_init_ok = 1;
 
-#if RPI_QPU_EMU_Y || RPI_QPU_EMU_C
-    {
-        static const uint32_t dframe[1] = {0x80808080};
-        s->qpu_dummy_frame_emu = (const uint8_t *)dframe;
-    }
-#endif
-#if !RPI_QPU_EMU_Y || !RPI_QPU_EMU_C
     s->qpu_dummy_frame_qpu = qpu_dummy();
-#endif
 
     bt_lc_init(s, s->HEVClc, 0);
     job_lc_init(s->HEVClc);
@@ -6047,6 +6148,10 @@ static const AVOption options[] = {
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { "strict-displaywin", "stricly apply default display window size", OFFSET(apply_defdispwin),
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
+    { "qpu_emu", "Run inter prediction on the ARM rather than the QPUs (still needs the Pi firmware)", OFFSET(qpu_emu),
+        AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
+    { "pipeline_stats", "Gather worker pass/job stats, export as frame metadata & log on close", OFFSET(pipeline_stats),
+        AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { NULL },
 };
 
@@ -116,14 +116,9 @@
 // This define exists so it is easy to test this.
 #define RPI_WORKER_WAIT_PASS_0  1
 
-// Use ARM emulation of QPU pred
-// These are for debug only as the emulation makes only limited
-// effort to be fast
-#define RPI_QPU_EMU_Y           0
-#define RPI_QPU_EMU_C           0
-
 // Max width & height we are prepared to consider
 // Sand frame shape calc becomes confused with large frames
+// ("tall" sand in rpi_zc.c is untested with this decoder)
 // Some buffer alloc also depends on this
 #define HEVC_RPI_MAX_WIDTH      2048
 #define HEVC_RPI_MAX_HEIGHT     1088
@@ -570,6 +565,7 @@ typedef struct HEVCRpiJob {
     HEVCRpiInterPredEnv chroma_ip;
     HEVCRpiInterPredEnv luma_ip;
     int16_t progress_req[HEVC_DPB_ELS]; // index by dpb_no
+    uint32_t ref_mask;                  // Bit per dpb_no referenced by inter pred in this job
     HEVCRpiIntraPredEnv intra;
     HEVCRpiCoeffsEnv coeffs;
     HEVCRpiFrameProgressWait progress_wait;
@@ -615,6 +611,28 @@ typedef struct HEVCRpiJobCtl
 } HEVCRpiJobCtl;
 
 
+// Runtime pipeline stats - only gathered if the pipeline_stats option is set
+// All times in us (av_gettime_relative)
+typedef struct HEVCRpiPassStats
+{
+    atomic_uint_fast64_t busy_us;       // Time spent in the worker fn
+    atomic_uint_fast64_t idle_us;       // Time spent waiting for a job
+    atomic_uint jobs;
+} HEVCRpiPassStats;
+
+typedef struct HEVCRpiPipeStats
+{
+    HEVCRpiPassStats pass[RPI_PASSES];
+    atomic_uint jobs_submitted;
+    atomic_uint queue_depth;            // Jobs submitted but not through the last pass
+    atomic_uint queue_depth_max;
+    atomic_uint_fast64_t queue_depth_sum; // Depth sampled at each submit
+    atomic_uint slot_waits;             // Waits for one of our RPI_MAX_JOBS slots
+    atomic_uint_fast64_t slot_wait_us;
+    atomic_uint pool_waits;             // Waits for a job from the global pool
+    atomic_uint_fast64_t pool_wait_us;
+} HEVCRpiPipeStats;
+
 typedef struct HEVCRpiJobGlobal
 {
     intptr_t ref_count;
@@ -624,6 +642,7 @@ typedef struct HEVCRpiJobGlobal
     HEVCRpiLocalContext * wait_good;  // Last good tail
     HEVCRpiLocalContext * wait_tail;
 
+    HEVCRpiPipeStats stats;             // Shared by all frame threads
 } HEVCRpiJobGlobal;
 
 #define RPI_BIT_THREADS (RPI_EXTRA_BIT_THREADS + 1)
@@ -702,12 +721,7 @@ typedef struct HEVCRpiContext {
     uint8_t * cabac_stash_up;
 
     // Function pointers
-#if RPI_QPU_EMU_Y || RPI_QPU_EMU_C
-    const uint8_t * qpu_dummy_frame_emu;
-#endif
-#if !RPI_QPU_EMU_Y || !RPI_QPU_EMU_C
     uint32_t qpu_dummy_frame_qpu;  // Not a frame - just a bit of memory
-#endif
     HEVCRpiQpu qpu;
 
     HEVCRpiFrameProgressState progress_states[2];
@@ -781,6 +795,8 @@ typedef struct HEVCRpiContext {
     int is_nalff;           ///< this flag is != 0 if bitstream is encapsulated
                             ///< as a format defined in 14496-15
     int apply_defdispwin;
+    int qpu_emu;            // Run the QPU inter-pred command stream on the ARM (Pi only)
+    int pipeline_stats;     // Gather pass/job stats & export them as frame metadata
 
     int nal_length_size;    ///< Number of bytes used for nal length (1, 2 or 4)
     int nuh_layer_id;
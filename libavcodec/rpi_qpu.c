@@ -326,9 +326,9 @@ static int gpu_init(gpu_env_t ** const gpu) {
 
     // Generate a dummy "frame" & fill with 0x80
     // * Could reset to 1 <<bit_depth?
-    if ((rv = gpu_malloc_internal(&ge->dummy_gm_ptr, 0x4000, VCSM_CACHE_TYPE_NONE, "ffmpeg dummy frame")) != 0)
+    if ((rv = gpu_malloc_internal(&ge->dummy_gm_ptr, QPU_DUMMY_SIZE, VCSM_CACHE_TYPE_NONE, "ffmpeg dummy frame")) != 0)
         return rv;
-    memset(ge->dummy_gm_ptr.arm, 0x80, 0x4000);
+    memset(ge->dummy_gm_ptr.arm, 0x80, QPU_DUMMY_SIZE);
 
     *gpu = ge;
     return 0;
@@ -738,6 +738,11 @@ uint32_t qpu_dummy(void)
   return gpu->dummy_gm_ptr.vc;
 }
 
+uint8_t * qpu_dummy_arm(void)
+{
+  return gpu->dummy_gm_ptr.arm;
+}
+
 int rpi_hevc_qpu_init_fn(HEVCRpiQpu * const qf, const unsigned int bit_depth)
 {
   // Dummy values we can catch with emulation
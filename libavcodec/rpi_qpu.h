@@ -56,6 +56,9 @@ int rpi_hevc_qpu_init_fn(HEVCRpiQpu * const qf, const unsigned int bit_depth);
 
 uint32_t qpu_fn(const int * const mc_fn);
 uint32_t qpu_dummy(void);
+uint8_t * qpu_dummy_arm(void);
+
+#define QPU_DUMMY_SIZE 0x4000
 
 #define QPU_N_GRP    4
 #define QPU_N_MAX    12
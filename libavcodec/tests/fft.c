@@ -42,6 +42,7 @@
 #include "libavutil/log.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/time.h"
+#include "libavutil/tx.h"
 
 #if AVFFT
 #include "libavcodec/avfft.h"
@@ -346,18 +347,43 @@ static inline void dct_end(DCTContext *d)
     ff_dct_end(d);
 #endif
 }
+
+/* av_tx counterparts, to compare both APIs on the same input */
+static int tx_init(AVTXContext **s, av_tx_fn *tx, enum AVTXType type,
+                   int nbits, int inverse, double scale)
+{
+    const float fscale = scale;
+    /* the length of an MDCT is its number of coefficients */
+    int len = 1 << (type == AV_TX_FLOAT_MDCT ? nbits - 1 : nbits);
+
+    return av_tx_init(s, tx, type, inverse, len, &fscale, 0);
+}
 #endif /* FFT_FLOAT */
 
+static void tx_imdct_calc(AVTXContext *s, av_tx_fn tx, FFTSample *output,
+                          FFTSample *input, int nbits)
+{
+    int k, n = 1 << nbits, n2 = n >> 1, n4 = n >> 2;
+
+    /* av_tx returns the half IMDCT, expand it like imdct_calc() */
+    tx(s, output + n4, input, sizeof(*input));
+    for (k = 0; k < n4; k++) {
+        output[k]         = -output[n2 - k - 1];
+        output[n - k - 1] =  output[n2 + k];
+    }
+}
+
 static void help(void)
 {
     av_log(NULL, AV_LOG_INFO,
-           "usage: fft-test [-h] [-s] [-i] [-n b]\n"
+           "usage: fft-test [-h] [-s] [-i] [-t] [-n b]\n"
            "-h     print this help\n"
            "-s     speed test\n"
            "-m     (I)MDCT test\n"
            "-d     (I)DCT test\n"
            "-r     (I)RDFT test\n"
            "-i     inverse transform test\n"
+           "-t     use av_tx instead of FFTContext for the FFT and (I)MDCT\n"
            "-n b   set the transform size to 2^b\n"
            "-f x   set scale factor for output data of (I)MDCT to x\n");
 }
@@ -378,11 +404,14 @@ int main(int argc, char **argv)
     FFTComplex *tab, *tab1, *tab_ref;
     FFTSample *tab2;
     enum tf_transform transform = TRANSFORM_FFT;
-    FFTContext *m, *s;
+    FFTContext *m = NULL, *s = NULL;
 #if FFT_FLOAT
     RDFTContext *r;
     DCTContext *d;
+    int use_tx = 0;
 #endif /* FFT_FLOAT */
+    AVTXContext *t = NULL;
+    av_tx_fn tx = NULL;
     int it, i, err = 1;
     int do_speed = 0, do_inverse = 0;
     int fft_nbits = 9, fft_size;
@@ -402,7 +431,7 @@ int main(int argc, char **argv)
     av_lfg_init(&prng, 1);
 
     for (;;) {
-        int c = getopt(argc, argv, "hsimrdn:f:c:");
+        int c = getopt(argc, argv, "hsimrdtn:f:c:");
         if (c == -1)
             break;
         switch (c) {
@@ -424,6 +453,11 @@ int main(int argc, char **argv)
         case 'd':
             transform = TRANSFORM_DCT;
             break;
+#if FFT_FLOAT
+        case 't':
+            use_tx = 1;
+            break;
+#endif /* FFT_FLOAT */
         case 'n':
             fft_nbits = atoi(optarg);
             break;
@@ -452,6 +486,16 @@ int main(int argc, char **argv)
     if (!(tab && tab1 && tab_ref && tab2))
         goto cleanup;
 
+#if FFT_FLOAT
+    if (use_tx && (transform == TRANSFORM_FFT || transform == TRANSFORM_MDCT)) {
+        enum AVTXType type = transform == TRANSFORM_MDCT ? AV_TX_FLOAT_MDCT
+                                                         : AV_TX_FLOAT_FFT;
+        if ((err = tx_init(&t, &tx, type, fft_nbits, do_inverse, scale)) < 0)
+            goto cleanup;
+        av_log(NULL, AV_LOG_INFO, "av_tx ");
+    }
+#endif
+
     switch (transform) {
 #if CONFIG_MDCT
     case TRANSFORM_MDCT:
@@ -460,7 +504,8 @@ int main(int argc, char **argv)
             av_log(NULL, AV_LOG_INFO, "IMDCT");
         else
             av_log(NULL, AV_LOG_INFO, "MDCT");
-        mdct_init(&m, fft_nbits, do_inverse, scale);
+        if (!tx)
+            mdct_init(&m, fft_nbits, do_inverse, scale);
         break;
 #endif /* CONFIG_MDCT */
     case TRANSFORM_FFT:
@@ -468,7 +513,8 @@ int main(int argc, char **argv)
             av_log(NULL, AV_LOG_INFO, "IFFT");
         else
             av_log(NULL, AV_LOG_INFO, "FFT");
-        fft_init(&s, fft_nbits, do_inverse);
+        if (!tx)
+            fft_init(&s, fft_nbits, do_inverse);
         if ((err = fft_ref_init(fft_nbits, do_inverse)) < 0)
             goto cleanup;
         break;
@@ -515,19 +561,29 @@ int main(int argc, char **argv)
     case TRANSFORM_MDCT:
         if (do_inverse) {
             imdct_ref(&tab_ref->re, &tab1->re, fft_nbits);
-            imdct_calc(m, tab2, &tab1->re);
+            if (tx)
+                tx_imdct_calc(t, tx, tab2, &tab1->re, fft_nbits);
+            else
+                imdct_calc(m, tab2, &tab1->re);
             err = check_diff(&tab_ref->re, tab2, fft_size, scale);
         } else {
             mdct_ref(&tab_ref->re, &tab1->re, fft_nbits);
-            mdct_calc(m, tab2, &tab1->re);
+            if (tx)
+                tx(t, tab2, &tab1->re, sizeof(FFTSample));
+            else
+                mdct_calc(m, tab2, &tab1->re);
             err = check_diff(&tab_ref->re, tab2, fft_size / 2, scale);
         }
         break;
 #endif /* CONFIG_MDCT */
     case TRANSFORM_FFT:
-        memcpy(tab, tab1, fft_size * sizeof(FFTComplex));
-        fft_permute(s, tab);
-        fft_calc(s, tab);
+        if (tx) {
+            tx(t, tab, tab1, sizeof(FFTComplex));
+        } else {
+            memcpy(tab, tab1, fft_size * sizeof(FFTComplex));
+            fft_permute(s, tab);
+            fft_calc(s, tab);
+        }
 
         fft_ref(tab_ref, tab1, fft_nbits);
         err = check_diff(&tab_ref->re, &tab->re, fft_size * 2, 1.0);
@@ -596,12 +652,22 @@ int main(int argc, char **argv)
             for (it = 0; it < nb_its; it++) {
                 switch (transform) {
                 case TRANSFORM_MDCT:
-                    if (do_inverse)
+                    if (tx && do_inverse)
+                        tx_imdct_calc(t, tx, &tab->re, &tab1->re, fft_nbits);
+                    else if (tx)
+                        tx(t, &tab->re, &tab1->re, sizeof(FFTSample));
+                    else if (do_inverse)
                         imdct_calc(m, &tab->re, &tab1->re);
                     else
                         mdct_calc(m, &tab->re, &tab1->re);
                     break;
                 case TRANSFORM_FFT:
+                    /* the permutation is part of an av_tx transform, which
+                     * is not in-place, so this replaces the copy */
+                    if (tx) {
+                        tx(t, tab, tab1, sizeof(FFTComplex));
+                        break;
+                    }
                     memcpy(tab, tab1, fft_size * sizeof(FFTComplex));
                     fft_calc(s, tab);
                     break;
@@ -629,6 +695,8 @@ int main(int argc, char **argv)
                nb_its);
     }
 
+    av_tx_uninit(&t);
+
     switch (transform) {
 #if CONFIG_MDCT
     case TRANSFORM_MDCT:
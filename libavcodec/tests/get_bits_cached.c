@@ -0,0 +1,120 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#define CACHED_BITSTREAM_READER 1
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "libavcodec/get_bits.h"
+#include "libavcodec/put_bits.h"
+
+#define COUNT 65536
+#define SIZE (COUNT * 4)
+
+int main(void)
+{
+    int i, ret = 0;
+    uint8_t *temp;
+    uint8_t *len;
+    uint32_t *val;
+    PutBitContext pb;
+    GetBitContext gb;
+    AVLFG lfg;
+
+    temp = av_mallocz(SIZE + AV_INPUT_BUFFER_PADDING_SIZE);
+    len  = av_malloc(COUNT);
+    val  = av_malloc_array(COUNT, sizeof(*val));
+    if (!temp || !len || !val) {
+        ret = 2;
+        goto end;
+    }
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+    init_put_bits(&pb, temp, SIZE);
+    for (i = 0; i < COUNT; i++) {
+        len[i] = av_lfg_get(&lfg) % 25 + 1;
+        val[i] = av_lfg_get(&lfg) & ((1U << len[i]) - 1);
+        put_bits(&pb, len[i], val[i]);
+    }
+    flush_put_bits(&pb);
+
+    /* mix the low-level macros with the function interface, both have to
+     * agree on the reader state */
+    init_get_bits(&gb, temp, 8 * SIZE);
+    for (i = 0; i < COUNT; i++) {
+        int count = get_bits_count(&gb);
+        unsigned v;
+
+        switch (i % 4) {
+        case 0:
+            v = get_bits(&gb, len[i]);
+            break;
+        case 1:
+            v = get_sbits(&gb, len[i]) & ((1U << len[i]) - 1);
+            break;
+        case 2: {
+            OPEN_READER(re, &gb);
+            UPDATE_CACHE(re, &gb);
+            if (BITS_LEFT(re, &gb) != get_bits_left(&gb)) {
+                fprintf(stderr, "%d: BITS_LEFT %d != get_bits_left %d\n",
+                        i, BITS_LEFT(re, &gb), get_bits_left(&gb));
+                ret = 1;
+            }
+            v = SHOW_UBITS(re, &gb, len[i]);
+            if ((unsigned)SHOW_SBITS(re, &gb, len[i]) != (unsigned)sign_extend(v, len[i])) {
+                fprintf(stderr, "%d: SHOW_SBITS mismatch\n", i);
+                ret = 1;
+            }
+            SKIP_BITS(re, &gb, len[i]);
+            CLOSE_READER(re, &gb);
+            break;
+        }
+        default: {
+            OPEN_READER(re, &gb);
+            UPDATE_CACHE(re, &gb);
+            v = GET_CACHE(re, &gb) >> (32 - len[i]);
+            SKIP_CACHE(re, &gb, len[i]);
+            SKIP_COUNTER(re, &gb, len[i]);
+            CLOSE_READER(re, &gb);
+            break;
+        }
+        }
+
+        if (v != val[i]) {
+            fprintf(stderr, "%d: expected %x (%d bits), got %x\n",
+                    i, val[i], len[i], v);
+            ret = 1;
+        }
+        if (get_bits_count(&gb) != count + len[i]) {
+            fprintf(stderr, "%d: bit count %d, expected %d\n",
+                    i, get_bits_count(&gb), count + len[i]);
+            ret = 1;
+        }
+    }
+
+end:
+    av_free(temp);
+    av_free(len);
+    av_free(val);
+
+    return ret;
+}
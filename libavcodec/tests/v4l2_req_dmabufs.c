@@ -0,0 +1,244 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavcodec/v4l2_req_dmabufs.c"
+
+#define N_THREADS 4
+#define THREAD_LOOPS 1000
+
+static int check_stats(struct dmabufs_ctl * const dbsc, const char * const name,
+                       uint64_t hits, uint64_t misses, uint64_t puts, uint64_t discards)
+{
+    struct dmabufs_pool_stats st;
+
+    dmabufs_ctl_pool_stats(dbsc, &st);
+    if (st.hits != hits || st.misses != misses || st.puts != puts || st.discards != discards) {
+        fprintf(stderr, "%s: hits %"PRIu64"/%"PRIu64", misses %"PRIu64"/%"PRIu64
+                ", puts %"PRIu64"/%"PRIu64", discards %"PRIu64"/%"PRIu64"\n", name,
+                st.hits, hits, st.misses, misses, st.puts, puts, st.discards, discards);
+        return 1;
+    }
+    return 0;
+}
+
+/* Class rounding is monotonic, covers the request & is idempotent */
+static int test_classes(void)
+{
+    size_t pages;
+    int last = -1;
+
+    for (pages = 1; pages <= 1 << 16; ++pages) {
+        size_t p = pages;
+        size_t p2;
+        const int idx = pool_class(&p);
+
+        if (idx < 0 || idx >= POOL_CLASSES || p < pages || idx < last ||
+            (pages > 4 && p - pages >= p / 4)) {
+            fprintf(stderr, "class: %zd -> %zd idx %d\n", pages, p, idx);
+            return 1;
+        }
+        p2 = p;
+        if (pool_class(&p2) != idx || p2 != p) {
+            fprintf(stderr, "class: %zd not stable\n", p);
+            return 1;
+        }
+        last = idx;
+    }
+    pages = (size_t)1 << 20;
+    if (pool_class(&pages) != -1) {
+        fprintf(stderr, "class: huge buffer poolable\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* Freed buffer comes back with its mapping intact */
+static int test_reuse(struct dmabufs_ctl * const dbsc)
+{
+    struct dmabuf_h * dh = dmabuf_alloc(dbsc, 5000);
+    struct dmabuf_h * dh2;
+    uint8_t * p;
+    int ret = 0;
+
+    if (!dh || !(p = dmabuf_map(dh)))
+        return 1;
+    if (dmabuf_write_start(dh) || dmabuf_write_end(dh)) {
+        fprintf(stderr, "reuse: sync failed\n");
+        ret = 1;
+    }
+    p[0] = 0x55;
+    dmabuf_len_set(dh, 100);
+    dmabuf_free(dh);
+
+    /* Same class, different request size */
+    dh2 = dmabuf_alloc(dbsc, 6000);
+    if (dh2 != dh || dh2->mapptr != p || dmabuf_len(dh2) != 0 || p[0] != 0x55) {
+        fprintf(stderr, "reuse: buffer not recycled\n");
+        ret = 1;
+    }
+    /* Realloc within size keeps the buffer, bigger moves class */
+    if (dmabuf_realloc(dbsc, dh2, 8000) != dh2)
+        ret = 1;
+    dh = dmabuf_realloc(dbsc, dh2, 1 << 20);
+    if (!dh || dmabuf_size(dh) < 1 << 20 || dmabuf_fd(dh) == -1)
+        ret = 1;
+    dmabuf_free(dh);
+
+    return ret | check_stats(dbsc, "reuse", 1, 2, 3, 0);
+}
+
+/* Limits are honoured & lowering them trims the pool */
+static int test_limits(struct dmabufs_ctl * const dbsc)
+{
+    struct dmabuf_h * dhs[8];
+    struct dmabufs_pool_stats st;
+    const size_t sz = dbsc->page_size * 2;
+    int ret = 0;
+    int i;
+
+    dmabufs_ctl_pool_set(dbsc, sz * 6, 3);
+    for (i = 0; i != 8; ++i)
+        if (!(dhs[i] = dmabuf_alloc(dbsc, sz)))
+            return 1;
+    for (i = 0; i != 8; ++i)
+        dmabuf_free(dhs[i]);
+
+    /* 3 kept by per-class limit */
+    ret |= check_stats(dbsc, "limits", 0, 8, 3, 5);
+
+    dhs[0] = dmabuf_alloc(dbsc, dbsc->page_size * 3);
+    dhs[1] = dmabuf_alloc(dbsc, dbsc->page_size * 3);
+    dhs[2] = dmabuf_alloc(dbsc, dbsc->page_size * 3);
+    dmabuf_free(dhs[0]);
+    dmabuf_free(dhs[1]);
+    dmabuf_free(dhs[2]);
+
+    /* 2 more fit in bytes limit (6 + 6 = 12 pages) */
+    ret |= check_stats(dbsc, "limits bytes", 0, 11, 5, 6);
+    dmabufs_ctl_pool_stats(dbsc, &st);
+    if (st.pooled_bytes != sz * 6 || st.pooled_bufs != 5) {
+        fprintf(stderr, "limits: pooled %zd bytes %u bufs\n", st.pooled_bytes, st.pooled_bufs);
+        ret = 1;
+    }
+
+    dmabufs_ctl_pool_set(dbsc, sz * 2, 3);
+    dmabufs_ctl_pool_stats(dbsc, &st);
+    if (st.pooled_bytes > sz * 2) {
+        fprintf(stderr, "limits: trim left %zd bytes\n", st.pooled_bytes);
+        ret = 1;
+    }
+
+    /* Disabled */
+    dmabufs_ctl_pool_set(dbsc, 0, 0);
+    dmabuf_free(dmabuf_alloc(dbsc, sz));
+    dmabufs_ctl_pool_stats(dbsc, &st);
+    if (st.pooled_bufs != 0)
+        ret = 1;
+
+    return ret;
+}
+
+/* Buffers outlive the ctl reference they were allocated from */
+static int test_lifetime(void)
+{
+    struct dmabufs_ctl * dbsc = dmabufs_ctl_new_memfd();
+    struct dmabuf_h * dh;
+    struct dmabuf_h * imp;
+
+    if (!dbsc || !(dh = dmabuf_alloc(dbsc, 100)))
+        return 1;
+    imp = dmabuf_import(dmabuf_fd(dh), dmabuf_size(dh));
+    dmabufs_ctl_unref(&dbsc);
+    memset(dmabuf_map(dh), 0xaa, dmabuf_size(dh));
+    if (!imp || ((uint8_t *)dmabuf_map(imp))[0] != 0xaa) {
+        fprintf(stderr, "lifetime: import mismatch\n");
+        return 1;
+    }
+    dmabuf_free(imp);
+    dmabuf_free(dh);
+    return 0;
+}
+
+static void * thread_fn(void * v)
+{
+    struct dmabufs_ctl * const dbsc = v;
+    unsigned int seed = (unsigned int)(uintptr_t)&seed;
+    int i;
+
+    for (i = 0; i != THREAD_LOOPS; ++i) {
+        struct dmabuf_h * dh = dmabuf_alloc(dbsc, 1 + rand_r(&seed) % (64 * 1024));
+        if (!dh)
+            return (void *)1;
+        dh = dmabuf_realloc(dbsc, dh, 1 + rand_r(&seed) % (256 * 1024));
+        if (!dh || !dmabuf_map(dh))
+            return (void *)1;
+        dmabuf_free(dh);
+    }
+    return NULL;
+}
+
+static int test_threads(struct dmabufs_ctl * const dbsc)
+{
+    pthread_t th[N_THREADS];
+    struct dmabufs_pool_stats st;
+    int ret = 0;
+    int i;
+
+    dmabufs_ctl_pool_set(dbsc, 1 << 20, 2);
+    for (i = 0; i != N_THREADS; ++i)
+        if (pthread_create(th + i, NULL, thread_fn, dbsc))
+            return 1;
+    for (i = 0; i != N_THREADS; ++i) {
+        void * rv;
+        pthread_join(th[i], &rv);
+        ret |= rv != NULL;
+    }
+    dmabufs_ctl_pool_stats(dbsc, &st);
+    if (st.pooled_bytes > 1 << 20 || st.hits == 0) {
+        fprintf(stderr, "threads: pooled %zd, hits %"PRIu64"\n", st.pooled_bytes, st.hits);
+        ret = 1;
+    }
+    return ret;
+}
+
+int main(void)
+{
+    struct dmabufs_ctl * dbsc;
+    int ret = 0;
+
+    ret |= test_classes();
+
+    if (!(dbsc = dmabufs_ctl_new_memfd()))
+        return 1;
+    ret |= test_reuse(dbsc);
+    dmabufs_ctl_unref(&dbsc);
+
+    if (!(dbsc = dmabufs_ctl_new_memfd()))
+        return 1;
+    ret |= test_limits(dbsc);
+    dmabufs_ctl_unref(&dbsc);
+
+    ret |= test_lifetime();
+
+    if (!(dbsc = dmabufs_ctl_new_memfd()))
+        return 1;
+    ret |= test_threads(dbsc);
+    dmabufs_ctl_unref(&dbsc);
+
+    return ret;
+}
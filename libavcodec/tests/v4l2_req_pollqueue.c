@@ -0,0 +1,240 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavcodec/v4l2_req_pollqueue.c"
+
+#define N_TASKS 64
+#define REQUEUES 100
+
+typedef struct TestTask {
+    struct polltask *pt;
+    int fd;
+    sem_t done;
+    atomic_int calls;
+    short revents;
+    int requeue;
+} TestTask;
+
+static void test_cb(void *v, short revents)
+{
+    TestTask *const t = v;
+    uint64_t buf;
+
+    t->revents = revents;
+    atomic_fetch_add(&t->calls, 1);
+    if (revents & POLLIN)
+        if (read(t->fd, &buf, sizeof(buf)) < 0)
+            return;
+    if (t->requeue > 0) {
+        --t->requeue;
+        /* Make ourselves ready again & requeue from the poll thread */
+        buf = 1;
+        if (write(t->fd, &buf, sizeof(buf)) < 0)
+            return;
+        pollqueue_add_task(t->pt, -1);
+        return;
+    }
+    sem_post(&t->done);
+}
+
+static int wait_done(TestTask *const t)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += 5;
+    while (sem_timedwait(&t->done, &ts)) {
+        if (errno != EINTR)
+            return -1;
+    }
+    return 0;
+}
+
+static int task_init(TestTask *const t, struct pollqueue *const pq, const int fd)
+{
+    memset(t, 0, sizeof(*t));
+    t->fd = fd;
+    sem_init(&t->done, 0, 0);
+    return (t->pt = polltask_new(pq, fd, POLLIN, test_cb, t)) ? 0 : -1;
+}
+
+static void task_uninit(TestTask *const t)
+{
+    polltask_delete(&t->pt);
+    sem_destroy(&t->done);
+}
+
+static int signal_fd(const int fd)
+{
+    const uint64_t one = 1;
+    return write(fd, &one, sizeof(one)) == sizeof(one) ? 0 : -1;
+}
+
+/* Pipe becomes readable */
+static int test_pipe(struct pollqueue *const pq)
+{
+    TestTask t;
+    int fds[2];
+    int ret = 0;
+
+    if (pipe(fds) || task_init(&t, pq, fds[0]))
+        return 1;
+    pollqueue_add_task(t.pt, -1);
+    if (write(fds[1], "x", 1) != 1 || wait_done(&t)) {
+        fprintf(stderr, "pipe: no callback\n");
+        ret = 1;
+    }
+    else if (!(t.revents & POLLIN) || atomic_load(&t.calls) != 1) {
+        fprintf(stderr, "pipe: revents %#x, calls %d\n", t.revents, atomic_load(&t.calls));
+        ret = 1;
+    }
+    task_uninit(&t);
+    close(fds[0]);
+    close(fds[1]);
+    return ret;
+}
+
+/* Timeout fires with revents 0 & no event turns up later */
+static int test_timeout(struct pollqueue *const pq)
+{
+    TestTask t;
+    int fd = eventfd(0, EFD_NONBLOCK);
+    int ret = 0;
+
+    if (fd == -1 || task_init(&t, pq, fd))
+        return 1;
+    pollqueue_add_task(t.pt, 20);
+    if (wait_done(&t) || t.revents != 0) {
+        fprintf(stderr, "timeout: revents %#x\n", t.revents);
+        ret = 1;
+    }
+    signal_fd(fd);
+    usleep(20000);
+    if (atomic_load(&t.calls) != 1) {
+        fprintf(stderr, "timeout: stale event after timeout\n");
+        ret = 1;
+    }
+    task_uninit(&t);
+    close(fd);
+    return ret;
+}
+
+/* No fd - only the timeout can run the task, & not before it expires */
+static int test_timer(struct pollqueue *const pq)
+{
+    TestTask t;
+    int ret = 0;
+
+    if (task_init(&t, pq, -1))
+        return 1;
+    pollqueue_add_task(t.pt, 50);
+    usleep(10000);
+    if (atomic_load(&t.calls) != 0) {
+        fprintf(stderr, "timer: ran before its timeout\n");
+        ret = 1;
+    }
+    else if (wait_done(&t) || t.revents != 0 || atomic_load(&t.calls) != 1) {
+        fprintf(stderr, "timer: revents %#x, calls %d\n", t.revents, atomic_load(&t.calls));
+        ret = 1;
+    }
+    task_uninit(&t);
+    return ret;
+}
+
+/* Lots of tasks ready at once, each requeued from its callback */
+static int test_many(struct pollqueue *const pq)
+{
+    static TestTask t[N_TASKS];
+    int ret = 0;
+    int i;
+
+    for (i = 0; i != N_TASKS; ++i) {
+        int fd = eventfd(0, EFD_NONBLOCK);
+        if (fd == -1 || task_init(t + i, pq, fd))
+            return 1;
+        t[i].requeue = REQUEUES;
+        pollqueue_add_task(t[i].pt, 1000 * 60);
+    }
+    for (i = 0; i != N_TASKS; ++i)
+        signal_fd(t[i].fd);
+    for (i = 0; i != N_TASKS; ++i) {
+        if (wait_done(t + i) || atomic_load(&t[i].calls) != REQUEUES + 1) {
+            fprintf(stderr, "many: task %d calls %d\n", i, atomic_load(&t[i].calls));
+            ret = 1;
+        }
+    }
+    for (i = 0; i != N_TASKS; ++i) {
+        task_uninit(t + i);
+        close(t[i].fd);
+    }
+    return ret;
+}
+
+/* Delete whilst queued (with & without a pending event) */
+static int test_delete(struct pollqueue *const pq)
+{
+    int ret = 0;
+    int i;
+
+    for (i = 0; i != 200; ++i) {
+        TestTask t;
+        int fd = eventfd(0, EFD_NONBLOCK);
+
+        if (fd == -1 || task_init(&t, pq, fd))
+            return 1;
+        pollqueue_add_task(t.pt, (i & 2) ? 1 : -1);
+        if (i & 1)
+            signal_fd(fd);
+        task_uninit(&t);
+        close(fd);
+        if (atomic_load(&t.calls) > 1) {
+            fprintf(stderr, "delete: calls %d\n", atomic_load(&t.calls));
+            ret = 1;
+        }
+    }
+    return ret;
+}
+
+int main(void)
+{
+    struct pollqueue *pq = pollqueue_shared();
+    struct pollqueue *pq2 = pollqueue_shared();
+    int ret = 0;
+
+    if (!pq || pq != pq2) {
+        fprintf(stderr, "shared pollqueue not shared\n");
+        return 1;
+    }
+    pollqueue_unref(&pq2);
+
+    ret |= test_pipe(pq);
+    ret |= test_timeout(pq);
+    ret |= test_timer(pq);
+    ret |= test_many(pq);
+    ret |= test_delete(pq);
+
+    pollqueue_unref(&pq);
+
+    /* Last ref gone so we should get a new one */
+    if (!(pq = pollqueue_shared()))
+        return 1;
+    ret |= test_pipe(pq);
+    pollqueue_unref(&pq);
+
+    return ret;
+}
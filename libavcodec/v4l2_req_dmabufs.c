@@ -1,3 +1,7 @@
+/* memfd_create */
+#define _GNU_SOURCE
+
+#include <pthread.h>
 #include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,6 +24,13 @@
 
 #define TRACE_ALLOC 0
 
+/* Size classes are exact up to 4 pages then go in quarter powers of 2
+ * (4, 5, 6, 7, 8, 10, 12, 14, 16, 20 ...).  Anything bigger than the last
+ * class is never pooled. */
+#define POOL_CLASSES 64
+#define POOL_DEFAULT_MAX_BYTES (32 << 20)
+#define POOL_DEFAULT_MAX_PER_CLASS 4
+
 struct dmabufs_ctl;
 struct dmabuf_h;
 
@@ -28,6 +39,17 @@ struct dmabuf_fns {
     void (*buf_free)(struct dmabuf_h * dh);
     int (*ctl_new)(struct dmabufs_ctl * dbsc);
     void (*ctl_free)(struct dmabufs_ctl * dbsc);
+    /* Buffers aren't real dmabufs so DMA_BUF_IOCTL_SYNC must be skipped */
+    int no_sync;
+};
+
+struct dmabuf_pool {
+    pthread_mutex_t lock;
+    size_t max_bytes;
+    unsigned int max_per_class;
+    struct dmabuf_h * free[POOL_CLASSES];
+    unsigned int n[POOL_CLASSES];
+    struct dmabufs_pool_stats stats;
 };
 
 struct dmabufs_ctl {
@@ -36,6 +58,7 @@ struct dmabufs_ctl {
     size_t page_size;
     void * v;
     const struct dmabuf_fns * fns;
+    struct dmabuf_pool pool;
 };
 
 struct dmabuf_h {
@@ -45,6 +68,11 @@ struct dmabuf_h {
     void * mapptr;
     void * v;
     const struct dmabuf_fns * fns;
+    /* Allocating ctl - holds a ref while the buffer is outstanding
+     * NULL for imported buffers */
+    struct dmabufs_ctl * ctl;
+    /* Pool free-list link */
+    struct dmabuf_h * next;
 };
 
 #if TRACE_ALLOC
@@ -101,9 +129,143 @@ struct dmabuf_h * dmabuf_import(int fd, size_t size)
     return dh;
 }
 
+static unsigned int log2_pages(size_t n)
+{
+    unsigned int b = 0;
+    while (n >>= 1)
+        ++b;
+    return b;
+}
+
+/* Round a page count up to its size class & return the class index
+ * Returns -1 if too big to pool */
+static int pool_class(size_t * const ppages)
+{
+    size_t pages = *ppages;
+    unsigned int b;
+    int idx;
+
+    if (pages <= 4)
+        return pages == 0 ? -1 : (int)pages - 1;
+
+    b = log2_pages(pages);
+    pages = (pages + ((size_t)1 << (b - 2)) - 1) & ~(((size_t)1 << (b - 2)) - 1);
+    b = log2_pages(pages);
+    idx = 4 * (b - 1) + ((pages >> (b - 2)) & 3) - 1;
+    if (idx >= POOL_CLASSES)
+        return -1;
+    *ppages = pages;
+    return idx;
+}
+
+static void dmabuf_destroy(struct dmabuf_h * const dh)
+{
+#if TRACE_ALLOC
+    --total_bufs;
+    total_size -= dh->size;
+    request_log("%s: Free: %zd, total=%zd, bufs=%d\n", __func__, dh->size, total_size, total_bufs);
+#endif
+
+    if (dh->fns)
+        dh->fns->buf_free(dh);
+
+    if (dh->mapptr != MAP_FAILED && dh->mapptr != NULL)
+        munmap(dh->mapptr, dh->size);
+    if (dh->fd != -1)
+        while (close(dh->fd) == -1 && errno == EINTR)
+            /* loop */;
+    free(dh);
+}
+
+static struct dmabuf_h * pool_get(struct dmabuf_pool * const pool, const int idx)
+{
+    struct dmabuf_h * dh;
+
+    pthread_mutex_lock(&pool->lock);
+    if ((dh = pool->free[idx]) != NULL) {
+        pool->free[idx] = dh->next;
+        --pool->n[idx];
+        pool->stats.pooled_bytes -= dh->size;
+        --pool->stats.pooled_bufs;
+        ++pool->stats.hits;
+    }
+    else {
+        ++pool->stats.misses;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (dh) {
+        dh->next = NULL;
+        dh->len = 0;
+    }
+    return dh;
+}
+
+/* Returns 0 if the buffer was taken by the pool */
+static int pool_put(struct dmabufs_ctl * const dbsc, struct dmabuf_h * const dh)
+{
+    struct dmabuf_pool * const pool = &dbsc->pool;
+    size_t pages = dh->size / dbsc->page_size;
+    const int idx = pool_class(&pages);
+    int rv = -1;
+
+    pthread_mutex_lock(&pool->lock);
+    /* Only take buffers that are exactly their class size */
+    if (idx < 0 || pages * dbsc->page_size != dh->size ||
+        pool->n[idx] >= pool->max_per_class ||
+        pool->stats.pooled_bytes + dh->size > pool->max_bytes) {
+        ++pool->stats.discards;
+    }
+    else {
+        dh->next = pool->free[idx];
+        pool->free[idx] = dh;
+        ++pool->n[idx];
+        pool->stats.pooled_bytes += dh->size;
+        ++pool->stats.pooled_bufs;
+        if (pool->stats.pooled_bytes > pool->stats.peak_pooled_bytes)
+            pool->stats.peak_pooled_bytes = pool->stats.pooled_bytes;
+        ++pool->stats.puts;
+        rv = 0;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return rv;
+}
+
+/* Free pooled buffers until within limits
+ * Biggest classes go first as they are the most expensive to keep */
+static void pool_trim(struct dmabuf_pool * const pool, const size_t max_bytes, const unsigned int max_per_class)
+{
+    struct dmabuf_h * kill = NULL;
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    for (i = POOL_CLASSES - 1; i >= 0; --i) {
+        while (pool->free[i] != NULL &&
+               (pool->n[i] > max_per_class || pool->stats.pooled_bytes > max_bytes)) {
+            struct dmabuf_h * const dh = pool->free[i];
+            pool->free[i] = dh->next;
+            --pool->n[i];
+            pool->stats.pooled_bytes -= dh->size;
+            --pool->stats.pooled_bufs;
+            dh->next = kill;
+            kill = dh;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    while (kill) {
+        struct dmabuf_h * const dh = kill;
+        kill = dh->next;
+        dmabuf_destroy(dh);
+    }
+}
+
 struct dmabuf_h * dmabuf_realloc(struct dmabufs_ctl * dbsc, struct dmabuf_h * old, size_t size)
 {
     struct dmabuf_h * dh;
+    size_t pages;
+    int idx;
+
     if (old != NULL) {
         if (old->size >= size) {
             return old;
@@ -111,8 +273,19 @@ struct dmabuf_h * dmabuf_realloc(struct dmabufs_ctl * dbsc, struct dmabuf_h * ol
         dmabuf_free(old);
     }
 
-    if (size == 0 ||
-        (dh = malloc(sizeof(*dh))) == NULL)
+    if (size == 0)
+        return NULL;
+
+    pages = (size + dbsc->page_size - 1) / dbsc->page_size;
+    if ((idx = pool_class(&pages)) >= 0) {
+        size = pages * dbsc->page_size;
+        if ((dh = pool_get(&dbsc->pool, idx)) != NULL) {
+            dh->ctl = dmabufs_ctl_ref(dbsc);
+            return dh;
+        }
+    }
+
+    if ((dh = malloc(sizeof(*dh))) == NULL)
         return NULL;
 
     *dh = (struct dmabuf_h){
@@ -124,6 +297,7 @@ struct dmabuf_h * dmabuf_realloc(struct dmabufs_ctl * dbsc, struct dmabuf_h * ol
     if (dh->fns->buf_alloc(dbsc, dh, size) != 0)
         goto fail;
 
+    dh->ctl = dmabufs_ctl_ref(dbsc);
 
 #if TRACE_ALLOC
     ++total_bufs;
@@ -143,7 +317,7 @@ int dmabuf_sync(struct dmabuf_h * const dh, unsigned int flags)
     struct dma_buf_sync sync = {
         .flags = flags
     };
-    if (dh->fd == -1)
+    if (dh->fd == -1 || (dh->fns && dh->fns->no_sync))
         return 0;
     while (ioctl(dh->fd, DMA_BUF_IOCTL_SYNC, &sync) == -1) {
         const int err = errno;
@@ -223,23 +397,23 @@ void dmabuf_len_set(struct dmabuf_h * const dh, const size_t len)
 
 void dmabuf_free(struct dmabuf_h * dh)
 {
+    struct dmabufs_ctl * dbsc;
+
     if (!dh)
         return;
 
-#if TRACE_ALLOC
-    --total_bufs;
-    total_size -= dh->size;
-    request_log("%s: Free: %zd, total=%zd, bufs=%d\n", __func__, dh->size, total_size, total_bufs);
-#endif
-
-    dh->fns->buf_free(dh);
+    /* Imported buffers have no ctl & are never pooled */
+    if ((dbsc = dh->ctl) == NULL) {
+        dmabuf_destroy(dh);
+        return;
+    }
 
-    if (dh->mapptr != MAP_FAILED && dh->mapptr != NULL)
-        munmap(dh->mapptr, dh->size);
-    if (dh->fd != -1)
-        while (close(dh->fd) == -1 && errno == EINTR)
-            /* loop */;
-    free(dh);
+    /* Keep the mapping (if any) on pooled buffers - that is a good part
+     * of the cost of a new one */
+    dh->ctl = NULL;
+    if (pool_put(dbsc, dh) != 0)
+        dmabuf_destroy(dh);
+    dmabufs_ctl_unref(&dbsc);
 }
 
 static struct dmabufs_ctl * dmabufs_ctl_new2(const struct dmabuf_fns * const fns)
@@ -252,12 +426,19 @@ static struct dmabufs_ctl * dmabufs_ctl_new2(const struct dmabuf_fns * const fns
     dbsc->fd = -1;
     dbsc->fns = fns;
     dbsc->page_size = (size_t)sysconf(_SC_PAGE_SIZE);
+    dbsc->pool.max_bytes = POOL_DEFAULT_MAX_BYTES;
+    dbsc->pool.max_per_class = POOL_DEFAULT_MAX_PER_CLASS;
 
-    if (fns->ctl_new(dbsc) != 0)
+    if (pthread_mutex_init(&dbsc->pool.lock, NULL) != 0)
         goto fail;
 
+    if (fns->ctl_new(dbsc) != 0)
+        goto fail_lock;
+
     return dbsc;
 
+fail_lock:
+    pthread_mutex_destroy(&dbsc->pool.lock);
 fail:
     free(dbsc);
     return NULL;
@@ -265,9 +446,15 @@ fail:
 
 static void dmabufs_ctl_free(struct dmabufs_ctl * const dbsc)
 {
-    request_debug(NULL, "Free dmabuf ctl\n");
+    const struct dmabufs_pool_stats * const st = &dbsc->pool.stats;
 
+    request_debug(NULL, "Free dmabuf ctl: pool hits=%" PRIu64 ", misses=%" PRIu64
+                  ", puts=%" PRIu64 ", discards=%" PRIu64 ", peak=%zd\n",
+                  st->hits, st->misses, st->puts, st->discards, st->peak_pooled_bytes);
+
+    pool_trim(&dbsc->pool, 0, 0);
     dbsc->fns->ctl_free(dbsc);
+    pthread_mutex_destroy(&dbsc->pool.lock);
 
     free(dbsc);
 }
@@ -292,6 +479,25 @@ struct dmabufs_ctl * dmabufs_ctl_ref(struct dmabufs_ctl * const dbsc)
     return dbsc;
 }
 
+void dmabufs_ctl_pool_set(struct dmabufs_ctl * const dbsc, const size_t max_bytes, const unsigned int max_per_class)
+{
+    struct dmabuf_pool * const pool = &dbsc->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->max_bytes = max_bytes;
+    pool->max_per_class = max_per_class;
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_trim(pool, max_bytes, max_per_class);
+}
+
+void dmabufs_ctl_pool_stats(struct dmabufs_ctl * const dbsc, struct dmabufs_pool_stats * const stats)
+{
+    pthread_mutex_lock(&dbsc->pool.lock);
+    *stats = dbsc->pool.stats;
+    pthread_mutex_unlock(&dbsc->pool.lock);
+}
+
 //-----------------------------------------------------------------------------
 //
 // Alloc dmabuf via CMA
@@ -367,3 +573,60 @@ struct dmabufs_ctl * dmabufs_ctl_new(void)
     return dmabufs_ctl_new2(&dmabuf_cma_fns);
 }
 
+//-----------------------------------------------------------------------------
+//
+// Alloc "dmabuf" via memfd
+// Not a real dmabuf so no use to a device but lets the pool be exercised
+// without a dma-heap
+
+static int ctl_memfd_new(struct dmabufs_ctl * dbsc)
+{
+    return 0;
+}
+
+static void ctl_memfd_free(struct dmabufs_ctl * dbsc)
+{
+}
+
+static int buf_memfd_alloc(struct dmabufs_ctl * const dbsc, struct dmabuf_h * dh, size_t size)
+{
+    const size_t len = (size + dbsc->page_size - 1) & ~(dbsc->page_size - 1);
+    int fd;
+
+    if ((fd = memfd_create("dmabuf", MFD_CLOEXEC)) == -1) {
+        const int err = errno;
+        request_log("Failed to create memfd: %s\n", strerror(err));
+        return -err;
+    }
+    while (ftruncate(fd, (off_t)len) == -1) {
+        const int err = errno;
+        if (err == EINTR)
+            continue;
+        request_log("Failed to size memfd to %zd: %s\n", len, strerror(err));
+        close(fd);
+        return -err;
+    }
+
+    dh->fd = fd;
+    dh->size = len;
+    return 0;
+}
+
+static void buf_memfd_free(struct dmabuf_h * dh)
+{
+    // Nothing needed
+}
+
+static const struct dmabuf_fns dmabuf_memfd_fns = {
+    .buf_alloc  = buf_memfd_alloc,
+    .buf_free   = buf_memfd_free,
+    .ctl_new    = ctl_memfd_new,
+    .ctl_free   = ctl_memfd_free,
+    .no_sync    = 1,
+};
+
+struct dmabufs_ctl * dmabufs_ctl_new_memfd(void)
+{
+    request_debug(NULL, "Dmabufs using memfd\n");
+    return dmabufs_ctl_new2(&dmabuf_memfd_fns);
+}
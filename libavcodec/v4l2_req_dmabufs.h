@@ -2,16 +2,37 @@
 #define DMABUFS_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 struct dmabufs_ctl;
 struct dmabuf_h;
 
+struct dmabufs_pool_stats {
+    uint64_t hits;      // Alloc satisfied from the pool
+    uint64_t misses;    // Alloc of a poolable size that needed a new buffer
+    uint64_t puts;      // Free that was kept in the pool
+    uint64_t discards;  // Free that was over a limit (or unpoolable)
+    size_t pooled_bytes;
+    unsigned int pooled_bufs;
+    size_t peak_pooled_bytes;
+};
+
 struct dmabufs_ctl * dmabufs_ctl_new(void);
+/* memfd backed buffers - not real dmabufs, for testing without a dma-heap */
+struct dmabufs_ctl * dmabufs_ctl_new_memfd(void);
 void dmabufs_ctl_unref(struct dmabufs_ctl ** const pdbsc);
 struct dmabufs_ctl * dmabufs_ctl_ref(struct dmabufs_ctl * const dbsc);
 
+/* Limits on buffers kept for reuse once freed
+ * Excess pooled buffers are released immediately
+ * max_bytes = 0 disables pooling */
+void dmabufs_ctl_pool_set(struct dmabufs_ctl * const dbsc, const size_t max_bytes, const unsigned int max_per_class);
+void dmabufs_ctl_pool_stats(struct dmabufs_ctl * const dbsc, struct dmabufs_pool_stats * const stats);
+
 // Need not preserve old contents
 // On NULL return old buffer is freed
+// Size is rounded up to a pool size class & a freed buffer of that
+// class is reused if there is one
 struct dmabuf_h * dmabuf_realloc(struct dmabufs_ctl * dbsc, struct dmabuf_h *, size_t size);
 
 static inline struct dmabuf_h * dmabuf_alloc(struct dmabufs_ctl * dbsc, size_t size) {
@@ -9,12 +9,16 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/epoll.h>
 #include <sys/eventfd.h>
 
 #include "v4l2_req_pollqueue.h"
 #include "v4l2_req_utils.h"
 
+/* Max events we collect (and so tasks we dispatch) per wakeup */
+#define POLLQUEUE_MAX_EVENTS 16
 
 struct pollqueue;
 
@@ -27,13 +31,17 @@ enum polltask_state {
 };
 
 struct polltask {
+    /* Timeout chain - only on it if queued with a timeout */
     struct polltask *next;
     struct polltask *prev;
+    /* Kill chain - only on it between delete & the poll thread noticing */
+    struct polltask *kill_next;
     struct pollqueue *q;
     enum polltask_state state;
 
     int fd;
     short events;
+    bool in_epoll;   /* fd has been added to the epoll set */
 
     void (*fn)(void *v, short revents);
     void * v;
@@ -46,16 +54,24 @@ struct pollqueue {
     atomic_int ref_count;
     pthread_mutex_t lock;
 
+    /* Tasks with a timeout, sorted by timeout */
     struct polltask *head;
     struct polltask *tail;
+    /* Tasks deleted whilst queued */
+    struct polltask *kill_head;
 
     bool kill;
-    bool no_prod;
+    bool shared;
+    uint64_t wait_timeout;  /* Timeout the poll thread is waiting on, 0 => forever */
+    int epoll_fd;
     int prod_fd;
-    struct polltask *prod_pt;
     pthread_t worker;
 };
 
+/* Single pollqueue shared between all users of pollqueue_shared */
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct pollqueue *shared_pq = NULL;
+
 struct polltask *polltask_new(struct pollqueue *const pq,
                               const int fd, const short events,
                   void (*const fn)(void *v, short revents),
@@ -73,6 +89,7 @@ struct polltask *polltask_new(struct pollqueue *const pq,
     *pt = (struct polltask){
         .next = NULL,
         .prev = NULL,
+        .kill_next = NULL,
         .q = pollqueue_ref(pq),
         .fd = fd,
         .events = events,
@@ -85,8 +102,11 @@ struct polltask *polltask_new(struct pollqueue *const pq,
     return pt;
 }
 
+/* Remove from the timeout chain (if on it) */
 static void pollqueue_rem_task(struct pollqueue *const pq, struct polltask *const pt)
 {
+    if (!pt->timeout)
+        return;
     if (pt->prev)
         pt->prev->next = pt->next;
     else
@@ -97,6 +117,55 @@ static void pollqueue_rem_task(struct pollqueue *const pq, struct polltask *cons
         pq->tail = pt->prev;
     pt->next = NULL;
     pt->prev = NULL;
+    pt->timeout = 0;
+}
+
+/* Insert into the timeout chain - search from the tail as new timeouts
+ * are usually the latest
+ */
+static void pollqueue_ins_task(struct pollqueue *const pq, struct polltask *const pt)
+{
+    struct polltask *p = pq->tail;
+
+    while (p && (int64_t)(p->timeout - pt->timeout) > 0)
+        p = p->prev;
+
+    pt->prev = p;
+    if (p) {
+        pt->next = p->next;
+        p->next = pt;
+    }
+    else {
+        pt->next = pq->head;
+        pq->head = pt;
+    }
+    if (pt->next)
+        pt->next->prev = pt;
+    else
+        pq->tail = pt;
+}
+
+/* (Dis)arm the fd - called with the lock held so we can't race the
+ * poll thread.  Oneshot so a fired task is automatically disarmed.
+ * A task without an fd (fd < 0) is a pure timer and never enters epoll.
+ */
+static int polltask_arm(struct polltask *const pt, const short events)
+{
+    struct epoll_event ev = {
+        .events = EPOLLONESHOT | (uint32_t)events,
+        .data.ptr = pt
+    };
+
+    if (pt->fd < 0)
+        return 0;
+
+    if (pt->in_epoll)
+        return epoll_ctl(pt->q->epoll_fd, EPOLL_CTL_MOD, pt->fd, &ev);
+
+    if (epoll_ctl(pt->q->epoll_fd, EPOLL_CTL_ADD, pt->fd, &ev))
+        return -1;
+    pt->in_epoll = true;
+    return 0;
 }
 
 static void polltask_free(struct polltask * const pt)
@@ -116,7 +185,6 @@ void polltask_delete(struct polltask **const ppt)
     struct polltask *const pt = *ppt;
     struct pollqueue * pq;
     enum polltask_state state;
-    bool prodme;
 
     if (!pt)
         return;
@@ -124,12 +192,26 @@ void polltask_delete(struct polltask **const ppt)
     pq = pt->q;
     pthread_mutex_lock(&pq->lock);
     state = pt->state;
-    pt->state = (state == POLLTASK_RUNNING) ? POLLTASK_RUN_KILL : POLLTASK_Q_KILL;
-    prodme = !pq->no_prod;
+    if (state == POLLTASK_UNQUEUED) {
+        /* Not armed & not in any event set the poll thread holds */
+        if (pt->in_epoll)
+            epoll_ctl(pq->epoll_fd, EPOLL_CTL_DEL, pt->fd, NULL);
+    }
+    else if (state == POLLTASK_RUNNING) {
+        pt->state = POLLTASK_RUN_KILL;
+    }
+    else {
+        /* Queued - the poll thread may already hold an event for this
+         * so it must be the one to finally let go of it
+         */
+        pt->state = POLLTASK_Q_KILL;
+        pt->kill_next = pq->kill_head;
+        pq->kill_head = pt;
+    }
     pthread_mutex_unlock(&pq->lock);
 
     if (state != POLLTASK_UNQUEUED) {
-        if (prodme)
+        if (state != POLLTASK_RUNNING)
             pollqueue_prod(pq);
         while (sem_wait(&pt->kill_sem) && errno == EINTR)
             /* loop */;
@@ -160,134 +242,139 @@ void pollqueue_add_task(struct polltask *const pt, const int timeout)
 
     pthread_mutex_lock(&pq->lock);
     if (pt->state != POLLTASK_Q_KILL && pt->state != POLLTASK_RUN_KILL) {
-        if (pq->tail)
-            pq->tail->next = pt;
-        else
-            pq->head = pt;
-        pt->prev = pq->tail;
-        pt->next = NULL;
+        pollqueue_rem_task(pq, pt);
         pt->state = POLLTASK_QUEUED;
-        pt->timeout = timeout < 0 ? 0 : pollqueue_now(timeout);
-        pq->tail = pt;
-        prodme = !pq->no_prod;
+        if (timeout >= 0) {
+            pt->timeout = pollqueue_now(timeout);
+            pollqueue_ins_task(pq, pt);
+            /* Only need to wake the poll thread if it is waiting for
+             * longer than we want
+             */
+            prodme = !pq->wait_timeout ||
+                (int64_t)(pq->wait_timeout - pt->timeout) > 0;
+        }
+        if (polltask_arm(pt, pt->events)) {
+            request_log("Failed to add fd %d to epoll: %s\n", pt->fd, strerror(errno));
+            /* Run it on the next poll thread loop as a timeout */
+            pollqueue_rem_task(pq, pt);
+            pt->timeout = pollqueue_now(0);
+            pollqueue_ins_task(pq, pt);
+            prodme = true;
+        }
     }
     pthread_mutex_unlock(&pq->lock);
     if (prodme)
         pollqueue_prod(pq);
 }
 
+/* Called with the lock held & drops it whilst running the task */
+static void pollqueue_run_task(struct pollqueue *const pq, struct polltask *const pt,
+                               const short revents)
+{
+    pollqueue_rem_task(pq, pt);
+    pt->state = POLLTASK_RUNNING;
+    pthread_mutex_unlock(&pq->lock);
+
+    pt->fn(pt->v, revents);
+
+    pthread_mutex_lock(&pq->lock);
+    if (pt->state == POLLTASK_RUNNING)
+        pt->state = POLLTASK_UNQUEUED;
+    if (pt->state == POLLTASK_RUN_KILL) {
+        if (pt->in_epoll)
+            epoll_ctl(pq->epoll_fd, EPOLL_CTL_DEL, pt->fd, NULL);
+        sem_post(&pt->kill_sem);
+    }
+}
+
 static void *poll_thread(void *v)
 {
     struct pollqueue *const pq = v;
-    struct pollfd *a = NULL;
-    size_t asize = 0;
+    struct epoll_event ev[POLLQUEUE_MAX_EVENTS];
 
     pthread_mutex_lock(&pq->lock);
     do {
-        unsigned int i;
-        unsigned int n = 0;
         struct polltask *pt;
-        struct polltask *pt_next;
         uint64_t now = pollqueue_now(0);
         int timeout = -1;
         int rv;
+        int i;
 
-        for (pt = pq->head; pt; pt = pt_next) {
-            int64_t t;
-
-            pt_next = pt->next;
-
-            if (pt->state == POLLTASK_Q_KILL) {
-                pollqueue_rem_task(pq, pt);
-                sem_post(&pt->kill_sem);
-                continue;
-            }
-
-            if (n >= asize) {
-                asize = asize ? asize * 2 : 4;
-                a = realloc(a, asize * sizeof(*a));
-                if (!a) {
-                    request_log("Failed to realloc poll array to %zd\n", asize);
-                    goto fail_locked;
-                }
-            }
-
-            a[n++] = (struct pollfd){
-                .fd = pt->fd,
-                .events = pt->events
-            };
-
-            t = (int64_t)(pt->timeout - now);
-            if (pt->timeout && t < INT_MAX &&
-                (timeout < 0 || (int)t < timeout))
-                timeout = (t < 0) ? 0 : (int)t;
+        pq->wait_timeout = 0;
+        if ((pt = pq->head) != NULL) {
+            const int64_t t = (int64_t)(pt->timeout - now);
+            timeout = t < 0 ? 0 : t < INT_MAX ? (int)t : INT_MAX;
+            pq->wait_timeout = pt->timeout;
         }
         pthread_mutex_unlock(&pq->lock);
 
-        if ((rv = poll(a, n, timeout)) == -1) {
+        if ((rv = epoll_wait(pq->epoll_fd, ev, POLLQUEUE_MAX_EVENTS, timeout)) == -1) {
             if (errno != EINTR) {
-                request_log("Poll error: %s\n", strerror(errno));
+                request_log("Epoll error: %s\n", strerror(errno));
                 goto fail_unlocked;
             }
+            rv = 0;
         }
 
         pthread_mutex_lock(&pq->lock);
-        now = pollqueue_now(0);
 
-        /* Prodding in this loop is pointless and might lead to
-         * infinite looping
-        */
-        pq->no_prod = true;
-        for (i = 0, pt = pq->head; i < n; ++i, pt = pt_next) {
-            pt_next = pt->next;
+        /* Run all the tasks that have fired.  New tasks added by a task
+         * fn cannot appear in ev so it remains valid throughout
+         */
+        for (i = 0; i < rv; ++i) {
+            pt = ev[i].data.ptr;
+
+            if (!pt) {
+                uint64_t buf;
+                /* Prod - just clear it */
+                if (read(pq->prod_fd, &buf, sizeof(buf)) == -1 && errno != EAGAIN)
+                    request_log("Prod read error: %s\n", strerror(errno));
+                continue;
+            }
+            /* Killed tasks are dealt with below, anything else has been
+             * run by a timeout & possibly requeued since - leave it.
+             */
+            if (pt->state == POLLTASK_QUEUED)
+                pollqueue_run_task(pq, pt, (short)ev[i].events);
+        }
 
-            /* Pending? */
-            if (a[i].revents ||
-                (pt->timeout && (int64_t)(now - pt->timeout) >= 0)) {
+        /* Timeouts */
+        now = pollqueue_now(0);
+        while ((pt = pq->head) != NULL && (int64_t)(now - pt->timeout) >= 0) {
+            if (pt->state != POLLTASK_QUEUED) {
+                /* Killed - just remove from timeouts */
                 pollqueue_rem_task(pq, pt);
-                if (pt->state == POLLTASK_QUEUED)
-                    pt->state = POLLTASK_RUNNING;
-                if (pt->state == POLLTASK_Q_KILL)
-                    pt->state = POLLTASK_RUN_KILL;
-                pthread_mutex_unlock(&pq->lock);
-
-                /* This can add new entries to the Q but as
-                 * those are added to the tail our existing
-                 * chain remains intact
-                */
-                pt->fn(pt->v, a[i].revents);
-
-                pthread_mutex_lock(&pq->lock);
-                if (pt->state == POLLTASK_RUNNING)
-                    pt->state = POLLTASK_UNQUEUED;
-                if (pt->state == POLLTASK_RUN_KILL)
-                    sem_post(&pt->kill_sem);
+                continue;
             }
+            /* Disarm the fd so no stale event can turn up later */
+            polltask_arm(pt, 0);
+            pollqueue_run_task(pq, pt, 0);
+        }
+
+        /* Release anything deleted whilst queued.  We have finished with
+         * ev so nothing else can reference these
+         */
+        while ((pt = pq->kill_head) != NULL) {
+            pq->kill_head = pt->kill_next;
+            pt->kill_next = NULL;
+            pollqueue_rem_task(pq, pt);
+            if (pt->in_epoll)
+                epoll_ctl(pq->epoll_fd, EPOLL_CTL_DEL, pt->fd, NULL);
+            sem_post(&pt->kill_sem);
         }
-        pq->no_prod = false;
 
     } while (!pq->kill);
 
-fail_locked:
     pthread_mutex_unlock(&pq->lock);
 fail_unlocked:
-    free(a);
     return NULL;
 }
 
-static void prod_fn(void *v, short revents)
-{
-    struct pollqueue *const pq = v;
-    char buf[8];
-    if (revents)
-        read(pq->prod_fd, buf, 8);
-    if (!pq->kill)
-        pollqueue_add_task(pq->prod_pt, -1);
-}
-
 struct pollqueue * pollqueue_new(void)
 {
     struct pollqueue *pq = malloc(sizeof(*pq));
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+
     if (!pq)
         return NULL;
     *pq = (struct pollqueue){
@@ -295,32 +382,50 @@ struct pollqueue * pollqueue_new(void)
         .lock = PTHREAD_MUTEX_INITIALIZER,
         .head = NULL,
         .tail = NULL,
+        .kill_head = NULL,
         .kill = false,
+        .epoll_fd = -1,
         .prod_fd = -1
     };
 
-    pq->prod_fd = eventfd(0, EFD_NONBLOCK);
-    if (pq->prod_fd == 1)
+    pq->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (pq->epoll_fd == -1)
         goto fail1;
-    pq->prod_pt = polltask_new(pq, pq->prod_fd, POLLIN, prod_fn, pq);
-    if (!pq->prod_pt)
+    pq->prod_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pq->prod_fd == -1)
         goto fail2;
-    pollqueue_add_task(pq->prod_pt, -1);
+    /* The prod is level triggered & never disarmed */
+    if (epoll_ctl(pq->epoll_fd, EPOLL_CTL_ADD, pq->prod_fd, &ev))
+        goto fail3;
     if (pthread_create(&pq->worker, NULL, poll_thread, pq))
         goto fail3;
-    // Reset ref count which will have been inced by the add_task
-    atomic_store(&pq->ref_count, 0);
     return pq;
 
 fail3:
-    polltask_free(pq->prod_pt);
-fail2:
     close(pq->prod_fd);
+fail2:
+    close(pq->epoll_fd);
 fail1:
     free(pq);
     return NULL;
 }
 
+struct pollqueue * pollqueue_shared(void)
+{
+    struct pollqueue *pq;
+
+    pthread_mutex_lock(&shared_lock);
+    if ((pq = shared_pq) != NULL) {
+        pollqueue_ref(pq);
+    }
+    else if ((pq = pollqueue_new()) != NULL) {
+        pq->shared = true;
+        shared_pq = pq;
+    }
+    pthread_mutex_unlock(&shared_lock);
+    return pq;
+}
+
 static void pollqueue_free(struct pollqueue *const pq)
 {
     void *rv;
@@ -331,9 +436,9 @@ static void pollqueue_free(struct pollqueue *const pq)
     pthread_mutex_unlock(&pq->lock);
 
     pthread_join(pq->worker, &rv);
-    polltask_free(pq->prod_pt);
     pthread_mutex_destroy(&pq->lock);
     close(pq->prod_fd);
+    close(pq->epoll_fd);
     free(pq);
 }
 
@@ -351,11 +456,20 @@ void pollqueue_unref(struct pollqueue **const ppq)
         return;
     *ppq = NULL;
 
+    if (pq->shared) {
+        /* Must stop pollqueue_shared finding it before we drop the last ref */
+        bool last;
+        pthread_mutex_lock(&shared_lock);
+        if ((last = atomic_fetch_sub(&pq->ref_count, 1) == 0))
+            shared_pq = NULL;
+        pthread_mutex_unlock(&shared_lock);
+        if (last)
+            pollqueue_free(pq);
+        return;
+    }
+
     if (atomic_fetch_sub(&pq->ref_count, 1) != 0)
         return;
 
     pollqueue_free(pq);
 }
-
-
-
@@ -4,6 +4,7 @@
 struct polltask;
 struct pollqueue;
 
+/* fd < 0 gives a task that only runs on its timeout */
 struct polltask *polltask_new(struct pollqueue *const pq,
 			      const int fd, const short events,
 			      void (*const fn)(void *v, short revents),
@@ -12,6 +13,8 @@ void polltask_delete(struct polltask **const ppt);
 
 void pollqueue_add_task(struct polltask *const pt, const int timeout);
 struct pollqueue * pollqueue_new(void);
+/* Get a ref to a single process-wide pollqueue (& its thread) */
+struct pollqueue * pollqueue_shared(void);
 void pollqueue_unref(struct pollqueue **const ppq);
 struct pollqueue * pollqueue_ref(struct pollqueue *const pq);
 
@@ -186,7 +186,7 @@ static int v4l2_request_hevc_init(AVCodecContext *avctx)
         dst_memtype = MEDIABUFS_MEMORY_DMABUF;
     }
 
-    if ((ctx->pq = pollqueue_new()) == NULL) {
+    if ((ctx->pq = pollqueue_shared()) == NULL) {
         av_log(avctx, AV_LOG_ERROR, "Unable to create pollqueue\n");
         goto fail1;
     }
@@ -2975,6 +2975,7 @@ AVCodec ff_vp8_decoder = {
 #endif
                                NULL
                            },
-    .caps_internal         = FF_CODEC_CAP_ALLOCATE_PROGRESS,
+    .caps_internal         = FF_CODEC_CAP_ALLOCATE_PROGRESS |
+                             FF_CODEC_CAP_SLICE_THREAD_CONCURRENT_JOBS,
 };
 #endif /* CONFIG_VP7_DECODER */
@@ -0,0 +1,628 @@
+;******************************************************************************
+;* SIMD optimized HEVC intra prediction
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+planar_x1:        dw  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16
+                  dw 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32
+
+intra_pred_angle: dd  32,  26,  21,  17,  13,   9,   5,   2,   0,  -2,  -5,  -9
+                  dd -13, -17, -21, -26, -32, -26, -21, -17, -13,  -9,  -5,  -2
+                  dd   0,   2,   5,   9,  13,  17,  21,  26,  32
+
+inv_angle:        dd -4096, -1638, -910, -630, -482, -390, -315, -256
+                  dd  -315,  -390, -482, -630, -910, -1638, -4096
+
+cextern pw_1
+cextern pw_1023
+
+SECTION .text
+
+; All the predictions are computed on 16-bit words whatever the bit depth,
+; 8-bit pixels are widened on load and packed again on store.
+
+%macro PIXEL_DEFS 1 ; bit depth
+%if %1 == 8
+    %define PS    1
+    %define pixel byte
+%else
+    %define PS    2
+    %define pixel word
+%endif
+%endmacro
+
+; %1 = number of pixels, sets npix to the number of pixels handled per
+; register and nch to the number of registers needed for a line
+%macro CHUNK_DEFS 1
+%assign npix mmsize / 2
+%if npix > %1
+%assign npix %1
+%endif
+%assign nch %1 / npix
+%endmacro
+
+%macro LOAD_PIXELS 2 ; dst, src
+%if PS == 1
+    pmovzxbw       %1, %2
+%else
+    movu           %1, %2
+%endif
+%endmacro
+
+; store the low %3 words of m%2 as pixels, m%2 is clobbered
+%macro STORE_PIXELS 3 ; dst, src register number, number of pixels
+%if PS == 1
+    packuswb     m%2, m%2
+%if %3 == 4
+    movd          %1, xm%2
+%elif %3 == 8
+    movq          %1, xm%2
+%else
+    vpermq       m%2, m%2, q0020
+    movu          %1, xm%2
+%endif
+%else
+%if %3 == 4
+    movq          %1, xm%2
+%elif %3 == 8
+    movu          %1, xm%2
+%else
+    movu          %1, m%2
+%endif
+%endif
+%endmacro
+
+%macro SPLAT_GPR 2 ; dst register number, gpr
+    movd        xm%1, %2
+    SPLATW       m%1, xm%1
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_hevc_pred_planar_<size>_<depth>_<opt>(uint8_t *src, const uint8_t *top,
+;                                               const uint8_t *left,
+;                                               ptrdiff_t stride)
+;------------------------------------------------------------------------------
+; Each line is computed incrementally: acc holds
+; (x + 1) * top[size] + (size - 1 - y) * top[x] + (y + 1) * left[size] + size
+; and is advanced by left[size] - top[x] per line. The result never exceeds
+; 16 bits at 10-bit, so unsigned word arithmetic is exact.
+%macro PRED_PLANAR 3 ; size, log2 size, bit depth
+PIXEL_DEFS %3
+CHUNK_DEFS %1
+cglobal hevc_pred_planar_%1_%3, 4, 6, 16, dst, top, left, stride, tmp, cnt
+%if PS == 2
+    add          strideq, strideq                   ; stride is in pixels
+%endif
+    movzx           tmpd, pixel [topq + %1 * PS]
+    SPLAT_GPR         14, tmpd                      ; top[size]
+    movzx           tmpd, pixel [leftq + %1 * PS]
+    SPLAT_GPR         15, tmpd                      ; left[size]
+    mov             tmpd, %1
+    SPLAT_GPR         13, tmpd                      ; size
+%assign i 0
+%rep nch
+%assign j i + nch
+%assign k i + 2 * nch
+    LOAD_PIXELS      m12, [topq + i * npix * PS]
+    mova         m %+ i, [planar_x1 + i * mmsize]
+    pmullw       m %+ i, m14
+    mova         m %+ k, m12
+    psllw        m %+ k, %2
+    psubw        m %+ k, m12
+    paddw        m %+ i, m %+ k
+    paddw        m %+ i, m15
+    paddw        m %+ i, m13                        ; acc
+    mova         m %+ j, m15
+    psubw        m %+ j, m12                        ; left[size] - top[x]
+    mova         m %+ k, m13
+    psubw        m %+ k, [planar_x1 + i * mmsize]   ; size - 1 - x
+%assign i i + 1
+%endrep
+    mov             cntd, %1
+.loop:
+    movzx           tmpd, pixel [leftq]
+    SPLAT_GPR         12, tmpd                      ; left[y]
+%assign i 0
+%rep nch
+%assign j i + nch
+%assign k i + 2 * nch
+    mova             m13, m %+ k
+    pmullw           m13, m12
+    paddw            m13, m %+ i
+    psrlw            m13, %2 + 1
+    paddw        m %+ i, m %+ j
+    STORE_PIXELS     [dstq + i * npix * PS], 13, npix
+%assign i i + 1
+%endrep
+    add            leftq, PS
+    add             dstq, strideq
+    dec             cntd
+    jg .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_hevc_pred_dc_<size>_<depth>_<opt>(uint8_t *src, const uint8_t *top,
+;                                           const uint8_t *left,
+;                                           ptrdiff_t stride, int c_idx)
+;------------------------------------------------------------------------------
+%macro DC_STORE_ROW 2 ; address, row size in bytes
+%if %2 == 4
+    movd            [%1], xm0
+%elif %2 == 8
+    movq            [%1], xm0
+%elif %2 < mmsize
+    movu            [%1], xm0
+%else
+%assign off 0
+%rep %2 / mmsize
+    movu      [%1 + off], m0
+%assign off off + mmsize
+%endrep
+%endif
+%endmacro
+
+%macro PRED_DC 3 ; size, log2 size, bit depth
+PIXEL_DEFS %3
+CHUNK_DEFS %1
+cglobal hevc_pred_dc_%1_%3, 5, 9, 6, dst, top, left, stride, cidx, dc, stride3, ptr, cnt
+%if PS == 2
+    add          strideq, strideq                   ; stride is in pixels
+%endif
+%if %1 == 4 && PS == 1
+    movd             xm0, [topq]
+    movd             xm1, [leftq]
+    pmovzxbw         xm0, xm0
+    pmovzxbw         xm1, xm1
+    paddw            xm0, xm1
+%elif %1 == 4
+    movq             xm0, [topq]
+    movq             xm1, [leftq]
+    paddw            xm0, xm1
+%else
+    LOAD_PIXELS       m0, [topq]
+    LOAD_PIXELS       m1, [leftq]
+    paddw             m0, m1
+%assign i 1
+%rep nch - 1
+    LOAD_PIXELS       m1, [topq + i * npix * PS]
+    paddw             m0, m1
+    LOAD_PIXELS       m1, [leftq + i * npix * PS]
+    paddw             m0, m1
+%assign i i + 1
+%endrep
+%if mmsize == 32
+    vextracti128     xm1, m0, 1
+    paddw            xm0, xm1
+%endif
+%endif
+    pmaddwd          xm0, [pw_1]
+    pshufd           xm1, xm0, q1032
+    paddd            xm0, xm1
+    pshufd           xm1, xm0, q2301
+    paddd            xm0, xm1
+    movd             dcd, xm0
+    add              dcd, %1
+    shr              dcd, %2 + 1
+
+    SPLAT_GPR          0, dcd
+%if PS == 1
+    packuswb          m0, m0
+%endif
+    lea          stride3q, [strideq * 3]
+    mov             ptrq, dstq
+    mov             cntd, %1 / 4
+.loop:
+    DC_STORE_ROW    ptrq, %1 * PS
+    DC_STORE_ROW    ptrq + strideq, %1 * PS
+    DC_STORE_ROW    ptrq + strideq * 2, %1 * PS
+    DC_STORE_ROW    ptrq + stride3q, %1 * PS
+    lea             ptrq, [ptrq + strideq * 4]
+    dec             cntd
+    jg .loop
+
+%if %1 < 32
+    test           cidxd, cidxd
+    jnz .end
+    ; first line and column: (top[x] + 3 * dc + 2) >> 2
+    lea            cidxd, [dcq * 3 + 2]
+    SPLAT_GPR          1, cidxd
+    LOAD_PIXELS      xm2, [topq]
+    LOAD_PIXELS      xm4, [leftq]
+    paddw            xm2, xm1
+    paddw            xm4, xm1
+    psrlw            xm2, 2
+    psrlw            xm4, 2
+%if %1 == 16
+    LOAD_PIXELS      xm3, [topq  + 8 * PS]
+    LOAD_PIXELS      xm5, [leftq + 8 * PS]
+    paddw            xm3, xm1
+    paddw            xm5, xm1
+    psrlw            xm3, 2
+    psrlw            xm5, 2
+%endif
+%if PS == 1
+%if %1 == 16
+    packuswb         xm2, xm3
+    packuswb         xm4, xm5
+%else
+    packuswb         xm2, xm2
+    packuswb         xm4, xm4
+%endif
+%if %1 == 4
+    movd           [dstq], xm2
+%elif %1 == 8
+    movq           [dstq], xm2
+%else
+    movu           [dstq], xm2
+%endif
+%else
+%if %1 == 4
+    movq           [dstq], xm2
+%else
+    movu           [dstq], xm2
+%if %1 == 16
+    movu      [dstq + 16], xm3
+%endif
+%endif
+%endif
+    mov             ptrq, dstq
+%assign y 1
+%rep %1 - 1
+    add             ptrq, strideq
+%if PS == 1
+    pextrb          [ptrq], xm4, y
+%elif y < 8
+    pextrw          [ptrq], xm4, y
+%else
+    pextrw          [ptrq], xm5, y - 8
+%endif
+%assign y y + 1
+%endrep
+    ; (left[0] + 2 * dc + top[0] + 2) >> 2
+    movzx          cidxd, pixel [topq]
+    movzx           cntd, pixel [leftq]
+    add            cidxd, cntd
+    lea            cidxd, [cidxq + dcq * 2 + 2]
+    shr            cidxd, 2
+%if PS == 1
+    mov            [dstq], cidxb
+%else
+    mov            [dstq], cidxw
+%endif
+.end:
+%endif
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_hevc_pred_angular_<size>_<depth>_<opt>(uint8_t *src, const uint8_t *top,
+;                                                const uint8_t *left,
+;                                                ptrdiff_t stride,
+;                                                int c_idx, int mode)
+;------------------------------------------------------------------------------
+; Horizontal modes are the transpose of the vertical ones with top and left
+; swapped (the angle tables are symmetric around mode 18), so both are
+; predicted line by line from a word reference array on the stack, the
+; horizontal ones into a word buffer that is then transposed into src.
+
+%assign ref_off 64              ; ref[0], ref[-size] is at rsp
+%assign tmp_off 256             ; transpose buffer, 64 bytes per line
+
+; ref[k] = main[k - 1] for 0 <= k <= 2 * size and, for negative angles,
+; ref[k] = side[((k * inv_angle + 128) >> 8) - 1] for last <= k < 0
+%macro ANGULAR_REF 3 ; size, main, side
+%assign n 2 * %1 + 1
+%assign k 0
+%rep (n - 1) / 8
+    LOAD_PIXELS      xm0, [%2 + (k - 1) * PS]
+    movu [rsp + ref_off + k * 2], xm0
+%assign k k + 8
+%endrep
+    LOAD_PIXELS      xm0, [%2 + (n - 9) * PS]
+    movu [rsp + ref_off + (n - 8) * 2], xm0
+
+    test          angled, angled
+    jns %%done
+    lea              idxq, [inv_angle]
+    movsxd           cntq, dword [idxq + modeq * 4 - 11 * 4]
+    mov              posq, angleq
+    imul             posq, %1
+    sar              posq, 5                        ; last
+%%loop:
+    mov              idxq, posq
+    imul             idxq, cntq
+    add              idxq, 128
+    sar              idxq, 8
+    movzx           moded, pixel [%3 + idxq * PS - PS]
+    mov [rsp + ref_off + posq * 2], modew
+    inc              posq
+    jnz %%loop
+%%done:
+%endmacro
+
+; out[x] = ref[x + idx + 1] + ((fact * (ref[x + idx + 2] - ref[x + idx + 1]) + 16) >> 5)
+; which is the same as the weighted sum with (32 - fact) and fact.
+; The rounded shift is done with pmulhrsw by fact << 10.
+%macro ANGULAR_LINES 3 ; size, output stride, output words (1) or pixels (0)
+    mov             posd, angled
+    mov             cntd, %1
+%%loop:
+    movsxd          idxq, posd
+    sar             idxq, 5
+    mov            moded, posd
+    and            moded, 31
+    shl            moded, 10
+    SPLAT_GPR          7, moded
+%assign i 0
+%rep nch
+    movu              m0, [rsp + idxq * 2 + ref_off + 2 + i * mmsize]
+    movu              m1, [rsp + idxq * 2 + ref_off + 4 + i * mmsize]
+    psubw             m1, m0
+    pmulhrsw          m1, m7
+    paddw             m0, m1
+%if %3
+    movu [outq + i * mmsize], m0
+%else
+    STORE_PIXELS      [outq + i * npix * PS], 0, npix
+%endif
+%assign i i + 1
+%endrep
+    add             outq, %2
+    add             posd, angled
+    dec             cntd
+    jg %%loop
+%endmacro
+
+; xm0 (and xm1 for 16x16) = av_clip_pixel(main[0] + ((side[y] - side[-1]) >> 1))
+; as words, used by the pure vertical and horizontal modes on luma
+%macro ANGULAR_EDGE 3 ; size, main, side
+    movzx           moded, pixel [%3 - PS]
+    movd              xm2, moded
+    SPLATW            xm2, xm2
+    movzx           moded, pixel [%2]
+    movd              xm3, moded
+    SPLATW            xm3, xm3
+    LOAD_PIXELS       xm0, [%3]
+    psubw             xm0, xm2
+    psraw             xm0, 1
+    paddw             xm0, xm3
+%if %1 == 16
+    LOAD_PIXELS       xm1, [%3 + 8 * PS]
+    psubw             xm1, xm2
+    psraw             xm1, 1
+    paddw             xm1, xm3
+%endif
+%if PS == 1
+%if %1 == 16
+    packuswb          xm0, xm1
+%else
+    packuswb          xm0, xm0
+%endif
+%else
+    pxor              xm2, xm2
+    pmaxsw            xm0, xm2
+    pminsw            xm0, [pw_1023]
+%if %1 == 16
+    pmaxsw            xm1, xm2
+    pminsw            xm1, [pw_1023]
+%endif
+%endif
+%endmacro
+
+; transpose the size x size words at rsp + tmp_off into src
+%macro ANGULAR_TRANSPOSE 1 ; size
+%if %1 == 4
+    movq              m0, [rsp + tmp_off + 0 * 64]
+    movq              m1, [rsp + tmp_off + 1 * 64]
+    movq              m2, [rsp + tmp_off + 2 * 64]
+    movq              m3, [rsp + tmp_off + 3 * 64]
+    punpcklwd         m0, m1
+    punpcklwd         m2, m3
+    mova              m1, m0
+    punpckldq         m0, m2
+    punpckhdq         m1, m2
+    lea             posq, [dstq + strideq * 2]
+%if PS == 1
+    packuswb          m0, m1
+    movd          [dstq], m0
+    pextrd [dstq + strideq], m0, 1
+    pextrd        [posq], m0, 2
+    pextrd [posq + strideq], m0, 3
+%else
+    movq          [dstq], m0
+    movhps [dstq + strideq], m0
+    movq          [posq], m1
+    movhps [posq + strideq], m1
+%endif
+%else
+    mov             outq, dstq
+%assign tj 0
+%rep %1 / (mmsize / 2)
+%assign ti 0
+%rep %1 / 8
+%assign k 0
+%rep 8
+    movu         m %+ k, [rsp + tmp_off + (ti * 8 + k) * 64 + tj * mmsize]
+%assign k k + 1
+%endrep
+    TRANSPOSE8x8W      0, 1, 2, 3, 4, 5, 6, 7, 8
+    lea             posq, [outq + ti * 8 * PS]
+%if mmsize == 32
+    lea             cntq, [posq + strideq * 8]
+%endif
+%assign k 0
+%rep 4
+%assign a 2 * k
+%assign b 2 * k + 1
+%if PS == 1
+    packuswb     m %+ a, m %+ b
+    movq          [posq], xm %+ a
+    movhps [posq + strideq], xm %+ a
+%if mmsize == 32
+    vextracti128      xm8, m %+ a, 1
+    movq          [cntq], xm8
+    movhps [cntq + strideq], xm8
+%endif
+%else
+    movu          [posq], xm %+ a
+    movu [posq + strideq], xm %+ b
+%if mmsize == 32
+    vextracti128  [cntq], m %+ a, 1
+    vextracti128 [cntq + strideq], m %+ b, 1
+%endif
+%endif
+%if k < 3
+    lea             posq, [posq + strideq * 2]
+%if mmsize == 32
+    lea             cntq, [cntq + strideq * 2]
+%endif
+%endif
+%assign k k + 1
+%endrep
+%assign ti ti + 1
+%endrep
+%if tj + 1 < %1 / (mmsize / 2)
+    lea             outq, [outq + strideq * 8]
+%if mmsize == 32
+    lea             outq, [outq + strideq * 8]
+%endif
+%endif
+%assign tj tj + 1
+%endrep
+%endif
+%endmacro
+
+%macro PRED_ANGULAR 3 ; size, log2 size, bit depth
+PIXEL_DEFS %3
+CHUNK_DEFS %1
+cglobal hevc_pred_angular_%1_%3, 6, 11, 16, tmp_off + %1 * 64, dst, top, left, stride, cidx, mode, angle, pos, cnt, idx, out
+%if PS == 2
+    add          strideq, strideq                   ; stride is in pixels
+%endif
+    movsxdifnidn    modeq, moded
+    lea              idxq, [intra_pred_angle]
+    movsxd         angleq, dword [idxq + modeq * 4 - 2 * 4]
+    cmp             moded, 18
+    jl .horizontal
+
+    ANGULAR_REF       %1, topq, leftq
+    mov              outq, dstq
+    ANGULAR_LINES     %1, strideq, 0
+%if %1 < 32
+    test            cidxd, cidxd
+    jnz .end
+    test           angled, angled
+    jnz .end
+    ANGULAR_EDGE      %1, topq, leftq
+    mov              outq, dstq
+%assign y 0
+%rep %1
+%if PS == 1
+    pextrb          [outq], xm0, y
+%elif y < 8
+    pextrw          [outq], xm0, y
+%else
+    pextrw          [outq], xm1, y - 8
+%endif
+%if y + 1 < %1
+    add              outq, strideq
+%endif
+%assign y y + 1
+%endrep
+.end:
+%endif
+    RET
+
+.horizontal:
+    ANGULAR_REF       %1, leftq, topq
+    lea              outq, [rsp + tmp_off]
+    ANGULAR_LINES     %1, 64, 1
+    ANGULAR_TRANSPOSE %1
+%if %1 < 32
+    test            cidxd, cidxd
+    jnz .end_h
+    test           angled, angled
+    jnz .end_h
+    ANGULAR_EDGE      %1, leftq, topq
+%if %1 * PS == 4
+    movd           [dstq], xm0
+%elif %1 * PS == 8
+    movq           [dstq], xm0
+%else
+    movu           [dstq], xm0
+%if %1 * PS == 32
+    movu      [dstq + 16], xm1
+%endif
+%endif
+.end_h:
+%endif
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse4
+PRED_PLANAR   4, 2, 8
+PRED_PLANAR   8, 3, 8
+PRED_PLANAR  16, 4, 8
+PRED_PLANAR  32, 5, 8
+PRED_PLANAR   4, 2, 10
+PRED_PLANAR   8, 3, 10
+PRED_PLANAR  16, 4, 10
+PRED_PLANAR  32, 5, 10
+
+PRED_DC       4, 2, 8
+PRED_DC       8, 3, 8
+PRED_DC      16, 4, 8
+PRED_DC      32, 5, 8
+PRED_DC       4, 2, 10
+PRED_DC       8, 3, 10
+PRED_DC      16, 4, 10
+PRED_DC      32, 5, 10
+
+PRED_ANGULAR  4, 2, 8
+PRED_ANGULAR  8, 3, 8
+PRED_ANGULAR 16, 4, 8
+PRED_ANGULAR 32, 5, 8
+PRED_ANGULAR  4, 2, 10
+PRED_ANGULAR  8, 3, 10
+PRED_ANGULAR 16, 4, 10
+PRED_ANGULAR 32, 5, 10
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+PRED_PLANAR  16, 4, 8
+PRED_PLANAR  32, 5, 8
+PRED_PLANAR  16, 4, 10
+PRED_PLANAR  32, 5, 10
+
+PRED_DC      16, 4, 8
+PRED_DC      32, 5, 8
+PRED_DC      16, 4, 10
+PRED_DC      32, 5, 10
+
+PRED_ANGULAR 16, 4, 8
+PRED_ANGULAR 32, 5, 8
+PRED_ANGULAR 16, 4, 10
+PRED_ANGULAR 32, 5, 10
+%endif
+%endif
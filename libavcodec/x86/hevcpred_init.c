@@ -0,0 +1,134 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/hevcpred.h"
+
+#define PRED_PLANAR(SIZE, DEPTH, OPT) \
+void ff_hevc_pred_planar_ ## SIZE ## _ ## DEPTH ## _ ## OPT(uint8_t *src, const uint8_t *top, \
+                                                            const uint8_t *left, ptrdiff_t stride);
+
+#define PRED_DC(SIZE, DEPTH, OPT) \
+void ff_hevc_pred_dc_ ## SIZE ## _ ## DEPTH ## _ ## OPT(uint8_t *src, const uint8_t *top, \
+                                                        const uint8_t *left, ptrdiff_t stride, \
+                                                        int c_idx);
+
+#define PRED_ANGULAR(SIZE, DEPTH, OPT) \
+void ff_hevc_pred_angular_ ## SIZE ## _ ## DEPTH ## _ ## OPT(uint8_t *src, const uint8_t *top, \
+                                                             const uint8_t *left, ptrdiff_t stride, \
+                                                             int c_idx, int mode);
+
+#define PRED_FUNCS(SIZE, DEPTH, OPT) \
+    PRED_PLANAR(SIZE, DEPTH, OPT)    \
+    PRED_DC(SIZE, DEPTH, OPT)        \
+    PRED_ANGULAR(SIZE, DEPTH, OPT)
+
+PRED_FUNCS( 4,  8, sse4)
+PRED_FUNCS( 8,  8, sse4)
+PRED_FUNCS(16,  8, sse4)
+PRED_FUNCS(32,  8, sse4)
+PRED_FUNCS( 4, 10, sse4)
+PRED_FUNCS( 8, 10, sse4)
+PRED_FUNCS(16, 10, sse4)
+PRED_FUNCS(32, 10, sse4)
+PRED_FUNCS(16,  8, avx2)
+PRED_FUNCS(32,  8, avx2)
+PRED_FUNCS(16, 10, avx2)
+PRED_FUNCS(32, 10, avx2)
+
+/* pred_dc takes the block size as an argument, the asm has one function
+ * per size */
+#define PRED_DC_DISPATCH(DEPTH, OPT, OPT16)                                     \
+static void pred_dc_ ## DEPTH ## _ ## OPT16(uint8_t *src, const uint8_t *top,   \
+                                            const uint8_t *left,                \
+                                            ptrdiff_t stride, int log2_size,    \
+                                            int c_idx)                          \
+{                                                                               \
+    switch (log2_size) {                                                        \
+    case 2:                                                                     \
+        ff_hevc_pred_dc_4_ ## DEPTH ## _ ## OPT(src, top, left, stride, c_idx); \
+        break;                                                                  \
+    case 3:                                                                     \
+        ff_hevc_pred_dc_8_ ## DEPTH ## _ ## OPT(src, top, left, stride, c_idx); \
+        break;                                                                  \
+    case 4:                                                                     \
+        ff_hevc_pred_dc_16_ ## DEPTH ## _ ## OPT16(src, top, left, stride, c_idx); \
+        break;                                                                  \
+    default:                                                                    \
+        ff_hevc_pred_dc_32_ ## DEPTH ## _ ## OPT16(src, top, left, stride, c_idx); \
+        break;                                                                  \
+    }                                                                           \
+}
+
+#if ARCH_X86_64 && HAVE_SSE4_EXTERNAL
+PRED_DC_DISPATCH( 8, sse4, sse4)
+PRED_DC_DISPATCH(10, sse4, sse4)
+#if HAVE_AVX2_EXTERNAL
+PRED_DC_DISPATCH( 8, sse4, avx2)
+PRED_DC_DISPATCH(10, sse4, avx2)
+#endif
+#endif
+
+#define SET_PRED_FUNCS(DEPTH, OPT)                                            \
+    hpc->pred_planar[0]  = ff_hevc_pred_planar_4_  ## DEPTH ## _ ## OPT;      \
+    hpc->pred_planar[1]  = ff_hevc_pred_planar_8_  ## DEPTH ## _ ## OPT;      \
+    hpc->pred_planar[2]  = ff_hevc_pred_planar_16_ ## DEPTH ## _ ## OPT;      \
+    hpc->pred_planar[3]  = ff_hevc_pred_planar_32_ ## DEPTH ## _ ## OPT;      \
+    hpc->pred_dc         = pred_dc_ ## DEPTH ## _ ## OPT;                     \
+    hpc->pred_angular[0] = ff_hevc_pred_angular_4_  ## DEPTH ## _ ## OPT;     \
+    hpc->pred_angular[1] = ff_hevc_pred_angular_8_  ## DEPTH ## _ ## OPT;     \
+    hpc->pred_angular[2] = ff_hevc_pred_angular_16_ ## DEPTH ## _ ## OPT;     \
+    hpc->pred_angular[3] = ff_hevc_pred_angular_32_ ## DEPTH ## _ ## OPT
+
+#define SET_PRED_FUNCS_16(DEPTH, OPT)                                         \
+    hpc->pred_planar[2]  = ff_hevc_pred_planar_16_ ## DEPTH ## _ ## OPT;      \
+    hpc->pred_planar[3]  = ff_hevc_pred_planar_32_ ## DEPTH ## _ ## OPT;      \
+    hpc->pred_dc         = pred_dc_ ## DEPTH ## _ ## OPT;                     \
+    hpc->pred_angular[2] = ff_hevc_pred_angular_16_ ## DEPTH ## _ ## OPT;     \
+    hpc->pred_angular[3] = ff_hevc_pred_angular_32_ ## DEPTH ## _ ## OPT
+
+av_cold void ff_hevc_pred_init_x86(HEVCPredContext *hpc, int bit_depth)
+{
+#if ARCH_X86_64 && HAVE_SSE4_EXTERNAL
+    int cpu_flags = av_get_cpu_flags();
+
+    if (bit_depth == 8) {
+        if (EXTERNAL_SSE4(cpu_flags)) {
+            SET_PRED_FUNCS(8, sse4);
+        }
+#if HAVE_AVX2_EXTERNAL
+        if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+            SET_PRED_FUNCS_16(8, avx2);
+        }
+#endif
+    } else if (bit_depth == 10) {
+        if (EXTERNAL_SSE4(cpu_flags)) {
+            SET_PRED_FUNCS(10, sse4);
+        }
+#if HAVE_AVX2_EXTERNAL
+        if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+            SET_PRED_FUNCS_16(10, avx2);
+        }
+#endif
+    }
+#endif /* ARCH_X86_64 && HAVE_SSE4_EXTERNAL */
+}
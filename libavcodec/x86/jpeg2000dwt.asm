@@ -0,0 +1,137 @@
+;******************************************************************************
+;* SIMD-optimized JPEG 2000 forward DWT lifting steps
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_2:     times 8 dd 2
+pq_round: times 4 dq 0x8000
+
+SECTION .text
+
+; rounds n up to a multiple of the vector size and points the arguments
+; past the end of the rows
+%macro LIFT_PROLOGUE 0
+    movsxdifnidn nq, nd
+    add          nq, mmsize/4 - 1
+    and          nq, -mmsize/4
+    shl          nq, 2
+    add        dstq, nq
+    add       src0q, nq
+    add       src1q, nq
+    neg          nq
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_dwt_lift53_odd_<opt>(int32_t *dst, const int32_t *src0,
+;                              const int32_t *src1, int n)
+; dst[i] -= (src0[i] + src1[i]) >> 1
+;-----------------------------------------------------------------------------
+%macro LIFT53_ODD 0
+cglobal dwt_lift53_odd, 4, 4, 2, dst, src0, src1, n
+    LIFT_PROLOGUE
+.loop:
+    mova         m0, [src0q+nq]
+    mova         m1, [dstq+nq]
+    paddd        m0, [src1q+nq]
+    psrad        m0, 1
+    psubd        m1, m0
+    mova  [dstq+nq], m1
+    add          nq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_dwt_lift53_even_<opt>(int32_t *dst, const int32_t *src0,
+;                               const int32_t *src1, int n)
+; dst[i] += (src0[i] + src1[i] + 2) >> 2
+;-----------------------------------------------------------------------------
+%macro LIFT53_EVEN 0
+cglobal dwt_lift53_even, 4, 4, 3, dst, src0, src1, n
+    LIFT_PROLOGUE
+    mova         m2, [pd_2]
+.loop:
+    mova         m0, [src0q+nq]
+    paddd        m0, [src1q+nq]
+    paddd        m0, m2
+    psrad        m0, 2
+    paddd        m0, [dstq+nq]
+    mova  [dstq+nq], m0
+    add          nq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_dwt_lift97_int_<sub|add>_<opt>(int32_t *dst, const int32_t *src0,
+;                                        const int32_t *src1, int n, int coef)
+; dst[i] -/+= (coef * (int64_t)(src0[i] + src1[i]) + (1 << 15)) >> 16
+;
+; The products are computed for the even and odd dwords separately. The
+; rounded result fits in 32 bits, so it is the low dword of the product
+; shifted right by 16 and the high dword of the product shifted left by 16.
+;-----------------------------------------------------------------------------
+%macro LIFT97_INT 2 ; name, psubd/paddd
+cglobal dwt_lift97_int_%1, 5, 5, 6, dst, src0, src1, n, coef
+%if cpuflag(avx2)
+    movd        xm4, coefd
+    vpbroadcastd m4, xm4
+%else
+    movd         m4, coefd
+    pshufd       m4, m4, 0
+%endif
+    mova         m5, [pq_round]
+    LIFT_PROLOGUE
+.loop:
+    mova         m0, [src0q+nq]
+    paddd        m0, [src1q+nq]
+    psrlq        m1, m0, 32
+    pmuldq       m0, m4
+    pmuldq       m1, m4
+    paddq        m0, m5
+    paddq        m1, m5
+    psrlq        m0, 16
+    psllq        m1, 16
+    pblendw      m0, m1, 0xcc
+    mova         m1, [dstq+nq]
+    %2           m1, m0
+    mova  [dstq+nq], m1
+    add          nq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+LIFT53_ODD
+LIFT53_EVEN
+
+INIT_XMM sse4
+LIFT97_INT sub, psubd
+LIFT97_INT add, paddd
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+LIFT53_ODD
+LIFT53_EVEN
+LIFT97_INT sub, psubd
+LIFT97_INT add, paddd
+%endif
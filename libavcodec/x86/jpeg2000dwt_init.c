@@ -0,0 +1,63 @@
+/*
+ * SIMD optimized JPEG 2000 forward DWT lifting steps
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/jpeg2000dwt.h"
+
+#define LIFT_FUNCS(opt)                                                        \
+void ff_dwt_lift53_odd_ ## opt(int32_t *dst, const int32_t *src0,              \
+                               const int32_t *src1, int n);                    \
+void ff_dwt_lift53_even_ ## opt(int32_t *dst, const int32_t *src0,             \
+                                const int32_t *src1, int n);
+
+#define LIFT97_FUNCS(opt)                                                      \
+void ff_dwt_lift97_int_sub_ ## opt(int32_t *dst, const int32_t *src0,          \
+                                   const int32_t *src1, int n, int coef);      \
+void ff_dwt_lift97_int_add_ ## opt(int32_t *dst, const int32_t *src0,          \
+                                   const int32_t *src1, int n, int coef);
+
+LIFT_FUNCS(sse2)
+LIFT_FUNCS(avx2)
+LIFT97_FUNCS(sse4)
+LIFT97_FUNCS(avx2)
+
+av_cold void ff_jpeg2000dwt_init_x86(DWTContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        s->lift53_odd     = ff_dwt_lift53_odd_sse2;
+        s->lift53_even    = ff_dwt_lift53_even_sse2;
+    }
+
+    if (EXTERNAL_SSE4(cpu_flags)) {
+        s->lift97_int_sub = ff_dwt_lift97_int_sub_sse4;
+        s->lift97_int_add = ff_dwt_lift97_int_add_sse4;
+    }
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        s->lift53_odd     = ff_dwt_lift53_odd_avx2;
+        s->lift53_even    = ff_dwt_lift53_even_avx2;
+        s->lift97_int_sub = ff_dwt_lift97_int_sub_avx2;
+        s->lift97_int_add = ff_dwt_lift97_int_add_avx2;
+    }
+}
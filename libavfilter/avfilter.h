@@ -917,6 +917,15 @@ typedef struct AVFilterGraph {
     int sink_links_count;
 
     unsigned disable_auto_convert;
+
+    /**
+     * Priority of the slice threading jobs of this graph when they run on the
+     * process-wide thread pool (see av_thread_pool_set_size()). Jobs of graphs
+     * and codecs with a higher priority are run first.
+     *
+     * May be set by the caller before adding any filters to the graph.
+     */
+    int thread_priority;
 } AVFilterGraph;
 
 /**
@@ -73,11 +73,13 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
     return 0;
 }
 
-static int thread_init_internal(ThreadContext *c, int nb_threads)
+static int thread_init_internal(ThreadContext *c, int nb_threads, int priority)
 {
     nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
     if (nb_threads <= 1)
         avpriv_slicethread_free(&c->thread);
+    else
+        avpriv_slicethread_set_priority(c->thread, priority);
     return FFMAX(nb_threads, 1);
 }
 
@@ -94,7 +96,8 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     if (!graph->internal->thread)
         return AVERROR(ENOMEM);
 
-    ret = thread_init_internal(graph->internal->thread, graph->nb_threads);
+    ret = thread_init_internal(graph->internal->thread, graph->nb_threads,
+                               graph->thread_priority);
     if (ret <= 1) {
         av_freep(&graph->internal->thread);
         graph->thread_type = 0;
@@ -35,6 +35,7 @@
 
 #define MAX_NB_THREADS 32
 #define NB_PLANES 4
+#define BLOCK_SIZE 128
 
 enum InterpolationMethods {
     INTERP_NEAREST,
@@ -367,6 +368,21 @@ typedef struct ThreadData {
     int linesize;
 } ThreadData;
 
+/* Evaluate w samples of a line at once, or one after the other when
+ * av_expr_eval_array() fails (it may run out of memory for its scratch). */
+static void eval_block(AVExpr *e, double *res, int w, double *values,
+                       const double *xs, void *opaque)
+{
+    const double *arrays[VAR_VARS_NB] = { [VAR_X] = xs };
+
+    if (av_expr_eval_array(e, res, w, values, arrays, opaque) >= 0)
+        return;
+    for (int i = 0; i < w; i++) {
+        values[VAR_X] = xs[i];
+        res[i] = av_expr_eval(e, values, opaque);
+    }
+}
+
 static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     GEQContext *geq = ctx->priv;
@@ -379,7 +395,9 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     const int slice_end = (height * (jobnr+1)) / nb_jobs;
     int x, y;
 
+    double xs[BLOCK_SIZE], res[BLOCK_SIZE];
     double values[VAR_VARS_NB];
+    values[VAR_X] = 0;
     values[VAR_W] = geq->values[VAR_W];
     values[VAR_H] = geq->values[VAR_H];
     values[VAR_N] = geq->values[VAR_N];
@@ -392,9 +410,13 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
         for (y = slice_start; y < slice_end; y++) {
             values[VAR_Y] = y;
 
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
+            for (x = 0; x < width; x += BLOCK_SIZE) {
+                const int w = FFMIN(width - x, BLOCK_SIZE);
+                for (int i = 0; i < w; i++)
+                    xs[i] = x + i;
+                eval_block(geq->e[plane][jobnr], res, w, values, xs, geq);
+                for (int i = 0; i < w; i++)
+                    ptr[x + i] = res[i];
             }
             ptr += linesize;
         }
@@ -402,9 +424,13 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
         uint16_t *ptr16 = geq->dst16 + (linesize/2) * slice_start;
         for (y = slice_start; y < slice_end; y++) {
             values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr16[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
+            for (x = 0; x < width; x += BLOCK_SIZE) {
+                const int w = FFMIN(width - x, BLOCK_SIZE);
+                for (int i = 0; i < w; i++)
+                    xs[i] = x + i;
+                eval_block(geq->e[plane][jobnr], res, w, values, xs, geq);
+                for (int i = 0; i < w; i++)
+                    ptr16[x + i] = res[i];
             }
             ptr16 += linesize/2;
         }
@@ -40,6 +40,15 @@ typedef struct UnsandContext {
     const AVClass *class;
 } UnsandContext;
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    unsigned int w, h;          // Cropped size
+    unsigned int stripe_w;      // Stripe width in luma pels
+    unsigned int stripe0;       // First stripe touched by the crop
+    unsigned int stripes;       // Number of stripes touched by the crop
+    int cols, rows;             // Jobs = cols x rows
+} ThreadData;
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
 //    UnsandContext *s = ctx->priv;
@@ -53,6 +62,78 @@ static av_cold int init(AVFilterContext *ctx)
 }
 
 
+// Left edge of job column col in cropped luma pels
+// Column edges fall on stripe boundaries, rounded down to even for 4:2:0
+// chroma when crop_left is odd, so jobs only share a stripe with an odd crop
+static unsigned int col_x(const ThreadData * const td, const int col)
+{
+    const unsigned int stripe = td->stripe0 + td->stripes * col / td->cols;
+    const unsigned int crop_left = td->in->crop_left;
+    const unsigned int x = stripe * td->stripe_w;
+
+    return x <= crop_left ? 0 : FFMIN((x - crop_left) & ~1U, td->w);
+}
+
+// Top edge of job row row - kept even for 4:2:0 chroma
+static unsigned int row_y(const ThreadData * const td, const int row)
+{
+    return row == td->rows ? td->h : (td->h * row / td->rows) & ~1;
+}
+
+static int unsand_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    const ThreadData * const td = arg;
+    const int col = jobnr % td->cols;
+    const int row = jobnr / td->cols;
+    const unsigned int x0 = col_x(td, col);
+    const unsigned int x1 = col_x(td, col + 1);
+    const unsigned int y0 = row_y(td, row);
+    const unsigned int y1 = row_y(td, row + 1);
+
+    if (x1 <= x0 || y1 <= y0)
+        return 0;
+
+    return av_rpi_sand_to_planar_frame_rect(td->out, td->in, x0, y0, x1 - x0, y1 - y0);
+}
+
+static int unsand_frame(AVFilterContext *ctx, AVFrame * const out, AVFrame * const in)
+{
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    ThreadData td = {
+        .in       = in,
+        .out      = out,
+        .w        = av_frame_cropped_width(in),
+        .h        = av_frame_cropped_height(in),
+        .stripe_w = av_rpi_sand_frame_stripe_width(in),
+    };
+    int rv;
+
+    td.stripe0 = in->crop_left / td.stripe_w;
+    td.stripes = (in->crop_left + td.w + td.stripe_w - 1) / td.stripe_w - td.stripe0;
+
+    // Split by stripe columns first as each stripe is contiguous in memory
+    // then by row bands if there are more threads than columns
+    td.cols = FFMAX(1, FFMIN(nb_threads, td.stripes));
+    td.rows = FFMAX(1, FFMIN((nb_threads + td.cols - 1) / td.cols, td.h / 16));
+
+    // Check that we can do this conversion before farming out jobs as
+    // errors from the jobs themselves are lost
+    if (av_rpi_sand_to_planar_frame_rect(out, in, 0, 0, 0, 0) != 0)
+        return AVERROR(EINVAL);
+
+    ctx->internal->execute(ctx, unsand_slice, &td, NULL, td.cols * td.rows);
+
+    if ((rv = av_frame_copy_props(out, in)) < 0)
+        return rv;
+
+    // We have cropped as part of the conversion
+    out->crop_top = 0;
+    out->crop_left = 0;
+    out->crop_bottom = 0;
+    out->crop_right = 0;
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     AVFilterLink * const outlink = link->dst->outputs[0];
@@ -70,11 +151,8 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
             rv = AVERROR(ENOMEM);
             goto fail;
         }
-        if (av_rpi_sand_to_planar_frame(out, in) != 0)
-        {
-            rv = -1;
+        if ((rv = unsand_frame(link->dst, out, in)) != 0)
             goto fail;
-        }
 
         av_frame_free(&in);
     }
@@ -225,5 +303,6 @@ AVFilter ff_vf_unsand = {
 
     .inputs        = avfilter_vf_unsand_inputs,
     .outputs       = avfilter_vf_unsand_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 
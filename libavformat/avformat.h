@@ -1393,6 +1393,12 @@ typedef struct AVFormatContext {
 #define AVFMT_FLAG_FAST_SEEK   0x80000 ///< Enable fast, but inaccurate seeks for some formats
 #define AVFMT_FLAG_SHORTEST   0x100000 ///< Stop muxing when the shortest stream stops.
 #define AVFMT_FLAG_AUTO_BSF   0x200000 ///< Add bitstream filters as requested by the muxer
+/**
+ * Allow the demuxer to return packets whose padding is not zeroed, e.g.
+ * referencing a memory mapped file in place. Only set this when the packets
+ * are never decoded, like when they are only stream copied.
+ */
+#define AVFMT_FLAG_UNPADDED   0x400000
 
     /**
      * Maximum size of the data read from input for determining
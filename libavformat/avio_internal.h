@@ -151,6 +151,19 @@ int ffio_fdopen(AVIOContext **s, URLContext *h);
  */
 URLContext *ffio_geturlcontext(AVIOContext *s);
 
+/**
+ * Read size bytes from AVIOContext without copying them, by referencing
+ * the memory mapping of the underlying URL (see ffurl_get_mapping()).
+ * On failure nothing is read and the caller is expected to fall back to
+ * avio_read().
+ *
+ * @param buf set to a read-only reference to the data, followed by
+ *            AV_INPUT_BUFFER_PADDING_SIZE readable bytes
+ * @return size on success, AVERROR(ENOSYS) if the data cannot be
+ *         referenced, another AVERROR on failure
+ */
+int ffio_read_mapped(AVIOContext *s, int size, AVBufferRef **buf);
+
 /**
  * Open a write-only fake memory stream. The written data is not stored
  * anywhere - this is only used for measuring the amount of data
@@ -987,6 +987,37 @@ URLContext* ffio_geturlcontext(AVIOContext *s)
         return NULL;
 }
 
+int ffio_read_mapped(AVIOContext *s, int size, AVBufferRef **buf)
+{
+    URLContext *h = ffio_geturlcontext(s);
+    int64_t pos;
+    int ret, left;
+
+    if (!h || s->write_flag || s->update_checksum || size <= 0)
+        return AVERROR(ENOSYS);
+
+    pos = avio_tell(s);
+    if ((ret = ffurl_get_mapping(h, pos, size, buf)) < 0)
+        return ret;
+
+    left = s->buf_end - s->buf_ptr;
+    if (size <= left) {
+        s->buf_ptr += size;
+    } else {
+        /* Move past the buffered data without reading the rest */
+        int64_t res = s->seek(s->opaque, pos + size, SEEK_SET);
+        if (res < 0) {
+            av_buffer_unref(buf);
+            return res;
+        }
+        s->buf_end = s->buf_ptr = s->buf_ptr_max = s->buffer;
+        s->pos = pos + size;
+        s->eof_reached = 0;
+        s->bytes_read += size - left;
+    }
+    return size;
+}
+
 static void update_checksum(AVIOContext *s)
 {
     if (s->update_checksum && s->buf_ptr > s->checksum_ptr) {
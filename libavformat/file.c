@@ -35,7 +35,11 @@
 #endif
 #include <sys/stat.h>
 #include <stdlib.h>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include "os_support.h"
+#include "readahead.h"
 #include "url.h"
 
 /* Some systems may not have S_ISFIFO */
@@ -74,6 +78,14 @@ typedef struct FileContext {
     int blocksize;
     int follow;
     int seekable;
+    int readahead;
+    int readahead_size;
+    int readahead_io_uring;
+    FFReadahead *ra;
+    int64_t pos;            ///< read position when reading ahead
+    int use_mmap;
+    AVBufferRef *map;       ///< read-only mapping of the whole file
+    int64_t map_size;
 #if HAVE_DIRENT_H
     DIR *dir;
 #endif
@@ -84,6 +96,10 @@ static const AVOption file_options[] = {
     { "blocksize", "set I/O operation maximum block size", offsetof(FileContext, blocksize), AV_OPT_TYPE_INT, { .i64 = INT_MAX }, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "seekable", "Sets if the file is seekable", offsetof(FileContext, seekable), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 0, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "readahead", "number of blocks to read ahead asynchronously", offsetof(FileContext, readahead), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1024, AV_OPT_FLAG_DECODING_PARAM },
+    { "readahead_size", "size of the readahead blocks", offsetof(FileContext, readahead_size), AV_OPT_TYPE_INT, { .i64 = 262144 }, 4096, 1 << 26, AV_OPT_FLAG_DECODING_PARAM },
+    { "readahead_io_uring", "use io_uring to read ahead when available", offsetof(FileContext, readahead_io_uring), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
+    { "mmap", "map the file to let demuxers reference its data without copying", offsetof(FileContext, use_mmap), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -111,6 +127,12 @@ static int file_read(URLContext *h, unsigned char *buf, int size)
     FileContext *c = h->priv_data;
     int ret;
     size = FFMIN(size, c->blocksize);
+    if (c->ra) {
+        ret = ff_readahead_read(c->ra, c->pos, buf, size);
+        if (ret > 0)
+            c->pos += ret;
+        return ret;
+    }
     ret = read(c->fd, buf, size);
     if (ret == 0 && c->follow)
         return AVERROR(EAGAIN);
@@ -205,6 +227,50 @@ static int file_move(URLContext *h_src, URLContext *h_dst)
 
 #if CONFIG_FILE_PROTOCOL
 
+#if HAVE_MMAP
+static void file_unmap(void *opaque, uint8_t *data)
+{
+    munmap(data, (size_t)(intptr_t)opaque);
+}
+
+static int file_map(URLContext *h, int64_t size)
+{
+    FileContext *c = h->priv_data;
+    void *ptr;
+
+    if (size > SIZE_MAX || size > INTPTR_MAX)
+        return AVERROR(ENOSYS);
+    ptr = mmap(NULL, size, PROT_READ, MAP_SHARED, c->fd, 0);
+    if (ptr == MAP_FAILED)
+        return AVERROR(errno);
+    /* The buffer size is only informative, the mapping may exceed INT_MAX */
+    c->map = av_buffer_create(ptr, FFMIN(size, INT_MAX), file_unmap,
+                              (void *)(intptr_t)size, AV_BUFFER_FLAG_READONLY);
+    if (!c->map) {
+        munmap(ptr, size);
+        return AVERROR(ENOMEM);
+    }
+    c->map_size = size;
+    return 0;
+}
+#endif
+
+static int file_get_mapping(URLContext *h, int64_t pos, int size,
+                            AVBufferRef **buf)
+{
+    FileContext *c = h->priv_data;
+
+    /* The padding must be within the mapping as well */
+    if (!c->map || pos < 0 || size < 0 ||
+        pos > c->map_size - AV_INPUT_BUFFER_PADDING_SIZE - size)
+        return AVERROR(ENOSYS);
+    if (!(*buf = av_buffer_ref(c->map)))
+        return AVERROR(ENOMEM);
+    (*buf)->data = c->map->data + pos;
+    (*buf)->size = size;
+    return 0;
+}
+
 static int file_open(URLContext *h, const char *filename, int flags)
 {
     FileContext *c = h->priv_data;
@@ -243,6 +309,28 @@ static int file_open(URLContext *h, const char *filename, int flags)
     if (c->seekable >= 0)
         h->is_streamed = !c->seekable;
 
+    if (c->readahead && !(flags & AVIO_FLAG_WRITE) && !c->follow &&
+        !fstat(fd, &st) && S_ISREG(st.st_mode)) {
+        int ret = ff_readahead_open(&c->ra, h, fd, c->readahead,
+                                    FFALIGN(c->readahead_size, 4096),
+                                    c->readahead_io_uring);
+        if (ret == AVERROR(ENOSYS)) {
+            av_log(h, AV_LOG_WARNING, "Readahead is not supported on this system\n");
+        } else if (ret < 0) {
+            close(fd);
+            return ret;
+        }
+    }
+
+#if HAVE_MMAP
+    if (c->use_mmap && !(flags & AVIO_FLAG_WRITE) && !c->follow &&
+        !fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+        int ret = file_map(h, st.st_size);
+        if (ret < 0)
+            av_log(h, AV_LOG_WARNING, "Cannot map the file: %s\n", av_err2str(ret));
+    }
+#endif
+
     return 0;
 }
 
@@ -258,6 +346,22 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
         return ret < 0 ? AVERROR(errno) : (S_ISFIFO(st.st_mode) ? 0 : st.st_size);
     }
 
+    if (c->ra) {
+        if (whence == SEEK_CUR) {
+            pos += c->pos;
+        } else if (whence == SEEK_END) {
+            struct stat st;
+            if (fstat(c->fd, &st) < 0)
+                return AVERROR(errno);
+            pos += st.st_size;
+        } else if (whence != SEEK_SET) {
+            return AVERROR(EINVAL);
+        }
+        if (pos < 0)
+            return AVERROR(EINVAL);
+        return c->pos = pos;
+    }
+
     ret = lseek(c->fd, pos, whence);
 
     return ret < 0 ? AVERROR(errno) : ret;
@@ -266,6 +370,9 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
+    ff_readahead_close(&c->ra);
+    /* Packets referencing the mapping keep it alive */
+    av_buffer_unref(&c->map);
     return close(c->fd);
 }
 
@@ -361,6 +468,7 @@ const URLProtocol ff_file_protocol = {
     .url_seek            = file_seek,
     .url_close           = file_close,
     .url_get_file_handle = file_get_handle,
+    .url_get_mapping     = file_get_mapping,
     .url_check           = file_check,
     .url_delete          = file_delete,
     .url_move            = file_move,
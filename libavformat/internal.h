@@ -76,6 +76,17 @@ struct AVFormatInternal {
     struct PacketList *packet_buffer;
     struct PacketList *packet_buffer_end;
 
+    /**
+     * Binary min-heap of the indices of the streams with queued packets,
+     * ordered by the dts of the first packet in each stream's queue.
+     * Used by ff_interleave_packet_per_dts() instead of packet_buffer
+     * when no custom interleaving order is required.
+     * Muxing only.
+     */
+    int *interleave_heap;
+    int nb_interleave_heap;
+    unsigned int interleave_heap_size;
+
     /* av_seek_frame() support */
     int64_t data_offset; /**< offset of the first packet */
 
@@ -346,7 +357,14 @@ struct AVStreamInternal {
     AVProbeData probe_data;
 
     /**
-     * last packet in packet_buffer for this stream when muxing.
+     * first packet in the per-stream interleaving queue when muxing;
+     * only used together with AVFormatInternal.interleave_heap.
+     */
+    struct PacketList *first_in_packet_buffer;
+
+    /**
+     * last packet in packet_buffer (or in the per-stream interleaving
+     * queue) for this stream when muxing.
      */
     struct PacketList *last_in_packet_buffer;
 };
@@ -645,6 +663,15 @@ int ff_framehash_write_header(AVFormatContext *s);
  */
 int ff_read_packet(AVFormatContext *s, AVPacket *pkt);
 
+/**
+ * Same as av_get_packet(), but reference the data in place when the
+ * input is memory mapped (see the mmap option of the file protocol) and
+ * the caller set AVFMT_FLAG_UNPADDED. The packet data is then read-only
+ * and its padding is not zeroed, so this is only for demuxers which do not
+ * modify the packet data.
+ */
+int ff_get_packet_mapped(AVFormatContext *s, AVIOContext *pb, AVPacket *pkt, int size);
+
 /**
  * Interleave an AVPacket per dts so it can be muxed.
  *
@@ -155,6 +155,21 @@ typedef struct MOVIndexRange {
     int64_t end;
 } MOVIndexRange;
 
+/**
+ * Position in the sample tables, used to resolve index entries on demand
+ * when the per-sample index is not built (compact_index).
+ */
+typedef struct MOVSampleCursor {
+    unsigned int sample;
+    unsigned int stts_index;
+    unsigned int stts_sample;
+    int64_t dts;
+    unsigned int stsc_index;
+    unsigned int chunk;
+    unsigned int chunk_sample;
+    int64_t pos;
+} MOVSampleCursor;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int pb_is_copied;
@@ -235,6 +250,15 @@ typedef struct MOVStreamContext {
     uint32_t format;
 
     int has_sidx;  // If there is an sidx entry for this stream.
+
+    int compact_index;        ///< samples are resolved from the sample tables, st->index_entries only holds sync samples
+    unsigned int nb_samples;  ///< number of samples when compact_index is set
+    int key_off;              ///< 1 if stss/stps sample numbers are 1-based
+    int64_t first_dts;        ///< dts of the first sample
+    MOVSampleCursor cursor;   ///< last resolved sample
+    MOVSampleCursor *cursor_checkpoints; ///< cursor at every MOV_CURSOR_CHECKPOINT_INTERVAL-th sample
+    AVIndexEntry sample_entry; ///< entry of the current sample when compact_index is set
+    int sample_entry_index;   ///< current_sample + 1 that sample_entry belongs to, 0 if none
     struct {
         struct AVAESCTR* aes_ctr;
         unsigned int per_sample_iv_size;  // Either 0, 8, or 16.
@@ -294,6 +318,7 @@ typedef struct MOVContext {
     uint8_t *decryption_key;
     int decryption_key_len;
     int enable_drefs;
+    int compact_index;
     int32_t movie_display_matrix[3][3]; ///< display matrix from mvhd
     int have_read_mfra_size;
     uint32_t mfra_size;
@@ -1041,10 +1041,28 @@ static int ebml_read_ascii(AVIOContext *pb, int size,
  * 0 is success, < 0 or NEEDS_CHECKING is failure.
  */
 static int ebml_read_binary(AVIOContext *pb, int length,
-                            int64_t pos, EbmlBin *bin)
+                            int64_t pos, EbmlBin *bin, int mapped)
 {
     int ret;
 
+    if (mapped) {
+        AVBufferRef *buf;
+
+        ret = ffio_read_mapped(pb, length, &buf);
+        if (ret >= 0) {
+            av_buffer_unref(&bin->buf);
+            bin->buf  = buf;
+            bin->data = buf->data;
+            bin->size = length;
+            bin->pos  = pos;
+            return 0;
+        } else if (ret != AVERROR(ENOSYS))
+            return ret;
+        /* Do not copy the previous block when reallocating */
+        if (bin->buf && !av_buffer_is_writable(bin->buf))
+            av_buffer_unref(&bin->buf);
+    }
+
     ret = av_buffer_realloc(&bin->buf, length + AV_INPUT_BUFFER_PADDING_SIZE);
     if (ret < 0)
         return ret;
@@ -1440,7 +1458,11 @@ static int ebml_parse(MatroskaDemuxContext *matroska,
         res = ebml_read_ascii(pb, length, syntax->def.s, data);
         break;
     case EBML_BIN:
-        res = ebml_read_binary(pb, length, pos_alt, data);
+        /* Blocks are only parsed, so their data can be referenced in place */
+        res = ebml_read_binary(pb, length, pos_alt, data,
+                               (matroska->ctx->flags & AVFMT_FLAG_UNPADDED) &&
+                               (id == MATROSKA_ID_BLOCK ||
+                                id == MATROSKA_ID_SIMPLEBLOCK));
         break;
     case EBML_LEVEL1:
     case EBML_NEST:
@@ -3390,11 +3390,454 @@ static int64_t add_ctts_entry(MOVStts** ctts_data, unsigned int* ctts_count, uns
     return *ctts_count;
 }
 
+/* Number of samples between the saved cursors of a compact index, so that
+ * resolving a sample never walks the sample tables over more samples. */
+#define MOV_CURSOR_CHECKPOINT_INTERVAL 256
+
+/**
+ * Return the position of the first entry not lower than v in the sorted
+ * sync sample table tab.
+ */
+static unsigned int mov_sync_sample_search(const unsigned *tab, unsigned int count, int64_t v)
+{
+    unsigned int lo = 0, hi = count;
+
+    while (lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        if (tab[mid] < v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static int mov_all_samples_sync(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    if (!sc->keyframe_absent)
+        return !sc->keyframe_count;
+    return !sc->stps_count && st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO;
+}
+
+/**
+ * Return the first keyframe at or after sample, or a value not lower than
+ * sc->nb_samples if there is none. Follows the rules of mov_build_index().
+ */
+static int64_t mov_next_keyframe(AVStream *st, unsigned int sample)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t key = INT64_MAX;
+    unsigned int i;
+
+    if (mov_all_samples_sync(st))
+        return sample;
+    if (sc->keyframe_absent && !sc->stps_count)
+        return sample ? INT64_MAX : 0;
+
+    if (!sc->keyframe_absent) {
+        i = mov_sync_sample_search((const unsigned *)sc->keyframes, sc->keyframe_count, (int64_t)sample + sc->key_off);
+        if (i < sc->keyframe_count)
+            key = sc->keyframes[i] - sc->key_off;
+    }
+    if (sc->stps_count) {
+        i = mov_sync_sample_search(sc->stps_data, sc->stps_count, (int64_t)sample + sc->key_off);
+        if (i < sc->stps_count)
+            key = FFMIN(key, sc->stps_data[i] - sc->key_off);
+    }
+    return key;
+}
+
+/**
+ * Return the last keyframe at or before sample, or -1 if there is none.
+ */
+static int64_t mov_prev_keyframe(AVStream *st, unsigned int sample)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t key = -1;
+    unsigned int i;
+
+    if (mov_all_samples_sync(st))
+        return sample;
+    if (sc->keyframe_absent && !sc->stps_count)
+        return 0;
+
+    if (!sc->keyframe_absent) {
+        i = mov_sync_sample_search((const unsigned *)sc->keyframes, sc->keyframe_count, (int64_t)sample + sc->key_off + 1);
+        if (i > 0)
+            key = sc->keyframes[i - 1] - sc->key_off;
+    }
+    if (sc->stps_count) {
+        i = mov_sync_sample_search(sc->stps_data, sc->stps_count, (int64_t)sample + sc->key_off + 1);
+        if (i > 0)
+            key = FFMAX(key, sc->stps_data[i - 1] - sc->key_off);
+    }
+    return key;
+}
+
+static int64_t mov_sample_sizes_sum(MOVStreamContext *sc, unsigned int sample, unsigned int count)
+{
+    int64_t size = 0;
+
+    if (sc->stsz_sample_size > 0)
+        return count * (int64_t)sc->stsz_sample_size;
+    while (count--)
+        size += sc->sample_sizes[sample++];
+    return size;
+}
+
+/**
+ * Move the cursor to the start of the first non-empty chunk at or after chunk.
+ */
+static void mov_cursor_enter_chunk(MOVStreamContext *sc, unsigned int chunk)
+{
+    MOVSampleCursor *c = &sc->cursor;
+
+    c->chunk_sample = 0;
+    for (c->chunk = chunk; c->chunk < sc->chunk_count; c->chunk++) {
+        while (mov_stsc_index_valid(c->stsc_index, sc->stsc_count) &&
+               c->chunk + 1 >= sc->stsc_data[c->stsc_index + 1].first)
+            c->stsc_index++;
+        if (sc->stsc_data[c->stsc_index].count > 0)
+            break;
+    }
+    if (c->chunk < sc->chunk_count)
+        c->pos = sc->chunk_offsets[c->chunk];
+}
+
+static void mov_cursor_reset(MOVStreamContext *sc)
+{
+    memset(&sc->cursor, 0, sizeof(sc->cursor));
+    sc->cursor.dts = sc->first_dts;
+    mov_cursor_enter_chunk(sc, 0);
+}
+
+static void mov_cursor_advance(MOVStreamContext *sc, unsigned int count)
+{
+    MOVSampleCursor *c = &sc->cursor;
+    unsigned int left = count;
+
+    while (left) {
+        const MOVStts *stts = &sc->stts_data[c->stts_index];
+        unsigned int n = left;
+        int last = c->stts_index + 1 >= sc->stts_count;
+
+        if (!last)
+            n = FFMIN(n, stts->count - c->stts_sample);
+        c->dts         += n * (int64_t)stts->duration;
+        c->stts_sample += n;
+        left           -= n;
+        if (!last && c->stts_sample == stts->count) {
+            c->stts_sample = 0;
+            c->stts_index++;
+        }
+    }
+
+    left = count;
+    while (left) {
+        unsigned int per_chunk = sc->stsc_data[c->stsc_index].count;
+        unsigned int run_end, skip;
+
+        if (left < per_chunk - c->chunk_sample) {
+            c->pos          += mov_sample_sizes_sum(sc, c->sample, left);
+            c->chunk_sample += left;
+            c->sample       += left;
+            break;
+        }
+        left      -= per_chunk - c->chunk_sample;
+        c->sample += per_chunk - c->chunk_sample;
+
+        /* skip whole chunks of the current stsc run */
+        run_end = sc->chunk_count;
+        if (mov_stsc_index_valid(c->stsc_index, sc->stsc_count))
+            run_end = FFMIN(run_end, sc->stsc_data[c->stsc_index + 1].first - 1);
+        skip = FFMIN(left / per_chunk, run_end - FFMIN(run_end, c->chunk + 1));
+        left      -= skip * per_chunk;
+        c->sample += skip * per_chunk;
+        mov_cursor_enter_chunk(sc, c->chunk + 1 + skip);
+    }
+}
+
+/**
+ * Save the cursor at every MOV_CURSOR_CHECKPOINT_INTERVAL-th sample.
+ */
+static int mov_cursor_build_checkpoints(MOVStreamContext *sc)
+{
+    unsigned int i, count = (sc->nb_samples - 1) / MOV_CURSOR_CHECKPOINT_INTERVAL + 1;
+
+    av_freep(&sc->cursor_checkpoints);
+    sc->cursor_checkpoints = av_malloc_array(count, sizeof(*sc->cursor_checkpoints));
+    if (!sc->cursor_checkpoints)
+        return AVERROR(ENOMEM);
+
+    mov_cursor_reset(sc);
+    for (i = 0; i < count; i++) {
+        if (i)
+            mov_cursor_advance(sc, MOV_CURSOR_CHECKPOINT_INTERVAL);
+        sc->cursor_checkpoints[i] = sc->cursor;
+    }
+    mov_cursor_reset(sc);
+    return 0;
+}
+
+static int mov_nb_samples(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    return sc->compact_index ? sc->nb_samples : st->nb_index_entries;
+}
+
+/**
+ * Get the index entry of a sample. With compact_index, the entry is
+ * resolved from the sample tables into e, otherwise the entry in
+ * st->index_entries is returned.
+ */
+static AVIndexEntry *mov_get_sample(AVStream *st, int sample, AVIndexEntry *e)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t key;
+
+    if (!sc->compact_index)
+        return sample >= 0 && sample < st->nb_index_entries ? &st->index_entries[sample] : NULL;
+    if (sample < 0 || sample >= sc->nb_samples)
+        return NULL;
+
+    if (sample < sc->cursor.sample ||
+        sample - sc->cursor.sample >= MOV_CURSOR_CHECKPOINT_INTERVAL)
+        sc->cursor = sc->cursor_checkpoints[sample / MOV_CURSOR_CHECKPOINT_INTERVAL];
+    mov_cursor_advance(sc, sample - sc->cursor.sample);
+
+    key = mov_prev_keyframe(st, sample);
+    e->pos          = sc->cursor.pos;
+    e->timestamp    = sc->cursor.dts;
+    e->size         = sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[sample];
+    e->flags        = key == sample ? AVINDEX_KEYFRAME : 0;
+    e->min_distance = sample - FFMAX(key, 0);
+    return e;
+}
+
+/**
+ * Search the samples of a compact index like ff_index_search_timestamp()
+ * searches st->index_entries.
+ */
+static int mov_compact_search_timestamp(AVStream *st, int64_t timestamp, int flags)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t dts = sc->first_dts, last_dts = INT64_MIN;
+    int64_t sample = 0, last = -1, m;
+    unsigned int i;
+
+    for (i = 0; i < sc->stts_count && sample < sc->nb_samples && dts <= timestamp; i++) {
+        int64_t count = i + 1 < sc->stts_count ? sc->stts_data[i].count : sc->nb_samples;
+        int duration = sc->stts_data[i].duration;
+        int64_t k;
+
+        count = FFMIN(count, sc->nb_samples - sample);
+        k = duration ? FFMIN(count - 1, (timestamp - dts) / duration) : count - 1;
+        last     = sample + k;
+        last_dts = dts + k * duration;
+        sample  += count;
+        dts     += count * duration;
+    }
+
+    m = flags & AVSEEK_FLAG_BACKWARD ? last : last + (last_dts != timestamp);
+    if (m < 0 || m >= sc->nb_samples)
+        return -1;
+    if (!(flags & AVSEEK_FLAG_ANY)) {
+        m = flags & AVSEEK_FLAG_BACKWARD ? mov_prev_keyframe(st, m) : mov_next_keyframe(st, m);
+        if (m < 0 || m >= sc->nb_samples)
+            return -1;
+    }
+    return m;
+}
+
+/**
+ * Return the dts of the first sample, or AV_NOPTS_VALUE if there is none.
+ * Unlike mov_get_sample(), this does not move the cursor of a compact index.
+ */
+static int64_t mov_first_sample_dts(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    if (sc->compact_index)
+        return sc->first_dts;
+    return st->nb_index_entries ? st->index_entries[0].timestamp : AV_NOPTS_VALUE;
+}
+
+/**
+ * Set up compact_index for a stream whose sample tables can be resolved on
+ * demand. Returns 1 if it was set up, 0 if the full index must be built.
+ */
+static int mov_build_compact_index(MOVContext *mov, AVStream *st, int64_t first_dts)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t nb_samples = 0;
+    uint64_t stream_size = 0;
+    int64_t edit_duration = INT64_MAX, edit_time;
+    int key_off = (sc->keyframe_count && sc->keyframes[0] > 0) || (sc->stps_count && sc->stps_data[0] > 0);
+    int64_t i;
+    AVIndexEntry e;
+
+    /* Only edit lists which mov_fix_index() leaves unchanged are supported. */
+    if (sc->elst_count && !mov->ignore_editlist && mov->advanced_editlist) {
+        if (sc->elst_count > 1 || sc->elst_data[0].time || sc->ctts_data || first_dts ||
+            !get_edit_list_entry(mov, sc, 0, &edit_time, &edit_duration, mov->time_scale))
+            return 0;
+    }
+    if ((sc->rap_group_count && sc->rap_group) ||
+        !sc->stts_count || !sc->stsc_count || !sc->chunk_count ||
+        (sc->stsz_sample_size > 0 && sc->stsz_sample_size < sc->sample_size) ||
+        (sc->sample_size > 0 && sc->sample_size < sc->stsz_sample_size) ||
+        sc->stsz_sample_size > 0x3FFFFFFF ||
+        (!sc->stsz_sample_size && !sc->sample_sizes))
+        return 0;
+
+    for (i = 0; i < sc->stts_count; i++)
+        if (sc->stts_data[i].duration < 0 ||
+            (i + 1 < sc->stts_count && !sc->stts_data[i].count))
+            return 0;
+
+    for (i = 0; i < sc->stsc_count; i++) {
+        int64_t start = i ? FFMIN(sc->stsc_data[i].first - 1, sc->chunk_count) : 0;
+        int64_t end = sc->chunk_count;
+        if (mov_stsc_index_valid(i, sc->stsc_count)) {
+            if (sc->stsc_data[i + 1].first <= sc->stsc_data[i].first)
+                return 0;
+            end = FFMIN(end, sc->stsc_data[i + 1].first - 1);
+        }
+        if (sc->stsc_data[i].first < 1 || sc->stsc_data[i].count < 0 ||
+            (sc->pseudo_stream_id != -1 && sc->stsc_data[i].id - 1 != sc->pseudo_stream_id))
+            return 0;
+        nb_samples += (end - start) * sc->stsc_data[i].count;
+    }
+    if (!nb_samples || nb_samples > sc->sample_count || nb_samples > INT_MAX)
+        return 0;
+
+    for (i = 0; i < sc->keyframe_count; i++)
+        if (sc->keyframes[i] < (i ? sc->keyframes[i - 1] + 1LL : key_off))
+            return 0;
+    for (i = 0; i < sc->stps_count; i++)
+        if (sc->stps_data[i] < (i ? sc->stps_data[i - 1] + 1LL : key_off))
+            return 0;
+
+    if (sc->stsz_sample_size > 0) {
+        stream_size = nb_samples * sc->stsz_sample_size;
+    } else {
+        for (i = 0; i < nb_samples; i++) {
+            if ((unsigned)sc->sample_sizes[i] > 0x3FFFFFFF)
+                return 0;
+            stream_size += sc->sample_sizes[i];
+        }
+    }
+
+    sc->compact_index = 1;
+    sc->nb_samples    = nb_samples;
+    sc->key_off       = key_off;
+    sc->first_dts     = first_dts;
+    if (mov_cursor_build_checkpoints(sc) < 0) {
+        sc->compact_index = 0;
+        return 0;
+    }
+
+    if (edit_duration != INT64_MAX) {
+        if (mov_get_sample(st, nb_samples - 1, &e)->timestamp >= edit_duration) {
+            sc->compact_index = 0;
+            av_freep(&sc->cursor_checkpoints);
+            return 0;
+        }
+        if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+            st->internal->skip_samples = 0;
+        sc->start_pad = st->internal->skip_samples;
+        sc->min_corrected_pts = 0;
+    }
+
+    av_log(mov->fc, AV_LOG_DEBUG, "Compact index for stream %d: %"PRId64" samples\n",
+           st->index, nb_samples);
+
+    for (i = mov_next_keyframe(st, 0); i < nb_samples; i = mov_next_keyframe(st, i + 1)) {
+        mov_get_sample(st, i, &e);
+        if (add_index_entry(st, e.pos, e.timestamp, e.size, e.min_distance, e.flags) < 0)
+            break;
+    }
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        for (i = 0; i < FFMIN(nb_samples, 99); i++)
+            ff_rfps_add_frame(mov->fc, st, mov_get_sample(st, i, &e)->timestamp);
+
+    if (st->duration > 0)
+        st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
+    if (edit_duration != INT64_MAX) {
+        st->start_time = 0;
+        st->duration   = FFMIN(st->duration, edit_duration);
+    }
+    return 1;
+}
+
+/**
+ * Replace a compact index by the full per-sample index, for code which needs
+ * to modify or walk st->index_entries.
+ */
+static int mov_expand_compact_index(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    AVIndexEntry *entries, e;
+    unsigned int i, j;
+
+    if (!sc->compact_index)
+        return 0;
+
+    entries = av_malloc_array(sc->nb_samples, sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < sc->nb_samples; i++)
+        entries[i] = *mov_get_sample(st, i, &e);
+
+    if (sc->ctts_data) {
+        MOVStts *ctts_data_old = sc->ctts_data;
+        unsigned int ctts_count_old = sc->ctts_count;
+
+        // Expand ctts entries such that we have a 1-1 mapping with samples
+        sc->ctts_count = 0;
+        sc->ctts_allocated_size = 0;
+        sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
+                                        sc->sample_count * sizeof(*sc->ctts_data));
+        if (!sc->ctts_data) {
+            sc->ctts_data  = ctts_data_old;
+            sc->ctts_count = ctts_count_old;
+            av_free(entries);
+            return AVERROR(ENOMEM);
+        }
+        for (i = 0; i < ctts_count_old && sc->ctts_count < sc->sample_count; i++)
+            for (j = 0; j < ctts_data_old[i].count && sc->ctts_count < sc->sample_count; j++)
+                add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
+                               &sc->ctts_allocated_size, 1,
+                               ctts_data_old[i].duration);
+        av_free(ctts_data_old);
+        sc->ctts_index  = sc->current_sample < sc->ctts_count ? sc->current_sample : sc->ctts_count;
+        sc->ctts_sample = 0;
+    }
+
+    av_free(st->index_entries);
+    st->index_entries = entries;
+    st->nb_index_entries = sc->nb_samples;
+    st->index_entries_allocated_size = sc->nb_samples * sizeof(*entries);
+
+    sc->compact_index = 0;
+    sc->sample_entry_index = 0;
+    av_freep(&sc->cursor_checkpoints);
+    av_freep(&sc->chunk_offsets);
+    av_freep(&sc->sample_sizes);
+    av_freep(&sc->keyframes);
+    av_freep(&sc->stts_data);
+    av_freep(&sc->stps_data);
+    return 0;
+}
+
 #define MAX_REORDER_DELAY 16
 static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
 {
     MOVStreamContext *msc = st->priv_data;
-    int ind;
+    AVIndexEntry e;
+    int ind, nb_samples = mov_nb_samples(st);
     int ctts_ind = 0;
     int ctts_sample = 0;
     int64_t pts_buf[MAX_REORDER_DELAY + 1]; // Circular buffer to sort pts.
@@ -3407,14 +3850,14 @@ static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
     if (st->codecpar->video_delay <= 0 && msc->ctts_data &&
         st->codecpar->codec_id == AV_CODEC_ID_H264) {
         st->codecpar->video_delay = 0;
-        for (ind = 0; ind < st->nb_index_entries && ctts_ind < msc->ctts_count; ++ind) {
+        for (ind = 0; ind < nb_samples && ctts_ind < msc->ctts_count; ++ind) {
             // Point j to the last elem of the buffer and insert the current pts there.
             j = buf_start;
             buf_start = (buf_start + 1);
             if (buf_start == MAX_REORDER_DELAY + 1)
                 buf_start = 0;
 
-            pts_buf[j] = st->index_entries[ind].timestamp + msc->ctts_data[ctts_ind].duration;
+            pts_buf[j] = mov_get_sample(st, ind, &e)->timestamp + msc->ctts_data[ctts_ind].duration;
 
             // The timestamps that are already in the sorted buffer, and are greater than the
             // current pts, are exactly the timestamps that need to be buffered to output PTS
@@ -3879,6 +4322,8 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
 
         if (!sc->sample_count || st->nb_index_entries)
             return;
+        if (mov->compact_index && mov_build_compact_index(mov, st, current_dts))
+            goto done;
         if (sc->sample_count >= UINT_MAX / sizeof(*st->index_entries) - st->nb_index_entries)
             return;
         if (av_reallocp_array(&st->index_entries,
@@ -4124,9 +4569,11 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         mov_fix_index(mov, st);
     }
 
+done:
     // Update start time of the stream.
-    if (st->start_time == AV_NOPTS_VALUE && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && st->nb_index_entries > 0) {
-        st->start_time = st->index_entries[0].timestamp + sc->dts_shift;
+    if (st->start_time == AV_NOPTS_VALUE && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && mov_nb_samples(st) > 0) {
+        AVIndexEntry e;
+        st->start_time = mov_get_sample(st, 0, &e)->timestamp + sc->dts_shift;
         if (sc->ctts_data) {
             st->start_time += sc->ctts_data[0].duration;
         }
@@ -4363,12 +4810,14 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         && sc->time_scale == st->codecpar->sample_rate) {
             st->need_parsing = AVSTREAM_PARSE_FULL;
     }
-    /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stts_data);
-    av_freep(&sc->stps_data);
+    /* Do not need those anymore, unless samples are resolved from them. */
+    if (!sc->compact_index) {
+        av_freep(&sc->chunk_offsets);
+        av_freep(&sc->sample_sizes);
+        av_freep(&sc->keyframes);
+        av_freep(&sc->stts_data);
+        av_freep(&sc->stps_data);
+    }
     av_freep(&sc->elst_data);
     av_freep(&sc->rap_group);
 
@@ -4795,7 +5244,7 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     unsigned entries, first_sample_flags = frag->flags;
     int flags, distance, i;
     int64_t prev_dts = AV_NOPTS_VALUE;
-    int next_frag_index = -1, index_entry_pos;
+    int next_frag_index = -1, index_entry_pos, ret;
     size_t requested_size;
     size_t old_ctts_allocated_size;
     AVIndexEntry *new_entries;
@@ -4819,6 +5268,8 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     sc = st->priv_data;
     if (sc->pseudo_stream_id+1 != frag->stsd_id && sc->pseudo_stream_id != -1)
         return 0;
+    if ((ret = mov_expand_compact_index(st)) < 0)
+        return ret;
 
     // Find the next frag_index index that has a valid index_entry for
     // the current track_id.
@@ -7262,6 +7713,8 @@ static void mov_read_chapters(AVFormatContext *s)
         }
 
         sc = st->priv_data;
+        if (mov_expand_compact_index(st) < 0)
+            continue;
         cur_pos = avio_tell(sc->pb);
 
         if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
@@ -7358,11 +7811,12 @@ static int mov_read_rtmd_track(AVFormatContext *s, AVStream *st)
     char buf[AV_TIMECODE_STR_SIZE];
     int64_t cur_pos = avio_tell(sc->pb);
     int hh, mm, ss, ff, drop;
+    AVIndexEntry e, *sample = mov_get_sample(st, 0, &e);
 
-    if (!st->nb_index_entries)
+    if (!sample)
         return -1;
 
-    avio_seek(sc->pb, st->index_entries->pos, SEEK_SET);
+    avio_seek(sc->pb, sample->pos, SEEK_SET);
     avio_skip(s->pb, 13);
     hh = avio_r8(s->pb);
     mm = avio_r8(s->pb);
@@ -7383,11 +7837,12 @@ static int mov_read_timecode_track(AVFormatContext *s, AVStream *st)
     int flags = 0;
     int64_t cur_pos = avio_tell(sc->pb);
     uint32_t value;
+    AVIndexEntry e, *sample = mov_get_sample(st, 0, &e);
 
-    if (!st->nb_index_entries)
+    if (!sample)
         return -1;
 
-    avio_seek(sc->pb, st->index_entries->pos, SEEK_SET);
+    avio_seek(sc->pb, sample->pos, SEEK_SET);
     value = avio_rb32(s->pb);
 
     if (sc->tmcd_flags & 0x0001) flags |= AV_TIMECODE_FLAG_DROPFRAME;
@@ -7442,6 +7897,7 @@ static int mov_read_close(AVFormatContext *s)
             ff_format_io_close(s, &sc->pb);
 
         sc->pb = NULL;
+        av_freep(&sc->cursor_checkpoints);
         av_freep(&sc->chunk_offsets);
         av_freep(&sc->stsc_data);
         av_freep(&sc->sample_sizes);
@@ -7844,6 +8300,20 @@ fail:
     return err;
 }
 
+static AVIndexEntry *mov_current_sample_entry(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    if (!sc->compact_index)
+        return mov_get_sample(st, sc->current_sample, NULL);
+    if (sc->sample_entry_index != sc->current_sample + 1) {
+        if (!mov_get_sample(st, sc->current_sample, &sc->sample_entry))
+            return NULL;
+        sc->sample_entry_index = sc->current_sample + 1;
+    }
+    return &sc->sample_entry;
+}
+
 static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
 {
     AVIndexEntry *sample = NULL;
@@ -7852,8 +8322,8 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
     for (i = 0; i < s->nb_streams; i++) {
         AVStream *avst = s->streams[i];
         MOVStreamContext *msc = avst->priv_data;
-        if (msc->pb && msc->current_sample < avst->nb_index_entries) {
-            AVIndexEntry *current_sample = &avst->index_entries[msc->current_sample];
+        AVIndexEntry *current_sample = msc->pb ? mov_current_sample_entry(avst) : NULL;
+        if (current_sample) {
             int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
             av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
             if (!sample || (!(s->pb->seekable & AVIO_SEEKABLE_NORMAL) && current_sample->pos < sample->pos) ||
@@ -8003,8 +8473,11 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
 
         if (st->codecpar->codec_id == AV_CODEC_ID_EIA_608 && sample->size > 8)
             ret = get_eia608_packet(sc->pb, pkt, sample->size);
-        else
+        else if (mov->aax_mode || mov->decryption_key)
+            /* decrypted in place below */
             ret = av_get_packet(sc->pb, pkt, sample->size);
+        else
+            ret = ff_get_packet_mapped(s, sc->pb, pkt, sample->size);
         if (ret < 0) {
             if (should_retry(sc->pb, ret)) {
                 mov_current_sample_dec(sc);
@@ -8056,8 +8529,8 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
             sc->ctts_sample = 0;
         }
     } else {
-        int64_t next_dts = (sc->current_sample < st->nb_index_entries) ?
-            st->index_entries[sc->current_sample].timestamp : st->duration;
+        AVIndexEntry e, *next = mov_get_sample(st, sc->current_sample, &e);
+        int64_t next_dts = next ? next->timestamp : st->duration;
 
         if (next_dts >= pkt->dts)
             pkt->duration = next_dts - pkt->dts;
@@ -8125,6 +8598,7 @@ static int mov_seek_fragment(AVFormatContext *s, AVStream *st, int64_t timestamp
 static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp, int flags)
 {
     MOVStreamContext *sc = st->priv_data;
+    int64_t first_dts;
     int sample, time_sample, ret;
     unsigned int i;
 
@@ -8136,9 +8610,13 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
     if (ret < 0)
         return ret;
 
-    sample = av_index_search_timestamp(st, timestamp, flags);
+    if (sc->compact_index)
+        sample = mov_compact_search_timestamp(st, timestamp, flags);
+    else
+        sample = av_index_search_timestamp(st, timestamp, flags);
     av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
-    if (sample < 0 && st->nb_index_entries && timestamp < st->index_entries[0].timestamp)
+    first_dts = mov_first_sample_dts(st);
+    if (sample < 0 && first_dts != AV_NOPTS_VALUE && timestamp < first_dts)
         sample = 0;
     if (sample < 0) /* not sure what to do */
         return AVERROR_INVALIDDATA;
@@ -8179,8 +8657,9 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
 static int64_t mov_get_skip_samples(AVStream *st, int sample)
 {
     MOVStreamContext *sc = st->priv_data;
-    int64_t first_ts = st->index_entries[0].timestamp;
-    int64_t ts = st->index_entries[sample].timestamp;
+    AVIndexEntry e;
+    int64_t first_ts = mov_first_sample_dts(st);
+    int64_t ts = mov_get_sample(st, sample, &e)->timestamp;
     int64_t off;
 
     if (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
@@ -8209,7 +8688,8 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
 
     if (mc->seek_individually) {
         /* adjust seek timestamp to found sample timestamp */
-        int64_t seek_timestamp = st->index_entries[sample].timestamp;
+        AVIndexEntry e;
+        int64_t seek_timestamp = mov_get_sample(st, sample, &e)->timestamp;
         st->internal->skip_samples = mov_get_skip_samples(st, sample);
 
         for (i = 0; i < s->nb_streams; i++) {
@@ -8292,6 +8772,8 @@ static const AVOption mov_options[] = {
     { "decryption_key", "The media decryption key (hex)", OFFSET(decryption_key), AV_OPT_TYPE_BINARY, .flags = AV_OPT_FLAG_DECODING_PARAM },
     { "enable_drefs", "Enable external track support.", OFFSET(enable_drefs), AV_OPT_TYPE_BOOL,
         {.i64 = 0}, 0, 1, FLAGS },
+    { "compact_index", "Resolve samples from the sample tables instead of building a per-sample index",
+        OFFSET(compact_index), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS },
 
     { NULL },
 };
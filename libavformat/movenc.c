@@ -69,6 +69,7 @@ static const AVOption options[] = {
     { "frag_custom", "Flush fragments on caller requests", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FRAG_CUSTOM}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "isml", "Create a live smooth streaming feed (for pushing to a publishing point)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_ISML}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "faststart", "Run a second pass to put the index (moov atom) at the beginning of the file", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FASTSTART}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
+    { "reserve_moov", "Reserve space for the index (moov atom) at the beginning of the file, use a second pass only if it is too small", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_RESERVE_MOOV}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "omit_tfhd_offset", "Omit the base data offset in tfhd atoms", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_OMIT_TFHD_OFFSET}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "disable_chpl", "Disable Nero chapter atom", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_DISABLE_CHPL}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "default_base_moof", "Set the default-base-is-moof flag in tfhd atoms", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_DEFAULT_BASE_MOOF}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
@@ -6419,6 +6420,66 @@ static int mov_create_dvd_sub_decoder_specific_info(MOVTrack *track,
     return 0;
 }
 
+/**
+ * Estimate the size of the moov atom from the stream duration and frame rate
+ * hints, to reserve space for it at the beginning of the file.
+ * Returns 0 if no stream has a duration hint.
+ */
+static int64_t estimate_moov_size(AVFormatContext *s)
+{
+    const AVDictionaryEntry *t = NULL;
+    double duration = 0, size = 4096;
+    int i;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        if (st->duration > 0)
+            duration = FFMAX(duration, st->duration * av_q2d(st->time_base));
+    }
+    if (duration <= 0)
+        return 0;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        AVCodecParameters *par = st->codecpar;
+        const AVCodecDescriptor *desc = avcodec_descriptor_get(par->codec_id);
+        double rate, st_duration = duration;
+        /* stsz and co64 entries, with room for stsc and stts changes */
+        int entry_size = 16;
+
+        if (st->duration > 0)
+            st_duration = st->duration * av_q2d(st->time_base);
+
+        switch (par->codec_type) {
+        case AVMEDIA_TYPE_VIDEO:
+            rate = av_q2d(st->avg_frame_rate);
+            if (rate <= 0)
+                rate = av_q2d(st->r_frame_rate);
+            if (rate <= 0)
+                rate = 60;
+            /* ctts and stss entries */
+            if (!desc || !(desc->props & AV_CODEC_PROP_INTRA_ONLY))
+                entry_size += 8;
+            break;
+        case AVMEDIA_TYPE_AUDIO:
+            rate = par->sample_rate / (double)(par->frame_size > 0 ? par->frame_size : 1024);
+            if (rate <= 0)
+                rate = 50;
+            break;
+        default:
+            rate = 10;
+            break;
+        }
+        size += 4096 + st_duration * rate * entry_size;
+    }
+
+    size += 1024 * s->nb_chapters;
+    while ((t = av_dict_get(s->metadata, "", t, AV_DICT_IGNORE_SUFFIX)))
+        size += strlen(t->key) + strlen(t->value) + 32;
+
+    return size < INT64_MAX / 2 ? (int64_t)size : INT64_MAX;
+}
+
 static int mov_init(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -6472,7 +6533,27 @@ static int mov_init(AVFormatContext *s)
         mov->flags &= ~FF_MOV_FLAG_SKIP_SIDX;
     }
 
-    if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+    if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV && mov->flags & FF_MOV_FLAG_FRAGMENT) {
+        av_log(s, AV_LOG_WARNING, "reserve_moov is not supported with fragmented output, ignoring\n");
+        mov->flags &= ~FF_MOV_FLAG_RESERVE_MOOV;
+    }
+
+    if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+        mov->flags |= FF_MOV_FLAG_FASTSTART;
+        if (!mov->reserved_moov_size) {
+            int64_t size = estimate_moov_size(s);
+            if (size > 0 && size <= INT_MAX) {
+                av_log(s, AV_LOG_VERBOSE, "Reserving %"PRId64" bytes for the moov atom\n", size);
+                mov->reserved_moov_size = size;
+            } else {
+                av_log(s, AV_LOG_WARNING, "Unable to estimate the moov size from the stream durations, "
+                       "set moov_size to reserve space for it; a second pass will be used\n");
+                mov->reserved_moov_size = -1;
+            }
+        } else {
+            mov->reserved_moov_size = FFMAX(mov->reserved_moov_size, 8);
+        }
+    } else if (mov->flags & FF_MOV_FLAG_FASTSTART) {
         mov->reserved_moov_size = -1;
     }
 
@@ -6833,6 +6914,7 @@ static int mov_write_header(AVFormatContext *s)
 
     if (mov->reserved_moov_size){
         mov->reserved_header_pos = avio_tell(pb);
+        mov->reserved_moov_pos   = mov->reserved_header_pos;
         if (mov->reserved_moov_size > 0)
             avio_skip(pb, mov->reserved_moov_size);
     }
@@ -7045,6 +7127,50 @@ end:
     return ret;
 }
 
+/*
+ * Write the moov atom into the space reserved for it at the beginning of the
+ * file, followed by a free atom filling the rest of it. If it does not fit,
+ * the reserved space is turned into a free atom and the moov atom is moved
+ * in front of the mdat atom with a second pass.
+ */
+static int mov_write_reserved_moov(AVFormatContext *s, int64_t moov_pos)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVIOContext *pb = s->pb;
+    int64_t free_size;
+    int moov_size, res;
+
+    moov_size = get_moov_size(s);
+    if (moov_size < 0)
+        return moov_size;
+
+    free_size = mov->reserved_moov_size - (int64_t)moov_size;
+    avio_seek(pb, mov->reserved_moov_pos, SEEK_SET);
+    if (free_size == 0 || free_size >= 8) {
+        if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
+            return res;
+        if (free_size) {
+            avio_wb32(pb, free_size);
+            ffio_wfourcc(pb, "free");
+            ffio_fill(pb, 0, free_size - 8);
+        }
+        avio_seek(pb, moov_pos, SEEK_SET);
+        return 0;
+    }
+
+    av_log(s, AV_LOG_WARNING, "Reserved moov size %d is too small, needed %d; "
+           "starting second pass: moving the moov atom to the beginning of the file\n",
+           mov->reserved_moov_size, moov_size);
+    avio_wb32(pb, mov->reserved_moov_size);
+    ffio_wfourcc(pb, "free");
+    avio_seek(pb, moov_pos, SEEK_SET);
+
+    if ((res = shift_data(s)) < 0)
+        return res;
+    avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+    return mov_write_moov_tag(pb, mov, s);
+}
+
 static int mov_write_trailer(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -7111,7 +7237,10 @@ static int mov_write_trailer(AVFormatContext *s)
         }
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_header_pos : moov_pos, SEEK_SET);
 
-        if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+        if (mov->flags & FF_MOV_FLAG_FASTSTART && mov->reserved_moov_size > 0) {
+            if ((res = mov_write_reserved_moov(s, moov_pos)) < 0)
+                return res;
+        } else if (mov->flags & FF_MOV_FLAG_FASTSTART) {
             av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
             res = shift_data(s);
             if (res < 0)
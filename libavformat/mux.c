@@ -929,6 +929,145 @@ static int interleave_compare_dts(AVFormatContext *s, const AVPacket *next,
     return comp > 0;
 }
 
+/**
+ * Return 1 if the queue of stream a has to be output before the queue of
+ * stream b, i.e. if its first packet comes first in dts order.
+ */
+static int interleave_heap_before(AVFormatContext *s, int a, int b)
+{
+    return interleave_compare_dts(s, &s->streams[b]->internal->first_in_packet_buffer->pkt,
+                                     &s->streams[a]->internal->first_in_packet_buffer->pkt);
+}
+
+static void interleave_heap_sift_up(AVFormatContext *s, int i)
+{
+    int *heap = s->internal->interleave_heap;
+
+    while (i > 0) {
+        int parent = (i - 1) >> 1;
+        if (!interleave_heap_before(s, heap[i], heap[parent]))
+            break;
+        FFSWAP(int, heap[i], heap[parent]);
+        i = parent;
+    }
+}
+
+static void interleave_heap_sift_down(AVFormatContext *s, int i)
+{
+    int *heap = s->internal->interleave_heap;
+    int n     = s->internal->nb_interleave_heap;
+
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && interleave_heap_before(s, heap[child + 1], heap[child]))
+            child++;
+        if (!interleave_heap_before(s, heap[child], heap[i]))
+            break;
+        FFSWAP(int, heap[i], heap[child]);
+        i = child;
+    }
+}
+
+/**
+ * Queue a packet for interleaving in dts order.
+ *
+ * Unlike ff_interleave_add_packet(), which has to find the position of
+ * every packet in the single packet_buffer list, packets are appended to
+ * the queue of their stream and only the streams are kept ordered, in a
+ * heap keyed on the first packet of each queue. The output order is the
+ * same as with ff_interleave_add_packet(s, pkt, interleave_compare_dts).
+ */
+static int interleave_add_packet_heap(AVFormatContext *s, AVPacket *pkt)
+{
+    AVFormatInternal *const si = s->internal;
+    AVStreamInternal *sti = s->streams[pkt->stream_index]->internal;
+    PacketList *this_pktl;
+    int ret;
+
+    if (!sti->first_in_packet_buffer &&
+        si->nb_interleave_heap >= si->interleave_heap_size / sizeof(*si->interleave_heap)) {
+        int *heap = av_fast_realloc(si->interleave_heap, &si->interleave_heap_size,
+                                    s->nb_streams * sizeof(*si->interleave_heap));
+        if (!heap) {
+            av_packet_unref(pkt);
+            return AVERROR(ENOMEM);
+        }
+        si->interleave_heap = heap;
+    }
+
+    this_pktl = av_malloc(sizeof(PacketList));
+    if (!this_pktl) {
+        av_packet_unref(pkt);
+        return AVERROR(ENOMEM);
+    }
+    if ((ret = av_packet_make_refcounted(pkt)) < 0) {
+        av_free(this_pktl);
+        av_packet_unref(pkt);
+        return ret;
+    }
+    av_packet_move_ref(&this_pktl->pkt, pkt);
+    this_pktl->next = NULL;
+
+    if (sti->first_in_packet_buffer) {
+        sti->last_in_packet_buffer->next = this_pktl;
+    } else {
+        sti->first_in_packet_buffer = this_pktl;
+        si->interleave_heap[si->nb_interleave_heap] = this_pktl->pkt.stream_index;
+        interleave_heap_sift_up(s, si->nb_interleave_heap++);
+    }
+    sti->last_in_packet_buffer = this_pktl;
+
+    return 0;
+}
+
+/**
+ * Return the first packet in interleaving order, or NULL if none is queued.
+ */
+static PacketList *interleave_peek_first(AVFormatContext *s)
+{
+    if (s->internal->nb_interleave_heap)
+        return s->streams[s->internal->interleave_heap[0]]->internal->first_in_packet_buffer;
+    return s->internal->packet_buffer;
+}
+
+/**
+ * Remove the first packet in interleaving order from its queue and
+ * return it. The caller owns the returned list entry.
+ */
+static PacketList *interleave_get_first(AVFormatContext *s)
+{
+    AVFormatInternal *const si = s->internal;
+    PacketList *pktl;
+    AVStreamInternal *sti;
+
+    if (si->nb_interleave_heap) {
+        sti  = s->streams[si->interleave_heap[0]]->internal;
+        pktl = sti->first_in_packet_buffer;
+
+        sti->first_in_packet_buffer = pktl->next;
+        if (!sti->first_in_packet_buffer) {
+            sti->last_in_packet_buffer = NULL;
+            si->interleave_heap[0] = si->interleave_heap[--si->nb_interleave_heap];
+        }
+        interleave_heap_sift_down(s, 0);
+        return pktl;
+    }
+
+    pktl = si->packet_buffer;
+    sti  = s->streams[pktl->pkt.stream_index]->internal;
+
+    si->packet_buffer = pktl->next;
+    if (!si->packet_buffer)
+        si->packet_buffer_end = NULL;
+
+    if (sti->last_in_packet_buffer == pktl)
+        sti->last_in_packet_buffer = NULL;
+
+    return pktl;
+}
+
 int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
                                  AVPacket *pkt, int flush)
 {
@@ -939,7 +1078,11 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
     int eof = flush;
 
     if (pkt) {
-        if ((ret = ff_interleave_add_packet(s, pkt, interleave_compare_dts)) < 0)
+        if (s->max_chunk_size || s->max_chunk_duration)
+            ret = ff_interleave_add_packet(s, pkt, interleave_compare_dts);
+        else
+            ret = interleave_add_packet_heap(s, pkt);
+        if (ret < 0)
             return ret;
     }
 
@@ -957,11 +1100,11 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
         flush = 1;
 
     if (s->max_interleave_delta > 0 &&
-        s->internal->packet_buffer &&
+        interleave_peek_first(s) &&
         !flush &&
         s->internal->nb_interleaved_streams == stream_count+noninterleaved_count
     ) {
-        AVPacket *top_pkt = &s->internal->packet_buffer->pkt;
+        AVPacket *top_pkt = &interleave_peek_first(s)->pkt;
         int64_t delta_dts = INT64_MIN;
         int64_t top_dts = av_rescale_q(top_pkt->dts,
                                        s->streams[top_pkt->stream_index]->time_base,
@@ -989,11 +1132,11 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
         }
     }
 
-    if (s->internal->packet_buffer &&
+    if (interleave_peek_first(s) &&
         eof &&
         (s->flags & AVFMT_FLAG_SHORTEST) &&
         s->internal->shortest_end == AV_NOPTS_VALUE) {
-        AVPacket *top_pkt = &s->internal->packet_buffer->pkt;
+        AVPacket *top_pkt = &interleave_peek_first(s)->pkt;
 
         s->internal->shortest_end = av_rescale_q(top_pkt->dts,
                                        s->streams[top_pkt->stream_index]->time_base,
@@ -1001,9 +1144,8 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
     }
 
     if (s->internal->shortest_end != AV_NOPTS_VALUE) {
-        while (s->internal->packet_buffer) {
-            AVPacket *top_pkt = &s->internal->packet_buffer->pkt;
-            AVStream *st;
+        while ((pktl = interleave_peek_first(s))) {
+            AVPacket *top_pkt = &pktl->pkt;
             int64_t top_dts = av_rescale_q(top_pkt->dts,
                                         s->streams[top_pkt->stream_index]->time_base,
                                         AV_TIME_BASE_Q);
@@ -1011,16 +1153,7 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
             if (s->internal->shortest_end + 1 >= top_dts)
                 break;
 
-            pktl = s->internal->packet_buffer;
-            st   = s->streams[pktl->pkt.stream_index];
-
-            s->internal->packet_buffer = pktl->next;
-            if (!s->internal->packet_buffer)
-                s->internal->packet_buffer_end = NULL;
-
-            if (st->internal->last_in_packet_buffer == pktl)
-                st->internal->last_in_packet_buffer = NULL;
-
+            pktl = interleave_get_first(s);
             av_packet_unref(&pktl->pkt);
             av_freep(&pktl);
             flush = 0;
@@ -1028,17 +1161,8 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
     }
 
     if (stream_count && flush) {
-        AVStream *st;
-        pktl = s->internal->packet_buffer;
+        pktl = interleave_get_first(s);
         *out = pktl->pkt;
-        st   = s->streams[out->stream_index];
-
-        s->internal->packet_buffer = pktl->next;
-        if (!s->internal->packet_buffer)
-            s->internal->packet_buffer_end = NULL;
-
-        if (st->internal->last_in_packet_buffer == pktl)
-            st->internal->last_in_packet_buffer = NULL;
         av_freep(&pktl);
 
         return 1;
@@ -1065,7 +1189,11 @@ int ff_get_muxer_ts_offset(AVFormatContext *s, int stream_index, int64_t *offset
 
 const AVPacket *ff_interleaved_peek(AVFormatContext *s, int stream)
 {
-    PacketList *pktl = s->internal->packet_buffer;
+    PacketList *pktl = s->streams[stream]->internal->first_in_packet_buffer;
+    if (pktl)
+        return &pktl->pkt;
+
+    pktl = s->internal->packet_buffer;
     while (pktl) {
         if (pktl->pkt.stream_index == stream) {
             return &pktl->pkt;
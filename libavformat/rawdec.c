@@ -35,14 +35,28 @@
 int ff_raw_read_partial_packet(AVFormatContext *s, AVPacket *pkt)
 {
     FFRawDemuxerContext *raw = s->priv_data;
+    AVBufferRef *buf;
+    int64_t pos = avio_tell(s->pb);
     int ret, size;
 
     size = raw->raw_packet_size;
 
+    ret = s->flags & AVFMT_FLAG_UNPADDED ? ffio_read_mapped(s->pb, size, &buf)
+                                         : AVERROR(ENOSYS);
+    if (ret >= 0) {
+        pkt->buf  = buf;
+        pkt->data = buf->data;
+        pkt->size = size;
+        pkt->pos  = pos;
+        pkt->stream_index = 0;
+        return size;
+    } else if (ret != AVERROR(ENOSYS))
+        return ret;
+
     if ((ret = av_new_packet(pkt, size)) < 0)
         return ret;
 
-    pkt->pos= avio_tell(s->pb);
+    pkt->pos= pos;
     pkt->stream_index = 0;
     ret = avio_read_partial(s->pb, pkt->data, size);
     if (ret < 0) {
@@ -0,0 +1,580 @@
+/*
+ * Asynchronous file readahead
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* Needed for syscall() and MAP_POPULATE */
+#define _DEFAULT_SOURCE
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_IO_URING
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "readahead.h"
+
+#define USE_THREADS (HAVE_THREADS && HAVE_PREAD)
+
+#define MAX_WORKERS 8
+
+/* user_data of the cancel requests; reads use READ_TAG() */
+#define CANCEL_TAG UINT64_MAX
+
+enum BlockState {
+    BLOCK_IDLE,         ///< no data
+    BLOCK_QUEUED,       ///< waiting for a worker thread
+    BLOCK_BUSY,         ///< being read
+    BLOCK_DONE,         ///< ret is valid
+};
+
+typedef struct ReadaheadBlock {
+    uint8_t *data;
+    int64_t index;      ///< block of the file held or being read, -1 if none
+    int state;
+    int ret;            ///< bytes read so far, or an AVERROR code once done
+    int cancel;         ///< a cancel request is pending
+    uint32_t gen;       ///< submission count, tells reads of the same block apart
+} ReadaheadBlock;
+
+struct FFReadahead {
+    void *logctx;
+    int fd;
+    int block_size;
+    int nb_blocks;
+    ReadaheadBlock *blocks;
+    int64_t window;     ///< first block of the window
+
+#if HAVE_IO_URING
+    int ring_fd;
+    unsigned unsubmitted;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size, sqes_size;
+#endif
+
+#if USE_THREADS
+    pthread_t workers[MAX_WORKERS];
+    int nb_workers;
+    int abort;
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+#endif
+};
+
+#if HAVE_IO_URING
+
+static void uring_uninit(FFReadahead *ra)
+{
+    if (ra->sqes)
+        munmap(ra->sqes, ra->sqes_size);
+    if (ra->cq_ring)
+        munmap(ra->cq_ring, ra->cq_ring_size);
+    if (ra->sq_ring)
+        munmap(ra->sq_ring, ra->sq_ring_size);
+    if (ra->ring_fd >= 0)
+        close(ra->ring_fd);
+    ra->sqes    = NULL;
+    ra->cq_ring = ra->sq_ring = NULL;
+    ra->ring_fd = -1;
+}
+
+static void *uring_mmap(FFReadahead *ra, size_t size, off_t offset)
+{
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     ra->ring_fd, offset);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+static int uring_init(FFReadahead *ra)
+{
+    struct io_uring_params p = { 0 };
+    int ret;
+
+    /* room for a read and a cancel request per block */
+    ra->ring_fd = syscall(__NR_io_uring_setup, 2 * ra->nb_blocks, &p);
+    if (ra->ring_fd < 0)
+        return AVERROR(errno);
+    /* IORING_OP_READ came with Linux 5.6, as did this feature */
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        ret = AVERROR(ENOSYS);
+        goto fail;
+    }
+
+    ra->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ra->cq_ring_size = p.cq_off.cqes  + p.cq_entries * sizeof(struct io_uring_cqe);
+    ra->sqes_size    = p.sq_entries * sizeof(struct io_uring_sqe);
+    ra->sq_ring = uring_mmap(ra, ra->sq_ring_size, IORING_OFF_SQ_RING);
+    ra->cq_ring = uring_mmap(ra, ra->cq_ring_size, IORING_OFF_CQ_RING);
+    ra->sqes    = uring_mmap(ra, ra->sqes_size,    IORING_OFF_SQES);
+    if (!ra->sq_ring || !ra->cq_ring || !ra->sqes) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+
+    ra->sq_tail  = (unsigned *)((uint8_t *)ra->sq_ring + p.sq_off.tail);
+    ra->sq_mask  = (unsigned *)((uint8_t *)ra->sq_ring + p.sq_off.ring_mask);
+    ra->sq_array = (unsigned *)((uint8_t *)ra->sq_ring + p.sq_off.array);
+    ra->cq_head  = (unsigned *)((uint8_t *)ra->cq_ring + p.cq_off.head);
+    ra->cq_tail  = (unsigned *)((uint8_t *)ra->cq_ring + p.cq_off.tail);
+    ra->cq_mask  = (unsigned *)((uint8_t *)ra->cq_ring + p.cq_off.ring_mask);
+    ra->cqes     = (struct io_uring_cqe *)((uint8_t *)ra->cq_ring + p.cq_off.cqes);
+    return 0;
+
+fail:
+    uring_uninit(ra);
+    return ret;
+}
+
+/* Queue a request; it is submitted by the next uring_enter() */
+static void uring_queue(FFReadahead *ra, int opcode, uint64_t addr,
+                        unsigned len, uint64_t offset, uint64_t user_data)
+{
+    unsigned tail = *ra->sq_tail;
+    unsigned idx  = tail & *ra->sq_mask;
+    struct io_uring_sqe *sqe = &ra->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = opcode;
+    sqe->fd        = opcode == IORING_OP_READ ? ra->fd : -1;
+    sqe->addr      = addr;
+    sqe->len       = len;
+    sqe->off       = offset;
+    sqe->user_data = user_data;
+    ra->sq_array[idx] = idx;
+    atomic_store_explicit((atomic_uint *)ra->sq_tail, tail + 1, memory_order_release);
+    ra->unsubmitted++;
+}
+
+/* a late cancel request must not hit a later read into the same block */
+#define READ_TAG(ra, b) ((uint64_t)(b)->gen << 32 | ((b) - (ra)->blocks))
+
+static void uring_queue_read(FFReadahead *ra, ReadaheadBlock *b)
+{
+    uring_queue(ra, IORING_OP_READ, (uintptr_t)(b->data + b->ret),
+                ra->block_size - b->ret,
+                b->index * ra->block_size + b->ret, READ_TAG(ra, b));
+}
+
+/* Submit the queued requests and wait for min_complete completions */
+static int uring_enter(FFReadahead *ra, unsigned min_complete)
+{
+    int ret;
+
+    if (!ra->unsubmitted && !min_complete)
+        return 0;
+    ret = syscall(__NR_io_uring_enter, ra->ring_fd, ra->unsubmitted, min_complete,
+                  min_complete ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    if (ret < 0)
+        return errno == EINTR ? 0 : AVERROR(errno);
+    ra->unsubmitted -= ret;
+    return 0;
+}
+
+static void uring_reap(FFReadahead *ra)
+{
+    unsigned head = *ra->cq_head;
+    unsigned tail = atomic_load_explicit((atomic_uint *)ra->cq_tail, memory_order_acquire);
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe *cqe = &ra->cqes[head & *ra->cq_mask];
+        ReadaheadBlock *b;
+
+        if (cqe->user_data == CANCEL_TAG)
+            continue;
+        b = &ra->blocks[(uint32_t)cqe->user_data];
+        if (b->cancel) {
+            b->state = BLOCK_IDLE;
+        } else if (cqe->res == -EAGAIN || cqe->res == -EINTR) {
+            uring_queue_read(ra, b);
+        } else if (cqe->res < 0) {
+            b->ret   = AVERROR(-cqe->res);
+            b->state = BLOCK_DONE;
+        } else {
+            b->ret += cqe->res;
+            /* buffered reads may be short; carry on up to the end of file */
+            if (cqe->res && b->ret < ra->block_size)
+                uring_queue_read(ra, b);
+            else
+                b->state = BLOCK_DONE;
+        }
+    }
+    atomic_store_explicit((atomic_uint *)ra->cq_head, head, memory_order_release);
+}
+
+#endif /* HAVE_IO_URING */
+
+#if USE_THREADS
+
+static int read_block(int fd, uint8_t *buf, int64_t pos, int size)
+{
+    int done = 0;
+
+    while (done < size) {
+        ssize_t ret = pread(fd, buf + done, size - done, pos + done);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return AVERROR(errno);
+        }
+        if (!ret)
+            break;
+        done += ret;
+    }
+    return done;
+}
+
+static void *worker_thread(void *arg)
+{
+    FFReadahead *ra = arg;
+
+    pthread_mutex_lock(&ra->lock);
+    while (!ra->abort) {
+        ReadaheadBlock *b = NULL;
+        int64_t index;
+        int i, ret;
+
+        /* nearest block first */
+        for (i = 0; i < ra->nb_blocks; i++) {
+            ReadaheadBlock *t = &ra->blocks[i];
+            if (t->state == BLOCK_QUEUED && (!b || t->index < b->index))
+                b = t;
+        }
+        if (!b) {
+            pthread_cond_wait(&ra->work_cond, &ra->lock);
+            continue;
+        }
+
+        b->state = BLOCK_BUSY;
+        index    = b->index;
+        pthread_mutex_unlock(&ra->lock);
+        ret = read_block(ra->fd, b->data, index * ra->block_size, ra->block_size);
+        pthread_mutex_lock(&ra->lock);
+        b->ret   = ret;
+        b->state = BLOCK_DONE;
+        pthread_cond_broadcast(&ra->done_cond);
+    }
+    pthread_mutex_unlock(&ra->lock);
+    return NULL;
+}
+
+static int threads_init(FFReadahead *ra)
+{
+    int i, ret;
+
+    if ((ret = pthread_mutex_init(&ra->lock, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&ra->work_cond, NULL))) {
+        pthread_mutex_destroy(&ra->lock);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&ra->done_cond, NULL))) {
+        pthread_cond_destroy(&ra->work_cond);
+        pthread_mutex_destroy(&ra->lock);
+        return AVERROR(ret);
+    }
+
+    for (i = 0; i < FFMIN(ra->nb_blocks, MAX_WORKERS); i++) {
+        if ((ret = pthread_create(&ra->workers[i], NULL, worker_thread, ra))) {
+            if (!i) {
+                pthread_cond_destroy(&ra->done_cond);
+                pthread_cond_destroy(&ra->work_cond);
+                pthread_mutex_destroy(&ra->lock);
+                return AVERROR(ret);
+            }
+            break;
+        }
+        ra->nb_workers++;
+    }
+    return 0;
+}
+
+static void threads_uninit(FFReadahead *ra)
+{
+    int i;
+
+    pthread_mutex_lock(&ra->lock);
+    ra->abort = 1;
+    pthread_cond_broadcast(&ra->work_cond);
+    pthread_mutex_unlock(&ra->lock);
+    for (i = 0; i < ra->nb_workers; i++)
+        pthread_join(ra->workers[i], NULL);
+    pthread_cond_destroy(&ra->done_cond);
+    pthread_cond_destroy(&ra->work_cond);
+    pthread_mutex_destroy(&ra->lock);
+    ra->nb_workers = 0;
+}
+
+#endif /* USE_THREADS */
+
+static void ra_lock(FFReadahead *ra)
+{
+#if USE_THREADS
+    if (ra->nb_workers)
+        pthread_mutex_lock(&ra->lock);
+#endif
+}
+
+static void ra_unlock(FFReadahead *ra)
+{
+#if USE_THREADS
+    if (ra->nb_workers)
+        pthread_mutex_unlock(&ra->lock);
+#endif
+}
+
+/* The functions below must be called with the lock held. */
+
+static int block_submit(FFReadahead *ra, ReadaheadBlock *b, int64_t index)
+{
+    b->index  = index;
+    b->ret    = 0;
+    b->cancel = 0;
+    b->gen++;
+#if HAVE_IO_URING
+    if (ra->ring_fd >= 0) {
+        b->state = BLOCK_BUSY;
+        uring_queue_read(ra, b);
+        return uring_enter(ra, 0);
+    }
+#endif
+#if USE_THREADS
+    b->state = BLOCK_QUEUED;
+    pthread_cond_signal(&ra->work_cond);
+#endif
+    return 0;
+}
+
+static int block_cancel(FFReadahead *ra, ReadaheadBlock *b)
+{
+    if (b->state == BLOCK_QUEUED) {
+        b->state = BLOCK_IDLE;
+    } else if (b->state == BLOCK_BUSY && !b->cancel) {
+        b->cancel = 1;
+#if HAVE_IO_URING
+        if (ra->ring_fd >= 0) {
+            uring_queue(ra, IORING_OP_ASYNC_CANCEL, READ_TAG(ra, b), 0, 0, CANCEL_TAG);
+            return uring_enter(ra, 0);
+        }
+#endif
+    }
+    return 0;
+}
+
+static int block_wait(FFReadahead *ra, ReadaheadBlock *b)
+{
+    while (b->state == BLOCK_QUEUED || b->state == BLOCK_BUSY) {
+#if HAVE_IO_URING
+        if (ra->ring_fd >= 0) {
+            int ret = uring_enter(ra, 1);
+            if (ret < 0)
+                return ret;
+            uring_reap(ra);
+            continue;
+        }
+#endif
+#if USE_THREADS
+        pthread_cond_wait(&ra->done_cond, &ra->lock);
+#endif
+    }
+    return 0;
+}
+
+/* Make sure the given block is held or being read */
+static int block_fetch(FFReadahead *ra, int64_t index)
+{
+    ReadaheadBlock *b = &ra->blocks[index % ra->nb_blocks];
+    int ret;
+
+    /* a block whose read is being cancelled ends up without its data */
+    if (b->index == index && b->state != BLOCK_IDLE && !b->cancel)
+        return 0;
+    if ((ret = block_cancel(ra, b)) < 0 ||
+        (ret = block_wait(ra, b)) < 0)
+        return ret;
+    return block_submit(ra, b, index);
+}
+
+/* Read from the block holding pos, up to its end */
+static int read_block_data(FFReadahead *ra, int64_t pos, uint8_t *buf, int size)
+{
+    int64_t index = pos / ra->block_size;
+    int offset    = pos % ra->block_size;
+    ReadaheadBlock *b = &ra->blocks[index % ra->nb_blocks];
+    int i, ret;
+
+    ra_lock(ra);
+    if (index < ra->window || index >= ra->window + ra->nb_blocks) {
+        /* seek: cancel the blocks outside the new window before priming it */
+        for (i = 0; i < ra->nb_blocks; i++) {
+            ReadaheadBlock *t = &ra->blocks[i];
+            if (t->index >= index && t->index < index + ra->nb_blocks)
+                continue;
+            if ((ret = block_cancel(ra, t)) < 0)
+                goto end;
+        }
+    }
+    ra->window = index;
+    for (i = 0; i < ra->nb_blocks; i++)
+        if ((ret = block_fetch(ra, index + i)) < 0)
+            goto end;
+    if ((ret = block_wait(ra, b)) < 0)
+        goto end;
+
+    /* the block was read up to the end of the file, which may have moved */
+    if (b->ret >= 0 && offset >= b->ret) {
+        if ((ret = block_submit(ra, b, index)) < 0 ||
+            (ret = block_wait(ra, b)) < 0)
+            goto end;
+    }
+
+    if (b->state != BLOCK_DONE) {
+        ret = AVERROR(EIO);
+    } else if (b->ret < 0) {
+        ret = b->ret;
+        b->state = BLOCK_IDLE;
+    } else if (offset >= b->ret) {
+        ret = AVERROR_EOF;
+    } else {
+        ret = FFMIN(size, b->ret - offset);
+    }
+end:
+    ra_unlock(ra);
+
+    /* a done block is only changed by this thread */
+    if (ret > 0)
+        memcpy(buf, b->data + offset, ret);
+    return ret;
+}
+
+int ff_readahead_read(FFReadahead *ra, int64_t pos, uint8_t *buf, int size)
+{
+    int done = 0;
+
+    while (done < size) {
+        int ret = read_block_data(ra, pos + done, buf + done, size - done);
+        if (ret < 0)
+            return done ? done : ret;
+        done += ret;
+    }
+    return done;
+}
+
+void ff_readahead_close(FFReadahead **pra)
+{
+    FFReadahead *ra = *pra;
+    int i;
+
+    if (!ra)
+        return;
+
+    ra_lock(ra);
+    for (i = 0; i < ra->nb_blocks; i++)
+        block_cancel(ra, &ra->blocks[i]);
+    for (i = 0; i < ra->nb_blocks; i++)
+        block_wait(ra, &ra->blocks[i]);
+    ra_unlock(ra);
+
+#if USE_THREADS
+    if (ra->nb_workers)
+        threads_uninit(ra);
+#endif
+#if HAVE_IO_URING
+    uring_uninit(ra);
+#endif
+
+    for (i = 0; i < ra->nb_blocks; i++)
+        av_freep(&ra->blocks[i].data);
+    av_freep(&ra->blocks);
+    av_freep(pra);
+}
+
+int ff_readahead_open(FFReadahead **pra, void *logctx, int fd,
+                      int nb_blocks, int block_size, int use_io_uring)
+{
+    FFReadahead *ra;
+    int i, ret = AVERROR(ENOSYS);
+
+    if (!HAVE_IO_URING && !USE_THREADS)
+        return AVERROR(ENOSYS);
+
+    ra = av_mallocz(sizeof(*ra));
+    if (!ra)
+        return AVERROR(ENOMEM);
+    ra->logctx     = logctx;
+    ra->fd         = fd;
+    ra->nb_blocks  = nb_blocks;
+    ra->block_size = block_size;
+#if HAVE_IO_URING
+    ra->ring_fd    = -1;
+#endif
+    *pra = ra;
+
+    ra->blocks = av_mallocz_array(nb_blocks, sizeof(*ra->blocks));
+    if (!ra->blocks)
+        goto fail_nomem;
+    ra->nb_blocks = 0;
+    for (i = 0; i < nb_blocks; i++) {
+        ReadaheadBlock *b = &ra->blocks[ra->nb_blocks++];
+        b->index = -1;
+        b->data  = av_malloc(block_size);
+        if (!b->data)
+            goto fail_nomem;
+    }
+
+#if HAVE_IO_URING
+    if (use_io_uring) {
+        if ((ret = uring_init(ra)) >= 0) {
+            av_log(logctx, AV_LOG_VERBOSE, "Reading ahead %d blocks of %d bytes with io_uring\n",
+                   nb_blocks, block_size);
+            return 0;
+        }
+        av_log(logctx, AV_LOG_VERBOSE, "io_uring unavailable: %s\n", av_err2str(ret));
+    }
+#endif
+#if USE_THREADS
+    if ((ret = threads_init(ra)) >= 0) {
+        av_log(logctx, AV_LOG_VERBOSE, "Reading ahead %d blocks of %d bytes with %d threads\n",
+               nb_blocks, block_size, ra->nb_workers);
+        return 0;
+    }
+#endif
+    ff_readahead_close(pra);
+    return ret;
+
+fail_nomem:
+    ff_readahead_close(pra);
+    return AVERROR(ENOMEM);
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_READAHEAD_H
+#define AVFORMAT_READAHEAD_H
+
+#include <stdint.h>
+
+/**
+ * Asynchronous readahead of a file descriptor.
+ *
+ * The file is read in blocks of block_size bytes at offsets aligned to
+ * block_size. A window of nb_blocks blocks, starting at the block of the
+ * last read, is kept in flight using io_uring when available and worker
+ * threads otherwise. Reading outside of the window cancels the pending
+ * reads and primes the window again at the new position.
+ */
+typedef struct FFReadahead FFReadahead;
+
+/**
+ * Start reading ahead fd, which must refer to a regular file opened for
+ * reading. The file offset of fd is neither used nor changed.
+ *
+ * @param use_io_uring try io_uring before falling back to worker threads
+ * @return 0 on success, AVERROR(ENOSYS) if readahead is not supported on
+ *         this system, another negative AVERROR code on failure
+ */
+int ff_readahead_open(FFReadahead **ra, void *logctx, int fd,
+                      int nb_blocks, int block_size, int use_io_uring);
+
+/**
+ * Read size bytes at pos, or fewer at the end of the file.
+ *
+ * @return the number of bytes read, AVERROR_EOF at the end of the file or
+ *         a negative AVERROR code on error
+ */
+int ff_readahead_read(FFReadahead *ra, int64_t pos, uint8_t *buf, int size);
+
+/**
+ * Cancel the pending reads and free the readahead context.
+ */
+void ff_readahead_close(FFReadahead **ra);
+
+#endif /* AVFORMAT_READAHEAD_H */
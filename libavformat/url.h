@@ -27,6 +27,7 @@
 #include "avio.h"
 #include "libavformat/version.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -86,6 +87,8 @@ typedef struct URLProtocol {
     int (*url_get_multi_file_handle)(URLContext *h, int **handles,
                                      int *numhandles);
     int (*url_get_short_seek)(URLContext *h);
+    int (*url_get_mapping)(URLContext *h, int64_t pos, int size,
+                           AVBufferRef **buf);
     int (*url_shutdown)(URLContext *h, int flags);
     const AVClass *priv_data_class;
     int priv_data_size;
@@ -254,6 +257,18 @@ int ffurl_get_multi_file_handle(URLContext *h, int **handles, int *numhandles);
  */
 int ffurl_get_short_seek(URLContext *h);
 
+/**
+ * Reference size bytes at pos of a memory mapping of this URL, without
+ * changing the read position. The returned buffer is read-only, its data
+ * points to the byte at pos, and at least AV_INPUT_BUFFER_PADDING_SIZE
+ * readable (but not necessarily zero) bytes follow the range, so packets
+ * referencing it may only be returned with AVFMT_FLAG_UNPADDED.
+ *
+ * @return 0 on success, AVERROR(ENOSYS) if the URL is not mapped or the
+ *         range is not covered by the mapping, another AVERROR on failure
+ */
+int ffurl_get_mapping(URLContext *h, int64_t pos, int size, AVBufferRef **buf);
+
 /**
  * Signal the URLContext that we are done reading or writing the stream.
  *
@@ -323,6 +323,32 @@ FF_ENABLE_DEPRECATION_WARNINGS
     return append_packet_chunked(s, pkt, size);
 }
 
+int ff_get_packet_mapped(AVFormatContext *s, AVIOContext *pb, AVPacket *pkt, int size)
+{
+    AVBufferRef *buf;
+    int64_t pos = avio_tell(pb);
+    int ret = s->flags & AVFMT_FLAG_UNPADDED ? ffio_read_mapped(pb, size, &buf)
+                                             : AVERROR(ENOSYS);
+
+    if (ret == AVERROR(ENOSYS))
+        return av_get_packet(pb, pkt, size);
+    if (ret < 0)
+        return ret;
+
+#if FF_API_INIT_PACKET
+FF_DISABLE_DEPRECATION_WARNINGS
+    av_init_packet(pkt);
+FF_ENABLE_DEPRECATION_WARNINGS
+#else
+    av_packet_unref(pkt);
+#endif
+    pkt->buf  = buf;
+    pkt->data = buf->data;
+    pkt->size = size;
+    pkt->pos  = pos;
+    return size;
+}
+
 int av_append_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
     if (!pkt->size)
@@ -4453,6 +4479,8 @@ static void free_stream(AVStream **pst)
         avcodec_free_context(&st->internal->avctx);
         av_bsf_free(&st->internal->bsfc);
         av_freep(&st->internal->priv_pts);
+        avpriv_packet_list_free(&st->internal->first_in_packet_buffer,
+                                &st->internal->last_in_packet_buffer);
         av_freep(&st->index_entries);
         av_freep(&st->internal->probe_data.buf);
 
@@ -4529,6 +4557,7 @@ void avformat_free_context(AVFormatContext *s)
     av_packet_free(&s->internal->pkt);
     av_packet_free(&s->internal->parse_pkt);
     av_freep(&s->streams);
+    av_freep(&s->internal->interleave_heap);
     flush_packet_queue(s);
     av_freep(&s->internal);
     av_freep(&s->url);
@@ -28,6 +28,7 @@
 
 #include <float.h>
 #include "attributes.h"
+#include "avassert.h"
 #include "avutil.h"
 #include "common.h"
 #include "eval.h"
@@ -174,6 +175,7 @@ struct AVExpr {
     } a;
     struct AVExpr *param[3];
     double *var;
+    struct ExprProgram *prog;
 };
 
 static double etime(double v)
@@ -331,6 +333,325 @@ static double eval_expr(Parser *p, AVExpr *e)
     return NAN;
 }
 
+/* Bytecode
+ *
+ * av_expr_parse() flattens the tree into a linear program over a small
+ * register file: each node writes its result to register r and its
+ * parameters to r, r+1 and r+2. Subtrees which do not depend on constants,
+ * variables or user functions are folded into a single load. if()/ifnot()
+ * evaluate only one branch through jumps when run on a single value; with
+ * the jumps ignored, both branches are computed and the select at the end
+ * picks the right one, which is how a whole array is evaluated at once. */
+
+#define MAX_REGS 32
+#define VEC_SIZE 32
+
+enum {
+    op_jz = e_sgn + 1,  ///< jump to target if src[0] is 0
+    op_jnz,             ///< jump to target if src[0] is not 0
+    op_jmp,
+    op_select,          ///< value * (src[0] ? src[1] : src[2])
+    op_select_not,      ///< value * (!src[0] ? src[1] : src[2])
+    op_tree,            ///< evaluate the tree of e
+};
+
+typedef struct ExprInsn {
+    int op;
+    int dst;
+    int src[3];
+    int index;              ///< constant index or jump target
+    double value;
+    const AVExpr *e;
+} ExprInsn;
+
+typedef struct ExprProgram {
+    ExprInsn *insns;
+    int nb_insns;
+    int nb_consts;          ///< highest constant index used + 1
+    int vectorizable;       ///< no side effects, see av_expr_eval_array()
+} ExprProgram;
+
+static int is_const_expr(const AVExpr *e)
+{
+    switch (e->type) {
+    case e_value:
+        return 1;
+    case e_const: case e_func1: case e_func2:
+    case e_ld: case e_st: case e_random: case e_print:
+    case e_while: case e_taylor: case e_root:
+        return 0;
+    case e_func0:
+        if (e->a.func0 == etime)
+            return 0;
+        /* fall through */
+    default:
+        for (int i = 0; i < 3; i++)
+            if (e->param[i] && !is_const_expr(e->param[i]))
+                return 0;
+        return 1;
+    }
+}
+
+static int emit(ExprProgram *prog, int op, const AVExpr *e, int dst)
+{
+    ExprInsn *insns, *in;
+
+    if (!(prog->nb_insns & (prog->nb_insns - 1))) {
+        insns = av_realloc_array(prog->insns, FFMAX(2 * prog->nb_insns, 16),
+                                 sizeof(*insns));
+        if (!insns)
+            return AVERROR(ENOMEM);
+        prog->insns = insns;
+    }
+    in = &prog->insns[prog->nb_insns];
+    memset(in, 0, sizeof(*in));
+    in->op     = op;
+    in->dst    = dst;
+    in->src[0] = in->src[1] = in->src[2] = dst;
+    in->value  = e ? e->value : 0;
+    in->e      = e;
+    return prog->nb_insns++;
+}
+
+static int compile_expr(ExprProgram *prog, const AVExpr *e, int r)
+{
+    int ret, i, jump, skip;
+
+    if (is_const_expr(e)) {
+        Parser p = { 0 };
+        if ((ret = emit(prog, e_value, NULL, r)) < 0)
+            return ret;
+        prog->insns[ret].value = eval_expr(&p, (AVExpr *)e);
+        return 0;
+    }
+
+    /* out of registers, the loops are left to the tree walker too */
+    if (r + 3 > MAX_REGS || e->type == e_while || e->type == e_taylor ||
+        e->type == e_root) {
+        prog->vectorizable = 0;
+        return FFMIN(emit(prog, op_tree, e, r), 0);
+    }
+
+    switch (e->type) {
+    case e_const:
+        if ((ret = emit(prog, e_const, e, r)) < 0)
+            return ret;
+        prog->insns[ret].index = e->const_index;
+        return 0;
+    case e_if:
+    case e_ifnot:
+        if ((ret = compile_expr(prog, e->param[0], r)) < 0 ||
+            (ret = jump = emit(prog, e->type == e_if ? op_jz : op_jnz, NULL, r)) < 0 ||
+            (ret = compile_expr(prog, e->param[1], r + 1)) < 0 ||
+            (ret = skip = emit(prog, op_jmp, NULL, r)) < 0)
+            return ret;
+        prog->insns[jump].index = prog->nb_insns;
+        if (e->param[2])
+            ret = compile_expr(prog, e->param[2], r + 2);
+        else
+            ret = emit(prog, e_value, NULL, r + 2);
+        if (ret < 0)
+            return ret;
+        prog->insns[skip].index = prog->nb_insns;
+        if ((ret = emit(prog, e->type == e_if ? op_select : op_select_not, e, r)) < 0)
+            return ret;
+        prog->insns[ret].src[1] = r + 1;
+        prog->insns[ret].src[2] = r + 2;
+        return 0;
+    case e_st:
+    case e_random:
+    case e_print:
+        prog->vectorizable = 0;
+        /* fall through */
+    default:
+        for (i = 0; i < 3 && e->param[i]; i++)
+            if ((ret = compile_expr(prog, e->param[i], r + i)) < 0)
+                return ret;
+        if ((ret = emit(prog, e->type, e, r)) < 0)
+            return ret;
+        while (i--)
+            prog->insns[ret].src[i] = r + i;
+        return 0;
+    }
+}
+
+static int count_consts(const AVExpr *e)
+{
+    int nb = e->type == e_const ? e->const_index + 1 : 0;
+
+    for (int i = 0; i < 3 && e->param[i]; i++)
+        nb = FFMAX(nb, count_consts(e->param[i]));
+    return nb;
+}
+
+static void free_program(ExprProgram **pprog)
+{
+    if (!*pprog)
+        return;
+    av_freep(&(*pprog)->insns);
+    av_freep(pprog);
+}
+
+static int compile_program(AVExpr *e)
+{
+    ExprProgram *prog = av_mallocz(sizeof(*prog));
+    int ret;
+
+    if (!prog)
+        return AVERROR(ENOMEM);
+    prog->vectorizable = 1;
+    prog->nb_consts    = count_consts(e);
+    if ((ret = compile_expr(prog, e, 0)) < 0) {
+        free_program(&prog);
+        return ret;
+    }
+    e->prog = prog;
+    return 0;
+}
+
+/* Same semantics as the corresponding nodes in eval_expr() */
+static av_always_inline double run_insn(Parser *p, int op, const ExprInsn *in,
+                                        double a, double b, double c)
+{
+    const double v = in->value;
+
+    switch (op) {
+    case e_func0:  return v * in->e->a.func0(a);
+    case e_func1:  return v * in->e->a.func1(p->opaque, a);
+    case e_func2:  return v * in->e->a.func2(p->opaque, a, b);
+    case e_squish: return 1/(1+exp(4*a));
+    case e_gauss:  return exp(-a*a/2)/sqrt(2*M_PI);
+    case e_ld:     return v * p->var[av_clip(a, 0, VARS-1)];
+    case e_isnan:  return v * !!isnan(a);
+    case e_isinf:  return v * !!isinf(a);
+    case e_floor:  return v * floor(a);
+    case e_ceil:   return v * ceil (a);
+    case e_trunc:  return v * trunc(a);
+    case e_round:  return v * round(a);
+    case e_sgn:    return v * FFDIFFSIGN(a, 0);
+    case e_sqrt:   return v * sqrt (a);
+    case e_not:    return v * (a == 0);
+    case e_clip:
+        if (isnan(b) || isnan(c) || isnan(a) || b > c)
+            return NAN;
+        return v * av_clipd(a, b, c);
+    case e_between: return v * (a >= b && a <= c);
+    case e_lerp:   return a + (b - a) * c;
+    case e_mod:    return v * (a - floor(b ? a / b : a * INFINITY) * b);
+    case e_gcd:    return v * av_gcd(a, b);
+    case e_max:    return v * (a >  b ?   a : b);
+    case e_min:    return v * (a <  b ?   a : b);
+    case e_eq:     return v * (a == b ? 1.0 : 0.0);
+    case e_gt:     return v * (a >  b ? 1.0 : 0.0);
+    case e_gte:    return v * (a >= b ? 1.0 : 0.0);
+    case e_lt:     return v * (a <  b ? 1.0 : 0.0);
+    case e_lte:    return v * (a <= b ? 1.0 : 0.0);
+    case e_pow:    return v * pow(a, b);
+    case e_mul:    return v * (a * b);
+    case e_div:    return v * (b ? (a / b) : a * INFINITY);
+    case e_add:    return v * (a + b);
+    case e_last:   return v * b;
+    case e_hypot:  return v * hypot(a, b);
+    case e_atan2:  return v * atan2(a, b);
+    case e_bitand: return isnan(a) || isnan(b) ? NAN : v * ((long int)a & (long int)b);
+    case e_bitor:  return isnan(a) || isnan(b) ? NAN : v * ((long int)a | (long int)b);
+    case op_select:     return v * (a ? b : c);
+    case op_select_not: return v * (!a ? b : c);
+    case e_st:     return v * (p->var[av_clip(a, 0, VARS-1)] = b);
+    case e_print: {
+        int level = in->e->param[1] ? av_clip(b, INT_MIN, INT_MAX) : AV_LOG_INFO;
+        av_log(p, level, "%f\n", a);
+        return a;
+    }
+    case e_random: {
+        int idx = av_clip(a, 0, VARS-1);
+        uint64_t r = isnan(p->var[idx]) ? 0 : p->var[idx];
+        r = r*1664525+1013904223;
+        p->var[idx] = r;
+        return v * (r * (1.0/UINT64_MAX));
+    }
+    }
+    return NAN;
+}
+
+static double run_program(Parser *p, const ExprProgram *prog)
+{
+    double r[MAX_REGS];
+
+    for (int pc = 0; pc < prog->nb_insns; pc++) {
+        const ExprInsn *in = &prog->insns[pc];
+
+        switch (in->op) {
+        case e_value: r[in->dst] = in->value;                                     break;
+        case e_const: r[in->dst] = in->value * p->const_values[in->index];        break;
+        case op_jz:   if (!r[in->src[0]]) pc = in->index - 1;                     break;
+        case op_jnz:  if ( r[in->src[0]]) pc = in->index - 1;                     break;
+        case op_jmp:  pc = in->index - 1;                                         break;
+        case op_tree: r[in->dst] = eval_expr(p, (AVExpr *)in->e);                 break;
+        default:
+            r[in->dst] = run_insn(p, in->op, in, r[in->src[0]], r[in->src[1]], r[in->src[2]]);
+        }
+    }
+
+    return r[0];
+}
+
+#define VEC_OP(op)                                                             \
+    case op:                                                                   \
+        for (int i = 0; i < n; i++)                                            \
+            d[i] = run_insn(p, op, in, a[i], b[i], c[i]);                      \
+        break;
+
+/* Runs all the instructions of a vectorizable program on n <= VEC_SIZE
+ * values, starting at index offset in const_arrays. */
+static void run_program_vec(Parser *p, const ExprProgram *prog, double *dst,
+                            int n, const double * const *const_arrays, int offset)
+{
+    double r[MAX_REGS][VEC_SIZE];
+
+    for (int pc = 0; pc < prog->nb_insns; pc++) {
+        const ExprInsn *in = &prog->insns[pc];
+        const double *a = r[in->src[0]], *b = r[in->src[1]], *c = r[in->src[2]];
+        double *d = r[in->dst];
+
+        switch (in->op) {
+        case e_value:
+            for (int i = 0; i < n; i++)
+                d[i] = in->value;
+            break;
+        case e_const: {
+            const double *src = const_arrays ? const_arrays[in->index] : NULL;
+            if (src) {
+                for (int i = 0; i < n; i++)
+                    d[i] = in->value * src[offset + i];
+            } else {
+                for (int i = 0; i < n; i++)
+                    d[i] = in->value * p->const_values[in->index];
+            }
+            break;
+        }
+        case op_jz:
+        case op_jnz:
+        case op_jmp:
+            break;
+        VEC_OP(e_func0)  VEC_OP(e_func1)   VEC_OP(e_func2)  VEC_OP(e_squish)
+        VEC_OP(e_gauss)  VEC_OP(e_ld)      VEC_OP(e_isnan)  VEC_OP(e_isinf)
+        VEC_OP(e_floor)  VEC_OP(e_ceil)    VEC_OP(e_trunc)  VEC_OP(e_round)
+        VEC_OP(e_sgn)    VEC_OP(e_sqrt)    VEC_OP(e_not)    VEC_OP(e_clip)
+        VEC_OP(e_between) VEC_OP(e_lerp)   VEC_OP(e_mod)    VEC_OP(e_gcd)
+        VEC_OP(e_max)    VEC_OP(e_min)     VEC_OP(e_eq)     VEC_OP(e_gt)
+        VEC_OP(e_gte)    VEC_OP(e_lt)      VEC_OP(e_lte)    VEC_OP(e_pow)
+        VEC_OP(e_mul)    VEC_OP(e_div)     VEC_OP(e_add)    VEC_OP(e_last)
+        VEC_OP(e_hypot)  VEC_OP(e_atan2)   VEC_OP(e_bitand) VEC_OP(e_bitor)
+        VEC_OP(op_select) VEC_OP(op_select_not)
+        default:
+            av_assert0(0);
+        }
+    }
+
+    memcpy(dst, r[0], n * sizeof(*dst));
+}
+
 static int parse_expr(AVExpr **e, Parser *p);
 
 void av_expr_free(AVExpr *e)
@@ -340,6 +661,7 @@ void av_expr_free(AVExpr *e)
     av_expr_free(e->param[1]);
     av_expr_free(e->param[2]);
     av_freep(&e->var);
+    free_program(&e->prog);
     av_freep(&e);
 }
 
@@ -729,6 +1051,8 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(ENOMEM);
         goto end;
     }
+    if ((ret = compile_program(e)) < 0)
+        goto end;
     *expr = e;
     e = NULL;
 end:
@@ -770,7 +1094,53 @@ double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
 
     p.const_values = const_values;
     p.opaque     = opaque;
-    return eval_expr(&p, e);
+    return e->prog ? run_program(&p, e->prog) : eval_expr(&p, e);
+}
+
+int av_expr_eval_array(AVExpr *e, double *dst, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    const ExprProgram *prog = e->prog;
+    double buf[16], *values = buf;
+    int nb_consts;
+
+    if (nb <= 0)
+        return nb < 0 ? AVERROR(EINVAL) : 0;
+
+    if (prog && prog->vectorizable) {
+        Parser p = { 0 };
+        p.var          = e->var;
+        p.const_values = const_values;
+        p.opaque       = opaque;
+        for (int i = 0; i < nb; i += VEC_SIZE)
+            run_program_vec(&p, prog, dst + i, FFMIN(nb - i, VEC_SIZE),
+                            const_arrays, i);
+        return 0;
+    }
+
+    /* one value at a time, in order, for the side effects */
+    if (!const_arrays) {
+        for (int i = 0; i < nb; i++)
+            dst[i] = av_expr_eval(e, const_values, opaque);
+        return 0;
+    }
+
+    nb_consts = prog ? prog->nb_consts : 0;
+    if (nb_consts > FF_ARRAY_ELEMS(buf) &&
+        !(values = av_malloc_array(nb_consts, sizeof(*values))))
+        return AVERROR(ENOMEM);
+    memcpy(values, const_values, nb_consts * sizeof(*values));
+    for (int i = 0; i < nb; i++) {
+        for (int j = 0; j < nb_consts; j++)
+            if (const_arrays[j])
+                values[j] = const_arrays[j][i];
+        dst[i] = av_expr_eval(e, values, opaque);
+    }
+    if (values != buf)
+        av_free(values);
+
+    return 0;
 }
 
 int av_expr_parse_and_eval(double *d, const char *s,
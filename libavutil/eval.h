@@ -86,6 +86,36 @@ int av_expr_parse(AVExpr **expr, const char *s,
  */
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque);
 
+/**
+ * Evaluate a previously parsed expression for several values of its
+ * constants at once, for example for all the pixels of a row.
+ *
+ * The i-th result is the value av_expr_eval() would return with the
+ * constant of index j set to const_arrays[j][i] if const_arrays[j] is not
+ * NULL, and to const_values[j] otherwise.
+ *
+ * Expressions without st(), random(), print(), while(), taylor() or root()
+ * are evaluated one operation at a time over the whole array, which is much
+ * faster than calling av_expr_eval() in a loop. Both branches of if() and
+ * ifnot() are evaluated then, and the functions from funcs1 and funcs2 may be
+ * called in any order, so they must not have side effects. Other expressions
+ * are evaluated one value after the other.
+ *
+ * @param dst array of nb values the results are written to
+ * @param nb number of values to evaluate
+ * @param const_values an array of values for the identifiers from
+ *                     av_expr_parse() const_names; the values of the
+ *                     constants set in const_arrays are ignored
+ * @param const_arrays NULL, or an array with an entry for each identifier
+ *                     from av_expr_parse() const_names, either NULL or
+ *                     pointing to nb values of this constant
+ * @param opaque a pointer which will be passed to all functions from funcs1 and funcs2
+ * @return 0 on success, a negative AVERROR code otherwise
+ */
+int av_expr_eval_array(AVExpr *e, double *dst, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque);
+
 /**
  * Track the presence of variables and their number of occurrences in a parsed expression
  *
@@ -0,0 +1,405 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "buffer_internal.h"
+#include "common.h"
+#include "framepool.h"
+#include "imgutils.h"
+#include "mem.h"
+#include "pixdesc.h"
+#include "thread.h"
+
+typedef struct FramePoolEntry {
+    AVBufferRef *backing;
+    size_t size;
+
+    struct AVFramePool *pool;
+    struct FramePoolEntry *next;
+} FramePoolEntry;
+
+struct AVFramePool {
+    AVMutex mutex;
+    FramePoolEntry *free_list;
+
+    /* Size of buffers for the current geometry; buffers of any other size
+     * are freed rather than recycled */
+    size_t size;
+    unsigned int min_frames;
+    unsigned int max_frames;
+    AVFramePoolStats stats;
+
+    /* 1 for the caller + 1 per buffer handed out */
+    atomic_uint refcount;
+
+    void *opaque;
+    AVBufferRef *(*alloc)(void *opaque, size_t size);
+    void (*pool_free)(void *opaque);
+};
+
+AVFramePool *av_frame_pool_init(void *opaque,
+                                AVBufferRef *(*alloc)(void *opaque, size_t size),
+                                void (*pool_free)(void *opaque))
+{
+    AVFramePool *pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return NULL;
+
+    if (ff_mutex_init(&pool->mutex, NULL)) {
+        av_free(pool);
+        return NULL;
+    }
+
+    pool->opaque    = opaque;
+    pool->alloc     = alloc;
+    pool->pool_free = pool_free;
+
+    atomic_init(&pool->refcount, 1);
+
+    return pool;
+}
+
+static void entry_free(FramePoolEntry *ent)
+{
+    av_buffer_unref(&ent->backing);
+    av_free(ent);
+}
+
+static void entry_free_list(FramePoolEntry *ent)
+{
+    while (ent) {
+        FramePoolEntry *next = ent->next;
+        entry_free(ent);
+        ent = next;
+    }
+}
+
+/* Called with the mutex held; the returned list must be freed once it is
+ * dropped */
+static FramePoolEntry *frame_pool_take_free_list(AVFramePool *pool)
+{
+    FramePoolEntry *list = pool->free_list;
+    FramePoolEntry *ent;
+
+    for (ent = list; ent; ent = ent->next) {
+        pool->stats.nb_allocated--;
+        pool->stats.flushed++;
+    }
+    pool->free_list = NULL;
+    return list;
+}
+
+/*
+ * This function gets called when the pool has been uninited and
+ * all the buffers returned to it.
+ */
+static void frame_pool_free(AVFramePool *pool)
+{
+    entry_free_list(pool->free_list);
+    ff_mutex_destroy(&pool->mutex);
+
+    if (pool->pool_free)
+        pool->pool_free(pool->opaque);
+
+    av_freep(&pool);
+}
+
+static void frame_pool_release(void *opaque, uint8_t *data)
+{
+    FramePoolEntry *ent = opaque;
+    AVFramePool *pool = ent->pool;
+    int discard;
+
+    ff_mutex_lock(&pool->mutex);
+    pool->stats.nb_in_use--;
+    discard = ent->size != pool->size;
+    if (discard) {
+        pool->stats.nb_allocated--;
+        pool->stats.flushed++;
+    } else {
+        ent->next = pool->free_list;
+        pool->free_list = ent;
+    }
+    ff_mutex_unlock(&pool->mutex);
+
+    if (discard)
+        entry_free(ent);
+
+    if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
+        frame_pool_free(pool);
+}
+
+static FramePoolEntry *entry_alloc(AVFramePool *pool, size_t size)
+{
+    FramePoolEntry *ent = av_mallocz(sizeof(*ent));
+    if (!ent)
+        return NULL;
+
+    ent->backing = pool->alloc ? pool->alloc(pool->opaque, size) :
+                                 av_buffer_alloc(size);
+    if (!ent->backing || (size_t)ent->backing->size < size) {
+        av_buffer_unref(&ent->backing);
+        av_free(ent);
+        return NULL;
+    }
+    ent->size = size;
+    ent->pool = pool;
+    return ent;
+}
+
+/* Bring the number of allocated buffers up to min_frames */
+static void frame_pool_prealloc(AVFramePool *pool, size_t size)
+{
+    FramePoolEntry *list = NULL;
+    unsigned int n = 0;
+
+    ff_mutex_lock(&pool->mutex);
+    if (pool->size == size && pool->stats.nb_allocated < pool->min_frames) {
+        n = pool->min_frames - pool->stats.nb_allocated;
+        pool->stats.nb_allocated += n;
+    }
+    ff_mutex_unlock(&pool->mutex);
+
+    for (; n; n--) {
+        FramePoolEntry *ent = entry_alloc(pool, size);
+        if (!ent)
+            break;
+        ent->next = list;
+        list = ent;
+    }
+
+    ff_mutex_lock(&pool->mutex);
+    pool->stats.nb_allocated -= n;
+    if (pool->size == size) {
+        while (list) {
+            FramePoolEntry *ent = list;
+            list = ent->next;
+            ent->next = pool->free_list;
+            pool->free_list = ent;
+        }
+    } else {
+        FramePoolEntry *ent;
+        for (ent = list; ent; ent = ent->next)
+            pool->stats.nb_allocated--;
+    }
+    ff_mutex_unlock(&pool->mutex);
+
+    entry_free_list(list);
+}
+
+int av_frame_pool_set_size(AVFramePool *pool, unsigned int min_frames,
+                           unsigned int max_frames)
+{
+    size_t size;
+
+    if (max_frames && min_frames > max_frames)
+        return AVERROR(EINVAL);
+
+    ff_mutex_lock(&pool->mutex);
+    pool->min_frames = min_frames;
+    pool->max_frames = max_frames;
+    size = pool->size;
+    ff_mutex_unlock(&pool->mutex);
+
+    if (size)
+        frame_pool_prealloc(pool, size);
+
+    return 0;
+}
+
+static AVBufferRef *frame_pool_get(AVFramePool *pool, size_t size, int *err)
+{
+    FramePoolEntry *flush = NULL;
+    FramePoolEntry *ent;
+    AVBufferRef *ret;
+    int resized = 0;
+
+    ff_mutex_lock(&pool->mutex);
+    if (pool->size != size) {
+        flush = frame_pool_take_free_list(pool);
+        pool->size = size;
+        resized = 1;
+    }
+    if ((ent = pool->free_list)) {
+        pool->free_list = ent->next;
+        ent->next = NULL;
+        pool->stats.hits++;
+    } else if (pool->max_frames && pool->stats.nb_allocated >= pool->max_frames) {
+        pool->stats.failed++;
+        ff_mutex_unlock(&pool->mutex);
+        entry_free_list(flush);
+        *err = AVERROR(EAGAIN);
+        return NULL;
+    } else {
+        /* Reserve our slot before dropping the lock to allocate */
+        pool->stats.nb_allocated++;
+        pool->stats.misses++;
+    }
+    pool->stats.nb_in_use++;
+    pool->stats.peak_in_use = FFMAX(pool->stats.peak_in_use, pool->stats.nb_in_use);
+    ff_mutex_unlock(&pool->mutex);
+
+    entry_free_list(flush);
+
+    if (!ent)
+        ent = entry_alloc(pool, size);
+
+    ret = ent ? av_buffer_create(ent->backing->data, size, frame_pool_release,
+                                 ent, 0) : NULL;
+    if (!ret) {
+        ff_mutex_lock(&pool->mutex);
+        pool->stats.nb_in_use--;
+        pool->stats.failed++;
+        if (ent && ent->size == pool->size) {
+            ent->next = pool->free_list;
+            pool->free_list = ent;
+            ent = NULL;
+        } else {
+            pool->stats.nb_allocated--;
+        }
+        ff_mutex_unlock(&pool->mutex);
+        if (ent)
+            entry_free(ent);
+        *err = AVERROR(ENOMEM);
+        return NULL;
+    }
+
+    atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
+
+    if (resized)
+        frame_pool_prealloc(pool, size);
+
+    return ret;
+}
+
+int av_frame_pool_get_video_buffer(AVFramePool *pool, AVFrame *frame,
+                                   int coded_width, int coded_height,
+                                   int align)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    const int width  = FFMAX(frame->width,  coded_width);
+    const int height = FFMAX(frame->height, coded_height);
+    int linesize[4] = { 0 };
+    ptrdiff_t linesizes[4];
+    size_t sizes[4];
+    size_t total_size;
+    int plane_padding;
+    uint8_t *data;
+    int ret, i;
+
+    if (!desc || desc->flags & AV_PIX_FMT_FLAG_HWACCEL)
+        return AVERROR(EINVAL);
+
+    if (align <= 0)
+        align = 64;
+    if (align & (align - 1))
+        return AVERROR(EINVAL);
+    plane_padding = FFMAX(16 + 16/*STRIDE_ALIGN*/, align);
+
+    if ((ret = av_image_check_size(width, height, 0, NULL)) < 0)
+        return ret;
+
+    for (i = 1; i <= align; i += i) {
+        ret = av_image_fill_linesizes(linesize, frame->format, FFALIGN(width, i));
+        if (ret < 0)
+            return ret;
+        if (!(linesize[0] & (align - 1)))
+            break;
+    }
+    for (i = 0; i < 4 && linesize[i]; i++)
+        linesize[i] = FFALIGN(linesize[i], align);
+
+    for (i = 0; i < 4; i++)
+        linesizes[i] = linesize[i];
+
+    if ((ret = av_image_fill_plane_sizes(sizes, frame->format, height, linesizes)) < 0)
+        return ret;
+
+    /* Room to align the start of the buffer as well as between planes */
+    total_size = 4 * plane_padding + align - 1;
+    for (i = 0; i < 4; i++) {
+        if (sizes[i] > INT_MAX - total_size)
+            return AVERROR(EINVAL);
+        total_size += sizes[i];
+    }
+
+    frame->buf[0] = frame_pool_get(pool, total_size, &ret);
+    if (!frame->buf[0])
+        return ret;
+
+    data = frame->buf[0]->data;
+    data += (align - ((uintptr_t)data & (align - 1))) & (align - 1);
+
+    if ((ret = av_image_fill_pointers(frame->data, frame->format, height,
+                                      data, linesize)) < 0) {
+        av_buffer_unref(&frame->buf[0]);
+        return ret;
+    }
+
+    for (i = 1; i < 4; i++) {
+        if (frame->data[i])
+            frame->data[i] += i * plane_padding;
+    }
+    for (i = 0; i < 4; i++)
+        frame->linesize[i] = linesize[i];
+
+    frame->extended_data = frame->data;
+
+    return 0;
+}
+
+const AVBufferRef *av_frame_pool_buffer_backing(const AVBufferRef *buf)
+{
+    const FramePoolEntry *ent;
+
+    if (!buf || buf->buffer->free != frame_pool_release)
+        return NULL;
+    ent = buf->buffer->opaque;
+    return ent->backing;
+}
+
+void av_frame_pool_get_stats(AVFramePool *pool, AVFramePoolStats *stats)
+{
+    ff_mutex_lock(&pool->mutex);
+    *stats = pool->stats;
+    stats->buffer_size = pool->size;
+    ff_mutex_unlock(&pool->mutex);
+}
+
+void av_frame_pool_uninit(AVFramePool **ppool)
+{
+    AVFramePool *pool;
+    FramePoolEntry *list;
+
+    if (!ppool || !*ppool)
+        return;
+    pool   = *ppool;
+    *ppool = NULL;
+
+    ff_mutex_lock(&pool->mutex);
+    list = frame_pool_take_free_list(pool);
+    ff_mutex_unlock(&pool->mutex);
+
+    entry_free_list(list);
+
+    if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
+        frame_pool_free(pool);
+}
@@ -0,0 +1,196 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * @ingroup lavu_framepool
+ * Pool of single-allocation video frame buffers
+ */
+
+#ifndef AVUTIL_FRAMEPOOL_H
+#define AVUTIL_FRAMEPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "buffer.h"
+#include "frame.h"
+
+/**
+ * @defgroup lavu_framepool AVFramePool
+ * @ingroup lavu_data
+ *
+ * @{
+ * AVFramePool hands out video frames whose planes all live in one buffer
+ * and recycles those buffers once every reference to them is gone.
+ *
+ * The memory behind each buffer may be supplied by the caller (e.g. a
+ * memfd or other shared memory that another process can map), so that a
+ * decoded frame can be passed on without copying. It is meant to be used
+ * from an AVCodecContext.get_buffer2() callback, e.g.
+ *
+ * @code
+ * static int get_buffer2(AVCodecContext *avctx, AVFrame *frame, int flags)
+ * {
+ *     AVFramePool *pool = avctx->opaque;
+ *     int w = frame->width, h = frame->height;
+ *     int linesize_align[AV_NUM_DATA_POINTERS];
+ *
+ *     if (avctx->codec_type != AVMEDIA_TYPE_VIDEO)
+ *         return avcodec_default_get_buffer2(avctx, frame, flags);
+ *     avcodec_align_dimensions2(avctx, &w, &h, linesize_align);
+ *     return av_frame_pool_get_video_buffer(pool, frame, w, h, 0);
+ * }
+ * @endcode
+ *
+ * The backing memory of a pool buffer can be found again from any frame
+ * that references it with av_frame_pool_buffer_backing().
+ *
+ * All functions may be called from multiple threads simultaneously.
+ */
+
+/**
+ * The frame pool. This structure is opaque and not meant to be accessed
+ * directly. It is allocated with av_frame_pool_init() and freed with
+ * av_frame_pool_uninit().
+ */
+typedef struct AVFramePool AVFramePool;
+
+/**
+ * Occupancy statistics for an AVFramePool, see av_frame_pool_get_stats().
+ */
+typedef struct AVFramePoolStats {
+    /**
+     * Size of each buffer for the current frame geometry.
+     */
+    size_t buffer_size;
+    /**
+     * Number of buffers currently allocated, both in use and free.
+     */
+    unsigned int nb_allocated;
+    /**
+     * Number of buffers currently referenced by frames.
+     */
+    unsigned int nb_in_use;
+    /**
+     * Highest value nb_in_use has reached.
+     */
+    unsigned int peak_in_use;
+    /**
+     * Number of requests satisfied from a free buffer.
+     */
+    uint64_t hits;
+    /**
+     * Number of requests that needed a new buffer to be allocated.
+     */
+    uint64_t misses;
+    /**
+     * Number of buffers freed because the frame geometry changed.
+     */
+    uint64_t flushed;
+    /**
+     * Number of requests that failed, either because max_frames buffers
+     * were already in use or because the allocator failed.
+     */
+    uint64_t failed;
+} AVFramePoolStats;
+
+/**
+ * Allocate and initialize a frame pool.
+ *
+ * @param opaque arbitrary user data passed to alloc and pool_free
+ * @param alloc a function that will be used to allocate the memory for a new
+ *              buffer of at least size bytes. The AVBufferRef it returns is
+ *              kept by the pool until the buffer is discarded and is what
+ *              av_frame_pool_buffer_backing() returns. May be NULL, then
+ *              av_buffer_alloc() is used.
+ * @param pool_free a function that will be called immediately before the pool
+ *                  is freed, i.e. after av_frame_pool_uninit() has been called
+ *                  and all buffers have been returned. May be NULL.
+ * @return newly created frame pool on success, NULL on error.
+ */
+AVFramePool *av_frame_pool_init(void *opaque,
+                                AVBufferRef *(*alloc)(void *opaque, size_t size),
+                                void (*pool_free)(void *opaque));
+
+/**
+ * Set the number of buffers the pool should hold.
+ *
+ * @param min_frames number of buffers to allocate up front whenever the frame
+ *                   geometry changes, so that the first min_frames requests
+ *                   do not have to wait for the allocator.
+ * @param max_frames maximum number of buffers that may be allocated at once;
+ *                   requests beyond that fail with AVERROR(EAGAIN).
+ *                   0 means no limit.
+ * @return 0 on success, a negative AVERROR on error.
+ */
+int av_frame_pool_set_size(AVFramePool *pool, unsigned int min_frames,
+                           unsigned int max_frames);
+
+/**
+ * Allocate a buffer from the pool for a video frame.
+ *
+ * frame->format, frame->width and frame->height must be set. On success
+ * frame->buf[0], frame->data and frame->linesize are filled in, all planes
+ * pointing into the single pool buffer.
+ *
+ * If the buffer size required differs from the previous request then all
+ * free buffers are discarded and buffers still in use are freed rather than
+ * recycled when they are returned.
+ *
+ * @param coded_width  width to allocate for, if larger than frame->width
+ * @param coded_height height to allocate for, if larger than frame->height
+ * @param align        required linesize and data pointer alignment, must be
+ *                     a power of 2. 0 selects a suitable default.
+ * @return 0 on success, a negative AVERROR on error.
+ */
+int av_frame_pool_get_video_buffer(AVFramePool *pool, AVFrame *frame,
+                                   int coded_width, int coded_height,
+                                   int align);
+
+/**
+ * Get the buffer returned by the pool's allocator that backs buf.
+ *
+ * @param buf any reference to a buffer handed out by an AVFramePool,
+ *            typically frame->buf[0]
+ * @return the backing buffer or NULL if buf does not belong to an AVFramePool.
+ *         The reference is owned by the pool and remains valid for as long as
+ *         buf does.
+ */
+const AVBufferRef *av_frame_pool_buffer_backing(const AVBufferRef *buf);
+
+/**
+ * Get a snapshot of the pool occupancy statistics.
+ */
+void av_frame_pool_get_stats(AVFramePool *pool, AVFramePoolStats *stats);
+
+/**
+ * Mark the pool as being available for freeing. It will actually be freed
+ * only once all the allocated buffers associated with the pool are released.
+ * Thus it is safe to call this function while some of the allocated buffers
+ * are still in use.
+ *
+ * @param pool pointer to the pool to be freed. It will be set to NULL.
+ */
+void av_frame_pool_uninit(AVFramePool **pool);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_FRAMEPOOL_H */
@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2018 Raspberry Pi (Trading) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AVUTIL_RPI_SAND_DSP_H
+#define AVUTIL_RPI_SAND_DSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Kernels that work on a column of lines within a single sand stripe.
+// src points at the first byte to convert, src_stride is the sand stride1
+// (the distance between lines within a stripe).
+// w is measured in source bytes and h in lines. The C versions accept any
+// whole number of source words; w passed to the function pointers must be
+// a multiple of 64 so SIMD versions need no tail handling.
+typedef struct RpiSandDSPContext {
+    // 3 x 10-bit values per 32-bit word -> 16-bit samples
+    void (*sand30_to_y16)(uint8_t *dst, ptrdiff_t dst_stride,
+                          const uint8_t *src, ptrdiff_t src_stride,
+                          int w, int h);
+    // As above but U & V interleaved -> 2 planes of 16-bit samples
+    void (*sand30_to_c16)(uint8_t *dst_u, ptrdiff_t dst_stride_u,
+                          uint8_t *dst_v, ptrdiff_t dst_stride_v,
+                          const uint8_t *src, ptrdiff_t src_stride,
+                          int w, int h);
+    // 3 x 10-bit values per 32-bit word -> top 8 bits of each
+    void (*sand30_to_y8)(uint8_t *dst, ptrdiff_t dst_stride,
+                         const uint8_t *src, ptrdiff_t src_stride,
+                         int w, int h);
+    // Interleaved 8-bit U & V -> 2 planes
+    void (*sand8_to_c8)(uint8_t *dst_u, ptrdiff_t dst_stride_u,
+                        uint8_t *dst_v, ptrdiff_t dst_stride_v,
+                        const uint8_t *src, ptrdiff_t src_stride,
+                        int w, int h);
+    // 16-bit samples -> 8-bit with rounding: (x + (1 << shr >> 1)) >> shr
+    // Only used with shr >= 1
+    void (*sand16_to_8)(uint8_t *dst, ptrdiff_t dst_stride,
+                        const uint8_t *src, ptrdiff_t src_stride,
+                        int w, int h, int shr);
+} RpiSandDSPContext;
+
+void ff_rpi_sand_dsp_init(RpiSandDSPContext *c);
+void ff_rpi_sand_dsp_init_x86(RpiSandDSPContext *c);
+
+#endif // AVUTIL_RPI_SAND_DSP_H
@@ -93,6 +93,28 @@ void FUNC(av_rpi_sand_to_planar_y)(uint8_t * dst, const unsigned int dst_stride,
     }
 }
 
+// Deinterleave a column of lines within a single stripe
+// w in bytes of interleave
+static void FUNC(sand_stripe_to_planar_c)(uint8_t * dst_u, const unsigned int dst_stride_u,
+                             uint8_t * dst_v, const unsigned int dst_stride_v,
+                             const uint8_t * src, unsigned int stride1,
+                             unsigned int w, unsigned int h)
+{
+#if PW == 1
+    sand8_stripe_to_c8(dst_u, dst_stride_u, dst_v, dst_stride_v, src, stride1, w, h);
+#else
+    for (unsigned int i = 0; i != h; ++i, dst_u += dst_stride_u, dst_v += dst_stride_v, src += stride1) {
+        pixel * du = (pixel *)dst_u;
+        pixel * dv = (pixel *)dst_v;
+        const pixel * p = (const pixel *)src;
+        for (unsigned int k = 0; k < w; k += 2 * PW) {
+            *du++ = *p++;
+            *dv++ = *p++;
+        }
+    }
+#endif
+}
+
 // x & w in bytes but not of interleave (i.e. offset = x*2 for U&V)
 
 void FUNC(av_rpi_sand_to_planar_c)(uint8_t * dst_u, const unsigned int dst_stride_u,
@@ -102,9 +124,9 @@ void FUNC(av_rpi_sand_to_planar_c)(uint8_t * dst_u, const unsigned int dst_strid
                              unsigned int _x, unsigned int y,
                              unsigned int _w, unsigned int h)
 {
-    const unsigned int x = _x * 2;
-    const unsigned int w = _w * 2;
+    const unsigned int x1 = (_x + _w) * 2;
     const unsigned int mask = stride1 - 1;
+    unsigned int x = _x * 2;
 
 #if PW == 1 && HAVE_SAND_ASM
     if (_x == 0) {
@@ -114,51 +136,15 @@ void FUNC(av_rpi_sand_to_planar_c)(uint8_t * dst_u, const unsigned int dst_strid
     }
 #endif
 
-    if ((x & ~mask) == ((x + w) & ~mask)) {
-        // All in one sand stripe
-        const uint8_t * p1 = src + (x & mask) + y * stride1 + (x & ~mask) * stride2;
-        for (unsigned int i = 0; i != h; ++i, dst_u += dst_stride_u, dst_v += dst_stride_v, p1 += stride1) {
-            pixel * du = (pixel *)dst_u;
-            pixel * dv = (pixel *)dst_v;
-            const pixel * p = (const pixel *)p1;
-            for (unsigned int k = 0; k < w; k += 2 * PW) {
-                *du++ = *p++;
-                *dv++ = *p++;
-            }
-        }
-    }
-    else
-    {
-        // Two+ stripe
-        const unsigned int sstride = stride1 * stride2;
-        const unsigned int sstride_p = (sstride - stride1) / PW;
-
-        const uint8_t * p1 = src + (x & mask) + y * stride1 + (x & ~mask) * stride2;
-        const uint8_t * p2 = p1 + sstride - (x & mask);
-        const unsigned int w1 = stride1 - (x & mask);
-        const unsigned int w3 = (x + w) & mask;
-        const unsigned int w2 = w - (w1 + w3);
+    // Work a stripe at a time so each column of lines stays in cache
+    while (x < x1) {
+        const unsigned int xe = FFMIN((x | mask) + 1, x1);
+        const unsigned int d_off = (x - _x * 2) / 2;
 
-        for (unsigned int i = 0; i != h; ++i, dst_u += dst_stride_u, dst_v += dst_stride_v, p1 += stride1, p2 += stride1) {
-            unsigned int j;
-            const pixel * p = (const pixel *)p1;
-            pixel * du = (pixel *)dst_u;
-            pixel * dv = (pixel *)dst_v;
-            for (unsigned int k = 0; k < w1; k += 2 * PW) {
-                *du++ = *p++;
-                *dv++ = *p++;
-            }
-            for (j = 0, p = (const pixel *)p2; j < w2; j += stride1, p += sstride_p) {
-                for (unsigned int k = 0; k < stride1; k += 2 * PW) {
-                    *du++ = *p++;
-                    *dv++ = *p++;
-                }
-            }
-            for (unsigned int k = 0; k < w3; k += 2 * PW) {
-                *du++ = *p++;
-                *dv++ = *p++;
-            }
-        }
+        FUNC(sand_stripe_to_planar_c)(dst_u + d_off, dst_stride_u, dst_v + d_off, dst_stride_v,
+                                      src + (x & mask) + y * stride1 + (x & ~mask) * stride2, stride1,
+                                      xe - x, h);
+        x = xe;
     }
 }
 
@@ -31,8 +31,12 @@ Authors: John Cox
 #include <stdint.h>
 #include <string.h>
 #include "rpi_sand_fns.h"
+#include "rpi_sand_dsp.h"
+#include "attributes.h"
 #include "avassert.h"
+#include "common.h"
 #include "frame.h"
+#include "thread.h"
 
 #if ARCH_ARM && HAVE_NEON
 #include "arm/rpi_sand_neon.h"
@@ -44,14 +48,6 @@ Authors: John Cox
 #define HAVE_SAND_ASM 0
 #endif
 
-#define PW 1
-#include "rpi_sand_fn_pw.h"
-#undef PW
-
-#define PW 2
-#include "rpi_sand_fn_pw.h"
-#undef PW
-
 #if 1
 // Simple round
 static void cpy16_to_8(uint8_t * dst, const uint8_t * _src, unsigned int n, const unsigned int shr)
@@ -78,6 +74,193 @@ static void cpy16_to_8(uint8_t * dst, const uint8_t * _src, unsigned int n, cons
 }
 #endif
 
+static void sand30_to_y16_c(uint8_t * dst, ptrdiff_t dst_stride,
+                            const uint8_t * src, ptrdiff_t src_stride,
+                            int w, int h)
+{
+    for (int i = 0; i != h; ++i, dst += dst_stride, src += src_stride) {
+        const uint32_t * p = (const uint32_t *)src;
+        uint16_t * d = (uint16_t *)dst;
+
+        for (int x = 0; x < w; x += 4) {
+            const uint32_t p3 = *p++;
+            *d++ = p3 & 0x3ff;
+            *d++ = (p3 >> 10) & 0x3ff;
+            *d++ = (p3 >> 20) & 0x3ff;
+        }
+    }
+}
+
+static void sand30_to_c16_c(uint8_t * dst_u, ptrdiff_t dst_stride_u,
+                            uint8_t * dst_v, ptrdiff_t dst_stride_v,
+                            const uint8_t * src, ptrdiff_t src_stride,
+                            int w, int h)
+{
+    for (int i = 0; i != h; ++i, dst_u += dst_stride_u, dst_v += dst_stride_v, src += src_stride) {
+        const uint32_t * p = (const uint32_t *)src;
+        uint16_t * du = (uint16_t *)dst_u;
+        uint16_t * dv = (uint16_t *)dst_v;
+
+        for (int x = 0; x < w; x += 8) {
+            const uint32_t p3a = *p++;
+            const uint32_t p3b = *p++;
+
+            *du++ = p3a & 0x3ff;
+            *dv++ = (p3a >> 10) & 0x3ff;
+            *du++ = (p3a >> 20) & 0x3ff;
+            *dv++ = p3b & 0x3ff;
+            *du++ = (p3b >> 10) & 0x3ff;
+            *dv++ = (p3b >> 20) & 0x3ff;
+        }
+    }
+}
+
+static void sand30_to_y8_c(uint8_t * dst, ptrdiff_t dst_stride,
+                           const uint8_t * src, ptrdiff_t src_stride,
+                           int w, int h)
+{
+    for (int i = 0; i != h; ++i, dst += dst_stride, src += src_stride) {
+        const uint32_t * p = (const uint32_t *)src;
+        uint8_t * d = dst;
+
+        for (int x = 0; x < w; x += 4) {
+            const uint32_t p3 = *p++;
+            *d++ = (p3 >> 2) & 0xff;
+            *d++ = (p3 >> 12) & 0xff;
+            *d++ = (p3 >> 22) & 0xff;
+        }
+    }
+}
+
+static void sand8_to_c8_c(uint8_t * dst_u, ptrdiff_t dst_stride_u,
+                          uint8_t * dst_v, ptrdiff_t dst_stride_v,
+                          const uint8_t * src, ptrdiff_t src_stride,
+                          int w, int h)
+{
+    for (int i = 0; i != h; ++i, dst_u += dst_stride_u, dst_v += dst_stride_v, src += src_stride) {
+        const uint8_t * p = src;
+        uint8_t * du = dst_u;
+        uint8_t * dv = dst_v;
+
+        for (int x = 0; x < w; x += 2) {
+            *du++ = *p++;
+            *dv++ = *p++;
+        }
+    }
+}
+
+static void sand16_to_8_c(uint8_t * dst, ptrdiff_t dst_stride,
+                          const uint8_t * src, ptrdiff_t src_stride,
+                          int w, int h, int shr)
+{
+    for (int i = 0; i != h; ++i, dst += dst_stride, src += src_stride)
+        cpy16_to_8(dst, src, w / 2, shr);
+}
+
+av_cold void ff_rpi_sand_dsp_init(RpiSandDSPContext * c)
+{
+    c->sand30_to_y16 = sand30_to_y16_c;
+    c->sand30_to_c16 = sand30_to_c16_c;
+    c->sand30_to_y8  = sand30_to_y8_c;
+    c->sand8_to_c8   = sand8_to_c8_c;
+    c->sand16_to_8   = sand16_to_8_c;
+
+#if ARCH_X86
+    ff_rpi_sand_dsp_init_x86(c);
+#endif
+}
+
+static RpiSandDSPContext sand_dsp;
+static AVOnce sand_dsp_once = AV_ONCE_INIT;
+
+static av_cold void sand_dsp_init_once(void)
+{
+    ff_rpi_sand_dsp_init(&sand_dsp);
+}
+
+static const RpiSandDSPContext * get_sand_dsp(void)
+{
+    ff_thread_once(&sand_dsp_once, sand_dsp_init_once);
+    return &sand_dsp;
+}
+
+// The stripe fns below take a column of lines within a single stripe
+// The bulk goes through the dsp fns (which may be SIMD and want w to be
+// a multiple of 64), any remainder is done in C
+
+static void sand30_stripe_to_y16(uint8_t * dst, const unsigned int dst_stride,
+                                 const uint8_t * src, const unsigned int stride1,
+                                 const unsigned int w, const unsigned int h)
+{
+    const unsigned int w1 = w & ~63;
+
+    if (w1 != 0)
+        get_sand_dsp()->sand30_to_y16(dst, dst_stride, src, stride1, w1, h);
+    if (w1 != w)
+        sand30_to_y16_c(dst + w1 / 4 * 6, dst_stride, src + w1, stride1, w - w1, h);
+}
+
+static void sand30_stripe_to_c16(uint8_t * dst_u, const unsigned int dst_stride_u,
+                                 uint8_t * dst_v, const unsigned int dst_stride_v,
+                                 const uint8_t * src, const unsigned int stride1,
+                                 const unsigned int w, const unsigned int h)
+{
+    const unsigned int w1 = w & ~63;
+
+    if (w1 != 0)
+        get_sand_dsp()->sand30_to_c16(dst_u, dst_stride_u, dst_v, dst_stride_v, src, stride1, w1, h);
+    if (w1 != w)
+        sand30_to_c16_c(dst_u + w1 / 8 * 6, dst_stride_u, dst_v + w1 / 8 * 6, dst_stride_v,
+                        src + w1, stride1, w - w1, h);
+}
+
+static void sand30_stripe_to_y8(uint8_t * dst, const unsigned int dst_stride,
+                                const uint8_t * src, const unsigned int stride1,
+                                const unsigned int w, const unsigned int h)
+{
+    const unsigned int w1 = w & ~63;
+
+    if (w1 != 0)
+        get_sand_dsp()->sand30_to_y8(dst, dst_stride, src, stride1, w1, h);
+    if (w1 != w)
+        sand30_to_y8_c(dst + w1 / 4 * 3, dst_stride, src + w1, stride1, w - w1, h);
+}
+
+static void sand8_stripe_to_c8(uint8_t * dst_u, const unsigned int dst_stride_u,
+                               uint8_t * dst_v, const unsigned int dst_stride_v,
+                               const uint8_t * src, const unsigned int stride1,
+                               const unsigned int w, const unsigned int h)
+{
+    const unsigned int w1 = w & ~63;
+
+    if (w1 != 0)
+        get_sand_dsp()->sand8_to_c8(dst_u, dst_stride_u, dst_v, dst_stride_v, src, stride1, w1, h);
+    if (w1 != w)
+        sand8_to_c8_c(dst_u + w1 / 2, dst_stride_u, dst_v + w1 / 2, dst_stride_v,
+                      src + w1, stride1, w - w1, h);
+}
+
+// w in bytes of src
+static void sand16_stripe_to_8(uint8_t * dst, const unsigned int dst_stride,
+                               const uint8_t * src, const unsigned int stride1,
+                               const unsigned int w, const unsigned int h, const unsigned int shr)
+{
+    const unsigned int w1 = shr == 0 ? 0 : w & ~63;
+
+    if (w1 != 0)
+        get_sand_dsp()->sand16_to_8(dst, dst_stride, src, stride1, w1, h, shr);
+    if (w1 != w)
+        sand16_to_8_c(dst + w1 / 2, dst_stride, src + w1, stride1, w - w1, h, shr);
+}
+
+#define PW 1
+#include "rpi_sand_fn_pw.h"
+#undef PW
+
+#define PW 2
+#include "rpi_sand_fn_pw.h"
+#undef PW
+
 // Fetches a single patch - offscreen fixup not done here
 // w <= stride1
 // unclipped
@@ -93,8 +276,7 @@ void av_rpi_sand30_to_planar_y16(uint8_t * dst, const unsigned int dst_stride,
     const unsigned int x1 = ((_x + _w) / 3) * 4;
     const unsigned int xrem1 = _x + _w - (x1 >> 2) * 3;
     const unsigned int mask = stride1 - 1;
-    const uint8_t * p0 = src + (x0 & mask) + y * stride1 + (x0 & ~mask) * stride2;
-    const unsigned int slice_inc = ((stride2 - 1) * stride1) >> 2;  // RHS of a stripe to LHS of next in words
+    unsigned int x;
 
 #if HAVE_SAND_ASM
     if (_x == 0) {
@@ -104,45 +286,57 @@ void av_rpi_sand30_to_planar_y16(uint8_t * dst, const unsigned int dst_stride,
 #endif
 
     if (x0 == x1) {
-        // *******************
         // Partial single word xfer
-        return;
-    }
-
-    for (unsigned int i = 0; i != h; ++i, dst += dst_stride, p0 += stride1)
-    {
-        unsigned int x = x0;
-        const uint32_t * p = (const uint32_t *)p0;
-        uint16_t * d = (uint16_t *)dst;
-
-        if (xskip0 != 0) {
-            const uint32_t p3 = *p++;
+        const uint8_t * p0 = src + (x0 & mask) + y * stride1 + (x0 & ~mask) * stride2;
 
-            if (xskip0 == 1)
-                *d++ = (p3 >> 10) & 0x3ff;
-            *d++ = (p3 >> 20) & 0x3ff;
+        for (unsigned int i = 0; i != h; ++i, dst += dst_stride, p0 += stride1)
+        {
+            const uint32_t p3 = *(const uint32_t *)p0;
+            uint16_t * d = (uint16_t *)dst;
 
-            if (((x += 4) & mask) == 0)
-                p += slice_inc;
+            for (unsigned int k = xskip0; k != xrem1; ++k)
+                *d++ = (p3 >> (k * 10)) & 0x3ff;
         }
+        return;
+    }
 
-        while (x != x1) {
-            const uint32_t p3 = *p++;
-            *d++ = p3 & 0x3ff;
-            *d++ = (p3 >> 10) & 0x3ff;
-            *d++ = (p3 >> 20) & 0x3ff;
+    // Partial words at either end
+    if (xskip0 != 0 || xrem1 != 0) {
+        const uint8_t * p0 = src + (x0 & mask) + y * stride1 + (x0 & ~mask) * stride2;
+        const uint8_t * p1 = src + (x1 & mask) + y * stride1 + (x1 & ~mask) * stride2;
+        uint8_t * d0 = dst;
+        uint8_t * d1 = dst + ((x1 >> 2) * 3 - _x) * 2;
+
+        for (unsigned int i = 0; i != h; ++i, d0 += dst_stride, d1 += dst_stride, p0 += stride1, p1 += stride1)
+        {
+            if (xskip0 != 0) {
+                const uint32_t p3 = *(const uint32_t *)p0;
+                uint16_t * d = (uint16_t *)d0;
+
+                if (xskip0 == 1)
+                    *d++ = (p3 >> 10) & 0x3ff;
+                *d++ = (p3 >> 20) & 0x3ff;
+            }
+
+            if (xrem1 != 0) {
+                const uint32_t p3 = *(const uint32_t *)p1;
+                uint16_t * d = (uint16_t *)d1;
 
-            if (((x += 4) & mask) == 0)
-                p += slice_inc;
+                *d++ = p3 & 0x3ff;
+                if (xrem1 == 2)
+                    *d++ = (p3 >> 10) & 0x3ff;
+            }
         }
+    }
 
-        if (xrem1 != 0) {
-            const uint32_t p3 = *p;
+    // Whole words a stripe at a time
+    for (x = xskip0 != 0 ? x0 + 4 : x0; x < x1;) {
+        const unsigned int xe = FFMIN((x | mask) + 1, x1);
 
-            *d++ = p3 & 0x3ff;
-            if (xrem1 == 2)
-                *d++ = (p3 >> 10) & 0x3ff;
-        }
+        sand30_stripe_to_y16(dst + ((x >> 2) * 3 - _x) * 2, dst_stride,
+                             src + (x & mask) + y * stride1 + (x & ~mask) * stride2, stride1,
+                             xe - x, h);
+        x = xe;
     }
 }
 
@@ -159,8 +353,7 @@ void av_rpi_sand30_to_planar_c16(uint8_t * dst_u, const unsigned int dst_stride_
     const unsigned int x1 = ((_x + _w) / 3) * 8;
     const unsigned int xrem1 = _x + _w - (x1 >> 3) * 3;
     const unsigned int mask = stride1 - 1;
-    const uint8_t * p0 = src + (x0 & mask) + y * stride1 + (x0 & ~mask) * stride2;
-    const unsigned int slice_inc = ((stride2 - 1) * stride1) >> 2;  // RHS of a stripe to LHS of next in words
+    unsigned int x;
 
 #if HAVE_SAND_ASM
     if (_x == 0) {
@@ -171,61 +364,76 @@ void av_rpi_sand30_to_planar_c16(uint8_t * dst_u, const unsigned int dst_stride_
 #endif
 
     if (x0 == x1) {
-        // *******************
-        // Partial single word xfer
-        return;
-    }
-
-    for (unsigned int i = 0; i != h; ++i, dst_u += dst_stride_u, dst_v += dst_stride_v, p0 += stride1)
-    {
-        unsigned int x = x0;
-        const uint32_t * p = (const uint32_t *)p0;
-        uint16_t * du = (uint16_t *)dst_u;
-        uint16_t * dv = (uint16_t *)dst_v;
+        // Partial single word pair xfer
+        const uint8_t * p0 = src + (x0 & mask) + y * stride1 + (x0 & ~mask) * stride2;
 
-        if (xskip0 != 0) {
-            const uint32_t p3a = *p++;
-            const uint32_t p3b = *p++;
+        for (unsigned int i = 0; i != h; ++i, dst_u += dst_stride_u, dst_v += dst_stride_v, p0 += stride1)
+        {
+            const uint32_t * const p3 = (const uint32_t *)p0;
+            uint16_t * du = (uint16_t *)dst_u;
+            uint16_t * dv = (uint16_t *)dst_v;
 
-            if (xskip0 == 1)
+            // U & V alternate so sample n of the pair is in word n / 3
+            for (unsigned int k = xskip0 * 2; k != xrem1 * 2; k += 2)
             {
-                *du++ = (p3a >> 20) & 0x3ff;
-                *dv++ = (p3b >>  0) & 0x3ff;
+                *du++ = (p3[k / 3] >> ((k % 3) * 10)) & 0x3ff;
+                *dv++ = (p3[(k + 1) / 3] >> (((k + 1) % 3) * 10)) & 0x3ff;
             }
-            *du++ = (p3b >> 10) & 0x3ff;
-            *dv++ = (p3b >> 20) & 0x3ff;
-
-            if (((x += 8) & mask) == 0)
-                p += slice_inc;
         }
+        return;
+    }
 
-        while (x != x1) {
-            const uint32_t p3a = *p++;
-            const uint32_t p3b = *p++;
-
-            *du++ = p3a & 0x3ff;
-            *dv++ = (p3a >> 10) & 0x3ff;
-            *du++ = (p3a >> 20) & 0x3ff;
-            *dv++ = p3b & 0x3ff;
-            *du++ = (p3b >> 10) & 0x3ff;
-            *dv++ = (p3b >> 20) & 0x3ff;
+    // Partial word pairs at either end
+    if (xskip0 != 0 || xrem1 != 0) {
+        const uint8_t * p0 = src + (x0 & mask) + y * stride1 + (x0 & ~mask) * stride2;
+        const uint8_t * p1 = src + (x1 & mask) + y * stride1 + (x1 & ~mask) * stride2;
+        const unsigned int d1_off = ((x1 >> 3) * 3 - _x) * 2;
+        uint8_t * du0 = dst_u;
+        uint8_t * dv0 = dst_v;
+
+        for (unsigned int i = 0; i != h; ++i, du0 += dst_stride_u, dv0 += dst_stride_v, p0 += stride1, p1 += stride1)
+        {
+            if (xskip0 != 0) {
+                const uint32_t p3a = ((const uint32_t *)p0)[0];
+                const uint32_t p3b = ((const uint32_t *)p0)[1];
+                uint16_t * du = (uint16_t *)du0;
+                uint16_t * dv = (uint16_t *)dv0;
+
+                if (xskip0 == 1)
+                {
+                    *du++ = (p3a >> 20) & 0x3ff;
+                    *dv++ = (p3b >>  0) & 0x3ff;
+                }
+                *du++ = (p3b >> 10) & 0x3ff;
+                *dv++ = (p3b >> 20) & 0x3ff;
+            }
 
-            if (((x += 8) & mask) == 0)
-                p += slice_inc;
+            if (xrem1 != 0) {
+                const uint32_t p3a = ((const uint32_t *)p1)[0];
+                const uint32_t p3b = ((const uint32_t *)p1)[1];
+                uint16_t * du = (uint16_t *)(du0 + d1_off);
+                uint16_t * dv = (uint16_t *)(dv0 + d1_off);
+
+                *du++ = p3a & 0x3ff;
+                *dv++ = (p3a >> 10) & 0x3ff;
+                if (xrem1 == 2)
+                {
+                    *du++ = (p3a >> 20) & 0x3ff;
+                    *dv++ = p3b & 0x3ff;
+                }
+            }
         }
+    }
 
-        if (xrem1 != 0) {
-            const uint32_t p3a = *p++;
-            const uint32_t p3b = *p++;
+    // Whole word pairs a stripe at a time
+    for (x = xskip0 != 0 ? x0 + 8 : x0; x < x1;) {
+        const unsigned int xe = FFMIN((x | mask) + 1, x1);
+        const unsigned int d_off = ((x >> 3) * 3 - _x) * 2;
 
-            *du++ = p3a & 0x3ff;
-            *dv++ = (p3a >> 10) & 0x3ff;
-            if (xrem1 == 2)
-            {
-                *du++ = (p3a >> 20) & 0x3ff;
-                *dv++ = p3b & 0x3ff;
-            }
-        }
+        sand30_stripe_to_c16(dst_u + d_off, dst_stride_u, dst_v + d_off, dst_stride_v,
+                             src + (x & mask) + y * stride1 + (x & ~mask) * stride2, stride1,
+                             xe - x, h);
+        x = xe;
     }
 }
 
@@ -244,8 +452,7 @@ void av_rpi_sand30_to_planar_y8(uint8_t * dst, const unsigned int dst_stride,
     const unsigned int x1 = ((_x + _w) / 3) * 4;
     const unsigned int xrem1 = _x + _w - (x1 >> 2) * 3;
     const unsigned int mask = stride1 - 1;
-    const uint8_t * p0 = src + (x0 & mask) + y * stride1 + (x0 & ~mask) * stride2;
-    const unsigned int slice_inc = ((stride2 - 1) * stride1) >> 2;  // RHS of a stripe to LHS of next in words
+    unsigned int x;
 
 #if HAVE_SAND_ASM
     if (_x == 0) {
@@ -255,45 +462,57 @@ void av_rpi_sand30_to_planar_y8(uint8_t * dst, const unsigned int dst_stride,
 #endif
 
     if (x0 == x1) {
-        // *******************
         // Partial single word xfer
-        return;
-    }
+        const uint8_t * p0 = src + (x0 & mask) + y * stride1 + (x0 & ~mask) * stride2;
 
-    for (unsigned int i = 0; i != h; ++i, dst += dst_stride, p0 += stride1)
-    {
-        unsigned int x = x0;
-        const uint32_t * p = (const uint32_t *)p0;
-        uint8_t * d = dst;
-
-        if (xskip0 != 0) {
-            const uint32_t p3 = *p++;
-
-            if (xskip0 == 1)
-                *d++ = (p3 >> 12) & 0xff;
-            *d++ = (p3 >> 22) & 0xff;
+        for (unsigned int i = 0; i != h; ++i, dst += dst_stride, p0 += stride1)
+        {
+            const uint32_t p3 = *(const uint32_t *)p0;
+            uint8_t * d = dst;
 
-            if (((x += 4) & mask) == 0)
-                p += slice_inc;
+            for (unsigned int k = xskip0; k != xrem1; ++k)
+                *d++ = (p3 >> (k * 10 + 2)) & 0xff;
         }
+        return;
+    }
 
-        while (x != x1) {
-            const uint32_t p3 = *p++;
-            *d++ = (p3 >> 2) & 0xff;
-            *d++ = (p3 >> 12) & 0xff;
-            *d++ = (p3 >> 22) & 0xff;
+    // Partial words at either end
+    if (xskip0 != 0 || xrem1 != 0) {
+        const uint8_t * p0 = src + (x0 & mask) + y * stride1 + (x0 & ~mask) * stride2;
+        const uint8_t * p1 = src + (x1 & mask) + y * stride1 + (x1 & ~mask) * stride2;
+        uint8_t * d0 = dst;
+        uint8_t * d1 = dst + (x1 >> 2) * 3 - _x;
+
+        for (unsigned int i = 0; i != h; ++i, d0 += dst_stride, d1 += dst_stride, p0 += stride1, p1 += stride1)
+        {
+            if (xskip0 != 0) {
+                const uint32_t p3 = *(const uint32_t *)p0;
+                uint8_t * d = d0;
+
+                if (xskip0 == 1)
+                    *d++ = (p3 >> 12) & 0xff;
+                *d++ = (p3 >> 22) & 0xff;
+            }
+
+            if (xrem1 != 0) {
+                const uint32_t p3 = *(const uint32_t *)p1;
+                uint8_t * d = d1;
 
-            if (((x += 4) & mask) == 0)
-                p += slice_inc;
+                *d++ = (p3 >> 2) & 0xff;
+                if (xrem1 == 2)
+                    *d++ = (p3 >> 12) & 0xff;
+            }
         }
+    }
 
-        if (xrem1 != 0) {
-            const uint32_t p3 = *p;
+    // Whole words a stripe at a time
+    for (x = xskip0 != 0 ? x0 + 4 : x0; x < x1;) {
+        const unsigned int xe = FFMIN((x | mask) + 1, x1);
 
-            *d++ = (p3 >> 2) & 0xff;
-            if (xrem1 == 2)
-                *d++ = (p3 >> 12) & 0xff;
-        }
+        sand30_stripe_to_y8(dst + (x >> 2) * 3 - _x, dst_stride,
+                            src + (x & mask) + y * stride1 + (x & ~mask) * stride2, stride1,
+                            xe - x, h);
+        x = xe;
     }
 }
 
@@ -333,10 +552,8 @@ void av_rpi_sand16_to_sand8(uint8_t * dst, const unsigned int dst_stride1, const
             const uint8_t * s1 = src + j * 2 * src_stride2;
             const uint8_t * s2 = s1 + src_stride1 * src_stride2;
 
-            for (unsigned int i = 0; i != h; ++i, s1 += src_stride1, s2 += src_stride1, d += dst_stride1) {
-                cpy16_to_8(d, s1, n, shr);
-                cpy16_to_8(d + n, s2, n, shr);
-            }
+            sand16_stripe_to_8(d, dst_stride1, s1, src_stride1, src_stride1, h, shr);
+            sand16_stripe_to_8(d + n, dst_stride1, s2, src_stride1, src_stride1, h, shr);
         }
     }
 
@@ -345,49 +562,47 @@ void av_rpi_sand16_to_sand8(uint8_t * dst, const unsigned int dst_stride1, const
         uint8_t * d = dst + j * dst_stride2;
         const uint8_t * s1 = src + j * 2 * src_stride2;
 
-        for (unsigned int i = 0; i != h; ++i, s1 += src_stride1, d += dst_stride1) {
-            cpy16_to_8(d, s1, n, shr);
-        }
+        sand16_stripe_to_8(d, dst_stride1, s1, src_stride1, src_stride1, h, shr);
     }
 }
 
-int av_rpi_sand_to_planar_frame(AVFrame * const dst, const AVFrame * const src)
+int av_rpi_sand_to_planar_frame_rect(AVFrame * const dst, const AVFrame * const src,
+                                     const unsigned int x, const unsigned int y,
+                                     const unsigned int w, const unsigned int h)
 {
-    const int w = av_frame_cropped_width(src);
-    const int h = av_frame_cropped_height(src);
-    const int x = src->crop_left;
-    const int y = src->crop_top;
-
-    // We will crop as part of the conversion
-    dst->crop_top = 0;
-    dst->crop_left = 0;
-    dst->crop_bottom = 0;
-    dst->crop_right = 0;
+    // Source coords include any cropping
+    const unsigned int sx = src->crop_left + x;
+    const unsigned int sy = src->crop_top + y;
+    const unsigned int stride1 = av_rpi_sand_frame_stride1(src);
+    const unsigned int stride2 = av_rpi_sand_frame_stride2(src);
+    // Chroma rows & cols - round the far edge down as whole frame conversion always has
+    const unsigned int cy = y / 2;
+    const unsigned int ch = (y + h) / 2 - cy;
 
     switch (src->format){
         case AV_PIX_FMT_SAND128:
         case AV_PIX_FMT_RPI4_8:
             switch (dst->format){
                 case AV_PIX_FMT_YUV420P:
-                    av_rpi_sand_to_planar_y8(dst->data[0], dst->linesize[0],
+                    av_rpi_sand_to_planar_y8(dst->data[0] + y * dst->linesize[0] + x, dst->linesize[0],
                                              src->data[0],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x, y, w, h);
-                    av_rpi_sand_to_planar_c8(dst->data[1], dst->linesize[1],
-                                             dst->data[2], dst->linesize[2],
+                                             stride1, stride2,
+                                             sx, sy, w, h);
+                    av_rpi_sand_to_planar_c8(dst->data[1] + cy * dst->linesize[1] + x / 2, dst->linesize[1],
+                                             dst->data[2] + cy * dst->linesize[2] + x / 2, dst->linesize[2],
                                              src->data[1],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x/2, y/2,  w/2, h/2);
+                                             stride1, stride2,
+                                             sx/2, sy/2, w/2, ch);
                     break;
                 case AV_PIX_FMT_NV12:
-                    av_rpi_sand_to_planar_y8(dst->data[0], dst->linesize[0],
+                    av_rpi_sand_to_planar_y8(dst->data[0] + y * dst->linesize[0] + x, dst->linesize[0],
                                              src->data[0],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x, y, w, h);
-                    av_rpi_sand_to_planar_y8(dst->data[1], dst->linesize[1],
+                                             stride1, stride2,
+                                             sx, sy, w, h);
+                    av_rpi_sand_to_planar_y8(dst->data[1] + cy * dst->linesize[1] + x, dst->linesize[1],
                                              src->data[1],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x/2, y/2, w, h/2);
+                                             stride1, stride2,
+                                             sx & ~1, sy/2, w, ch);
                     break;
                 default:
                     return -1;
@@ -396,15 +611,15 @@ int av_rpi_sand_to_planar_frame(AVFrame * const dst, const AVFrame * const src)
         case AV_PIX_FMT_SAND64_10:
             switch (dst->format){
                 case AV_PIX_FMT_YUV420P10:
-                    av_rpi_sand_to_planar_y16(dst->data[0], dst->linesize[0],
+                    av_rpi_sand_to_planar_y16(dst->data[0] + y * dst->linesize[0] + x * 2, dst->linesize[0],
                                              src->data[0],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x*2, y, w*2, h);
-                    av_rpi_sand_to_planar_c16(dst->data[1], dst->linesize[1],
-                                             dst->data[2], dst->linesize[2],
+                                             stride1, stride2,
+                                             sx*2, sy, w*2, h);
+                    av_rpi_sand_to_planar_c16(dst->data[1] + cy * dst->linesize[1] + x, dst->linesize[1],
+                                             dst->data[2] + cy * dst->linesize[2] + x, dst->linesize[2],
                                              src->data[1],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x, y/2,  w, h/2);
+                                             stride1, stride2,
+                                             sx & ~1, sy/2, w, ch);
                     break;
                 default:
                     return -1;
@@ -413,25 +628,25 @@ int av_rpi_sand_to_planar_frame(AVFrame * const dst, const AVFrame * const src)
         case AV_PIX_FMT_RPI4_10:
             switch (dst->format){
                 case AV_PIX_FMT_YUV420P10:
-                    av_rpi_sand30_to_planar_y16(dst->data[0], dst->linesize[0],
+                    av_rpi_sand30_to_planar_y16(dst->data[0] + y * dst->linesize[0] + x * 2, dst->linesize[0],
                                              src->data[0],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x, y, w, h);
-                    av_rpi_sand30_to_planar_c16(dst->data[1], dst->linesize[1],
-                                             dst->data[2], dst->linesize[2],
+                                             stride1, stride2,
+                                             sx, sy, w, h);
+                    av_rpi_sand30_to_planar_c16(dst->data[1] + cy * dst->linesize[1] + x, dst->linesize[1],
+                                             dst->data[2] + cy * dst->linesize[2] + x, dst->linesize[2],
                                              src->data[1],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x/2, y/2, w/2, h/2);
+                                             stride1, stride2,
+                                             sx/2, sy/2, w/2, ch);
                     break;
                 case AV_PIX_FMT_NV12:
-                    av_rpi_sand30_to_planar_y8(dst->data[0], dst->linesize[0],
+                    av_rpi_sand30_to_planar_y8(dst->data[0] + y * dst->linesize[0] + x, dst->linesize[0],
                                              src->data[0],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x, y, w, h);
-                    av_rpi_sand30_to_planar_y8(dst->data[1], dst->linesize[1],
+                                             stride1, stride2,
+                                             sx, sy, w, h);
+                    av_rpi_sand30_to_planar_y8(dst->data[1] + cy * dst->linesize[1] + x, dst->linesize[1],
                                              src->data[1],
-                                             av_rpi_sand_frame_stride1(src), av_rpi_sand_frame_stride2(src),
-                                             x/2, y/2, w, h/2);
+                                             stride1, stride2,
+                                             sx & ~1, sy/2, w, ch);
                     break;
                 default:
                     return -1;
@@ -441,5 +656,26 @@ int av_rpi_sand_to_planar_frame(AVFrame * const dst, const AVFrame * const src)
             return -1;
     }
 
-    return av_frame_copy_props(dst, src);
+    return 0;
+}
+
+int av_rpi_sand_to_planar_frame(AVFrame * const dst, const AVFrame * const src)
+{
+    const int w = av_frame_cropped_width(src);
+    const int h = av_frame_cropped_height(src);
+    int rv;
+
+    if ((rv = av_rpi_sand_to_planar_frame_rect(dst, src, 0, 0, w, h)) != 0)
+        return rv;
+
+    if ((rv = av_frame_copy_props(dst, src)) < 0)
+        return rv;
+
+    // We have cropped as part of the conversion
+    dst->crop_top = 0;
+    dst->crop_left = 0;
+    dst->crop_bottom = 0;
+    dst->crop_right = 0;
+
+    return 0;
 }
@@ -101,6 +101,16 @@ void av_rpi_sand16_to_sand8(uint8_t * dst, const unsigned int dst_stride1, const
 // Cropping on the src buffer will be honoured and dst crop will be set to zero
 int av_rpi_sand_to_planar_frame(AVFrame * const dst, const AVFrame * const src);
 
+// Convert a w x h rectangle at x, y of the cropped src frame into the same
+// place in dst. Only the pixels are converted - props & crop are left alone.
+// x, y, w & h are in luma pixels and x, y must be even. Rectangles aligned
+// to av_rpi_sand_frame_stripe_width may be converted in parallel.
+// A zero sized rectangle converts nothing but still checks that the format
+// pair is supported.
+int av_rpi_sand_to_planar_frame_rect(AVFrame * const dst, const AVFrame * const src,
+                                     const unsigned int x, const unsigned int y,
+                                     const unsigned int w, const unsigned int h);
+
 
 static inline unsigned int av_rpi_sand_frame_stride1(const AVFrame * const frame)
 {
@@ -149,6 +159,13 @@ static inline int av_rpi_sand_frame_xshl(const AVFrame * const frame)
     return av_rpi_is_sand8_frame(frame) ? 0 : 1;
 }
 
+// Width of a single stripe in luma pixels
+static inline unsigned int av_rpi_sand_frame_stripe_width(const AVFrame * const frame)
+{
+    const unsigned int stride1 = av_rpi_sand_frame_stride1(frame);
+    return av_rpi_is_sand30_frame(frame) ? stride1 / 4 * 3 : stride1 >> av_rpi_sand_frame_xshl(frame);
+}
+
 // If x is measured in bytes (not pixels) then this works for sand64_16 as
 // well as sand128 - but in the general case we work that out
 
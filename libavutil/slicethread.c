@@ -18,6 +18,8 @@
 
 #include <stdatomic.h>
 #include "slicethread.h"
+#include "threadpool.h"
+#include "cpu.h"
 #include "mem.h"
 #include "thread.h"
 #include "avassert.h"
@@ -32,6 +34,25 @@ typedef struct WorkerContext {
     int             done;
 } WorkerContext;
 
+typedef struct PoolWorker {
+    AVSliceThreadPool *pool;
+    pthread_t       thread;
+    int             index;
+} PoolWorker;
+
+/* Worker threads shared by all the slice threading contexts attached to it */
+struct AVSliceThreadPool {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    PoolWorker      **workers;
+    int             nb_workers;     ///< started workers, protected by pool_lock
+    int             nb_threads;     ///< workers allowed to run, protected by mutex
+    int             refcount;       ///< protected by pool_lock
+
+    /* contexts with jobs left to be picked up, by decreasing priority */
+    AVSliceThread   *queue;
+};
+
 struct AVSliceThread {
     WorkerContext   *workers;
     int             nb_threads;
@@ -48,8 +69,21 @@ struct AVSliceThread {
     void            *priv;
     void            (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
     void            (*main_func)(void *priv);
+
+    /* the following fields are only used when attached to a shared pool,
+     * and are protected by the pool mutex */
+    AVSliceThreadPool      *pool;
+    AVSliceThread   *next;
+    int             queued;
+    int             priority;
+    int             nb_slots;       ///< thread numbers handed out for the current jobs
+    int             nb_busy;        ///< threads running the current jobs
 };
 
+/* protects shared_pool and the reference counts of all pools */
+static AVMutex pool_lock = AV_MUTEX_INITIALIZER;
+static AVSliceThreadPool *shared_pool;
+
 static int run_jobs(AVSliceThread *ctx)
 {
     unsigned nb_jobs    = ctx->nb_jobs;
@@ -91,10 +125,247 @@ static void *attribute_align_arg thread_worker(void *v)
     }
 }
 
-int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
+static void pool_enqueue(AVSliceThreadPool *pool, AVSliceThread *ctx)
+{
+    AVSliceThread **p = &pool->queue;
+
+    /* behind all the contexts of the same priority, so that they are
+     * served in turn */
+    while (*p && (*p)->priority >= ctx->priority)
+        p = &(*p)->next;
+    ctx->next   = *p;
+    *p          = ctx;
+    ctx->queued = 1;
+}
+
+static void pool_dequeue(AVSliceThreadPool *pool, AVSliceThread *ctx)
+{
+    AVSliceThread **p = &pool->queue;
+
+    while (*p != ctx)
+        p = &(*p)->next;
+    *p          = ctx->next;
+    ctx->next   = NULL;
+    ctx->queued = 0;
+}
+
+static void run_shared_jobs(AVSliceThread *ctx, int threadnr)
+{
+    unsigned nb_jobs = ctx->nb_jobs;
+    unsigned job;
+
+    while ((job = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs)
+        ctx->worker_func(ctx->priv, job, threadnr, nb_jobs, ctx->nb_active_threads);
+}
+
+static void *attribute_align_arg pool_worker(void *v)
+{
+    PoolWorker *w    = v;
+    AVSliceThreadPool *pool = w->pool;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (w->index < pool->nb_threads) {
+        AVSliceThread *ctx = pool->queue;
+        int threadnr;
+
+        if (!ctx) {
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+            continue;
+        }
+
+        /* Take a thread number and move the context to the back of its
+         * priority class, the next idle worker helps the next context. */
+        threadnr = ctx->nb_slots++;
+        ctx->nb_busy++;
+        pool_dequeue(pool, ctx);
+        if (ctx->nb_slots < ctx->nb_active_threads &&
+            atomic_load_explicit(&ctx->current_job, memory_order_relaxed) < ctx->nb_jobs)
+            pool_enqueue(pool, ctx);
+        pthread_mutex_unlock(&pool->mutex);
+
+        run_shared_jobs(ctx, threadnr);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (!--ctx->nb_busy)
+            pthread_cond_signal(&ctx->done_cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+/**
+ * Start or stop workers so that nb_threads of them run. Workers beyond the
+ * new size leave once done with the job they are running, so this may wait
+ * for the jobs in progress. Must be called with pool_lock held, or on a pool
+ * nothing else refers to.
+ */
+static int pool_resize(AVSliceThreadPool *pool, int nb_threads)
+{
+    int ret = 0;
+
+    if (nb_threads > pool->nb_workers) {
+        PoolWorker **workers = av_realloc_array(pool->workers, nb_threads,
+                                                sizeof(*workers));
+        if (!workers)
+            return AVERROR(ENOMEM);
+        pool->workers = workers;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->nb_threads = nb_threads;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (; pool->nb_workers > nb_threads; pool->nb_workers--) {
+        PoolWorker **w = &pool->workers[pool->nb_workers - 1];
+        pthread_join((*w)->thread, NULL);
+        av_freep(w);
+    }
+
+    for (; pool->nb_workers < nb_threads; pool->nb_workers++) {
+        PoolWorker *w = av_mallocz(sizeof(*w));
+        if (!w) {
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+        w->pool  = pool;
+        w->index = pool->nb_workers;
+        if (ret = pthread_create(&w->thread, NULL, pool_worker, w)) {
+            av_free(w);
+            ret = AVERROR(ret);
+            break;
+        }
+        pool->workers[pool->nb_workers] = w;
+    }
+
+    if (ret < 0) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->nb_threads = pool->nb_workers;
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    return ret;
+}
+
+static void pool_free(AVSliceThreadPool **ppool)
+{
+    AVSliceThreadPool *pool = *ppool;
+
+    pool_resize(pool, 0);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->mutex);
+    av_freep(&pool->workers);
+    av_freep(ppool);
+}
+
+static int pool_alloc(AVSliceThreadPool **ppool, int nb_threads)
+{
+    AVSliceThreadPool *pool;
+    int ret;
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return AVERROR(ENOMEM);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pool->refcount = 1;
+    *ppool = pool;
+
+    if ((ret = pool_resize(pool, nb_threads)) < 0)
+        pool_free(ppool);
+    return ret;
+}
+
+static void pool_unref(AVSliceThreadPool **ppool)
+{
+    int refcount;
+
+    ff_mutex_lock(&pool_lock);
+    refcount = --(*ppool)->refcount;
+    ff_mutex_unlock(&pool_lock);
+
+    if (!refcount)
+        pool_free(ppool);
+    *ppool = NULL;
+}
+
+int av_thread_pool_set_size(int nb_threads)
+{
+    AVSliceThreadPool *old = NULL;
+    int refcount = 1, ret = 0;
+
+    if (nb_threads < 0)
+        nb_threads = av_cpu_count();
+
+    /* The pool is resized in place, so that the threads of the previous size
+     * do not outlive this call. Once disabled, the contexts still attached
+     * to it run their jobs on the calling thread until they are freed. */
+    ff_mutex_lock(&pool_lock);
+    if (nb_threads && shared_pool) {
+        ret = pool_resize(shared_pool, nb_threads);
+    } else if (nb_threads) {
+        ret = pool_alloc(&shared_pool, nb_threads);
+    } else if (shared_pool) {
+        pool_resize(shared_pool, 0);
+        old         = shared_pool;
+        refcount    = --old->refcount;
+        shared_pool = NULL;
+    }
+    ff_mutex_unlock(&pool_lock);
+
+    if (!refcount)
+        pool_free(&old);
+
+    return ret;
+}
+
+int av_thread_pool_get_size(void)
+{
+    int nb_threads;
+
+    ff_mutex_lock(&pool_lock);
+    nb_threads = shared_pool ? shared_pool->nb_workers : 0;
+    ff_mutex_unlock(&pool_lock);
+
+    return nb_threads;
+}
+
+static void execute_shared(AVSliceThread *ctx)
+{
+    AVSliceThreadPool *pool = ctx->pool;
+
+    /* The calling thread is thread 0 and runs jobs until there are none left,
+     * so all the jobs get done even if no worker ever joins in. It always
+     * runs job 0 itself, as it would with threads of its own: some callers
+     * keep the state job 0 starts from in the data of thread 0. */
+    pthread_mutex_lock(&pool->mutex);
+    /* the pool may have been shrunk since the context was created */
+    ctx->nb_active_threads = FFMIN(ctx->nb_active_threads, pool->nb_threads + 1);
+    ctx->nb_slots = 1;
+    ctx->nb_busy  = 1;
+    if (ctx->nb_active_threads > 1) {
+        pool_enqueue(pool, ctx);
+        for (int i = 1; i < ctx->nb_active_threads; i++)
+            pthread_cond_signal(&pool->cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    ctx->worker_func(ctx->priv, 0, 0, ctx->nb_jobs, ctx->nb_active_threads);
+    run_shared_jobs(ctx, 0);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (ctx->queued)
+        pool_dequeue(pool, ctx);
+    ctx->nb_busy--;
+    while (ctx->nb_busy)
+        pthread_cond_wait(&ctx->done_cond, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static int slicethread_create(AVSliceThread **pctx, AVSliceThreadPool *pool, void *priv,
                               void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
                               void (*main_func)(void *priv),
-                              int nb_threads)
+                              int nb_threads, int flags)
 {
     AVSliceThread *ctx;
     int nb_workers, i;
@@ -116,6 +387,23 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     if (!ctx)
         return AVERROR(ENOMEM);
 
+    /* The main function may wait on jobs no pool worker is free to run, and
+     * pool workers join in any order, or not at all when they are busy, so
+     * jobs waiting for each other could deadlock too. Only contexts without
+     * either are attached to the shared pool. Jobs are still handed out in
+     * increasing order, so those of contexts created on a given pool may
+     * wait for jobs with lower numbers. */
+    if (pool || (!main_func && !(flags & AVPRIV_SLICETHREAD_FLAG_CONCURRENT_JOBS) &&
+                 nb_threads > 1)) {
+        ff_mutex_lock(&pool_lock);
+        if ((ctx->pool = pool ? pool : shared_pool)) {
+            ctx->pool->refcount++;
+            nb_threads = FFMIN(nb_threads, ctx->pool->nb_workers + 1);
+            nb_workers = 0;
+        }
+        ff_mutex_unlock(&pool_lock);
+    }
+
     if (nb_workers && !(ctx->workers = av_calloc(nb_workers, sizeof(*ctx->workers)))) {
         av_freep(pctx);
         return AVERROR(ENOMEM);
@@ -161,6 +449,54 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return nb_threads;
 }
 
+int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
+                              void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                              void (*main_func)(void *priv),
+                              int nb_threads)
+{
+    return slicethread_create(pctx, NULL, priv, worker_func, main_func, nb_threads, 0);
+}
+
+int avpriv_slicethread_create2(AVSliceThread **pctx, void *priv,
+                               void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                               void (*main_func)(void *priv),
+                               int nb_threads, int flags)
+{
+    return slicethread_create(pctx, NULL, priv, worker_func, main_func, nb_threads, flags);
+}
+
+int avpriv_slicethread_create_pooled(AVSliceThread **pctx, AVSliceThreadPool *pool, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads)
+{
+    return slicethread_create(pctx, pool, priv, worker_func, NULL, nb_threads, 0);
+}
+
+int avpriv_slicethread_pool_alloc(AVSliceThreadPool **ppool, int nb_threads)
+{
+    int ret;
+
+    av_assert0(nb_threads > 0);
+
+    /* share the process-wide pool when it is enabled, to keep its cap */
+    ff_mutex_lock(&pool_lock);
+    if ((*ppool = shared_pool))
+        shared_pool->refcount++;
+    ff_mutex_unlock(&pool_lock);
+    if (*ppool)
+        return (*ppool)->nb_workers;
+
+    if ((ret = pool_alloc(ppool, nb_threads)) < 0)
+        return ret;
+    return (*ppool)->nb_workers;
+}
+
+void avpriv_slicethread_pool_free(AVSliceThreadPool **ppool)
+{
+    if (*ppool)
+        pool_unref(ppool);
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     int nb_workers, i, is_last = 0;
@@ -168,6 +504,13 @@ void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_mai
     av_assert0(nb_jobs > 0);
     ctx->nb_jobs           = nb_jobs;
     ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
+
+    if (ctx->pool) {
+        atomic_store_explicit(&ctx->current_job, 1, memory_order_relaxed);
+        execute_shared(ctx);
+        return;
+    }
+
     atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
     atomic_store_explicit(&ctx->current_job, ctx->nb_active_threads, memory_order_relaxed);
     nb_workers             = ctx->nb_active_threads;
@@ -208,6 +551,10 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
     nb_workers = ctx->nb_threads;
     if (!ctx->main_func)
         nb_workers--;
+    if (ctx->pool) {
+        pool_unref(&ctx->pool);
+        nb_workers = 0;
+    }
 
     ctx->finished = 1;
     for (i = 0; i < nb_workers; i++) {
@@ -231,6 +578,15 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
     av_freep(pctx);
 }
 
+void avpriv_slicethread_set_priority(AVSliceThread *ctx, int priority)
+{
+    if (!ctx->pool)
+        return;
+    pthread_mutex_lock(&ctx->pool->mutex);
+    ctx->priority = priority;
+    pthread_mutex_unlock(&ctx->pool->mutex);
+}
+
 #else /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS32THREADS */
 
 int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
@@ -242,6 +598,34 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return AVERROR(EINVAL);
 }
 
+int avpriv_slicethread_create2(AVSliceThread **pctx, void *priv,
+                               void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                               void (*main_func)(void *priv),
+                               int nb_threads, int flags)
+{
+    *pctx = NULL;
+    return AVERROR(EINVAL);
+}
+
+int avpriv_slicethread_create_pooled(AVSliceThread **pctx, AVSliceThreadPool *pool, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads)
+{
+    *pctx = NULL;
+    return AVERROR(EINVAL);
+}
+
+int avpriv_slicethread_pool_alloc(AVSliceThreadPool **ppool, int nb_threads)
+{
+    *ppool = NULL;
+    return AVERROR(EINVAL);
+}
+
+void avpriv_slicethread_pool_free(AVSliceThreadPool **ppool)
+{
+    av_assert0(!*ppool);
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     av_assert0(0);
@@ -252,4 +636,19 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
     av_assert0(!pctx || !*pctx);
 }
 
+void avpriv_slicethread_set_priority(AVSliceThread *ctx, int priority)
+{
+    av_assert0(0);
+}
+
+int av_thread_pool_set_size(int nb_threads)
+{
+    return nb_threads ? AVERROR(ENOSYS) : 0;
+}
+
+int av_thread_pool_get_size(void)
+{
+    return 0;
+}
+
 #endif /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS32THREADS */
@@ -20,6 +20,14 @@
 #define AVUTIL_SLICETHREAD_H
 
 typedef struct AVSliceThread AVSliceThread;
+typedef struct AVSliceThreadPool AVSliceThreadPool;
+
+/**
+ * The jobs wait for each other, so the first nb_threads jobs of an execution
+ * must all run at the same time, job n on thread n. Such contexts always get
+ * threads of their own, even when the shared thread pool is enabled.
+ */
+#define AVPRIV_SLICETHREAD_FLAG_CONCURRENT_JOBS (1 << 0)
 
 /**
  * Create slice threading context.
@@ -35,6 +43,49 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*main_func)(void *priv),
                               int nb_threads);
 
+/**
+ * Same as avpriv_slicethread_create(), with flags.
+ * @param flags combination of AVPRIV_SLICETHREAD_FLAG_*
+ */
+int avpriv_slicethread_create2(AVSliceThread **pctx, void *priv,
+                               void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                               void (*main_func)(void *priv),
+                               int nb_threads, int flags);
+
+/**
+ * Allocate a pool of worker threads for contexts created with
+ * avpriv_slicethread_create_pooled(). When the process-wide thread pool is
+ * enabled (see threadpool.h), a reference to it is returned instead.
+ * @param ppool pool returned here
+ * @param nb_threads number of worker threads, must be > 0
+ * @return number of worker threads of the pool or negative AVERROR on failure
+ */
+int avpriv_slicethread_pool_alloc(AVSliceThreadPool **ppool, int nb_threads);
+
+/**
+ * Release a pool. Its workers are stopped once all the contexts created on it
+ * are freed too.
+ * @param ppool pointer to pool
+ */
+void avpriv_slicethread_pool_free(AVSliceThreadPool **ppool);
+
+/**
+ * Create a slice threading context running its jobs on a pool of worker
+ * threads, which may be shared by contexts executing concurrently from
+ * different threads. The calling thread runs jobs as thread 0, and jobs are
+ * started in increasing order, so a job may wait for jobs with lower numbers
+ * but never for jobs with higher ones.
+ * @param pctx slice threading context returned here
+ * @param pool pool to run the jobs on
+ * @param priv private pointer to be passed to callback function
+ * @param worker_func callback function to be executed
+ * @param nb_threads maximum number of threads, 0 for automatic, must be >= 0
+ * @return return number of threads or negative AVERROR on failure
+ */
+int avpriv_slicethread_create_pooled(AVSliceThread **pctx, AVSliceThreadPool *pool, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads);
+
 /**
  * Execute slice threading.
  * @param ctx slice threading context
@@ -43,6 +94,15 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
  */
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main);
 
+/**
+ * Set the priority of the jobs of a context attached to the shared thread
+ * pool (see threadpool.h); higher priorities are served first. This has no
+ * effect on contexts running on their own threads.
+ * @param ctx slice threading context
+ * @param priority priority, 0 by default
+ */
+void avpriv_slicethread_set_priority(AVSliceThread *ctx, int priority);
+
 /**
  * Destroy slice threading context.
  * @param pctx pointer to context
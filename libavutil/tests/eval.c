@@ -37,6 +37,47 @@ static const char *const const_names[] = {
     0
 };
 
+static const char *const array_const_names[] = {
+    "X",
+    "Y",
+    "Z",
+    0
+};
+
+#define ARRAY_SIZE 100
+
+/* av_expr_eval_array() must match av_expr_eval() exactly */
+static void check_array(const char *s)
+{
+    AVExpr *e = NULL, *e_ref = NULL;
+    double x[ARRAY_SIZE], dst[ARRAY_SIZE];
+    double values[] = { 0, 3, 0.5 };
+    const double *arrays[] = { x, NULL, NULL };
+    int i, ret, mismatch = 0;
+
+    for (i = 0; i < ARRAY_SIZE; i++)
+        x[i] = i * 0.37 - 5;
+
+    if ((ret = av_expr_parse(&e, s, array_const_names, NULL, NULL, NULL, NULL, 0, NULL)) < 0 ||
+        (ret = av_expr_parse(&e_ref, s, array_const_names, NULL, NULL, NULL, NULL, 0, NULL)) < 0 ||
+        (ret = av_expr_eval_array(e, dst, ARRAY_SIZE, values, arrays, NULL)) < 0) {
+        printf("'%s' array failed\n", s);
+        goto end;
+    }
+    for (i = 0; i < ARRAY_SIZE; i++) {
+        double ref;
+        values[0] = x[i];
+        ref = av_expr_eval(e_ref, values, NULL);
+        if (memcmp(&ref, &dst[i], sizeof(ref)))
+            mismatch++;
+    }
+    printf("'%s' array -> %f, %d mismatches\n", s, dst[ARRAY_SIZE - 1], mismatch);
+
+end:
+    av_expr_free(e);
+    av_expr_free(e_ref);
+}
+
 int main(int argc, char **argv)
 {
     int i;
@@ -140,6 +181,18 @@ int main(int argc, char **argv)
         "clip(0, 0/0, 1)",
         NULL
     };
+    static const char *const array_exprs[] = {
+        "X*2+Y",
+        "if(gt(X,Y),X-Y,sin(X)*Z)",
+        "ifnot(mod(X,3),hypot(X,Y),-PI)",
+        "if(lt(X,0),sqrt(X))",
+        "clip(X*Y-5,0,10)+between(X,-2,2)+isnan(0/0)+floor(X)",
+        "lerp(X,Y,Z)*gauss(X/10)-squish(X)+pow(abs(X),Z)",
+        "bitand(X,7)+bitor(X,Y)+max(X,Y)-min(X,Z)",
+        "st(0,ld(0)+X);ld(0)",
+        "X*random(1)",
+        NULL
+    };
     int ret;
 
     for (expr = exprs; *expr; expr++) {
@@ -168,7 +221,36 @@ int main(int argc, char **argv)
     if (ret < 0)
         printf("av_expr_parse_and_eval failed\n");
 
+    for (expr = array_exprs; *expr; expr++)
+        check_array(*expr);
+
     if (argc > 1 && !strcmp(argv[1], "-t")) {
+        static const char *const geq_like = "if(gt(X,Y),255*(1+sin(X/8)*cos(Y/8))/2,clip(X*Y/W,0,255))";
+        static const char *const geq_names[] = { "X", "Y", "W", 0 };
+        double xs[1024], dst[1024], values[3] = { 0, 300, 1024 };
+        const double *arrays[3] = { xs };
+        AVExpr *e = NULL;
+
+        if (av_expr_parse(&e, geq_like, geq_names, NULL, NULL, NULL, NULL, 0, NULL) < 0)
+            return 1;
+        for (i = 0; i < 1024; i++)
+            xs[i] = i;
+        for (i = 0; i < 1050; i++) {
+            int x;
+            START_TIMER;
+            for (x = 0; x < 1024; x++) {
+                values[0] = x;
+                dst[x] = av_expr_eval(e, values, NULL);
+            }
+            STOP_TIMER("av_expr_eval x1024");
+        }
+        for (i = 0; i < 1050; i++) {
+            START_TIMER;
+            av_expr_eval_array(e, dst, 1024, values, arrays, NULL);
+            STOP_TIMER("av_expr_eval_array 1024");
+        }
+        av_expr_free(e);
+
         for (i = 0; i < 1050; i++) {
             START_TIMER;
             ret = av_expr_parse_and_eval(&d, "1+(5-2)^(3-1)+1/2+sin(PI)-max(-2.2,-3.1)",
@@ -0,0 +1,185 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/framepool.h"
+#include "libavutil/frame.h"
+#include "libavutil/mem.h"
+
+/* Stands in for application supplied (e.g. shared) memory */
+typedef struct Backing {
+    int nb_alloc;
+    int nb_live;
+    int pool_freed;
+} Backing;
+
+static void backing_free(void *opaque, uint8_t *data)
+{
+    Backing *b = opaque;
+    b->nb_live--;
+    av_free(data);
+}
+
+static AVBufferRef *backing_alloc(void *opaque, size_t size)
+{
+    Backing *b = opaque;
+    uint8_t *data = av_malloc(size + 1);
+    AVBufferRef *buf;
+
+    if (!data)
+        return NULL;
+    /* Deliberately misaligned to check the pool aligns for us */
+    buf = av_buffer_create(data, size + 1, backing_free, b, 0);
+    if (!buf) {
+        av_free(data);
+        return NULL;
+    }
+    buf->data++;
+    buf->size--;
+    b->nb_alloc++;
+    b->nb_live++;
+    return buf;
+}
+
+static void backing_pool_free(void *opaque)
+{
+    Backing *b = opaque;
+    b->pool_freed = 1;
+}
+
+static void print_stats(AVFramePool *pool)
+{
+    AVFramePoolStats st;
+
+    av_frame_pool_get_stats(pool, &st);
+    printf("allocated %u, in use %u, peak %u, hits %"PRIu64", misses %"PRIu64
+           ", flushed %"PRIu64", failed %"PRIu64"\n",
+           st.nb_allocated, st.nb_in_use, st.peak_in_use,
+           st.hits, st.misses, st.flushed, st.failed);
+}
+
+static AVFrame *get_frame(AVFramePool *pool, enum AVPixelFormat format,
+                          int width, int height, int *err)
+{
+    AVFrame *frame = av_frame_alloc();
+
+    if (!frame)
+        return NULL;
+    frame->format = format;
+    frame->width  = width;
+    frame->height = height;
+    if ((*err = av_frame_pool_get_video_buffer(pool, frame, 0, 0, 32)) < 0)
+        av_frame_free(&frame);
+    return frame;
+}
+
+static int check_frame(const AVFrame *frame)
+{
+    const AVBufferRef *backing = av_frame_pool_buffer_backing(frame->buf[0]);
+    int i;
+
+    if (!backing)
+        return -1;
+    for (i = 0; i < 4 && frame->data[i]; i++) {
+        if ((uintptr_t)frame->data[i] & 31 || frame->linesize[i] & 31)
+            return -1;
+        if (frame->data[i] < frame->buf[0]->data ||
+            frame->data[i] >= frame->buf[0]->data + frame->buf[0]->size)
+            return -1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    Backing b = { 0 };
+    AVFramePool *pool = av_frame_pool_init(&b, backing_alloc, backing_pool_free);
+    AVFrame *frames[4];
+    AVFrame *extra;
+    uint8_t *first;
+    int err, i;
+
+    if (!pool)
+        return 1;
+
+    /* Allocate, return & reuse */
+    for (i = 0; i < 3; i++) {
+        frames[i] = get_frame(pool, AV_PIX_FMT_YUV420P, 352, 288, &err);
+        if (!frames[i] || check_frame(frames[i]) < 0)
+            return 1;
+    }
+    first = frames[2]->data[0];
+    print_stats(pool);
+    /* Most recently returned buffer is reused first */
+    for (i = 0; i < 3; i++)
+        av_frame_free(&frames[i]);
+    frames[0] = get_frame(pool, AV_PIX_FMT_YUV420P, 352, 288, &err);
+    printf("reused: %d\n", frames[0] && frames[0]->data[0] == first);
+    print_stats(pool);
+
+    /* Foreign buffers are not ours */
+    extra = av_frame_alloc();
+    extra->format = AV_PIX_FMT_GRAY8;
+    extra->width  = extra->height = 16;
+    av_frame_get_buffer(extra, 0);
+    printf("foreign backing: %d\n", av_frame_pool_buffer_backing(extra->buf[0]) != NULL);
+    av_frame_free(&extra);
+
+    /* Cap & preallocation */
+    av_frame_pool_set_size(pool, 3, 3);
+    print_stats(pool);
+    frames[1] = get_frame(pool, AV_PIX_FMT_YUV420P, 352, 288, &err);
+    frames[2] = get_frame(pool, AV_PIX_FMT_YUV420P, 352, 288, &err);
+    frames[3] = get_frame(pool, AV_PIX_FMT_YUV420P, 352, 288, &err);
+    printf("over limit: %s\n", !frames[3] && err == AVERROR(EAGAIN) ? "EAGAIN" : "unexpected");
+    print_stats(pool);
+
+    /* Geometry change: free buffers dropped, in use ones freed on return */
+    av_frame_free(&frames[2]);
+    extra = get_frame(pool, AV_PIX_FMT_YUV420P10, 640, 360, &err);
+    if (!extra || check_frame(extra) < 0)
+        return 1;
+    print_stats(pool);
+    av_frame_free(&frames[0]);
+    av_frame_free(&frames[1]);
+    print_stats(pool);
+
+    /* Pool outlives uninit until the last frame is gone */
+    av_frame_pool_uninit(&pool);
+    printf("after uninit: pool freed %d, live %d\n", b.pool_freed, b.nb_live);
+    av_frame_free(&extra);
+    printf("after last frame: pool freed %d, live %d, allocs %d\n",
+           b.pool_freed, b.nb_live, b.nb_alloc);
+
+    /* Preallocation once the geometry is known */
+    pool = av_frame_pool_init(NULL, NULL, NULL);
+    if (!pool)
+        return 1;
+    av_frame_pool_set_size(pool, 4, 0);
+    frames[0] = get_frame(pool, AV_PIX_FMT_NV12, 1920, 1080, &err);
+    print_stats(pool);
+    frames[1] = get_frame(pool, AV_PIX_FMT_NV12, 1920, 1080, &err);
+    print_stats(pool);
+    av_frame_free(&frames[0]);
+    av_frame_free(&frames[1]);
+    av_frame_pool_uninit(&pool);
+
+    return 0;
+}
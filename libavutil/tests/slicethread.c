@@ -0,0 +1,227 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "libavutil/slicethread.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadpool.h"
+#include "libavutil/time.h"
+
+#define NB_JOBS     37
+#define NB_EXECUTES 50
+#define NB_CONTEXTS 4
+#define MAX_THREADS 16
+#define NB_ROWS     64
+
+typedef struct TestContext {
+    AVSliceThread *thread;
+    int nb_threads;
+    int priority;
+    atomic_int runs[NB_JOBS];
+    atomic_int busy[MAX_THREADS];
+    atomic_int errors;
+} TestContext;
+
+static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    TestContext *c = priv;
+
+    if (threadnr < 0 || threadnr >= c->nb_threads || nb_threads > c->nb_threads ||
+        jobnr < 0 || jobnr >= nb_jobs) {
+        atomic_fetch_add(&c->errors, 1);
+        return;
+    }
+    /* the calling thread always runs job 0 */
+    if (!jobnr && threadnr)
+        atomic_fetch_add(&c->errors, 1);
+    /* a thread number must never be used by two running jobs at once */
+    if (atomic_exchange(&c->busy[threadnr], 1))
+        atomic_fetch_add(&c->errors, 1);
+    atomic_fetch_add(&c->runs[jobnr], 1);
+    atomic_store(&c->busy[threadnr], 0);
+}
+
+static int test_init(TestContext *c, int nb_threads, int priority)
+{
+    for (int i = 0; i < NB_JOBS; i++)
+        atomic_init(&c->runs[i], 0);
+    for (int i = 0; i < MAX_THREADS; i++)
+        atomic_init(&c->busy[i], 0);
+    atomic_init(&c->errors, 0);
+
+    c->priority   = priority;
+    c->nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func,
+                                              NULL, nb_threads);
+    if (c->nb_threads < 0)
+        return c->nb_threads;
+    avpriv_slicethread_set_priority(c->thread, priority);
+    return 0;
+}
+
+/* Jobs decoding rows that each need the row above, as VP8 and HEVC WPP do */
+typedef struct RowContext {
+    AVSliceThread *thread;
+    int nb_threads;
+    int interleaved;
+    atomic_int rows[NB_ROWS];
+    atomic_int errors;
+} RowContext;
+
+/* Wait for a row with a deadline, so that a deadlock is reported rather
+ * than hanging the test */
+static void wait_row(RowContext *c, int row)
+{
+    for (int i = 0; !atomic_load(&c->rows[row]); i++) {
+        if (i == 20000) {
+            atomic_fetch_add(&c->errors, 1);
+            return;
+        }
+        av_usleep(100);
+    }
+}
+
+static void row_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    RowContext *c = priv;
+
+    if (c->interleaved) {
+        /* job n decodes rows n, n + nb_jobs, ... like sliced VP8: all the
+         * jobs must run at once, job n on thread n */
+        if (jobnr < nb_threads && threadnr != jobnr)
+            atomic_fetch_add(&c->errors, 1);
+        for (int row = jobnr; row < NB_ROWS; row += nb_jobs) {
+            if (row)
+                wait_row(c, row - 1);
+            atomic_store(&c->rows[row], 1);
+        }
+    } else {
+        /* job n decodes row n like HEVC WPP: only needs the jobs to be
+         * started in order */
+        if (jobnr)
+            wait_row(c, jobnr - 1);
+        atomic_store(&c->rows[jobnr], 1);
+    }
+}
+
+static int test_rows(int interleaved, int nb_threads)
+{
+    RowContext c = { .interleaved = interleaved };
+    int nb_jobs, ret;
+
+    for (int i = 0; i < NB_ROWS; i++)
+        atomic_init(&c.rows[i], 0);
+    atomic_init(&c.errors, 0);
+
+    c.nb_threads = avpriv_slicethread_create2(&c.thread, &c, row_func, NULL, nb_threads,
+                                              interleaved ? AVPRIV_SLICETHREAD_FLAG_CONCURRENT_JOBS : 0);
+    if (c.nb_threads < 0)
+        return c.nb_threads;
+    nb_jobs = interleaved ? c.nb_threads : NB_ROWS;
+    for (int i = 0; i < NB_EXECUTES; i++) {
+        for (int j = 0; j < NB_ROWS; j++)
+            atomic_store(&c.rows[j], 0);
+        avpriv_slicethread_execute(c.thread, nb_jobs, 0);
+    }
+    ret = atomic_load(&c.errors);
+    for (int i = 0; i < NB_ROWS; i++)
+        if (!atomic_load(&c.rows[i]))
+            ret++;
+    printf("%s rows: %d threads, %d errors\n",
+           interleaved ? "interleaved" : "ordered", c.nb_threads, ret);
+    avpriv_slicethread_free(&c.thread);
+    return 0;
+}
+
+static int test_check(TestContext *c, int nb_executes)
+{
+    int ret = atomic_load(&c->errors);
+
+    for (int i = 0; i < NB_JOBS; i++)
+        if (atomic_load(&c->runs[i]) != nb_executes)
+            ret++;
+    return ret;
+}
+
+static void *test_run(void *arg)
+{
+    TestContext *c = arg;
+
+    for (int i = 0; i < NB_EXECUTES; i++)
+        avpriv_slicethread_execute(c->thread, NB_JOBS, 0);
+    return NULL;
+}
+
+int main(void)
+{
+    TestContext c[NB_CONTEXTS], *p = &c[0];
+    pthread_t threads[NB_CONTEXTS];
+    int ret;
+
+    if ((ret = test_init(p, 4, 0)) < 0)
+        return 1;
+    test_run(p);
+    printf("own threads: %d threads, %d errors\n", p->nb_threads, test_check(p, NB_EXECUTES));
+    avpriv_slicethread_free(&p->thread);
+
+    if ((ret = av_thread_pool_set_size(3)) < 0)
+        return 1;
+    printf("pool size: %d\n", av_thread_pool_get_size());
+
+    for (int i = 0; i < NB_CONTEXTS; i++)
+        if ((ret = test_init(&c[i], 8, i & 1)) < 0)
+            return 1;
+    for (int i = 0; i < NB_CONTEXTS; i++)
+        if (pthread_create(&threads[i], NULL, test_run, &c[i]))
+            return 1;
+    for (int i = 0; i < NB_CONTEXTS; i++)
+        pthread_join(threads[i], NULL);
+    for (int i = 0; i < NB_CONTEXTS; i++) {
+        printf("shared %d: priority %d, %d threads, %d errors\n", i,
+               c[i].priority, c[i].nb_threads, test_check(&c[i], NB_EXECUTES));
+    }
+
+    /* jobs waiting for each other: in order ones can share the pool,
+     * interleaved ones need threads of their own */
+    if (test_rows(0, 8) < 0 || test_rows(1, 8) < 0)
+        return 1;
+
+    /* the pool is resized in place under the attached contexts */
+    if ((ret = av_thread_pool_set_size(1)) < 0)
+        return 1;
+    printf("pool size: %d\n", av_thread_pool_get_size());
+    for (int i = 0; i < NB_CONTEXTS; i++)
+        if (pthread_create(&threads[i], NULL, test_run, &c[i]))
+            return 1;
+    for (int i = 0; i < NB_CONTEXTS; i++)
+        pthread_join(threads[i], NULL);
+    for (int i = 0; i < NB_CONTEXTS; i++)
+        printf("resized %d: %d errors\n", i, test_check(&c[i], 2 * NB_EXECUTES));
+
+    /* contexts attached to a disabled pool run their jobs by themselves */
+    if ((ret = av_thread_pool_set_size(0)) < 0)
+        return 1;
+    printf("pool size: %d\n", av_thread_pool_get_size());
+    test_run(p);
+    printf("detached pool: %d errors\n", test_check(p, 3 * NB_EXECUTES));
+    for (int i = 0; i < NB_CONTEXTS; i++)
+        avpriv_slicethread_free(&c[i].thread);
+
+    return 0;
+}
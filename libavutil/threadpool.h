@@ -0,0 +1,80 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * @ingroup lavu_threadpool
+ * Process-wide thread pool
+ */
+
+#ifndef AVUTIL_THREADPOOL_H
+#define AVUTIL_THREADPOOL_H
+
+/**
+ * @defgroup lavu_threadpool Shared thread pool
+ * @ingroup lavu_misc
+ *
+ * By default every codec context using slice threading and every filter
+ * graph starts its own worker threads. A process running many of them at
+ * once can instead make them share a single pool of worker threads, which
+ * bounds the number of threads started by the libraries for slice threading.
+ *
+ * Contexts attached to the shared pool queue their jobs on it; idle workers
+ * pick jobs from the queued contexts with the highest priority first (see
+ * AVCodecContext.thread_priority and AVFilterGraph.thread_priority) and
+ * round-robin between contexts of equal priority. The thread submitting the
+ * jobs always takes part in running them, so a context keeps making progress
+ * even when all workers are busy with higher priority ones.
+ *
+ * Only slice threading contexts whose jobs can run in any number and order
+ * are attached to the pool. Frame threading in libavcodec, and slice
+ * threading contexts with a main function or with jobs that must all run at
+ * once, keep threads of their own.
+ *
+ * @{
+ */
+
+/**
+ * Set the number of worker threads of the shared thread pool.
+ *
+ * The pool is resized in place: workers are started or stopped before this
+ * function returns, and contexts already attached to the pool use the new
+ * number of workers from their next execution on, up to the number of threads
+ * they were created with. When the pool is disabled, the contexts still
+ * attached to it run their jobs on the calling thread until they are freed.
+ *
+ * This function is thread-safe.
+ *
+ * @param nb_threads number of worker threads; 0 disables the shared pool
+ *                   (the default), a negative value creates one worker per
+ *                   CPU
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_thread_pool_set_size(int nb_threads);
+
+/**
+ * @return the number of worker threads of the shared thread pool, 0 if it
+ *         is disabled
+ */
+int av_thread_pool_get_size(void);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_THREADPOOL_H */
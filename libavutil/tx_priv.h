@@ -153,6 +153,9 @@ int ff_tx_init_mdct_fft_int32(AVTXContext *s, av_tx_fn *tx,
                               enum AVTXType type, int inv, int len,
                               const void *scale, uint64_t flags);
 
+/* SIMD init, may replace the transform function and the revtab */
+int ff_tx_init_float_x86(AVTXContext *s, av_tx_fn *tx);
+
 typedef struct CosTabsInitOnce {
     void (*func)(void);
     AVOnce control;
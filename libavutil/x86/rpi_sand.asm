@@ -0,0 +1,329 @@
+;******************************************************************************
+;* x86 optimized SAND de-striping functions
+;* Copyright (c) 2018 Raspberry Pi (Trading) Ltd.
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+; sand30 packs 3 x 10-bit samples into the low 30 bits of each 32-bit word.
+; Each 16-byte lane of output words is gathered from 4 source words, lane n
+; (mod 3) starting at source word 2n. pshufb picks the 2 bytes containing
+; each sample, pmullw shifts the sample to the top of the word and a final
+; psrlw brings it back down.
+; Tables are laid out lane 0,1,2,0,1,2 so that xmm code reads them at
+; 16-byte and ymm code at 32-byte steps.
+sand30_y_shuf: db 0, 1, 1, 2, 2, 3, 4, 5, 5, 6, 6, 7, 8, 9, 9,10
+               db 2, 3, 4, 5, 5, 6, 6, 7, 8, 9, 9,10,10,11,12,13
+               db 5, 6, 6, 7, 8, 9, 9,10,10,11,12,13,13,14,14,15
+               db 0, 1, 1, 2, 2, 3, 4, 5, 5, 6, 6, 7, 8, 9, 9,10
+               db 2, 3, 4, 5, 5, 6, 6, 7, 8, 9, 9,10,10,11,12,13
+               db 5, 6, 6, 7, 8, 9, 9,10,10,11,12,13,13,14,14,15
+sand30_y_mul:  dw 64,16, 4,64,16, 4,64,16
+               dw  4,64,16, 4,64,16, 4,64
+               dw 16, 4,64,16, 4,64,16, 4
+               dw 64,16, 4,64,16, 4,64,16
+               dw  4,64,16, 4,64,16, 4,64
+               dw 16, 4,64,16, 4,64,16, 4
+
+; As above but U & V samples are sorted into the low & high halves of
+; each lane
+sand30_c_shuf: db 0, 1, 2, 3, 5, 6, 8, 9, 1, 2, 4, 5, 6, 7, 9,10
+               db 2, 3, 5, 6, 8, 9,10,11, 4, 5, 6, 7, 9,10,12,13
+               db 5, 6, 8, 9,10,11,13,14, 6, 7, 9,10,12,13,14,15
+               db 0, 1, 2, 3, 5, 6, 8, 9, 1, 2, 4, 5, 6, 7, 9,10
+               db 2, 3, 5, 6, 8, 9,10,11, 4, 5, 6, 7, 9,10,12,13
+               db 5, 6, 8, 9,10,11,13,14, 6, 7, 9,10,12,13,14,15
+sand30_c_mul:  dw 64, 4,16,64,16,64, 4,16
+               dw  4,16,64, 4,64, 4,16,64
+               dw 16,64, 4,16, 4,16,64, 4
+               dw 64, 4,16,64,16,64, 4,16
+               dw  4,16,64, 4,64, 4,16,64
+               dw 16,64, 4,16, 4,16,64, 4
+
+; for AVX2 version only - spread 8 source words over the 2 lanes
+sand30_perm0:  dd 0, 1, 2, 3, 2, 3, 4, 5
+sand30_perm2:  dd 2, 3, 4, 5, 4, 5, 6, 7
+
+SECTION .text
+
+%if ARCH_X86_64
+
+%macro SAND30_CONSTS 1 ; table prefix
+    mova   m6, [%1_shuf + 0 * mmsize]
+    mova   m7, [%1_shuf + 1 * mmsize]
+    mova   m8, [%1_shuf + 2 * mmsize]
+    mova   m9, [%1_mul  + 0 * mmsize]
+    mova  m10, [%1_mul  + 1 * mmsize]
+    mova  m11, [%1_mul  + 2 * mmsize]
+%if cpuflag(avx2)
+    mova  m12, [sand30_perm0]
+    mova  m13, [sand30_perm2]
+%endif
+%endmacro
+
+; Load 2 * mmsize bytes of source words from srcq + xq and leave 3 registers
+; (m0-m2) of samples shifted into the top 10 bits of each word
+%macro SAND30_UNPACK 0
+    movu       m0, [srcq + xq]
+    movu       m1, [srcq + xq + mmsize / 2]
+    movu       m2, [srcq + xq + mmsize]
+%if cpuflag(avx2)
+    vpermd     m0, m12, m0
+    vpermd     m2, m13, m2
+%endif
+    pshufb     m0, m6
+    pshufb     m1, m7
+    pshufb     m2, m8
+    pmullw     m0, m9
+    pmullw     m1, m10
+    pmullw     m2, m11
+%endmacro
+
+; void ff_rpi_sand30_to_y16(uint8_t *dst, ptrdiff_t dst_stride,
+;                           const uint8_t *src, ptrdiff_t src_stride,
+;                           int w, int h)
+%macro SAND30_TO_Y16 0
+cglobal rpi_sand30_to_y16, 6, 8, 14, dst, dst_stride, src, src_stride, w, h, x, out
+    movsxdifnidn wq, wd
+    SAND30_CONSTS sand30_y
+
+.row:
+    xor        xd, xd
+    mov        outq, dstq
+.loop:
+    SAND30_UNPACK
+    psrlw      m0, 6
+    psrlw      m1, 6
+    psrlw      m2, 6
+    movu       [outq + 0 * mmsize], m0
+    movu       [outq + 1 * mmsize], m1
+    movu       [outq + 2 * mmsize], m2
+    add        outq, 3 * mmsize
+    add        xq, 2 * mmsize
+    cmp        xq, wq
+    jl .loop
+
+    add        srcq, src_strideq
+    add        dstq, dst_strideq
+    dec        hd
+    jg .row
+    RET
+%endmacro
+
+; void ff_rpi_sand30_to_y8(uint8_t *dst, ptrdiff_t dst_stride,
+;                          const uint8_t *src, ptrdiff_t src_stride,
+;                          int w, int h)
+%macro SAND30_TO_Y8 0
+cglobal rpi_sand30_to_y8, 6, 8, 14, dst, dst_stride, src, src_stride, w, h, x, out
+    movsxdifnidn wq, wd
+    SAND30_CONSTS sand30_y
+
+.row:
+    xor        xd, xd
+    mov        outq, dstq
+.loop:
+    SAND30_UNPACK
+    psrlw      m0, 8
+    psrlw      m1, 8
+    psrlw      m2, 8
+    packuswb   m0, m1
+    packuswb   m2, m2
+%if cpuflag(avx2)
+    vpermq     m0, m0, q3120
+    vpermq     m2, m2, q3120
+    movu       [outq], m0
+    movu       [outq + mmsize], xm2
+%else
+    movu       [outq], m0
+    movq       [outq + mmsize], m2
+%endif
+    add        outq, 3 * mmsize / 2
+    add        xq, 2 * mmsize
+    cmp        xq, wq
+    jl .loop
+
+    add        srcq, src_strideq
+    add        dstq, dst_strideq
+    dec        hd
+    jg .row
+    RET
+%endmacro
+
+; void ff_rpi_sand30_to_c16(uint8_t *dst_u, ptrdiff_t dst_stride_u,
+;                           uint8_t *dst_v, ptrdiff_t dst_stride_v,
+;                           const uint8_t *src, ptrdiff_t src_stride,
+;                           int w, int h)
+%macro SAND30_TO_C16 0
+cglobal rpi_sand30_to_c16, 8, 11, 14, dst_u, dst_stride_u, dst_v, dst_stride_v, src, src_stride, w, h, x, du, dv
+    movsxdifnidn wq, wd
+    SAND30_CONSTS sand30_c
+
+.row:
+    xor        xd, xd
+    mov        duq, dst_uq
+    mov        dvq, dst_vq
+.loop:
+    SAND30_UNPACK
+    psrlw      m0, 6
+    psrlw      m1, 6
+    psrlw      m2, 6
+%if cpuflag(avx2)
+    vpermq     m0, m0, q3120
+    vpermq     m1, m1, q3120
+    vpermq     m2, m2, q3120
+    movu       [duq +  0], xm0
+    movu       [duq + 16], xm1
+    movu       [duq + 32], xm2
+    vextracti128 [dvq +  0], m0, 1
+    vextracti128 [dvq + 16], m1, 1
+    vextracti128 [dvq + 32], m2, 1
+%else
+    punpckhqdq m3, m0, m1
+    punpcklqdq m0, m1
+    movu       [duq], m0
+    movq       [duq + 16], m2
+    movu       [dvq], m3
+    movhps     [dvq + 16], m2
+%endif
+    add        duq, 3 * mmsize / 2
+    add        dvq, 3 * mmsize / 2
+    add        xq, 2 * mmsize
+    cmp        xq, wq
+    jl .loop
+
+    add        srcq, src_strideq
+    add        dst_uq, dst_stride_uq
+    add        dst_vq, dst_stride_vq
+    dec        hd
+    jg .row
+    RET
+%endmacro
+
+INIT_XMM ssse3
+SAND30_TO_Y16
+SAND30_TO_Y8
+SAND30_TO_C16
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SAND30_TO_Y16
+SAND30_TO_Y8
+SAND30_TO_C16
+%endif
+
+; void ff_rpi_sand8_to_c8(uint8_t *dst_u, ptrdiff_t dst_stride_u,
+;                         uint8_t *dst_v, ptrdiff_t dst_stride_v,
+;                         const uint8_t *src, ptrdiff_t src_stride,
+;                         int w, int h)
+%macro SAND8_TO_C8 0
+cglobal rpi_sand8_to_c8, 8, 11, 5, dst_u, dst_stride_u, dst_v, dst_stride_v, src, src_stride, w, h, x, du, dv
+    movsxdifnidn wq, wd
+    pcmpeqw    m4, m4
+    psrlw      m4, 8
+
+.row:
+    xor        xd, xd
+    mov        duq, dst_uq
+    mov        dvq, dst_vq
+.loop:
+    movu       m0, [srcq + xq]
+    movu       m1, [srcq + xq + mmsize]
+    psrlw      m2, m0, 8
+    psrlw      m3, m1, 8
+    pand       m0, m4
+    pand       m1, m4
+    packuswb   m0, m1
+    packuswb   m2, m3
+%if cpuflag(avx2)
+    vpermq     m0, m0, q3120
+    vpermq     m2, m2, q3120
+%endif
+    movu       [duq], m0
+    movu       [dvq], m2
+    add        duq, mmsize
+    add        dvq, mmsize
+    add        xq, 2 * mmsize
+    cmp        xq, wq
+    jl .loop
+
+    add        srcq, src_strideq
+    add        dst_uq, dst_stride_uq
+    add        dst_vq, dst_stride_vq
+    dec        hd
+    jg .row
+    RET
+%endmacro
+
+; void ff_rpi_sand16_to_8(uint8_t *dst, ptrdiff_t dst_stride,
+;                         const uint8_t *src, ptrdiff_t src_stride,
+;                         int w, int h, int shift)
+;
+; (x + (1 << shift >> 1)) >> shift is done as pavgw(x >> (shift - 1), 0)
+; which cannot overflow. The result is masked to 8 bits rather than
+; saturated to match the truncation done by C.
+%macro SAND16_TO_8 0
+cglobal rpi_sand16_to_8, 7, 8, 6, dst, dst_stride, src, src_stride, w, h, shift, x
+    movsxdifnidn wq, wd
+    shr        wq, 1
+    dec        shiftd
+    movd       xm4, shiftd
+    pxor       m3, m3
+    pcmpeqw    m5, m5
+    psrlw      m5, 8
+
+.row:
+    xor        xd, xd
+.loop:
+    movu       m0, [srcq + 2 * xq]
+    movu       m1, [srcq + 2 * xq + mmsize]
+    psrlw      m0, xm4
+    psrlw      m1, xm4
+    pavgw      m0, m3
+    pavgw      m1, m3
+    pand       m0, m5
+    pand       m1, m5
+    packuswb   m0, m1
+%if cpuflag(avx2)
+    vpermq     m0, m0, q3120
+%endif
+    movu       [dstq + xq], m0
+    add        xq, mmsize
+    cmp        xq, wq
+    jl .loop
+
+    add        srcq, src_strideq
+    add        dstq, dst_strideq
+    dec        hd
+    jg .row
+    RET
+%endmacro
+
+INIT_XMM sse2
+SAND8_TO_C8
+SAND16_TO_8
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SAND8_TO_C8
+SAND16_TO_8
+%endif
+
+%endif ; ARCH_X86_64
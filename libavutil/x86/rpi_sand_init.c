@@ -0,0 +1,77 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/rpi_sand_dsp.h"
+#include "cpu.h"
+
+#define SAND30_FUNCS(opt)                                                     \
+void ff_rpi_sand30_to_y16_ ## opt(uint8_t *dst, ptrdiff_t dst_stride,         \
+                                  const uint8_t *src, ptrdiff_t src_stride,   \
+                                  int w, int h);                              \
+void ff_rpi_sand30_to_y8_ ## opt(uint8_t *dst, ptrdiff_t dst_stride,          \
+                                 const uint8_t *src, ptrdiff_t src_stride,    \
+                                 int w, int h);                               \
+void ff_rpi_sand30_to_c16_ ## opt(uint8_t *dst_u, ptrdiff_t dst_stride_u,     \
+                                  uint8_t *dst_v, ptrdiff_t dst_stride_v,     \
+                                  const uint8_t *src, ptrdiff_t src_stride,   \
+                                  int w, int h);
+
+#define SAND8_FUNCS(opt)                                                      \
+void ff_rpi_sand8_to_c8_ ## opt(uint8_t *dst_u, ptrdiff_t dst_stride_u,       \
+                                uint8_t *dst_v, ptrdiff_t dst_stride_v,       \
+                                const uint8_t *src, ptrdiff_t src_stride,     \
+                                int w, int h);                                \
+void ff_rpi_sand16_to_8_ ## opt(uint8_t *dst, ptrdiff_t dst_stride,           \
+                                const uint8_t *src, ptrdiff_t src_stride,     \
+                                int w, int h, int shift);
+
+SAND30_FUNCS(ssse3)
+SAND30_FUNCS(avx2)
+SAND8_FUNCS(sse2)
+SAND8_FUNCS(avx2)
+
+av_cold void ff_rpi_sand_dsp_init_x86(RpiSandDSPContext *c)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        c->sand8_to_c8 = ff_rpi_sand8_to_c8_sse2;
+        c->sand16_to_8 = ff_rpi_sand16_to_8_sse2;
+    }
+    if (EXTERNAL_SSSE3(cpu_flags)) {
+        c->sand30_to_y16 = ff_rpi_sand30_to_y16_ssse3;
+        c->sand30_to_y8  = ff_rpi_sand30_to_y8_ssse3;
+        c->sand30_to_c16 = ff_rpi_sand30_to_c16_ssse3;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        c->sand8_to_c8   = ff_rpi_sand8_to_c8_avx2;
+        c->sand16_to_8   = ff_rpi_sand16_to_8_avx2;
+        c->sand30_to_y16 = ff_rpi_sand30_to_y16_avx2;
+        c->sand30_to_y8  = ff_rpi_sand30_to_y8_avx2;
+        c->sand30_to_c16 = ff_rpi_sand30_to_c16_avx2;
+    }
+#endif
+}
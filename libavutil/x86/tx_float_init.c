@@ -0,0 +1,237 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#define TX_FLOAT
+#include "libavutil/tx_priv.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+
+void ff_tx_fft_sr_float_sse (FFTComplex *z, int nbits);
+void ff_tx_fft_sr_float_avx (FFTComplex *z, int nbits);
+void ff_tx_fft_sr_float_avx2(FFTComplex *z, int nbits);
+
+/* The transforms below are the monolithic ones of tx_template.c with the
+ * power-of-two FFT replaced by the SIMD one, which works on a different
+ * input permutation (see gen_revtab_simd()). */
+
+static av_always_inline void fft_sr(AVTXContext *s, void *_out, void *_in,
+                                    void (*fft)(FFTComplex *z, int nbits))
+{
+    FFTComplex *in = _in;
+    FFTComplex *out = _out;
+    int m = s->m, mb = av_log2(m);
+
+    if (s->flags & AV_TX_INPLACE) {
+        FFTComplex tmp;
+        int src, dst, *inplace_idx = s->inplace_idx;
+
+        /* unlike the C permutation, this one may have no cycles at all */
+        while ((src = *inplace_idx++)) {
+            tmp = out[src];
+            dst = s->revtab[src];
+            do {
+                FFSWAP(FFTComplex, tmp, out[dst]);
+                dst = s->revtab[dst];
+            } while (dst != src);
+            out[dst] = tmp;
+        }
+    } else {
+        for (int i = 0; i < m; i++)
+            out[i] = in[s->revtab[i]];
+    }
+
+    fft(out, mb);
+}
+
+static av_always_inline void imdct_sr(AVTXContext *s, void *_dst, void *_src,
+                                      ptrdiff_t stride,
+                                      void (*fft)(FFTComplex *z, int nbits))
+{
+    FFTComplex *z = _dst, *exp = s->exptab;
+    const int m = s->m, len8 = m >> 1;
+    const FFTSample *src = _src, *in1, *in2;
+
+    stride /= sizeof(*src);
+    in1 = src;
+    in2 = src + ((m*2) - 1) * stride;
+
+    for (int i = 0; i < m; i++) {
+        FFTComplex tmp = { in2[-2*i*stride], in1[2*i*stride] };
+        CMUL3(z[s->revtab[i]], tmp, exp[i]);
+    }
+
+    fft(z, av_log2(m));
+
+    for (int i = 0; i < len8; i++) {
+        const int i0 = len8 + i, i1 = len8 - i - 1;
+        FFTComplex src1 = { z[i1].im, z[i1].re };
+        FFTComplex src0 = { z[i0].im, z[i0].re };
+
+        CMUL(z[i1].re, z[i0].im, src1.re, src1.im, exp[i1].im, exp[i1].re);
+        CMUL(z[i0].re, z[i1].im, src0.re, src0.im, exp[i0].im, exp[i0].re);
+    }
+}
+
+static av_always_inline void mdct_sr(AVTXContext *s, void *_dst, void *_src,
+                                     ptrdiff_t stride,
+                                     void (*fft)(FFTComplex *z, int nbits))
+{
+    FFTSample *src = _src, *dst = _dst;
+    FFTComplex *exp = s->exptab, tmp, *z = _dst;
+    const int m = s->m, len4 = m, len3 = len4 * 3, len8 = len4 >> 1;
+
+    stride /= sizeof(*dst);
+
+    for (int i = 0; i < m; i++) { /* Folding and pre-reindexing */
+        const int k = 2*i;
+        if (k < len4) {
+            tmp.re = FOLD(-src[ len4 + k],  src[1*len4 - 1 - k]);
+            tmp.im = FOLD(-src[ len3 + k], -src[1*len3 - 1 - k]);
+        } else {
+            tmp.re = FOLD(-src[ len4 + k], -src[5*len4 - 1 - k]);
+            tmp.im = FOLD( src[-len4 + k], -src[1*len3 - 1 - k]);
+        }
+        CMUL(z[s->revtab[i]].im, z[s->revtab[i]].re, tmp.re, tmp.im,
+             exp[i].re, exp[i].im);
+    }
+
+    fft(z, av_log2(m));
+
+    for (int i = 0; i < len8; i++) {
+        const int i0 = len8 + i, i1 = len8 - i - 1;
+        FFTComplex src1 = { z[i1].re, z[i1].im };
+        FFTComplex src0 = { z[i0].re, z[i0].im };
+
+        CMUL(dst[2*i1*stride + stride], dst[2*i0*stride], src0.re, src0.im,
+             exp[i0].im, exp[i0].re);
+        CMUL(dst[2*i0*stride + stride], dst[2*i1*stride], src1.re, src1.im,
+             exp[i1].im, exp[i1].re);
+    }
+}
+
+#define DECL_SR_TX(opt)                                                        \
+static void fft_sr_ ## opt(AVTXContext *s, void *out, void *in,                \
+                           ptrdiff_t stride)                                   \
+{                                                                              \
+    fft_sr(s, out, in, ff_tx_fft_sr_float_ ## opt);                            \
+}                                                                              \
+                                                                               \
+static void imdct_sr_ ## opt(AVTXContext *s, void *dst, void *src,             \
+                             ptrdiff_t stride)                                 \
+{                                                                              \
+    imdct_sr(s, dst, src, stride, ff_tx_fft_sr_float_ ## opt);                 \
+}                                                                              \
+                                                                               \
+static void mdct_sr_ ## opt(AVTXContext *s, void *dst, void *src,              \
+                            ptrdiff_t stride)                                  \
+{                                                                              \
+    mdct_sr(s, dst, src, stride, ff_tx_fft_sr_float_ ## opt);                  \
+}
+
+DECL_SR_TX(sse)
+DECL_SR_TX(avx)
+DECL_SR_TX(avx2)
+
+static int is_second_half_of_fft32(int i, int n)
+{
+    if (n <= 32)
+        return i >= 16;
+    else if (i < n/2)
+        return is_second_half_of_fft32(i, n/2);
+    else if (i < 3*n/4)
+        return is_second_half_of_fft32(i - n/2, n/4);
+    else
+        return is_second_half_of_fft32(i - 3*n/4, n/4);
+}
+
+/* Position of the i-th input of the split-radix FFT in the SIMD layout */
+static int simd_permutation(int i, int n, int avx)
+{
+    static const int avx_tab[] = {
+        0, 4, 1, 5, 8, 12, 9, 13, 2, 6, 3, 7, 10, 14, 11, 15
+    };
+
+    if (!avx)
+        return (i & ~3) | ((i >> 1) & 1) | ((i << 1) & 2);
+    if (is_second_half_of_fft32(i & ~15, n))
+        return (i & ~15) + avx_tab[i & 15];
+    return (i & ~7) | ((i >> 1) & 3) | ((i << 2) & 4);
+}
+
+/* Same lookup direction as ff_tx_gen_ptwo_revtab() used for this context */
+static av_cold int gen_revtab_simd(AVTXContext *s, int avx)
+{
+    const int m = s->m, inv = s->inv;
+    const int invert_lookup = s->type == AV_TX_FLOAT_FFT &&
+                              !(s->flags & AV_TX_INPLACE);
+
+    for (int i = 0; i < m; i++) {
+        int k = -split_radix_permutation(i, m, inv) & (m - 1);
+        int j = simd_permutation(i, m, avx);
+        if (invert_lookup)
+            s->revtab[j] = k;
+        else
+            s->revtab[k] = j;
+    }
+
+    if (s->flags & AV_TX_INPLACE) {
+        av_freep(&s->inplace_idx);
+        return ff_tx_gen_ptwo_inplace_revtab_idx(s);
+    }
+
+    return 0;
+}
+
+av_cold int ff_tx_init_float_x86(AVTXContext *s, av_tx_fn *tx)
+{
+    int cpu_flags = av_get_cpu_flags();
+    const int is_mdct = ff_tx_type_is_mdct(s->type);
+    const int nbits = av_log2(s->m);
+    av_tx_fn fft = NULL, imdct = NULL, mdct = NULL;
+    int avx = 0;
+
+    /* Only the monolithic power-of-two transforms have SIMD versions */
+    if (s->n != 1 || nbits < 2)
+        return 0;
+
+    if (EXTERNAL_SSE(cpu_flags)) {
+        fft   = fft_sr_sse;
+        imdct = imdct_sr_sse;
+        mdct  = mdct_sr_sse;
+    }
+    if (EXTERNAL_AVX_FAST(cpu_flags) && nbits >= 5) {
+        fft   = fft_sr_avx;
+        imdct = imdct_sr_avx;
+        mdct  = mdct_sr_avx;
+        avx   = 1;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags) && EXTERNAL_FMA3(cpu_flags) && nbits >= 5) {
+        fft   = fft_sr_avx2;
+        imdct = imdct_sr_avx2;
+        mdct  = mdct_sr_avx2;
+        avx   = 1;
+    }
+
+    if (!fft)
+        return 0;
+
+    *tx = is_mdct ? s->inv ? imdct : mdct : fft;
+
+    return gen_revtab_simd(s, avx);
+}
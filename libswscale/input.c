@@ -762,6 +762,54 @@ static void p016BEToUV_c(uint8_t *dstU, uint8_t *dstV,
     }
 }
 
+/* SAND line pointers address the first stripe only, sand_stride[0] is the
+ * stripe width and sand_stride[1] the distance between stripes (bytes). */
+static void sand8ToY_c(uint8_t *dst, const uint8_t *src, const uint8_t *unused1,
+                       const uint8_t *unused2, int width, uint32_t *sand_stride)
+{
+    const int n = sand_stride[0];
+    int i;
+    for (i = 0; i < width; i += n, src += sand_stride[1])
+        memcpy(dst + i, src, FFMIN(n, width - i));
+}
+
+static void sand8ToUV_c(uint8_t *dstU, uint8_t *dstV,
+                        const uint8_t *unused0, const uint8_t *src1, const uint8_t *src2,
+                        int width, uint32_t *sand_stride)
+{
+    const int n = sand_stride[0] / 2;
+    int i;
+    for (i = 0; i < width; i += n, src1 += sand_stride[1])
+        nvXXtoUV_c(dstU + i, dstV + i, src1, FFMIN(n, width - i));
+}
+
+static void sand16ToY_c(uint8_t *dst, const uint8_t *src, const uint8_t *unused1,
+                        const uint8_t *unused2, int width, uint32_t *sand_stride)
+{
+    const int n = sand_stride[0] / 2;
+    int i, j;
+    for (i = 0; i < width; i += n, src += sand_stride[1]) {
+        const int w = FFMIN(n, width - i);
+        for (j = 0; j < w; j++)
+            AV_WN16(dst + (i + j) * 2, AV_RL16(src + j * 2));
+    }
+}
+
+static void sand16ToUV_c(uint8_t *dstU, uint8_t *dstV,
+                         const uint8_t *unused0, const uint8_t *src1, const uint8_t *src2,
+                         int width, uint32_t *sand_stride)
+{
+    const int n = sand_stride[0] / 4;
+    int i, j;
+    for (i = 0; i < width; i += n, src1 += sand_stride[1]) {
+        const int w = FFMIN(n, width - i);
+        for (j = 0; j < w; j++) {
+            AV_WN16(dstU + (i + j) * 2, AV_RL16(src1 + j * 4 + 0));
+            AV_WN16(dstV + (i + j) * 2, AV_RL16(src1 + j * 4 + 2));
+        }
+    }
+}
+
 #define input_pixel(pos) (isBE(origin) ? AV_RB16(pos) : AV_RL16(pos))
 
 static void bgr24ToY_c(uint8_t *_dst, const uint8_t *src, const uint8_t *unused1, const uint8_t *unused2,
@@ -1254,6 +1302,13 @@ av_cold void ff_sws_init_input_funcs(SwsContext *c)
     case AV_PIX_FMT_P016BE:
         c->chrToYV12 = p016BEToUV_c;
         break;
+    case AV_PIX_FMT_SAND128:
+        c->chrToYV12 = sand8ToUV_c;
+        break;
+    case AV_PIX_FMT_SAND64_10:
+    case AV_PIX_FMT_SAND64_16:
+        c->chrToYV12 = sand16ToUV_c;
+        break;
     case AV_PIX_FMT_Y210LE:
         c->chrToYV12 = y210le_UV_c;
         break;
@@ -1691,6 +1746,13 @@ av_cold void ff_sws_init_input_funcs(SwsContext *c)
     case AV_PIX_FMT_P010BE:
         c->lumToYV12 = p010BEToY_c;
         break;
+    case AV_PIX_FMT_SAND128:
+        c->lumToYV12 = sand8ToY_c;
+        break;
+    case AV_PIX_FMT_SAND64_10:
+    case AV_PIX_FMT_SAND64_16:
+        c->lumToYV12 = sand16ToY_c;
+        break;
     case AV_PIX_FMT_GRAYF32LE:
 #if HAVE_BIGENDIAN
         c->lumToYV12 = grayf32ToY16_bswap_c;
@@ -775,6 +775,16 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
         return AVERROR(EINVAL);
     }
 
+    if (isSAND(c->srcFormat)) {
+        // linesize[3] of a SAND frame holds the stripe height in lines
+        if (srcStride[0] <= 0 || srcStride[3] <= 0) {
+            av_log(c, AV_LOG_ERROR, "Invalid SAND strides %d, %d\n", srcStride[0], srcStride[3]);
+            return AVERROR(EINVAL);
+        }
+        c->sand_stride[0] = srcStride[0];
+        c->sand_stride[1] = srcStride[0] * srcStride[3];
+    }
+
     if (c->gamma_flag && c->cascaded_context[0]) {
         ret = sws_scale(c->cascaded_context[0],
                     srcSlice, srcStride, srcSliceY, srcSliceH,
@@ -339,6 +339,13 @@ typedef struct SwsContext {
     uint32_t pal_yuv[256];
     uint32_t pal_rgb[256];
 
+    /**
+     * SAND input: stripe width and distance between stripes, in bytes.
+     * Set by sws_scale() from srcStride[0] and srcStride[3] and passed to
+     * the input functions in place of the palette.
+     */
+    uint32_t sand_stride[2];
+
     float uint2float_lut[256];
 
     /**
@@ -796,11 +803,20 @@ static av_always_inline int isALPHA(enum AVPixelFormat pix_fmt)
     return desc->flags & AV_PIX_FMT_FLAG_ALPHA;
 }
 
+/* Y plane + interleaved UV plane, both cut into vertical stripes.
+ * The descriptors lack AV_PIX_FMT_FLAG_PLANAR but they are semi-planar. */
+static av_always_inline int isSAND(enum AVPixelFormat pix_fmt)
+{
+    return pix_fmt == AV_PIX_FMT_SAND128   ||
+           pix_fmt == AV_PIX_FMT_SAND64_10 ||
+           pix_fmt == AV_PIX_FMT_SAND64_16;
+}
+
 static av_always_inline int isPacked(enum AVPixelFormat pix_fmt)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
     av_assert0(desc);
-    return (desc->nb_components >= 2 && !(desc->flags & AV_PIX_FMT_FLAG_PLANAR)) ||
+    return (desc->nb_components >= 2 && !(desc->flags & AV_PIX_FMT_FLAG_PLANAR) && !isSAND(pix_fmt)) ||
             pix_fmt == AV_PIX_FMT_PAL8 ||
             pix_fmt == AV_PIX_FMT_MONOBLACK || pix_fmt == AV_PIX_FMT_MONOWHITE;
 }
@@ -809,7 +825,8 @@ static av_always_inline int isPlanar(enum AVPixelFormat pix_fmt)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
     av_assert0(desc);
-    return (desc->nb_components >= 2 && (desc->flags & AV_PIX_FMT_FLAG_PLANAR));
+    return (desc->nb_components >= 2 && (desc->flags & AV_PIX_FMT_FLAG_PLANAR)) ||
+            isSAND(pix_fmt);
 }
 
 static av_always_inline int isPackedRGB(enum AVPixelFormat pix_fmt)
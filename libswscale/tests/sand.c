@@ -0,0 +1,255 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check SAND input of sws_scale(): a random SAND frame is converted to
+ * several output formats and sizes, and the result must be identical to
+ * the conversion of the same picture laid out as plain yuv420p(10/16).
+ * Converting to the planar layout at the same size must reproduce it
+ * exactly. The one exception is a same size reduction of 10/16 bit input to
+ * 8 bit: the planar input takes the unscaled copy, which dithers, while SAND
+ * input always goes through the scaler, so they may differ by one.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/imgutils.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+
+#define STRIPE_W 128
+
+typedef struct Picture {
+    uint8_t *data[4];
+    int linesize[4];
+} Picture;
+
+static const struct {
+    enum AVPixelFormat sand, planar;
+    int depth;
+} formats[] = {
+    { AV_PIX_FMT_SAND128,   AV_PIX_FMT_YUV420P,   8 },
+    { AV_PIX_FMT_SAND64_10, AV_PIX_FMT_YUV420P10, 10 },
+    { AV_PIX_FMT_SAND64_16, AV_PIX_FMT_YUV420P16, 16 },
+};
+
+static const enum AVPixelFormat dst_fmts[] = {
+    AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12, AV_PIX_FMT_RGB24, AV_PIX_FMT_BGRA,
+};
+
+static const int sizes[][2] = {
+    { 300, 68 }, { 516, 36 },
+};
+
+static const int dst_sizes[][2] = {
+    { 0, 0 }, { 176, 100 },
+};
+
+static void free_picture(Picture *p)
+{
+    av_freep(&p->data[0]);
+    av_freep(&p->data[1]);
+}
+
+/* Luma and chroma each get their own buffer of whole stripes, with a few
+ * spare lines per stripe as the decoders allocate them. */
+static int alloc_sand(Picture *p, int bpp, int w, int h)
+{
+    const int stripe_h = h + 8;
+    const int size = (w * bpp + STRIPE_W - 1) / STRIPE_W * STRIPE_W * stripe_h;
+
+    memset(p, 0, sizeof(*p));
+    p->data[0] = av_mallocz(size);
+    p->data[1] = av_mallocz(size);
+    if (!p->data[0] || !p->data[1]) {
+        free_picture(p);
+        return AVERROR(ENOMEM);
+    }
+    p->linesize[0] = p->linesize[1] = STRIPE_W;
+    p->linesize[3] = stripe_h;
+    return 0;
+}
+
+static uint8_t *sand_pos(const Picture *p, int plane, int x_bytes, int y)
+{
+    return p->data[plane] + (x_bytes / STRIPE_W) * STRIPE_W * p->linesize[3] +
+           y * STRIPE_W + x_bytes % STRIPE_W;
+}
+
+/* Fill the SAND picture with random samples and write the same samples to
+ * the planar picture. */
+static void fill(Picture *sand, uint8_t *planar[4], const int planar_ls[4],
+                 int depth, int w, int h, AVLFG *lfg)
+{
+    const int bpp  = depth > 8 ? 2 : 1;
+    const int mask = (1 << depth) - 1;
+    int x, y, c;
+
+    for (y = 0; y < h; y++)
+        for (x = 0; x < w; x++) {
+            const int v = av_lfg_get(lfg) & mask;
+            uint8_t *d = planar[0] + y * planar_ls[0] + x * bpp;
+            uint8_t *s = sand_pos(sand, 0, x * bpp, y);
+            if (bpp == 1)
+                *d = *s = v;
+            else {
+                AV_WN16(d, v);
+                AV_WL16(s, v);
+            }
+        }
+    for (y = 0; y < h / 2; y++)
+        for (x = 0; x < w / 2; x++)
+            for (c = 0; c < 2; c++) {
+                const int v = av_lfg_get(lfg) & mask;
+                uint8_t *d = planar[1 + c] + y * planar_ls[1 + c] + x * bpp;
+                uint8_t *s = sand_pos(sand, 1, (2 * x + c) * bpp, y);
+                if (bpp == 1)
+                    *d = *s = v;
+                else {
+                    AV_WN16(d, v);
+                    AV_WL16(s, v);
+                }
+            }
+}
+
+static int convert(enum AVPixelFormat src_fmt, const uint8_t *const src[4],
+                   const int src_ls[4], int w, int h,
+                   enum AVPixelFormat dst_fmt, uint8_t *dst[4], int dst_ls[4],
+                   int dw, int dh)
+{
+    struct SwsContext *sws = sws_getContext(w, h, src_fmt, dw, dh, dst_fmt,
+                                            SWS_BICUBIC | SWS_ACCURATE_RND | SWS_BITEXACT,
+                                            NULL, NULL, NULL);
+    int ret;
+
+    if (!sws)
+        return AVERROR(EINVAL);
+    ret = sws_scale(sws, src, src_ls, 0, h, dst, dst_ls);
+    sws_freeContext(sws);
+    return ret == dh ? 0 : AVERROR(EINVAL);
+}
+
+/* Return the largest difference between two pictures of an 8 bit format,
+ * or 256 for any difference in other formats. */
+static int compare(enum AVPixelFormat fmt, uint8_t *a[4], const int a_ls[4],
+                   uint8_t *b[4], const int b_ls[4], int w, int h)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+    const int depth8 = desc->comp[0].depth == 8;
+    int lw[4], p, x, y, maxdiff = 0;
+
+    av_image_fill_linesizes(lw, fmt, w);
+    for (p = 0; p < 4 && a[p]; p++) {
+        const int ph = p == 1 || p == 2 ? AV_CEIL_RSHIFT(h, desc->log2_chroma_h) : h;
+        for (y = 0; y < ph; y++) {
+            const uint8_t *pa = a[p] + y * a_ls[p], *pb = b[p] + y * b_ls[p];
+            if (!depth8) {
+                if (memcmp(pa, pb, lw[p]))
+                    return 256;
+                continue;
+            }
+            for (x = 0; x < lw[p]; x++)
+                maxdiff = FFMAX(maxdiff, FFABS(pa[x] - pb[x]));
+        }
+    }
+    return maxdiff;
+}
+
+static int run(int f, int w, int h, AVLFG *lfg)
+{
+    Picture sand;
+    uint8_t *planar[4], *out_s[4] = { NULL }, *out_p[4] = { NULL };
+    int planar_ls[4], out_s_ls[4], out_p_ls[4];
+    int i, j, ret, diff;
+
+    if ((ret = alloc_sand(&sand, formats[f].depth > 8 ? 2 : 1, w, h)) < 0)
+        return ret;
+    if ((ret = av_image_alloc(planar, planar_ls, w, h, formats[f].planar, 16)) < 0) {
+        free_picture(&sand);
+        return ret;
+    }
+    fill(&sand, planar, planar_ls, formats[f].depth, w, h, lfg);
+
+    /* Same size to the matching planar format is a plain copy */
+    ret = av_image_alloc(out_s, out_s_ls, w, h, formats[f].planar, 16);
+    if (ret >= 0)
+        ret = convert(formats[f].sand, (const uint8_t * const *)sand.data, sand.linesize,
+                      w, h, formats[f].planar, out_s, out_s_ls, w, h);
+    if (ret < 0)
+        goto end;
+    diff = compare(formats[f].planar, out_s, out_s_ls, planar, planar_ls, w, h);
+    printf("%s %dx%d -> %s %dx%d: %s\n", av_get_pix_fmt_name(formats[f].sand), w, h,
+           av_get_pix_fmt_name(formats[f].planar), w, h, diff ? "FAIL" : "ok");
+    ret = diff ? AVERROR(EINVAL) : 0;
+    av_freep(&out_s[0]);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(dst_fmts); i++)
+        for (j = 0; j < FF_ARRAY_ELEMS(dst_sizes); j++) {
+            const int dw = dst_sizes[j][0] ? dst_sizes[j][0] : w;
+            const int dh = dst_sizes[j][1] ? dst_sizes[j][1] : h;
+            int r;
+
+            if ((r = av_image_alloc(out_s, out_s_ls, dw, dh, dst_fmts[i], 16)) < 0 ||
+                (r = av_image_alloc(out_p, out_p_ls, dw, dh, dst_fmts[i], 16)) < 0) {
+                av_freep(&out_s[0]);
+                ret = r;
+                goto end;
+            }
+            r = convert(formats[f].sand, (const uint8_t * const *)sand.data, sand.linesize,
+                        w, h, dst_fmts[i], out_s, out_s_ls, dw, dh);
+            if (r >= 0)
+                r = convert(formats[f].planar, (const uint8_t * const *)planar, planar_ls,
+                            w, h, dst_fmts[i], out_p, out_p_ls, dw, dh);
+            diff = r < 0 ? 1 : compare(dst_fmts[i], out_s, out_s_ls, out_p, out_p_ls, dw, dh);
+            if (diff == 1 && formats[f].depth > 8 && dst_fmts[i] == AV_PIX_FMT_YUV420P &&
+                dw == w && dh == h)
+                diff = 0;
+            printf("%s %dx%d -> %s %dx%d: %s\n", av_get_pix_fmt_name(formats[f].sand), w, h,
+                   av_get_pix_fmt_name(dst_fmts[i]), dw, dh, diff ? "FAIL" : "ok");
+            if (diff)
+                ret = AVERROR(EINVAL);
+            av_freep(&out_s[0]);
+            av_freep(&out_p[0]);
+        }
+
+end:
+    av_freep(&planar[0]);
+    free_picture(&sand);
+    return ret;
+}
+
+int main(void)
+{
+    AVLFG lfg;
+    int f, s, ret = 0;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+    for (f = 0; f < FF_ARRAY_ELEMS(formats); f++)
+        for (s = 0; s < FF_ARRAY_ELEMS(sizes); s++) {
+            int r = run(f, sizes[s][0], sizes[s][1], &lfg);
+            if (r < 0 && !ret)
+                ret = r;
+        }
+
+    return ret < 0;
+}
@@ -23,7 +23,7 @@ class tstats:
 
     def times_str(self):
         ctime = self.sys + self.user
-        return "time=%6.2f, cpu=%6.2f (%4.2f%%)" % (self.elapsed, ctime, (ctime * 100.0) / self.elapsed)
+        return "time=%8.4f, cpu=%8.4f (%4.2f%%)" % (self.elapsed, ctime, (ctime * 100.0) / self.elapsed)
 
     def dict(self):
         return {"name":self.name, "elapsed":self.elapsed, "user":self.user, "sys":self.sys}
@@ -36,14 +36,11 @@ class tstats:
     def __gt__(self, other):
         return self.elapsed > other.elapsed
 
-    def time_file(name, prefix, ffmpeg="./ffmpeg"):
+    def time_cmd(name, cmd):
         stats = tstats()
         stats.name = name
         start_time = time.clock_gettime(time.CLOCK_MONOTONIC);
-        cproc = subprocess.Popen([ffmpeg, "-no_cvt_hw",
-                                  "-vcodec", "hevc_rpi",
-                                  "-t", "30", "-i", prefix + name,
-                                  "-f", "vout_rpi", os.devnull], bufsize=-1, stdout=flog, stderr=flog);
+        cproc = subprocess.Popen(cmd, bufsize=-1, stdout=flog, stderr=flog);
         pinfo = os.wait4(cproc.pid, 0)
         end_time = time.clock_gettime(time.CLOCK_MONOTONIC);
         stats.elapsed = end_time - start_time
@@ -51,6 +48,29 @@ class tstats:
         stats.sys = pinfo[2].ru_stime
         return stats
 
+    def time_file(name, prefix, ffmpeg="./ffmpeg"):
+        return tstats.time_cmd(name, [ffmpeg, "-no_cvt_hw",
+                                      "-vcodec", "hevc_rpi",
+                                      "-t", "30", "-i", prefix + name,
+                                      "-f", "vout_rpi", os.devnull])
+
+    # Startup cost is far below timer noise for a single run so average
+    # over a number of probes of a file small enough to parse instantly
+    def time_probe(name, prefix, ffprobe="./ffprobe", runs=50):
+        stats = tstats({"name":name, "elapsed":0, "user":0, "sys":0})
+        for i in range(runs):
+            t = tstats.time_cmd(name, [ffprobe, "-hide_banner", "-show_streams", prefix + name])
+            stats.elapsed += t.elapsed / runs
+            stats.user += t.user / runs
+            stats.sys += t.sys / runs
+        return stats
+
+def make_tiny_file(ffmpeg, dir):
+    name = "ffperf_tiny.nut"
+    subprocess.check_call([ffmpeg, "-y", "-f", "lavfi", "-i", "testsrc=size=64x64:rate=1",
+                           "-frames:v", "1", os.path.join(dir, name)], stdout=flog, stderr=flog)
+    return name
+
 
 def common_prefix(s1, s2):
     for i in range(min(len(s1),len(s2))):
@@ -72,6 +92,10 @@ To blank the screen before starting use "xdg-screensaver activate"
     argp.add_argument("--prefix", help="Filename prefix (include terminal '/' if a directory).")
     argp.add_argument("--repeat", default=3, type=int, help="Run repeat count")
     argp.add_argument("--ffmpeg", default="./ffmpeg", help="FFmpeg executable")
+    argp.add_argument("--startup", action='store_true', help="Time ffprobe startup on each stream rather than decoding it. "
+                      "With no streams a tiny file is generated with --ffmpeg")
+    argp.add_argument("--ffprobe", default="./ffprobe", help="FFprobe executable")
+    argp.add_argument("--startup_runs", default=50, type=int, help="Number of probes averaged for each --startup run")
 
     args = argp.parse_args()
 
@@ -86,7 +110,10 @@ To blank the screen before starting use "xdg-screensaver activate"
     flog = open(os.path.join(tempfile.gettempdir(), "ffperf.log"), "wt")
 
     streams = args.streams
-    if not streams:
+    if not streams and args.startup and not stats_in:
+        prefix = tempfile.gettempdir() + os.sep
+        streams = [make_tiny_file(args.ffmpeg, prefix)]
+    elif not streams:
         if not stats_in:
             print ("No source streams specified")
             return 1
@@ -107,7 +134,10 @@ To blank the screen before starting use "xdg-screensaver activate"
 
         t0 = tstats({"name":f, "elapsed":999, "user":999, "sys":999})
         for i in range(args.repeat):
-            t = tstats.time_file(f, prefix, args.ffmpeg)
+            if args.startup:
+                t = tstats.time_probe(f, prefix, args.ffprobe, args.startup_runs)
+            else:
+                t = tstats.time_file(f, prefix, args.ffmpeg)
             print ("...", t.times_str())
             if t0 > t:
                 t0 = t
@@ -0,0 +1,144 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+#include <math.h>
+
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/tx.h"
+
+#include "checkasm.h"
+
+#define MAX_BITS 16
+/* generating the in-place lookup is quadratic, keep the init time sane */
+#define MAX_BITS_INPLACE 12
+
+static const float scale = 1.0f;
+
+static void randomize(float *buf, int len)
+{
+    for (int i = 0; i < len; i++)
+        buf[i] = (int32_t)rnd() / (float)INT32_MAX;
+}
+
+/* A context is bound to the function it was initialized with, so the
+ * reference is always the C transform, called directly instead of through
+ * call_ref() which may point to a previously tested SIMD version. */
+static av_tx_fn init_ref(AVTXContext **ctx, enum AVTXType type, int inv,
+                         int len, uint64_t flags)
+{
+    int cpu_flags = av_get_cpu_flags();
+    av_tx_fn fn = NULL;
+
+    av_force_cpu_flags(0);
+    if (av_tx_init(ctx, &fn, type, inv, len, &scale, flags) < 0)
+        fn = NULL;
+    av_force_cpu_flags(cpu_flags);
+
+    return fn;
+}
+
+static void check_tx(enum AVTXType type, int inv, int bits, uint64_t flags,
+                     const char *name, float *src, float *in,
+                     float *ref_out, float *new_out)
+{
+    const int is_mdct = type == AV_TX_FLOAT_MDCT;
+    const int len = 1 << bits;
+    /* the forward MDCT input is two blocks long */
+    const int nb_in  = is_mdct ? (inv ? len : 2 * len) : 2 * len;
+    const int nb_out = is_mdct ? len : 2 * len;
+    const ptrdiff_t stride = is_mdct ? sizeof(float) : sizeof(AVComplexFloat);
+    const int inplace = flags & AV_TX_INPLACE;
+    const float eps = FLT_EPSILON * 16 * bits * sqrtf(len);
+    AVTXContext *ref_ctx = NULL, *new_ctx = NULL;
+    av_tx_fn ref_fn, new_fn;
+
+    declare_func(void, AVTXContext *s, void *out, void *in, ptrdiff_t stride);
+
+    if (av_tx_init(&new_ctx, &new_fn, type, inv, len, &scale, flags) < 0)
+        return;
+
+    if (check_func(new_fn, "%s_%d", name, len)) {
+        ref_fn = init_ref(&ref_ctx, type, inv, len, flags);
+        if (!ref_fn) {
+            fail();
+            goto end;
+        }
+
+        randomize(src, nb_in);
+
+        memcpy(ref_out, src, nb_in * sizeof(float));
+        ref_fn(ref_ctx, ref_out, inplace ? ref_out : src, stride);
+
+        memcpy(new_out, src, nb_in * sizeof(float));
+        memcpy(in,      src, nb_in * sizeof(float));
+        call_new(new_ctx, new_out, inplace ? new_out : in, stride);
+
+        if (!float_near_abs_eps_array(ref_out, new_out, eps, nb_out))
+            fail();
+        if (!inplace && memcmp(in, src, nb_in * sizeof(float)))
+            fail();
+
+        bench_new(new_ctx, new_out, inplace ? new_out : in, stride);
+    }
+
+end:
+    av_tx_uninit(&ref_ctx);
+    av_tx_uninit(&new_ctx);
+}
+
+void checkasm_check_av_tx(void)
+{
+    float *src     = av_malloc(sizeof(float) << (MAX_BITS + 2));
+    float *in      = av_malloc(sizeof(float) << (MAX_BITS + 2));
+    float *ref_out = av_malloc(sizeof(float) << (MAX_BITS + 2));
+    float *new_out = av_malloc(sizeof(float) << (MAX_BITS + 2));
+
+    if (!src || !in || !ref_out || !new_out) {
+        fail();
+        goto end;
+    }
+
+    for (int bits = 2; bits <= MAX_BITS; bits++)
+        check_tx(AV_TX_FLOAT_FFT, 0, bits, 0, "fft", src, in, ref_out, new_out);
+    report("fft");
+
+    for (int bits = 2; bits <= MAX_BITS; bits++)
+        check_tx(AV_TX_FLOAT_FFT, 1, bits, 0, "ifft", src, in, ref_out, new_out);
+    report("ifft");
+
+    for (int bits = 2; bits <= MAX_BITS_INPLACE; bits++)
+        check_tx(AV_TX_FLOAT_FFT, 0, bits, AV_TX_INPLACE, "fft_inplace",
+                 src, in, ref_out, new_out);
+    report("fft_inplace");
+
+    for (int bits = 3; bits <= MAX_BITS; bits++)
+        check_tx(AV_TX_FLOAT_MDCT, 0, bits, 0, "mdct", src, in, ref_out, new_out);
+    report("mdct");
+
+    for (int bits = 3; bits <= MAX_BITS; bits++)
+        check_tx(AV_TX_FLOAT_MDCT, 1, bits, 0, "imdct", src, in, ref_out, new_out);
+    report("imdct");
+
+end:
+    av_free(src);
+    av_free(in);
+    av_free(ref_out);
+    av_free(new_out);
+}
@@ -116,6 +116,7 @@ static const struct {
     #if CONFIG_HEVC_DECODER
         { "hevc_add_res", checkasm_check_hevc_add_res },
         { "hevc_idct", checkasm_check_hevc_idct },
+        { "hevc_pred", checkasm_check_hevc_pred },
         { "hevc_qpel", checkasm_check_hevc_qpel },
         { "hevc_qpel_uni", checkasm_check_hevc_qpel_uni },
         { "hevc_qpel_uni_w", checkasm_check_hevc_qpel_uni_w },
@@ -137,6 +138,9 @@ static const struct {
     #if CONFIG_JPEG2000_DECODER
         { "jpeg2000dsp", checkasm_check_jpeg2000dsp },
     #endif
+    #if CONFIG_JPEG2000_ENCODER
+        { "jpeg2000dwt", checkasm_check_jpeg2000dwt },
+    #endif
     #if CONFIG_HUFFYUVDSP
         { "llviddsp", checkasm_check_llviddsp },
     #endif
@@ -202,8 +206,12 @@ static const struct {
     { "sw_scale", checkasm_check_sw_scale },
 #endif
 #if CONFIG_AVUTIL
+        { "av_tx", checkasm_check_av_tx },
         { "fixed_dsp", checkasm_check_fixed_dsp },
         { "float_dsp", checkasm_check_float_dsp },
+    #if CONFIG_SAND
+        { "rpi_sand", checkasm_check_rpi_sand },
+    #endif
 #endif
     { NULL }
 };
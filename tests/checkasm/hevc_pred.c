@@ -0,0 +1,157 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+#include "libavcodec/hevcpred.h"
+
+#include "checkasm.h"
+
+static const uint32_t pixel_mask[3] = { 0xffffffff, 0x03ff03ff, 0x0fff0fff };
+
+#define SIZEOF_PIXEL ((bit_depth + 7) / 8)
+#define PIXEL_STRIDE 64
+#define BUF_SIZE (PIXEL_STRIDE * 32 * 2)
+/* top/left hold [-1, 2 * size) plus some room for overreads on either side */
+#define REF_SIZE (4 * 32 * 2)
+#define REF_OFFSET (32 * 2)
+
+#define randomize_buffers(buf, size)                        \
+    do {                                                    \
+        uint32_t mask = pixel_mask[(bit_depth - 8) >> 1];   \
+        int k;                                              \
+        for (k = 0; k < size; k += 4) {                     \
+            uint32_t r = rnd() & mask;                      \
+            AV_WN32A(buf + k, r);                           \
+        }                                                   \
+    } while (0)
+
+static void check_pred_planar(HEVCPredContext *h, uint8_t *dst0, uint8_t *dst1,
+                              const uint8_t *top, const uint8_t *left, int bit_depth)
+{
+    int i;
+    declare_func(void, uint8_t *src, const uint8_t *top, const uint8_t *left,
+                 ptrdiff_t stride);
+
+    for (i = 0; i < 4; i++) {
+        int size = 4 << i;
+        if (check_func(h->pred_planar[i], "hevc_pred_planar_%dx%d_%d", size, size, bit_depth)) {
+            memset(dst0, 0, BUF_SIZE);
+            memset(dst1, 0, BUF_SIZE);
+            call_ref(dst0, top, left, PIXEL_STRIDE);
+            call_new(dst1, top, left, PIXEL_STRIDE);
+            if (memcmp(dst0, dst1, BUF_SIZE))
+                fail();
+            bench_new(dst1, top, left, PIXEL_STRIDE);
+        }
+    }
+}
+
+static void check_pred_dc(HEVCPredContext *h, uint8_t *dst0, uint8_t *dst1,
+                          const uint8_t *top, const uint8_t *left, int bit_depth)
+{
+    int i, c_idx;
+    declare_func(void, uint8_t *src, const uint8_t *top, const uint8_t *left,
+                 ptrdiff_t stride, int log2_size, int c_idx);
+
+    for (i = 2; i <= 5; i++) {
+        int size = 1 << i;
+        for (c_idx = 0; c_idx <= 1; c_idx++) {
+            if (check_func(h->pred_dc, "hevc_pred_dc_%dx%d_%s_%d", size, size,
+                           c_idx ? "chroma" : "luma", bit_depth)) {
+                memset(dst0, 0, BUF_SIZE);
+                memset(dst1, 0, BUF_SIZE);
+                call_ref(dst0, top, left, PIXEL_STRIDE, i, c_idx);
+                call_new(dst1, top, left, PIXEL_STRIDE, i, c_idx);
+                if (memcmp(dst0, dst1, BUF_SIZE))
+                    fail();
+                bench_new(dst1, top, left, PIXEL_STRIDE, i, c_idx);
+            }
+        }
+    }
+}
+
+static void check_pred_angular(HEVCPredContext *h, uint8_t *dst0, uint8_t *dst1,
+                               const uint8_t *top, const uint8_t *left, int bit_depth)
+{
+    int i, mode, c_idx;
+    declare_func(void, uint8_t *src, const uint8_t *top, const uint8_t *left,
+                 ptrdiff_t stride, int c_idx, int mode);
+
+    for (i = 0; i < 4; i++) {
+        int size = 4 << i;
+        for (mode = 2; mode <= 34; mode++) {
+            for (c_idx = 0; c_idx <= 1; c_idx++) {
+                if (check_func(h->pred_angular[i], "hevc_pred_angular_%dx%d_%d_%s_%d",
+                               size, size, mode, c_idx ? "chroma" : "luma", bit_depth)) {
+                    memset(dst0, 0, BUF_SIZE);
+                    memset(dst1, 0, BUF_SIZE);
+                    call_ref(dst0, top, left, PIXEL_STRIDE, c_idx, mode);
+                    call_new(dst1, top, left, PIXEL_STRIDE, c_idx, mode);
+                    if (memcmp(dst0, dst1, BUF_SIZE))
+                        fail();
+                    bench_new(dst1, top, left, PIXEL_STRIDE, c_idx, mode);
+                }
+            }
+        }
+    }
+}
+
+void checkasm_check_hevc_pred(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, top,  [REF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, left, [REF_SIZE]);
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 12; bit_depth += 2) {
+        HEVCPredContext h;
+
+        ff_hevc_pred_init(&h, bit_depth);
+        randomize_buffers(top,  REF_SIZE);
+        randomize_buffers(left, REF_SIZE);
+        check_pred_planar(&h, dst0, dst1, top + REF_OFFSET, left + REF_OFFSET, bit_depth);
+    }
+    report("pred_planar");
+
+    for (bit_depth = 8; bit_depth <= 12; bit_depth += 2) {
+        HEVCPredContext h;
+
+        ff_hevc_pred_init(&h, bit_depth);
+        randomize_buffers(top,  REF_SIZE);
+        randomize_buffers(left, REF_SIZE);
+        check_pred_dc(&h, dst0, dst1, top + REF_OFFSET, left + REF_OFFSET, bit_depth);
+    }
+    report("pred_dc");
+
+    for (bit_depth = 8; bit_depth <= 12; bit_depth += 2) {
+        HEVCPredContext h;
+
+        ff_hevc_pred_init(&h, bit_depth);
+        randomize_buffers(top,  REF_SIZE);
+        randomize_buffers(left, REF_SIZE);
+        /* top[-1] and left[-1] are the same corner sample */
+        memcpy(left + REF_OFFSET - SIZEOF_PIXEL, top + REF_OFFSET - SIZEOF_PIXEL, SIZEOF_PIXEL);
+        check_pred_angular(&h, dst0, dst1, top + REF_OFFSET, left + REF_OFFSET, bit_depth);
+    }
+    report("pred_angular");
+}
@@ -0,0 +1,109 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/jpeg2000dwt.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem_internal.h"
+
+#define randomize_buffers()                     \
+    do {                                        \
+        int i;                                  \
+        for (i = 0; i < FF_DWT_COLS; i++) {     \
+            src0[i] = (int32_t)rnd() >> 8;      \
+            src1[i] = (int32_t)rnd() >> 8;      \
+            dst[i]  = (int32_t)rnd() >> 8;      \
+        }                                       \
+    } while (0)
+
+static void check_lift53(void)
+{
+    LOCAL_ALIGNED_32(int32_t, src0, [FF_DWT_COLS]);
+    LOCAL_ALIGNED_32(int32_t, src1, [FF_DWT_COLS]);
+    LOCAL_ALIGNED_32(int32_t, dst,  [FF_DWT_COLS]);
+    LOCAL_ALIGNED_32(int32_t, ref,  [FF_DWT_COLS]);
+    LOCAL_ALIGNED_32(int32_t, new,  [FF_DWT_COLS]);
+    int n;
+
+    declare_func(void, int32_t *dst, const int32_t *src0,
+                 const int32_t *src1, int n);
+
+    for (n = 1; n <= FF_DWT_COLS; n++) {
+        randomize_buffers();
+        memcpy(ref, dst, FF_DWT_COLS * sizeof(*dst));
+        memcpy(new, dst, FF_DWT_COLS * sizeof(*dst));
+        call_ref(ref, src0, src1, n);
+        call_new(new, src0, src1, n);
+        if (memcmp(ref, new, n * sizeof(*dst)))
+            fail();
+    }
+    bench_new(new, src0, src1, FF_DWT_COLS);
+}
+
+static void check_lift97_int(int coef)
+{
+    LOCAL_ALIGNED_32(int32_t, src0, [FF_DWT_COLS]);
+    LOCAL_ALIGNED_32(int32_t, src1, [FF_DWT_COLS]);
+    LOCAL_ALIGNED_32(int32_t, dst,  [FF_DWT_COLS]);
+    LOCAL_ALIGNED_32(int32_t, ref,  [FF_DWT_COLS]);
+    LOCAL_ALIGNED_32(int32_t, new,  [FF_DWT_COLS]);
+    int n;
+
+    declare_func(void, int32_t *dst, const int32_t *src0,
+                 const int32_t *src1, int n, int coef);
+
+    for (n = 1; n <= FF_DWT_COLS; n++) {
+        randomize_buffers();
+        memcpy(ref, dst, FF_DWT_COLS * sizeof(*dst));
+        memcpy(new, dst, FF_DWT_COLS * sizeof(*dst));
+        call_ref(ref, src0, src1, n, coef);
+        call_new(new, src0, src1, n, coef);
+        if (memcmp(ref, new, n * sizeof(*dst)))
+            fail();
+    }
+    bench_new(new, src0, src1, FF_DWT_COLS, coef);
+}
+
+void checkasm_check_jpeg2000dwt(void)
+{
+    int border[2][2] = { { 0, 64 }, { 0, 64 } };
+    DWTContext s53 = { 0 }, s97 = { 0 };
+
+    if (ff_jpeg2000_dwt_init(&s53, border, 1, FF_DWT53) ||
+        ff_jpeg2000_dwt_init(&s97, border, 1, FF_DWT97_INT))
+        goto end;
+
+    if (check_func(s53.lift53_odd, "jpeg2000_lift53_odd"))
+        check_lift53();
+    if (check_func(s53.lift53_even, "jpeg2000_lift53_even"))
+        check_lift53();
+    report("lift53");
+
+    if (check_func(s97.lift97_int_sub, "jpeg2000_lift97_int_sub"))
+        check_lift97_int(103949);
+    if (check_func(s97.lift97_int_add, "jpeg2000_lift97_int_add"))
+        check_lift97_int(57862);
+    report("lift97_int");
+
+end:
+    ff_dwt_destroy(&s53);
+    ff_dwt_destroy(&s97);
+}
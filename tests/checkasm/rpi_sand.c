@@ -0,0 +1,275 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/rpi_sand_dsp.h"
+
+#if ARCH_ARM && HAVE_NEON
+#include "libavutil/arm/rpi_sand_neon.h"
+#define HAVE_SAND_NEON 1
+#elif ARCH_AARCH64 && HAVE_NEON
+#include "libavutil/aarch64/rpi_sand_neon.h"
+#define HAVE_SAND_NEON 1
+#else
+#define HAVE_SAND_NEON 0
+#endif
+
+#define STRIDE1    128
+#define LINES      16
+#define STRIPES    2
+#define DST_STRIDE (STRIDE1 * 2)
+#define SRC_SIZE   (STRIDE1 * LINES * STRIPES)
+#define DST_SIZE   (DST_STRIDE * LINES * STRIPES)
+
+#define randomize_buffers(buf, size, mask)          \
+    do {                                            \
+        for (int j = 0; j < size; j += 4)           \
+            AV_WN32A(buf + j, rnd() & (mask));      \
+    } while (0)
+
+static void check_sand30(const RpiSandDSPContext *c, uint8_t *src,
+                         uint8_t *dst0, uint8_t *dst1)
+{
+    declare_func(void, uint8_t *dst, ptrdiff_t dst_stride,
+                 const uint8_t *src, ptrdiff_t src_stride, int w, int h);
+
+    if (check_func(c->sand30_to_y16, "rpi_sand30_to_y16")) {
+        for (int w = 64; w <= STRIDE1; w += 64) {
+            memset(dst0, 0, DST_SIZE);
+            memset(dst1, 0, DST_SIZE);
+            call_ref(dst0, DST_STRIDE, src + STRIDE1 - w, STRIDE1, w, LINES);
+            call_new(dst1, DST_STRIDE, src + STRIDE1 - w, STRIDE1, w, LINES);
+            if (memcmp(dst0, dst1, DST_SIZE))
+                fail();
+        }
+        bench_new(dst1, DST_STRIDE, src, STRIDE1, STRIDE1, LINES);
+    }
+    report("sand30_to_y16");
+
+    if (check_func(c->sand30_to_y8, "rpi_sand30_to_y8")) {
+        for (int w = 64; w <= STRIDE1; w += 64) {
+            memset(dst0, 0, DST_SIZE);
+            memset(dst1, 0, DST_SIZE);
+            call_ref(dst0, DST_STRIDE, src + STRIDE1 - w, STRIDE1, w, LINES);
+            call_new(dst1, DST_STRIDE, src + STRIDE1 - w, STRIDE1, w, LINES);
+            if (memcmp(dst0, dst1, DST_SIZE))
+                fail();
+        }
+        bench_new(dst1, DST_STRIDE, src, STRIDE1, STRIDE1, LINES);
+    }
+    report("sand30_to_y8");
+}
+
+static void check_sand30_c16(const RpiSandDSPContext *c, uint8_t *src,
+                             uint8_t *dst0, uint8_t *dst1)
+{
+    declare_func(void, uint8_t *dst_u, ptrdiff_t dst_stride_u,
+                 uint8_t *dst_v, ptrdiff_t dst_stride_v,
+                 const uint8_t *src, ptrdiff_t src_stride, int w, int h);
+
+    // U & V share a buffer with each at half the dst stride
+    if (check_func(c->sand30_to_c16, "rpi_sand30_to_c16")) {
+        for (int w = 64; w <= STRIDE1; w += 64) {
+            memset(dst0, 0, DST_SIZE);
+            memset(dst1, 0, DST_SIZE);
+            call_ref(dst0, DST_STRIDE, dst0 + DST_STRIDE / 2, DST_STRIDE,
+                     src + STRIDE1 - w, STRIDE1, w, LINES);
+            call_new(dst1, DST_STRIDE, dst1 + DST_STRIDE / 2, DST_STRIDE,
+                     src + STRIDE1 - w, STRIDE1, w, LINES);
+            if (memcmp(dst0, dst1, DST_SIZE))
+                fail();
+        }
+        bench_new(dst1, DST_STRIDE, dst1 + DST_STRIDE / 2, DST_STRIDE,
+                  src, STRIDE1, STRIDE1, LINES);
+    }
+    report("sand30_to_c16");
+}
+
+static void check_sand8_c8(const RpiSandDSPContext *c, uint8_t *src,
+                           uint8_t *dst0, uint8_t *dst1)
+{
+    declare_func(void, uint8_t *dst_u, ptrdiff_t dst_stride_u,
+                 uint8_t *dst_v, ptrdiff_t dst_stride_v,
+                 const uint8_t *src, ptrdiff_t src_stride, int w, int h);
+
+    if (check_func(c->sand8_to_c8, "rpi_sand8_to_c8")) {
+        for (int w = 64; w <= STRIDE1; w += 64) {
+            memset(dst0, 0, DST_SIZE);
+            memset(dst1, 0, DST_SIZE);
+            call_ref(dst0, DST_STRIDE, dst0 + DST_STRIDE / 2, DST_STRIDE,
+                     src + STRIDE1 - w, STRIDE1, w, LINES);
+            call_new(dst1, DST_STRIDE, dst1 + DST_STRIDE / 2, DST_STRIDE,
+                     src + STRIDE1 - w, STRIDE1, w, LINES);
+            if (memcmp(dst0, dst1, DST_SIZE))
+                fail();
+        }
+        bench_new(dst1, DST_STRIDE, dst1 + DST_STRIDE / 2, DST_STRIDE,
+                  src, STRIDE1, STRIDE1, LINES);
+    }
+    report("sand8_to_c8");
+}
+
+static void check_sand16_8(const RpiSandDSPContext *c, uint8_t *src,
+                           uint8_t *dst0, uint8_t *dst1)
+{
+    declare_func(void, uint8_t *dst, ptrdiff_t dst_stride,
+                 const uint8_t *src, ptrdiff_t src_stride, int w, int h, int shr);
+
+    for (int shr = 2; shr <= 8; shr += 6) {
+        if (check_func(c->sand16_to_8, "rpi_sand16_to_8_shr%d", shr)) {
+            for (int w = 64; w <= STRIDE1; w += 64) {
+                memset(dst0, 0, DST_SIZE);
+                memset(dst1, 0, DST_SIZE);
+                call_ref(dst0, DST_STRIDE, src + STRIDE1 - w, STRIDE1, w, LINES, shr);
+                call_new(dst1, DST_STRIDE, src + STRIDE1 - w, STRIDE1, w, LINES, shr);
+                if (memcmp(dst0, dst1, DST_SIZE))
+                    fail();
+            }
+            bench_new(dst1, DST_STRIDE, src, STRIDE1, STRIDE1, LINES, shr);
+        }
+    }
+    report("sand16_to_8");
+}
+
+#if HAVE_SAND_NEON
+// The NEON code converts whole lines rather than single stripes so
+// build the reference for it out of the C kernels
+static RpiSandDSPContext ref_dsp;
+
+static void sand30_lines_to_planar_y16_ref(uint8_t *dst, unsigned int dst_stride,
+                                           const uint8_t *src,
+                                           unsigned int stride1, unsigned int stride2,
+                                           unsigned int _x, unsigned int y,
+                                           unsigned int _w, unsigned int h)
+{
+    const unsigned int n = _w / 3 * 4;
+    for (unsigned int x = 0; x < n; x += stride1)
+        ref_dsp.sand30_to_y16(dst + x / 4 * 6, dst_stride,
+                              src + y * stride1 + x * stride2, stride1,
+                              FFMIN(stride1, n - x), h);
+}
+
+static void sand30_lines_to_planar_y8_ref(uint8_t *dst, unsigned int dst_stride,
+                                          const uint8_t *src,
+                                          unsigned int stride1, unsigned int stride2,
+                                          unsigned int _x, unsigned int y,
+                                          unsigned int _w, unsigned int h)
+{
+    const unsigned int n = _w / 3 * 4;
+    for (unsigned int x = 0; x < n; x += stride1)
+        ref_dsp.sand30_to_y8(dst + x / 4 * 3, dst_stride,
+                             src + y * stride1 + x * stride2, stride1,
+                             FFMIN(stride1, n - x), h);
+}
+
+static void sand30_lines_to_planar_c16_ref(uint8_t *dst_u, unsigned int dst_stride_u,
+                                           uint8_t *dst_v, unsigned int dst_stride_v,
+                                           const uint8_t *src,
+                                           unsigned int stride1, unsigned int stride2,
+                                           unsigned int _x, unsigned int y,
+                                           unsigned int _w, unsigned int h)
+{
+    const unsigned int n = _w / 3 * 8;
+    for (unsigned int x = 0; x < n; x += stride1)
+        ref_dsp.sand30_to_c16(dst_u + x / 8 * 6, dst_stride_u,
+                              dst_v + x / 8 * 6, dst_stride_v,
+                              src + y * stride1 + x * stride2, stride1,
+                              FFMIN(stride1, n - x), h);
+}
+
+static void check_sand30_lines(uint8_t *src, uint8_t *dst0, uint8_t *dst1)
+{
+    const int neon = av_get_cpu_flags() & AV_CPU_FLAG_NEON;
+    // Whole stripes, packed destination
+    const unsigned int w = STRIDE1 / 4 * 3 * STRIPES;
+
+    ff_rpi_sand_dsp_init(&ref_dsp);
+
+    {
+        declare_func(void, uint8_t *dst, unsigned int dst_stride,
+                     const uint8_t *src, unsigned int stride1, unsigned int stride2,
+                     unsigned int _x, unsigned int y, unsigned int _w, unsigned int h);
+
+        if (check_func(neon ? ff_rpi_sand30_lines_to_planar_y16 : sand30_lines_to_planar_y16_ref,
+                       "rpi_sand30_lines_to_planar_y16")) {
+            memset(dst0, 0, DST_SIZE);
+            memset(dst1, 0, DST_SIZE);
+            call_ref(dst0, w * 2, src, STRIDE1, LINES, 0, 0, w, LINES);
+            call_new(dst1, w * 2, src, STRIDE1, LINES, 0, 0, w, LINES);
+            if (memcmp(dst0, dst1, DST_SIZE))
+                fail();
+            bench_new(dst1, w * 2, src, STRIDE1, LINES, 0, 0, w, LINES);
+        }
+        if (check_func(neon ? ff_rpi_sand30_lines_to_planar_y8 : sand30_lines_to_planar_y8_ref,
+                       "rpi_sand30_lines_to_planar_y8")) {
+            memset(dst0, 0, DST_SIZE);
+            memset(dst1, 0, DST_SIZE);
+            call_ref(dst0, w, src, STRIDE1, LINES, 0, 0, w, LINES);
+            call_new(dst1, w, src, STRIDE1, LINES, 0, 0, w, LINES);
+            if (memcmp(dst0, dst1, DST_SIZE))
+                fail();
+            bench_new(dst1, w, src, STRIDE1, LINES, 0, 0, w, LINES);
+        }
+    }
+
+    {
+        declare_func(void, uint8_t *dst_u, unsigned int dst_stride_u,
+                     uint8_t *dst_v, unsigned int dst_stride_v,
+                     const uint8_t *src, unsigned int stride1, unsigned int stride2,
+                     unsigned int _x, unsigned int y, unsigned int _w, unsigned int h);
+
+        if (check_func(neon ? ff_rpi_sand30_lines_to_planar_c16 : sand30_lines_to_planar_c16_ref,
+                       "rpi_sand30_lines_to_planar_c16")) {
+            memset(dst0, 0, DST_SIZE);
+            memset(dst1, 0, DST_SIZE);
+            call_ref(dst0, w, dst0 + DST_SIZE / 2, w, src, STRIDE1, LINES, 0, 0, w / 2, LINES);
+            call_new(dst1, w, dst1 + DST_SIZE / 2, w, src, STRIDE1, LINES, 0, 0, w / 2, LINES);
+            if (memcmp(dst0, dst1, DST_SIZE))
+                fail();
+            bench_new(dst1, w, dst1 + DST_SIZE / 2, w, src, STRIDE1, LINES, 0, 0, w / 2, LINES);
+        }
+    }
+    report("sand30_lines");
+}
+#endif
+
+void checkasm_check_rpi_sand(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,  [SRC_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_SIZE]);
+    RpiSandDSPContext c;
+
+    ff_rpi_sand_dsp_init(&c);
+
+    randomize_buffers(src, SRC_SIZE, 0x3fffffff);
+    check_sand30(&c, src, dst0, dst1);
+    check_sand30_c16(&c, src, dst0, dst1);
+#if HAVE_SAND_NEON
+    check_sand30_lines(src, dst0, dst1);
+#endif
+
+    randomize_buffers(src, SRC_SIZE, 0xffffffff);
+    check_sand8_c8(&c, src, dst0, dst1);
+    check_sand16_8(&c, src, dst0, dst1);
+}
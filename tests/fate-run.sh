@@ -216,6 +216,16 @@ enc_dec(){
         run ffprobe${PROGSUF}${EXECSUF} $ffprobe_opts $tencfile || return
 }
 
+# Run a test command with the names of the files it outputs changed to those
+# of another test, so that its output can be checked against the reference of
+# that test, e.g. for variants using other threading options.
+as_test(){
+    name=$1
+    shift
+    out=$("$@") || return
+    printf '%s\n' "$out" | sed "s;/${test}\.;/${name}.;g"
+}
+
 transcode(){
     src_fmt=$1
     srcfile=$2
@@ -237,6 +247,16 @@ transcode(){
         run ffprobe${PROGSUF}${EXECSUF} $ffprobe_opts $tencfile || return
 }
 
+# transcode, then print the type and size of the top level atoms of the
+# mov/mp4 output as the demuxer finds them
+transcode_mov_atoms(){
+    transcode "$1" "$2" "$3" "$4" "$5" -keep || return
+    encfile="${outdir}/${test}.${3}"
+    cleanfiles="$cleanfiles $encfile"
+    run ffprobe${PROGSUF}${EXECSUF} -v trace $(target_path $encfile) 2>&1 >/dev/null |
+        sed -n "s/.*type:'\(....\)' parent:'root' sz: \([0-9]*\) .*/\1 \2/p"
+}
+
 stream_remux(){
     src_fmt=$1
     srcfile=$2
@@ -135,6 +135,11 @@ fate-acodec-flac: CODEC = flac -compression_level 2
 fate-acodec-flac-exact-rice: FMT = flac
 fate-acodec-flac-exact-rice: CODEC = flac -compression_level 2 -exact_rice_parameters 1
 
+# frames encoded in parallel must give the same output as the serial encoder
+FATE_ACODEC-$(call ENCDEC, FLAC, FLAC) += fate-acodec-flac-threads
+fate-acodec-flac-threads: CMD = as_test acodec-flac enc_dec wav $(SRC) flac "-b:a 128k -c flac -compression_level 2 -threads 4 -thread_type slice" wav "-c pcm_s16le"
+fate-acodec-flac-threads: REF = $(SRC_PATH)/tests/ref/acodec/flac
+
 FATE_ACODEC-$(call ENCDEC, G723_1, G723_1) += fate-acodec-g723_1
 fate-acodec-g723_1: tests/data/asynth-8000-1.wav
 fate-acodec-g723_1: SRC = tests/data/asynth-8000-1.wav
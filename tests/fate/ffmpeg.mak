@@ -41,6 +41,46 @@ fate-ffmpeg-filter_colorkey: CMD = framecrc -auto_conversion_filters -idct simpl
 FATE_FFMPEG-$(CONFIG_COLOR_FILTER) += fate-ffmpeg-lavfi
 fate-ffmpeg-lavfi: CMD = framecrc -lavfi color=d=1:r=5 -fflags +bitexact
 
+# The slice threaded MJPEG encoder writes a DRI and one restart interval per
+# macroblock row, which the decoder splits between slice threads. Frame
+# threads get new optimal Huffman tables with every picture.
+FATE_MJPEG_THREADS-$(call ALLYES, RAWVIDEO_DEMUXER MJPEG_ENCODER AVI_MUXER AVI_DEMUXER MJPEG_DECODER) += fate-mjpeg-rst-slice fate-mjpeg-rst-frame
+fate-mjpeg-rst-%: tests/data/vsynth1.yuv
+fate-mjpeg-rst-%: CMD = transcode "rawvideo -s 352x288 -pix_fmt yuvj420p" tests/data/vsynth1.yuv \
+  avi "-c:v mjpeg -q:v 9 -huffman optimal -threads 4 -thread_type slice" "-c:v rawvideo"
+fate-mjpeg-rst-slice: THREADS = 4
+fate-mjpeg-rst-slice: THREAD_TYPE = slice
+fate-mjpeg-rst-frame: THREADS = 4
+fate-mjpeg-rst-frame: THREAD_TYPE = frame
+
+FATE_FFMPEG += $(FATE_MJPEG_THREADS-yes)
+fate-mjpeg-threads: $(FATE_MJPEG_THREADS-yes)
+
+# Decoding from a memory mapped file, whose packets reference the mapping
+# in place and are not followed by zeroed padding, must match plain reads.
+FATE_MMAP-$(call ALLYES, FILE_PROTOCOL MOV_DEMUXER MPEG4_DECODER PCM_ALAW_DECODER) += fate-mmap-mov
+FATE_MMAP-$(call ALLYES, FILE_PROTOCOL MATROSKA_DEMUXER MPEG4_DECODER MP2_DECODER) += fate-mmap-mkv
+FATE_MMAP-$(call ALLYES, FILE_PROTOCOL FLAC_DEMUXER FLAC_PARSER FLAC_DECODER) += fate-mmap-flac
+fate-mmap-mov: fate-lavf-mov
+fate-mmap-mov: CMD = framecrc -mmap 1 -i $(TARGET_PATH)/tests/data/lavf/lavf.mov
+fate-mmap-mkv: fate-lavf-mkv
+fate-mmap-mkv: CMD = framecrc -mmap 1 -i $(TARGET_PATH)/tests/data/lavf/lavf.mkv -af aresample
+fate-mmap-flac: fate-acodec-flac
+fate-mmap-flac: CMD = framecrc -mmap 1 -i $(TARGET_PATH)/tests/data/fate/acodec-flac.flac
+
+FATE_MMAP-$(call ALLYES, FILE_PROTOCOL MOV_DEMUXER) += fate-mmap-copy-mov
+FATE_MMAP-$(call ALLYES, FILE_PROTOCOL MATROSKA_DEMUXER) += fate-mmap-copy-mkv
+FATE_MMAP-$(call ALLYES, FILE_PROTOCOL FLAC_DEMUXER FLAC_PARSER) += fate-mmap-copy-flac
+fate-mmap-copy-mov: fate-lavf-mov
+fate-mmap-copy-mov: CMD = framecrc -mmap 1 -i $(TARGET_PATH)/tests/data/lavf/lavf.mov -c copy
+fate-mmap-copy-mkv: fate-lavf-mkv
+fate-mmap-copy-mkv: CMD = framecrc -mmap 1 -i $(TARGET_PATH)/tests/data/lavf/lavf.mkv -c copy
+fate-mmap-copy-flac: fate-acodec-flac
+fate-mmap-copy-flac: CMD = framecrc -mmap 1 -i $(TARGET_PATH)/tests/data/fate/acodec-flac.flac -c copy
+
+FATE_FFMPEG += $(FATE_MMAP-yes)
+fate-mmap: $(FATE_MMAP-yes)
+
 FATE_SAMPLES_FFMPEG-$(CONFIG_RAWVIDEO_DEMUXER) += fate-force_key_frames
 fate-force_key_frames: tests/data/vsynth_lena.yuv
 fate-force_key_frames: CMD = enc_dec \
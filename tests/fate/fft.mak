@@ -3,6 +3,8 @@ FATE_DCT-$(CONFIG_DCT)   += fate-dct1d-$(1) fate-idct1d-$(1)
 FATE_FFT-$(CONFIG_FFT)   += fate-fft-$(1)   fate-ifft-$(1)
 FATE_MDCT-$(CONFIG_MDCT) += fate-mdct-$(1)  fate-imdct-$(1)
 FATE_RDFT-$(CONFIG_RDFT) += fate-rdft-$(1)  fate-irdft-$(1)
+FATE_TX-$(CONFIG_FFT)    += fate-tx-fft-$(1)  fate-tx-ifft-$(1)
+FATE_TX-$(CONFIG_MDCT)   += fate-tx-mdct-$(1) fate-tx-imdct-$(1)
 
 fate-fft-$(N):    ARGS = -n$(1)
 fate-ifft-$(N):   ARGS = -n$(1) -i
@@ -12,6 +14,10 @@ fate-rdft-$(N):   ARGS = -n$(1) -r
 fate-irdft-$(N):  ARGS = -n$(1) -r -i
 fate-dct1d-$(N):  ARGS = -n$(1) -d
 fate-idct1d-$(N): ARGS = -n$(1) -d -i
+fate-tx-fft-$(N):   ARGS = -n$(1) -t
+fate-tx-ifft-$(N):  ARGS = -n$(1) -t -i
+fate-tx-mdct-$(N):  ARGS = -n$(1) -t -m
+fate-tx-imdct-$(N): ARGS = -n$(1) -t -m -i
 endef
 
 $(foreach N, 4 5 6 7 8 9 10 11 12, $(eval $(call DEF_FFT,$(N))))
@@ -20,8 +26,9 @@ fate-dct-float: $(FATE_DCT-yes)
 fate-fft-float: $(FATE_FFT-yes)
 fate-mdct-float: $(FATE_MDCT-yes)
 fate-rdft-float: $(FATE_RDFT-yes)
+fate-tx-float: $(FATE_TX-yes)
 
-FATE_FFT_ALL = $(FATE_DCT-yes) $(FATE_FFT-yes) $(FATE_MDCT-yes) $(FATE_RDFT-yes)
+FATE_FFT_ALL = $(FATE_DCT-yes) $(FATE_FFT-yes) $(FATE_MDCT-yes) $(FATE_RDFT-yes) $(FATE_TX-yes)
 
 $(FATE_FFT_ALL): libavcodec/tests/fft$(EXESUF)
 $(FATE_FFT_ALL): CMD = run libavcodec/tests/fft$(EXESUF) $(CPUFLAGS:%=-c%) $(ARGS)
@@ -230,6 +230,14 @@ FATE_HEVC_LARGE += fate-hevc-conformance-$(1)
 fate-hevc-conformance-$(1): CMD = framecrc -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv444p12le -vf scale
 endef
 
+# WPP rows of several frames in flight decoded on a shared pool, must match
+# the plain decode
+define FATE_HEVC_TEST_WPP_POOL
+FATE_HEVC += fate-hevc-conformance-wpp-pool-$(1)
+fate-hevc-conformance-wpp-pool-$(1): CMD = threads=2 thread_type=frame framecrc -wpp_threads 4 -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit $(2)
+fate-hevc-conformance-wpp-pool-$(1): REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+endef
+
 $(foreach N,$(HEVC_SAMPLES),$(eval $(call FATE_HEVC_TEST,$(N))))
 $(foreach N,$(HEVC_SAMPLES_10BIT),$(eval $(call FATE_HEVC_TEST_10BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_422_10BIT),$(eval $(call FATE_HEVC_TEST_422_10BIT,$(N))))
@@ -238,6 +246,8 @@ $(foreach N,$(HEVC_SAMPLES_422_10BIN_LARGE),$(eval $(call FATE_HEVC_TEST_422_10B
 $(foreach N,$(HEVC_SAMPLES_444_8BIT),$(eval $(call FATE_HEVC_TEST_444_8BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_444_12BIT),$(eval $(call FATE_HEVC_TEST_444_12BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_444_12BIT_LARGE),$(eval $(call FATE_HEVC_TEST_444_12BIT_LARGE,$(N))))
+$(foreach N,$(filter WPP_%,$(HEVC_SAMPLES)),$(eval $(call FATE_HEVC_TEST_WPP_POOL,$(N),-pix_fmt yuv420p)))
+$(foreach N,$(filter WPP_%,$(HEVC_SAMPLES_10BIT)),$(eval $(call FATE_HEVC_TEST_WPP_POOL,$(N),-pix_fmt yuv420p10le -vf scale)))
 
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -vsync 0 -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc -sws_flags area+accurate_rnd+bitexact
 FATE_HEVC_LARGE += fate-hevc-paramchange-yuv420p-yuv420p10
@@ -18,6 +18,11 @@ fate-codec_desc: libavcodec/tests/codec_desc$(EXESUF)
 fate-codec_desc: CMD = run libavcodec/tests/codec_desc$(EXESUF)
 fate-codec_desc: CMP = null
 
+FATE_LIBAVCODEC-yes += fate-get_bits_cached
+fate-get_bits_cached: libavcodec/tests/get_bits_cached$(EXESUF)
+fate-get_bits_cached: CMD = run libavcodec/tests/get_bits_cached$(EXESUF)
+fate-get_bits_cached: CMP = null
+
 FATE_LIBAVCODEC-$(CONFIG_GOLOMB) += fate-golomb
 fate-golomb: libavcodec/tests/golomb$(EXESUF)
 fate-golomb: CMD = run libavcodec/tests/golomb$(EXESUF)
@@ -84,6 +89,16 @@ fate-libavcodec-utils: libavcodec/tests/utils$(EXESUF)
 fate-libavcodec-utils: CMD = run libavcodec/tests/utils$(EXESUF)
 fate-libavcodec-utils: CMP = null
 
+FATE_LIBAVCODEC-$(HAVE_SYS_EPOLL_H) += fate-v4l2-req-pollqueue
+fate-v4l2-req-pollqueue: libavcodec/tests/v4l2_req_pollqueue$(EXESUF)
+fate-v4l2-req-pollqueue: CMD = run libavcodec/tests/v4l2_req_pollqueue$(EXESUF)
+fate-v4l2-req-pollqueue: CMP = null
+
+FATE_LIBAVCODEC-$(HAVE_LINUX_DMA_HEAP_H) += fate-v4l2-req-dmabufs
+fate-v4l2-req-dmabufs: libavcodec/tests/v4l2_req_dmabufs$(EXESUF)
+fate-v4l2-req-dmabufs: CMD = run libavcodec/tests/v4l2_req_dmabufs$(EXESUF)
+fate-v4l2-req-dmabufs: CMP = null
+
 FATE_LIBAVCODEC-yes += fate-libavcodec-huffman
 fate-libavcodec-huffman: libavcodec/tests/mjpegenc_huffman$(EXESUF)
 fate-libavcodec-huffman: CMD = run libavcodec/tests/mjpegenc_huffman$(EXESUF)
@@ -33,11 +33,18 @@ FATE_MOV_FFPROBE = fate-mov-neg-firstpts-discard \
 
 FATE_MOV_FASTSTART = fate-mov-faststart-4gb-overflow \
 
-FATE_SAMPLES_AVCONV += $(FATE_MOV)
+FATE_MOV_COMPACT_INDEX = fate-mov-compact-index-1elist-noctts \
+                         fate-mov-compact-index-1elist-1ctts \
+                         fate-mov-compact-index-3elist \
+                         fate-mov-compact-index-elist-starts-ctts-2ndsample \
+                         fate-mov-compact-index-440hz-10ms \
+                         fate-mov-compact-index-frag-overlap \
+
+FATE_SAMPLES_AVCONV += $(FATE_MOV) $(FATE_MOV_COMPACT_INDEX)
 FATE_SAMPLES_FFPROBE += $(FATE_MOV_FFPROBE)
 FATE_SAMPLES_FASTSTART += $(FATE_MOV_FASTSTART)
 
-fate-mov: $(FATE_MOV) $(FATE_MOV_FFPROBE) $(FATE_MOV_FASTSTART)
+fate-mov: $(FATE_MOV) $(FATE_MOV_FFPROBE) $(FATE_MOV_FASTSTART) $(FATE_MOV_COMPACT_INDEX)
 
 # Make sure we handle edit lists correctly in normal cases.
 fate-mov-1elist-noctts: CMD = framemd5 -i $(TARGET_SAMPLES)/mov/mov-1elist-noctts.mov
@@ -127,3 +134,26 @@ fate-mov-faststart-4gb-overflow: REF = bc875921f151871e787c4b4023269b29
 fate-mov-mp4-with-mov-in24-ver: CMD = run ffprobe$(PROGSSUF)$(EXESUF) -show_entries stream=codec_name -select_streams 1 $(TARGET_SAMPLES)/mov/mp4-with-mov-in24-ver.mp4
 
 fate-mov-mp4-extended-atom: CMD = run ffprobe$(PROGSSUF)$(EXESUF) -show_packets -print_format compact -select_streams v $(TARGET_SAMPLES)/mov/extended_atom_size_probe
+
+# Resolving the samples from the sample tables (or falling back to the full
+# index for the edit lists it cannot handle) must give the same packets.
+$(FATE_MOV_COMPACT_INDEX): REF = $(SRC_PATH)/tests/ref/fate/$(@:fate-mov-compact-index-%=mov-%)
+fate-mov-compact-index-1elist-noctts: CMD = framemd5 -compact_index 1 -i $(TARGET_SAMPLES)/mov/mov-1elist-noctts.mov
+fate-mov-compact-index-1elist-1ctts: CMD = framemd5 -compact_index 1 -i $(TARGET_SAMPLES)/mov/mov-1elist-1ctts.mov
+fate-mov-compact-index-3elist: CMD = framemd5 -compact_index 1 -i $(TARGET_SAMPLES)/mov/mov-3elist.mov
+fate-mov-compact-index-elist-starts-ctts-2ndsample: CMD = framemd5 -compact_index 1 -i $(TARGET_SAMPLES)/mov/mov-elist-starts-ctts-2ndsample.mov
+fate-mov-compact-index-440hz-10ms: CMD = framemd5 -compact_index 1 -i $(TARGET_SAMPLES)/mov/440hz-10ms.m4a -af aresample
+fate-mov-compact-index-frag-overlap: CMD = framemd5 -compact_index 1 -i $(TARGET_SAMPLES)/mov/frag_overlap.mp4
+
+# reserve_moov writes the moov atom into the space reserved after ftyp, with
+# a free atom for the rest of it. When -moov_size is too small, the reserved
+# space stays a free atom and the second pass puts the moov atom after it.
+FATE_MOV_RESERVE_MOOV-$(call ALLYES, RAWVIDEO_DEMUXER MPEG4_ENCODER MP4_MUXER MOV_DEMUXER) += fate-mov-reserve-moov fate-mov-reserve-moov-undersized
+fate-mov-reserve-moov%: tests/data/vsynth1.yuv
+fate-mov-reserve-moov: CMD = transcode_mov_atoms "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv \
+  mp4 "-c:v mpeg4 -q:v 10 -t 1 -movflags +reserve_moov" "-c copy"
+fate-mov-reserve-moov-undersized: CMD = transcode_mov_atoms "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv \
+  mp4 "-c:v mpeg4 -q:v 10 -t 1 -movflags +reserve_moov -moov_size 200" "-c copy"
+
+FATE_FFMPEG_FFPROBE += $(FATE_MOV_RESERVE_MOOV-yes)
+fate-mov: $(FATE_MOV_RESERVE_MOOV-yes)
@@ -176,6 +176,7 @@ FATE_SEEK_LAVF-$(call ENCDEC,  MJPEG,                 IMAGE2)      += jpg
 FATE_SEEK_LAVF-$(call ENCDEC2, MPEG4,      MP2,       MATROSKA)    += mkv
 FATE_SEEK_LAVF-$(call ENCDEC,  ADPCM_YAMAHA,          MMF)         += mmf
 FATE_SEEK_LAVF-$(call ENCDEC2, MPEG4,      PCM_ALAW,  MOV)         += mov
+FATE_SEEK_LAVF-$(call ENCDEC2, MPEG4,      PCM_ALAW,  MOV)         += mov_bframes
 FATE_SEEK_LAVF-$(call ENCDEC2, MPEG1VIDEO, MP2,       MPEG1SYSTEM MPEGPS) += mpg
 FATE_SEEK_LAVF-$(call ENCDEC,  PCM_MULAW,             PCM_MULAW)   += ul
 FATE_SEEK_LAVF-$(call ENCDEC2, MPEG2VIDEO, PCM_S16LE, MXF)         += mxf
@@ -217,6 +218,7 @@ fate-seek-lavf-jpg:      SRC = images/jpg/%02d.jpg
 fate-seek-lavf-mkv:      SRC = lavf/lavf.mkv
 fate-seek-lavf-mmf:      SRC = lavf/lavf.mmf
 fate-seek-lavf-mov:      SRC = lavf/lavf.mov
+fate-seek-lavf-mov_bframes: SRC = lavf/lavf.mov_bframes
 fate-seek-lavf-mpg:      SRC = lavf/lavf.mpg
 fate-seek-lavf-ul:       SRC = lavf/lavf.ul
 fate-seek-lavf-mxf:      SRC = lavf/lavf.mxf
@@ -266,6 +268,42 @@ fate-seek-mkv-codec-delay:   CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_
 
 FATE_SEEK_EXTRA += $(FATE_SEEK_EXTRA-yes)
 
+# compact_index of the mov demuxer must seek like the full index; the audio
+# tracks only keep every 64th sample in the exported index, and mov_bframes
+# has an edit list, which is ignored in the last test
+
+FATE_SEEK_COMPACT_INDEX-$(call ENCDEC2, MPEG4, PCM_ALAW, MOV) += fate-seek-compact-index-lavf-mov
+FATE_SEEK_COMPACT_INDEX-$(call ENCDEC2, MPEG4, PCM_ALAW, MOV) += fate-seek-compact-index-lavf-mov_bframes
+FATE_SEEK_COMPACT_INDEX-$(call ENCDEC2, MPEG4, PCM_ALAW, MOV) += fate-seek-compact-index-ignore-editlist-lavf-mov_bframes
+
+fate-seek-compact-index-lavf-mov: fate-lavf-mov
+fate-seek-compact-index-lavf-mov: REF = $(SRC_PATH)/tests/ref/seek/lavf-mov
+fate-seek-compact-index-lavf-mov: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.mov -compact_index 1
+fate-seek-compact-index-lavf-mov_bframes: fate-lavf-mov_bframes
+fate-seek-compact-index-lavf-mov_bframes: REF = $(SRC_PATH)/tests/ref/seek/lavf-mov_bframes
+fate-seek-compact-index-lavf-mov_bframes: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.mov_bframes -compact_index 1
+fate-seek-compact-index-ignore-editlist-lavf-mov_bframes: fate-lavf-mov_bframes
+fate-seek-compact-index-ignore-editlist-lavf-mov_bframes: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.mov_bframes -compact_index 1 -ignore_editlist 1
+
+$(FATE_SEEK_COMPACT_INDEX-yes): libavformat/tests/seek$(EXESUF)
+
+FATE_SEEK_EXTRA_AVCONV += $(FATE_SEEK_COMPACT_INDEX-yes)
+
+# asynchronous readahead of the file protocol, in blocks small enough for
+# the seeks to move the window; the result must match the plain reads
+
+FATE_SEEK_READAHEAD-$(call ENCDEC, PCM_S16BE, MOV) += fate-seek-readahead-threads
+FATE_SEEK_READAHEAD-$(call ENCDEC, PCM_S16BE, MOV) += fate-seek-readahead-io_uring
+
+fate-seek-readahead-threads:  READAHEAD_OPTS = -readahead_io_uring 0
+fate-seek-readahead-io_uring: READAHEAD_OPTS = -readahead_io_uring 1
+
+$(FATE_SEEK_READAHEAD-yes): libavformat/tests/seek$(EXESUF) fate-acodec-pcm-s16be
+$(FATE_SEEK_READAHEAD-yes): CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/fate/acodec-pcm-s16be.mov -readahead 4 -readahead_size 4096 $(READAHEAD_OPTS)
+$(FATE_SEEK_READAHEAD-yes): REF = $(SRC_PATH)/tests/ref/seek/acodec-pcm-s16be
+
+FATE_SEEK_EXTRA_AVCONV += $(FATE_SEEK_READAHEAD-yes)
+
 
 $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA): libavformat/tests/seek$(EXESUF)
 $(FATE_SEEK) $(FATE_SAMPLES_SEEK): CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/$(SRC)
@@ -273,6 +311,6 @@ $(FATE_SEEK) $(FATE_SAMPLES_SEEK): fate-seek-%: fate-%
 $(subst fate-seek-,fate-,$(FATE_SAMPLES_SEEK) $(FATE_SEEK)): KEEP_OVERRIDE = -keep
 fate-seek-%: REF = $(SRC_PATH)/tests/ref/seek/$(@:fate-seek-%=%)
 
-FATE_AVCONV += $(FATE_SEEK)
+FATE_AVCONV += $(FATE_SEEK) $(FATE_SEEK_EXTRA_AVCONV)
 FATE_SAMPLES_AVCONV += $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA)
-fate-seek:     $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA)
+fate-seek:     $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA) $(FATE_SEEK_EXTRA_AVCONV)
@@ -4,11 +4,16 @@ fate-vsynth_lena-%: SRC = tests/data/vsynth_lena.yuv
 fate-vsynth3-%: SRC = tests/data/vsynth3.yuv
 fate-vsynth%: CODEC = $(word 3, $(subst -, ,$(@)))
 fate-vsynth%: FMT = avi
-fate-vsynth%: CMD = enc_dec "rawvideo -s 352x288 -pix_fmt yuv420p $(RAWDECOPTS)" $(SRC) $(FMT) "-c $(CODEC) $(ENCOPTS)" rawvideo "-s 352x288 -pix_fmt yuv420p -vsync 0 $(DECOPTS)" "$(KEEP_OVERRIDE)" "$(DECINOPTS)"
-fate-vsynth3-%: CMD = enc_dec "rawvideo -s $(FATEW)x$(FATEH) -pix_fmt yuv420p $(RAWDECOPTS)" $(SRC) $(FMT) "-c $(CODEC) $(ENCOPTS)" rawvideo "-s $(FATEW)x$(FATEH) -pix_fmt yuv420p -vsync 0 $(DECOPTS)" "" "$(DECINOPTS)"
+fate-vsynth%: CMD = $(AS_TEST) enc_dec "rawvideo -s 352x288 -pix_fmt yuv420p $(RAWDECOPTS)" $(SRC) $(FMT) "-c $(CODEC) $(ENCOPTS)" rawvideo "-s 352x288 -pix_fmt yuv420p -vsync 0 $(DECOPTS)" "$(KEEP_OVERRIDE)" "$(DECINOPTS)"
+fate-vsynth3-%: CMD = $(AS_TEST) enc_dec "rawvideo -s $(FATEW)x$(FATEH) -pix_fmt yuv420p $(RAWDECOPTS)" $(SRC) $(FMT) "-c $(CODEC) $(ENCOPTS)" rawvideo "-s $(FATEW)x$(FATEH) -pix_fmt yuv420p -vsync 0 $(DECOPTS)" "" "$(DECINOPTS)"
 fate-vsynth%: CMP_UNIT = 1
 fate-vsynth%: REF = $(SRC_PATH)/tests/ref/vsynth/$(@:fate-%=%)
 
+# variants with other threading options, checked against the reference of
+# the plain test
+fate-vsynth%-threads: AS_TEST = as_test $(@:fate-%-threads=%)
+fate-vsynth%-threads: REF = $(SRC_PATH)/tests/ref/vsynth/$(@:fate-%-threads=%)
+
 FATE_VCODEC-$(call ENCDEC, AMV, AVI) += amv
 fate-vsynth%-amv:                ENCOPTS = -strict -1
 
@@ -232,6 +237,17 @@ fate-vsynth%-jpeg2000:                DECINOPTS = -c:v jpeg2000
 fate-vsynth%-jpeg2000-97:             ENCOPTS = -qscale 7 -strict experimental -pix_fmt rgb24
 fate-vsynth%-jpeg2000-97:             DECINOPTS = -c:v jpeg2000
 
+FATE_VCODEC-$(call ENCDEC, JPEG2000, AVI) += jpeg2000-threads jpeg2000-97-threads
+fate-vsynth%-jpeg2000-threads:        ENCOPTS = -qscale 7 -strict experimental -pred 1 -pix_fmt rgb24 -threads 4 -thread_type slice
+fate-vsynth%-jpeg2000-threads:        DECINOPTS = -c:v jpeg2000
+fate-vsynth%-jpeg2000-97-threads:     ENCOPTS = -qscale 7 -strict experimental -pix_fmt rgb24 -threads 4 -thread_type slice
+fate-vsynth%-jpeg2000-97-threads:     DECINOPTS = -c:v jpeg2000
+
+FATE_VSYNTH1_EXTRA-$(call ENCDEC, JPEG2000, AVI) += jpeg2000-tiles jpeg2000-tiles-threads
+fate-vsynth1-jpeg2000-tiles:          ENCOPTS = -qscale 7 -strict experimental -pred 1 -pix_fmt rgb24 -tile_width 64 -tile_height 48
+fate-vsynth1-jpeg2000-tiles-threads:  ENCOPTS = -qscale 7 -strict experimental -pred 1 -pix_fmt rgb24 -tile_width 64 -tile_height 48 -threads 4 -thread_type slice
+fate-vsynth1-jpeg2000-tiles%:         DECINOPTS = -c:v jpeg2000
+
 FATE_VCODEC-$(call ENCDEC, LJPEG MJPEG, AVI) += ljpeg
 fate-vsynth%-ljpeg:              ENCOPTS = -strict -1
 
@@ -461,7 +477,7 @@ FATE_VCODEC-$(call ENCDEC, Y41P, AVI) += y41p
 FATE_VCODEC-$(call ENCDEC, ZLIB, AVI) += zlib
 
 FATE_VCODEC += $(FATE_VCODEC-yes)
-FATE_VSYNTH1 = $(FATE_VCODEC:%=fate-vsynth1-%)
+FATE_VSYNTH1 = $(FATE_VCODEC:%=fate-vsynth1-%) $(FATE_VSYNTH1_EXTRA-yes:%=fate-vsynth1-%)
 FATE_VSYNTH2 = $(FATE_VCODEC:%=fate-vsynth2-%)
 FATE_VSYNTH_LENA = $(FATE_VCODEC:%=fate-vsynth_lena-%)
 # Redundant tests because they just resize the input
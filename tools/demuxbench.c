@@ -0,0 +1,237 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Demux throughput benchmark.
+ *
+ * Reads every packet of each input and writes one CSV row per input with
+ * the name, elapsed, user & sys columns (seconds) of tools/ffbench, then the
+ * packet count, the number of bytes read and the throughput in MB/s.
+ *
+ * The inputs are evicted from the page cache before each run unless -warm
+ * is given, so that the I/O path is measured rather than memcpy. Options
+ * given with -o go to the demuxer and the protocol, e.g.
+ *   demuxbench -o readahead=16 input.mov
+ * measures the file protocol readahead.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
+#include "libavformat/avformat.h"
+#include "libavutil/avstring.h"
+#include "libavutil/dict.h"
+#include "libavutil/time.h"
+
+typedef struct Clock {
+    int64_t wall;
+    int64_t user;
+    int64_t sys;
+} Clock;
+
+typedef struct BenchResult {
+    Clock time;
+    int64_t packets;
+    int64_t bytes;
+} BenchResult;
+
+static void clock_now(Clock *c)
+{
+#if HAVE_GETRUSAGE
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    c->user = ru.ru_utime.tv_sec * 1000000LL + ru.ru_utime.tv_usec;
+    c->sys  = ru.ru_stime.tv_sec * 1000000LL + ru.ru_stime.tv_usec;
+#else
+    c->user = c->sys = 0;
+#endif
+    c->wall = av_gettime_relative();
+}
+
+/* Evict a local file from the page cache; clean pages only */
+static int drop_cache(const char *filename)
+{
+#if HAVE_UNISTD_H && defined(POSIX_FADV_DONTNEED)
+    int fd, ret;
+
+    av_strstart(filename, "file:", &filename);
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        return AVERROR(errno);
+    ret = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    return ret ? AVERROR(ret) : 0;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
+
+static int bench_file(BenchResult *res, const char *filename,
+                      AVInputFormat *fmt, const char *opts)
+{
+    AVFormatContext *s = NULL;
+    AVDictionary *dict = NULL;
+    AVPacket *pkt;
+    Clock t0, t1;
+    int ret;
+
+    if (opts && (ret = av_dict_parse_string(&dict, opts, "=", ":", 0)) < 0)
+        return ret;
+    if (!(pkt = av_packet_alloc())) {
+        av_dict_free(&dict);
+        return AVERROR(ENOMEM);
+    }
+
+    clock_now(&t0);
+    if ((ret = avformat_open_input(&s, filename, fmt, &dict)) < 0)
+        goto end;
+    if (dict) {
+        AVDictionaryEntry *e = av_dict_get(dict, "", NULL, AV_DICT_IGNORE_SUFFIX);
+        fprintf(stderr, "Option '%s' not found\n", e->key);
+        ret = AVERROR_OPTION_NOT_FOUND;
+        goto end;
+    }
+    while ((ret = av_read_frame(s, pkt)) >= 0) {
+        res->packets++;
+        av_packet_unref(pkt);
+    }
+    if (ret == AVERROR_EOF)
+        ret = 0;
+    if (s->pb)
+        res->bytes = s->pb->bytes_read;
+    clock_now(&t1);
+
+    res->time.wall = t1.wall - t0.wall;
+    res->time.user = t1.user - t0.user;
+    res->time.sys  = t1.sys  - t0.sys;
+
+end:
+    av_dict_free(&dict);
+    av_packet_free(&pkt);
+    avformat_close_input(&s);
+    if (ret < 0)
+        fprintf(stderr, "Benchmark of '%s' failed: %s\n", filename, av_err2str(ret));
+    return ret;
+}
+
+static void print_str(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"')
+            fputc('"', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] input [input...]\n"
+            "Options:\n"
+            "  -f format        force the input format\n"
+            "  -o opts          demuxer/protocol options, as key=value:key=value\n"
+            "  -repeat n        runs per input, the fastest is reported (default 3)\n"
+            "  -warm            do not evict the inputs from the page cache\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    AVInputFormat *fmt = NULL;
+    const char *opts = NULL;
+    int repeat = 3, warm = 0;
+    int i, ret = 0;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        const char *opt = argv[i];
+        const char *arg = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!strcmp(opt, "-warm")) {
+            warm = 1;
+            continue;
+        }
+        if (!arg) {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+        if (!strcmp(opt, "-f")) {
+            if (!(fmt = av_find_input_format(arg))) {
+                fprintf(stderr, "Unknown input format '%s'\n", arg);
+                return 1;
+            }
+        } else if (!strcmp(opt, "-o"))
+            opts = arg;
+        else if (!strcmp(opt, "-repeat"))
+            repeat = FFMAX(atoi(arg), 1);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (i >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    printf("name,elapsed,user,sys,packets,bytes,mbps\n");
+    for (; i < argc; i++) {
+        BenchResult best = { { 0 } };
+        int r;
+
+        for (r = 0; r < repeat; r++) {
+            BenchResult res = { { 0 } };
+
+            if (!warm && (ret = drop_cache(argv[i])) < 0) {
+                fprintf(stderr, "Cannot evict '%s' from the page cache: %s\n",
+                        argv[i], av_err2str(ret));
+                warm = 1;
+            }
+            if ((ret = bench_file(&res, argv[i], fmt, opts)) < 0)
+                break;
+            fprintf(stderr, "%s: %6.3fs %"PRId64" packets %8.2f MB/s\n", argv[i],
+                    res.time.wall / 1000000.0, res.packets,
+                    res.bytes / (double)FFMAX(res.time.wall, 1));
+            if (!r || res.time.wall < best.time.wall)
+                best = res;
+        }
+        if (ret < 0)
+            break;
+
+        print_str(stdout, argv[i]);
+        printf(",%.6f,%.6f,%.6f,%"PRId64",%"PRId64",%.2f\n",
+               best.time.wall / 1000000.0, best.time.user / 1000000.0,
+               best.time.sys / 1000000.0, best.packets, best.bytes,
+               best.bytes / (double)FFMAX(best.time.wall, 1));
+    }
+
+    return ret < 0;
+}
@@ -0,0 +1,743 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Per-stage decode / filter / scale / encode benchmark.
+ *
+ * Times each stage of each stream separately and writes one row per
+ * stream & stage plus one row per input for the whole run. The name,
+ * elapsed, user & sys columns (seconds) are the same as those written by
+ * pi-util/ffperf.py so the output can be fed straight to pi-util/perfcmp.py
+ * (or ffperf.py --csv_in) to compare stage by stage. Further columns give
+ * the frame count, frames/s and per-frame latency percentiles.
+ *
+ * Row names are "<input>" for the whole run and
+ * "<input>:<stream index>:<stage>" for stages.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
+#include "libavcodec/avcodec.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+#include "libavformat/avformat.h"
+#include "libavutil/avstring.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/qsort.h"
+#include "libavutil/time.h"
+#include "libswscale/swscale.h"
+
+enum {
+    STAGE_DECODE,
+    STAGE_FILTER,
+    STAGE_SCALE,
+    STAGE_ENCODE,
+    STAGE_NB
+};
+
+static const char *const stage_names[STAGE_NB] = {
+    "decode", "filter", "scale", "encode"
+};
+
+typedef struct Clock {
+    int64_t wall;
+    int64_t user;
+    int64_t sys;
+} Clock;
+
+typedef struct StageStats {
+    int64_t *samples;           /* us per frame out of the stage */
+    unsigned int nb_samples;
+    unsigned int samples_size;
+    int64_t pending;            /* us spent since the last frame came out */
+    Clock total;
+} StageStats;
+
+typedef struct BenchStream {
+    int index;
+    AVStream *st;
+    AVCodecContext *dec;
+    AVCodecContext *enc;
+    AVFilterGraph *graph;
+    AVFilterContext *src;
+    AVFilterContext *sink;
+    struct SwsContext *sws;
+    AVFrame *frame;
+    AVFrame *filt_frame;
+    AVFrame *scaled;
+    AVPacket *enc_pkt;
+    StageStats stats[STAGE_NB];
+} BenchStream;
+
+typedef struct BenchOptions {
+    const char *vcodec;
+    const char *vf;
+    const char *venc;
+    int width, height;
+    enum AVPixelFormat pix_fmt;
+    int threads;
+    double duration;
+    int repeat;
+    int json;
+    const char *out;
+    const char *prefix;
+} BenchOptions;
+
+typedef struct BenchRun {
+    BenchStream *streams;
+    int nb_streams;
+    Clock total;
+} BenchRun;
+
+static void clock_now(Clock *c)
+{
+#if HAVE_GETRUSAGE
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    c->user = ru.ru_utime.tv_sec * 1000000LL + ru.ru_utime.tv_usec;
+    c->sys  = ru.ru_stime.tv_sec * 1000000LL + ru.ru_stime.tv_usec;
+#else
+    c->user = c->sys = 0;
+#endif
+    c->wall = av_gettime_relative();
+}
+
+static void stage_enter(Clock *t0)
+{
+    clock_now(t0);
+}
+
+static void stage_leave(StageStats *s, const Clock *t0)
+{
+    Clock t1;
+
+    clock_now(&t1);
+    s->total.wall += t1.wall - t0->wall;
+    s->total.user += t1.user - t0->user;
+    s->total.sys  += t1.sys  - t0->sys;
+    s->pending    += t1.wall - t0->wall;
+}
+
+/* A frame (or packet) came out of the stage - charge it with the time
+ * spent in the stage since the previous one */
+static int stage_frame(StageStats *s)
+{
+    if (s->nb_samples >= s->samples_size) {
+        unsigned int size = FFMAX(256, s->samples_size * 2);
+        int64_t *p = av_realloc_array(s->samples, size, sizeof(*p));
+        if (!p)
+            return AVERROR(ENOMEM);
+        s->samples      = p;
+        s->samples_size = size;
+    }
+    s->samples[s->nb_samples++] = s->pending;
+    s->pending = 0;
+    return 0;
+}
+
+static int cmp_int64(const void *a, const void *b)
+{
+    const int64_t va = *(const int64_t *)a, vb = *(const int64_t *)b;
+    return FFDIFFSIGN(va, vb);
+}
+
+/* Nearest-rank percentile in ms; samples must be sorted */
+static double percentile(const StageStats *s, int p)
+{
+    unsigned int i;
+
+    if (!s->nb_samples)
+        return 0;
+    i = (s->nb_samples * (uint64_t)p + 99) / 100;
+    return s->samples[FFMAX(i, 1) - 1] / 1000.0;
+}
+
+static void bench_stream_free(BenchStream *bs)
+{
+    int i;
+
+    avcodec_free_context(&bs->dec);
+    avcodec_free_context(&bs->enc);
+    avfilter_graph_free(&bs->graph);
+    sws_freeContext(bs->sws);
+    av_frame_free(&bs->frame);
+    av_frame_free(&bs->filt_frame);
+    av_frame_free(&bs->scaled);
+    av_packet_free(&bs->enc_pkt);
+    for (i = 0; i < STAGE_NB; i++)
+        av_freep(&bs->stats[i].samples);
+}
+
+static void bench_run_free(BenchRun *run)
+{
+    int i;
+
+    for (i = 0; i < run->nb_streams; i++)
+        bench_stream_free(run->streams + i);
+    av_freep(&run->streams);
+    run->nb_streams = 0;
+}
+
+static int open_decoder(BenchStream *bs, const BenchOptions *opts)
+{
+    const AVCodec *codec = NULL;
+    int ret;
+
+    if (bs->st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && opts->vcodec) {
+        if (!(codec = avcodec_find_decoder_by_name(opts->vcodec))) {
+            av_log(NULL, AV_LOG_ERROR, "Unknown decoder '%s'\n", opts->vcodec);
+            return AVERROR_DECODER_NOT_FOUND;
+        }
+    } else if (!(codec = avcodec_find_decoder(bs->st->codecpar->codec_id))) {
+        av_log(NULL, AV_LOG_WARNING, "No decoder for stream %d\n", bs->index);
+        return 0;
+    }
+
+    if (!(bs->dec = avcodec_alloc_context3(codec)))
+        return AVERROR(ENOMEM);
+    if ((ret = avcodec_parameters_to_context(bs->dec, bs->st->codecpar)) < 0)
+        return ret;
+    bs->dec->pkt_timebase = bs->st->time_base;
+    bs->dec->thread_count = opts->threads;
+    if ((ret = avcodec_open2(bs->dec, codec, NULL)) < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to open decoder for stream %d\n", bs->index);
+        return ret;
+    }
+
+    if (!(bs->frame = av_frame_alloc()) || !(bs->filt_frame = av_frame_alloc()))
+        return AVERROR(ENOMEM);
+    return 0;
+}
+
+/* Built on the first frame as that is when the geometry is known */
+static int init_filter(BenchStream *bs, const AVFrame *frame, const char *desc)
+{
+    AVFilterInOut *outputs = avfilter_inout_alloc();
+    AVFilterInOut *inputs  = avfilter_inout_alloc();
+    AVRational tb = bs->st->time_base;
+    char args[256];
+    int ret;
+
+    if (!(bs->graph = avfilter_graph_alloc()) || !outputs || !inputs) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    snprintf(args, sizeof(args),
+             "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+             frame->width, frame->height, frame->format, tb.num, tb.den,
+             frame->sample_aspect_ratio.num, FFMAX(frame->sample_aspect_ratio.den, 1));
+    if ((ret = avfilter_graph_create_filter(&bs->src, avfilter_get_by_name("buffer"),
+                                            "in", args, NULL, bs->graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(&bs->sink, avfilter_get_by_name("buffersink"),
+                                            "out", NULL, NULL, bs->graph)) < 0)
+        goto end;
+
+    outputs->name       = av_strdup("in");
+    outputs->filter_ctx = bs->src;
+    inputs->name        = av_strdup("out");
+    inputs->filter_ctx  = bs->sink;
+    if ((ret = avfilter_graph_parse_ptr(bs->graph, desc, &inputs, &outputs, NULL)) < 0 ||
+        (ret = avfilter_graph_config(bs->graph, NULL)) < 0)
+        av_log(NULL, AV_LOG_ERROR, "Failed to set up filter graph '%s'\n", desc);
+
+end:
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    return ret;
+}
+
+/* Also opened on the first frame */
+static int init_encoder(BenchStream *bs, const AVFrame *frame, const BenchOptions *opts)
+{
+    const AVCodec *codec = avcodec_find_encoder_by_name(opts->venc);
+    int ret;
+
+    if (!codec) {
+        av_log(NULL, AV_LOG_ERROR, "Unknown encoder '%s'\n", opts->venc);
+        return AVERROR_ENCODER_NOT_FOUND;
+    }
+    if (!(bs->enc = avcodec_alloc_context3(codec)) || !(bs->enc_pkt = av_packet_alloc()))
+        return AVERROR(ENOMEM);
+
+    bs->enc->width               = frame->width;
+    bs->enc->height              = frame->height;
+    bs->enc->pix_fmt             = frame->format;
+    bs->enc->sample_aspect_ratio = frame->sample_aspect_ratio;
+    bs->enc->time_base           = bs->sink ? av_buffersink_get_time_base(bs->sink) :
+                                              bs->st->time_base;
+    bs->enc->framerate           = bs->st->avg_frame_rate;
+    bs->enc->thread_count        = opts->threads;
+
+    if ((ret = avcodec_open2(bs->enc, codec, NULL)) < 0)
+        av_log(NULL, AV_LOG_ERROR, "Failed to open encoder '%s' for %s %dx%d\n",
+               opts->venc, av_get_pix_fmt_name(frame->format), frame->width, frame->height);
+    return ret;
+}
+
+static int encode_frame(BenchStream *bs, const AVFrame *frame)
+{
+    StageStats *s = bs->stats + STAGE_ENCODE;
+    Clock t0;
+    int ret;
+
+    stage_enter(&t0);
+    ret = avcodec_send_frame(bs->enc, frame);
+    stage_leave(s, &t0);
+    if (ret < 0)
+        return ret;
+
+    for (;;) {
+        stage_enter(&t0);
+        ret = avcodec_receive_packet(bs->enc, bs->enc_pkt);
+        stage_leave(s, &t0);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            return 0;
+        if (ret < 0)
+            return ret;
+        av_packet_unref(bs->enc_pkt);
+        if ((ret = stage_frame(s)) < 0)
+            return ret;
+    }
+}
+
+static int scale_encode_frame(BenchStream *bs, AVFrame *frame, const BenchOptions *opts)
+{
+    const int width  = opts->width  ? opts->width  : frame->width;
+    const int height = opts->height ? opts->height : frame->height;
+    const enum AVPixelFormat pix_fmt = opts->pix_fmt != AV_PIX_FMT_NONE ? opts->pix_fmt : frame->format;
+    int ret;
+
+    if (width != frame->width || height != frame->height || pix_fmt != frame->format) {
+        StageStats *s = bs->stats + STAGE_SCALE;
+        Clock t0;
+
+        stage_enter(&t0);
+        bs->sws = sws_getCachedContext(bs->sws, frame->width, frame->height, frame->format,
+                                       width, height, pix_fmt, SWS_BICUBIC, NULL, NULL, NULL);
+        if (!bs->sws) {
+            av_log(NULL, AV_LOG_ERROR, "Failed to set up scaler\n");
+            return AVERROR(EINVAL);
+        }
+        if (!bs->scaled) {
+            if (!(bs->scaled = av_frame_alloc()))
+                return AVERROR(ENOMEM);
+            bs->scaled->format = pix_fmt;
+            bs->scaled->width  = width;
+            bs->scaled->height = height;
+            if ((ret = av_frame_get_buffer(bs->scaled, 0)) < 0)
+                return ret;
+        }
+        /* The encoder may still hold a reference to the last one */
+        if ((ret = av_frame_make_writable(bs->scaled)) < 0)
+            return ret;
+        sws_scale(bs->sws, (const uint8_t * const *)frame->data, frame->linesize, 0,
+                  frame->height, bs->scaled->data, bs->scaled->linesize);
+        stage_leave(s, &t0);
+        if ((ret = stage_frame(s)) < 0)
+            return ret;
+
+        bs->scaled->pts                 = frame->pts;
+        bs->scaled->sample_aspect_ratio = frame->sample_aspect_ratio;
+        frame = bs->scaled;
+    }
+
+    if (!opts->venc)
+        return 0;
+    if (!bs->enc && (ret = init_encoder(bs, frame, opts)) < 0)
+        return ret;
+    return encode_frame(bs, frame);
+}
+
+/* frame == NULL flushes */
+static int filter_frame(BenchStream *bs, AVFrame *frame, const BenchOptions *opts)
+{
+    StageStats *s = bs->stats + STAGE_FILTER;
+    Clock t0;
+    int ret;
+
+    if (!opts->vf)
+        return frame ? scale_encode_frame(bs, frame, opts) : 0;
+
+    if (!bs->graph) {
+        if (!frame)
+            return 0;
+        if ((ret = init_filter(bs, frame, opts->vf)) < 0)
+            return ret;
+    }
+
+    stage_enter(&t0);
+    ret = av_buffersrc_add_frame_flags(bs->src, frame, AV_BUFFERSRC_FLAG_KEEP_REF);
+    stage_leave(s, &t0);
+    if (ret < 0)
+        return ret;
+
+    for (;;) {
+        stage_enter(&t0);
+        ret = av_buffersink_get_frame(bs->sink, bs->filt_frame);
+        stage_leave(s, &t0);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            return 0;
+        if (ret < 0)
+            return ret;
+        if ((ret = stage_frame(s)) >= 0)
+            ret = scale_encode_frame(bs, bs->filt_frame, opts);
+        av_frame_unref(bs->filt_frame);
+        if (ret < 0)
+            return ret;
+    }
+}
+
+/* pkt == NULL flushes */
+static int decode_packet(BenchStream *bs, const AVPacket *pkt, const BenchOptions *opts)
+{
+    StageStats *s = bs->stats + STAGE_DECODE;
+    const int is_video = bs->dec->codec_type == AVMEDIA_TYPE_VIDEO;
+    Clock t0;
+    int ret;
+
+    stage_enter(&t0);
+    ret = avcodec_send_packet(bs->dec, pkt);
+    stage_leave(s, &t0);
+    if (ret < 0 && ret != AVERROR_EOF) {
+        av_log(NULL, AV_LOG_WARNING, "Decode error on stream %d\n", bs->index);
+        return 0;
+    }
+
+    for (;;) {
+        stage_enter(&t0);
+        ret = avcodec_receive_frame(bs->dec, bs->frame);
+        stage_leave(s, &t0);
+        if (ret == AVERROR(EAGAIN))
+            return 0;
+        if (ret == AVERROR_EOF)
+            break;
+        if (ret < 0)
+            return ret;
+        if ((ret = stage_frame(s)) >= 0 && is_video) {
+            bs->frame->pts = bs->frame->best_effort_timestamp;
+            ret = filter_frame(bs, bs->frame, opts);
+        }
+        av_frame_unref(bs->frame);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (!is_video)
+        return 0;
+    if ((ret = filter_frame(bs, NULL, opts)) < 0)
+        return ret;
+    return bs->enc ? encode_frame(bs, NULL) : 0;
+}
+
+static int bench_file(BenchRun *run, const char *filename, const BenchOptions *opts)
+{
+    AVFormatContext *fmt = NULL;
+    AVPacket *pkt = NULL;
+    Clock start, end;
+    int i, ret;
+
+    clock_now(&start);
+
+    if ((ret = avformat_open_input(&fmt, filename, NULL, NULL)) < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Cannot open '%s'\n", filename);
+        return ret;
+    }
+    if ((ret = avformat_find_stream_info(fmt, NULL)) < 0)
+        goto end;
+
+    if (!(run->streams = av_mallocz_array(fmt->nb_streams, sizeof(*run->streams))) ||
+        !(pkt = av_packet_alloc())) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    run->nb_streams = fmt->nb_streams;
+    for (i = 0; i < fmt->nb_streams; i++) {
+        BenchStream *bs = run->streams + i;
+        const enum AVMediaType type = fmt->streams[i]->codecpar->codec_type;
+
+        bs->index = i;
+        bs->st    = fmt->streams[i];
+        if (type == AVMEDIA_TYPE_VIDEO || type == AVMEDIA_TYPE_AUDIO)
+            if ((ret = open_decoder(bs, opts)) < 0)
+                goto end;
+    }
+
+    while ((ret = av_read_frame(fmt, pkt)) >= 0) {
+        BenchStream *bs = run->streams + pkt->stream_index;
+
+        if (opts->duration > 0 && pkt->pts != AV_NOPTS_VALUE &&
+            av_compare_ts(pkt->pts - (bs->st->start_time != AV_NOPTS_VALUE ? bs->st->start_time : 0),
+                          bs->st->time_base,
+                          llrint(opts->duration * 1000), (AVRational){ 1, 1000 }) > 0) {
+            av_packet_unref(pkt);
+            break;
+        }
+        ret = bs->dec ? decode_packet(bs, pkt, opts) : 0;
+        av_packet_unref(pkt);
+        if (ret < 0)
+            goto end;
+    }
+
+    for (i = 0; i < run->nb_streams; i++) {
+        if (run->streams[i].dec && (ret = decode_packet(run->streams + i, NULL, opts)) < 0)
+            goto end;
+    }
+    ret = 0;
+
+end:
+    clock_now(&end);
+    run->total.wall = end.wall - start.wall;
+    run->total.user = end.user - start.user;
+    run->total.sys  = end.sys  - start.sys;
+
+    av_packet_free(&pkt);
+    avformat_close_input(&fmt);
+    if (ret < 0)
+        av_log(NULL, AV_LOG_ERROR, "Benchmark of '%s' failed: %s\n", filename, av_err2str(ret));
+    return ret;
+}
+
+static void print_str(FILE *f, const char *s, int json)
+{
+    const char quote = '"';
+
+    fputc(quote, f);
+    for (; *s; s++) {
+        if (*s == quote)
+            fputs(json ? "\\\"" : "\"\"", f);
+        else if (json && *s == '\\')
+            fputs("\\\\", f);
+        else
+            fputc(*s, f);
+    }
+    fputc(quote, f);
+}
+
+static const char *const columns[] = {
+    "name", "elapsed", "user", "sys", "frames", "fps", "p50_ms", "p90_ms", "p99_ms"
+};
+
+static void print_row(FILE *f, int json, int *first, const char *name, const Clock *c,
+                      const StageStats *s)
+{
+    const double elapsed = c->wall / 1000000.0;
+    double vals[8] = {
+        elapsed, c->user / 1000000.0, c->sys / 1000000.0,
+    };
+    int i;
+
+    if (s) {
+        vals[3] = s->nb_samples;
+        vals[4] = elapsed > 0 ? s->nb_samples / elapsed : 0;
+        vals[5] = percentile(s, 50);
+        vals[6] = percentile(s, 90);
+        vals[7] = percentile(s, 99);
+    }
+
+    if (json) {
+        fputs(*first ? "  {" : ",\n  {", f);
+        fprintf(f, "\"%s\": ", columns[0]);
+        print_str(f, name, 1);
+        for (i = 0; i < FF_ARRAY_ELEMS(vals); i++)
+            fprintf(f, i == 3 ? ", \"%s\": %.0f" : ", \"%s\": %.6f", columns[i + 1], vals[i]);
+        fputc('}', f);
+    } else {
+        print_str(f, name, 0);
+        for (i = 0; i < FF_ARRAY_ELEMS(vals); i++)
+            fprintf(f, i == 3 ? ",%.0f" : ",%.6f", vals[i]);
+        fputc('\n', f);
+    }
+    *first = 0;
+}
+
+static void print_run(FILE *f, const BenchRun *run, const char *name, int json, int *first)
+{
+    int i, j;
+
+    print_row(f, json, first, name, &run->total, NULL);
+    for (i = 0; i < run->nb_streams; i++) {
+        for (j = 0; j < STAGE_NB; j++) {
+            StageStats *s = run->streams[i].stats + j;
+            char sname[1024];
+
+            if (!s->nb_samples)
+                continue;
+            AV_QSORT(s->samples, s->nb_samples, int64_t, cmp_int64);
+            snprintf(sname, sizeof(sname), "%s:%d:%s", name, i, stage_names[j]);
+            print_row(f, json, first, sname, &s->total, s);
+        }
+    }
+}
+
+static void print_summary(const BenchRun *run)
+{
+    const double ctime = (run->total.user + run->total.sys) / 1000000.0;
+    const double elapsed = run->total.wall / 1000000.0;
+    int i, j;
+
+    fprintf(stderr, "... time=%6.2f, cpu=%6.2f (%4.2f%%)\n",
+            elapsed, ctime, elapsed > 0 ? ctime * 100.0 / elapsed : 0);
+    for (i = 0; i < run->nb_streams; i++) {
+        for (j = 0; j < STAGE_NB; j++) {
+            const StageStats *s = run->streams[i].stats + j;
+            if (s->nb_samples)
+                fprintf(stderr, "    %d:%-6s %8u frames %9.2f fps\n", i, stage_names[j],
+                        s->nb_samples, s->nb_samples * 1000000.0 / FFMAX(s->total.wall, 1));
+        }
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] input [input...]\n"
+            "Options:\n"
+            "  -vcodec name     video decoder to use\n"
+            "  -vf graph        video filter graph to time\n"
+            "  -s WxH           scale to this size\n"
+            "  -pix_fmt fmt     scale to this pixel format\n"
+            "  -venc name       video encoder to time\n"
+            "  -threads n       decoder/encoder thread count (default 0 = auto)\n"
+            "  -t secs          stop after this much of each input\n"
+            "  -repeat n        runs per input, the fastest is reported (default 3)\n"
+            "  -prefix path     strip this from input names in the output\n"
+            "  -o file          output file (default stdout)\n"
+            "  -json            JSON rather than CSV output\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opts = {
+        .pix_fmt = AV_PIX_FMT_NONE,
+        .repeat  = 3,
+    };
+    FILE *out = stdout;
+    int first = 1;
+    int i, ret = 0;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        const char *opt = argv[i];
+        const char *arg = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!strcmp(opt, "-json")) {
+            opts.json = 1;
+            continue;
+        }
+        if (!arg) {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+        if (!strcmp(opt, "-vcodec"))
+            opts.vcodec = arg;
+        else if (!strcmp(opt, "-vf"))
+            opts.vf = arg;
+        else if (!strcmp(opt, "-venc"))
+            opts.venc = arg;
+        else if (!strcmp(opt, "-s")) {
+            if (av_parse_video_size(&opts.width, &opts.height, arg) < 0) {
+                fprintf(stderr, "Bad size '%s'\n", arg);
+                return 1;
+            }
+        } else if (!strcmp(opt, "-pix_fmt")) {
+            if ((opts.pix_fmt = av_get_pix_fmt(arg)) == AV_PIX_FMT_NONE) {
+                fprintf(stderr, "Unknown pixel format '%s'\n", arg);
+                return 1;
+            }
+        } else if (!strcmp(opt, "-threads"))
+            opts.threads = atoi(arg);
+        else if (!strcmp(opt, "-t"))
+            opts.duration = atof(arg);
+        else if (!strcmp(opt, "-repeat"))
+            opts.repeat = FFMAX(atoi(arg), 1);
+        else if (!strcmp(opt, "-prefix"))
+            opts.prefix = arg;
+        else if (!strcmp(opt, "-o"))
+            opts.out = arg;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (i >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (opts.out && !(out = fopen(opts.out, "w"))) {
+        fprintf(stderr, "Cannot open '%s'\n", opts.out);
+        return 1;
+    }
+
+    if (opts.json)
+        fputs("[\n", out);
+    else
+        fprintf(out, "%s,%s,%s,%s,%s,%s,%s,%s,%s\n", columns[0], columns[1], columns[2],
+                columns[3], columns[4], columns[5], columns[6], columns[7], columns[8]);
+
+    for (; i < argc; i++) {
+        const char *name = argv[i];
+        BenchRun best = { 0 };
+        int r;
+
+        if (opts.prefix && av_strstart(name, opts.prefix, &name) && !*name)
+            name = argv[i];
+
+        fprintf(stderr, "==== %s\n", name);
+        for (r = 0; r < opts.repeat; r++) {
+            BenchRun run = { 0 };
+
+            if ((ret = bench_file(&run, argv[i], &opts)) < 0) {
+                bench_run_free(&run);
+                break;
+            }
+            print_summary(&run);
+            if (!best.streams || run.total.wall < best.total.wall) {
+                bench_run_free(&best);
+                best = run;
+            } else {
+                bench_run_free(&run);
+            }
+        }
+        if (best.streams)
+            print_run(out, &best, name, opts.json, &first);
+        bench_run_free(&best);
+    }
+
+    if (opts.json)
+        fputs("\n]\n", out);
+    if (out != stdout)
+        fclose(out);
+
+    return ret < 0;
+}
@@ -0,0 +1,279 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Mux interleaving throughput benchmark.
+ *
+ * Muxes synthetic packets for a number of audio and video streams with
+ * av_interleaved_write_frame() into memory and writes one CSV row with the
+ * format, elapsed, user & sys columns (seconds) of tools/ffbench, then the
+ * packet count, the throughput in packets/s and the MD5 of the output.
+ * The streams hand their packets over in bursts and in a pseudo random
+ * order, as independent encoders would, so that the interleaving queue is
+ * exercised; the MD5 allows to check that two builds produce the same
+ * packet order, e.g.
+ *   muxbench -streams 64 -f nut -max_delay 0
+ * where -max_delay 0 disables the forced flushing of the queue so that it
+ * grows as deep as the streams drift apart.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
+#include "libavformat/avformat.h"
+#include "libavutil/log.h"
+#include "libavutil/md5.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+
+typedef struct Clock {
+    int64_t wall;
+    int64_t user;
+    int64_t sys;
+} Clock;
+
+typedef struct BenchResult {
+    Clock time;
+    int64_t packets;
+    uint8_t md5[16];
+} BenchResult;
+
+static void clock_now(Clock *c)
+{
+#if HAVE_GETRUSAGE
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    c->user = ru.ru_utime.tv_sec * 1000000LL + ru.ru_utime.tv_usec;
+    c->sys  = ru.ru_stime.tv_sec * 1000000LL + ru.ru_stime.tv_usec;
+#else
+    c->user = c->sys = 0;
+#endif
+    c->wall = av_gettime_relative();
+}
+
+static int write_md5(void *opaque, uint8_t *buf, int size)
+{
+    av_md5_update(opaque, buf, size);
+    return size;
+}
+
+static int add_streams(AVFormatContext *s, int nb_streams)
+{
+    int i;
+
+    for (i = 0; i < nb_streams; i++) {
+        AVStream *st = avformat_new_stream(s, NULL);
+        AVCodecParameters *par;
+
+        if (!st)
+            return AVERROR(ENOMEM);
+        par = st->codecpar;
+        if (i & 1) {
+            par->codec_type     = AVMEDIA_TYPE_AUDIO;
+            par->codec_id       = AV_CODEC_ID_PCM_S16LE;
+            par->sample_rate    = 48000;
+            par->channels       = 1;
+            par->channel_layout = AV_CH_LAYOUT_MONO;
+            par->format         = AV_SAMPLE_FMT_S16;
+            st->time_base       = (AVRational){ 1, par->sample_rate };
+        } else {
+            par->codec_type     = AVMEDIA_TYPE_VIDEO;
+            par->codec_id       = AV_CODEC_ID_MPEG4;
+            par->width          = 16;
+            par->height         = 16;
+            st->time_base       = (AVRational){ 1, 24 + i };
+        }
+    }
+    return 0;
+}
+
+static int bench_mux(BenchResult *res, AVOutputFormat *fmt, int nb_streams,
+                     int nb_packets, int burst, int64_t max_delay)
+{
+    AVFormatContext *s = NULL;
+    struct AVMD5 *md5 = av_md5_alloc();
+    uint8_t *buf = av_malloc(4096);
+    AVPacket *pkt = av_packet_alloc();
+    int *sent = av_mallocz_array(nb_streams, sizeof(*sent));
+    unsigned seed = 0;
+    Clock t0, t1;
+    int i, left, ret;
+
+    if (!md5 || !buf || !pkt || !sent) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    av_md5_init(md5);
+
+    if ((ret = avformat_alloc_output_context2(&s, fmt, NULL, NULL)) < 0)
+        goto end;
+    s->flags |= AVFMT_FLAG_BITEXACT;
+    if (max_delay >= 0)
+        s->max_interleave_delta = max_delay;
+    if (!(s->pb = avio_alloc_context(buf, 4096, 1, md5, NULL, write_md5, NULL))) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    buf = NULL;
+    if ((ret = add_streams(s, nb_streams)) < 0)
+        goto end;
+
+    clock_now(&t0);
+    if ((ret = avformat_write_header(s, NULL)) < 0)
+        goto end;
+    for (left = nb_streams; left > 0;) {
+        AVStream *st;
+        int audio, size, end;
+
+        /* pick the streams in a fixed pseudo random order, so that they
+         * run ahead of each other like independent encoders would */
+        seed = seed * 1664525 + 1013904223;
+        i = (seed >> 8) % nb_streams;
+        while (sent[i] >= nb_packets)
+            i = (i + 1) % nb_streams;
+
+        st    = s->streams[i];
+        audio = st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO;
+        size  = 16 + i;
+        end   = FFMIN(sent[i] + burst, nb_packets);
+        for (; sent[i] < end; sent[i]++) {
+            if ((ret = av_new_packet(pkt, size)) < 0)
+                goto end;
+            memset(pkt->data, i + sent[i], size);
+            pkt->stream_index = i;
+            pkt->duration     = audio ? 1000 + 8 * i : 1;
+            pkt->pts = pkt->dts = (int64_t)sent[i] * pkt->duration;
+            pkt->flags        = AV_PKT_FLAG_KEY;
+            if ((ret = av_interleaved_write_frame(s, pkt)) < 0)
+                goto end;
+            res->packets++;
+        }
+        left -= sent[i] == nb_packets;
+    }
+    if ((ret = av_write_trailer(s)) < 0)
+        goto end;
+    clock_now(&t1);
+
+    avio_flush(s->pb);
+    av_md5_final(md5, res->md5);
+    res->time.wall = t1.wall - t0.wall;
+    res->time.user = t1.user - t0.user;
+    res->time.sys  = t1.sys  - t0.sys;
+
+end:
+    if (s && s->pb) {
+        av_freep(&s->pb->buffer);
+        avio_context_free(&s->pb);
+    }
+    avformat_free_context(s);
+    av_packet_free(&pkt);
+    av_free(sent);
+    av_free(buf);
+    av_free(md5);
+    if (ret < 0)
+        fprintf(stderr, "Benchmark of '%s' failed: %s\n", fmt->name, av_err2str(ret));
+    return ret;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Options:\n"
+            "  -f format        output format (default nut)\n"
+            "  -streams n       number of streams, alternately video and audio (default 64)\n"
+            "  -packets n       packets per stream (default 2000)\n"
+            "  -burst n         packets handed over per stream at a time (default 8)\n"
+            "  -max_delay us    max_interleave_delta of the muxer (default: lavf default)\n"
+            "  -repeat n        runs, the fastest is reported (default 3)\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    AVOutputFormat *fmt;
+    const char *format = "nut";
+    int nb_streams = 64, nb_packets = 2000, burst = 8, repeat = 3;
+    int64_t max_delay = -1;
+    BenchResult best = { { 0 } };
+    int i, r, ret = 0;
+
+    for (i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *arg = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!arg || opt[0] != '-') {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+        if (!strcmp(opt, "-f"))
+            format = arg;
+        else if (!strcmp(opt, "-streams"))
+            nb_streams = FFMAX(atoi(arg), 1);
+        else if (!strcmp(opt, "-packets"))
+            nb_packets = FFMAX(atoi(arg), 1);
+        else if (!strcmp(opt, "-burst"))
+            burst = FFMAX(atoi(arg), 1);
+        else if (!strcmp(opt, "-max_delay"))
+            max_delay = FFMAX(strtoll(arg, NULL, 10), 0);
+        else if (!strcmp(opt, "-repeat"))
+            repeat = FFMAX(atoi(arg), 1);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    av_log_set_level(AV_LOG_ERROR);
+    if (!(fmt = av_guess_format(format, NULL, NULL))) {
+        fprintf(stderr, "Unknown output format '%s'\n", format);
+        return 1;
+    }
+
+    for (r = 0; r < repeat; r++) {
+        BenchResult res = { { 0 } };
+
+        if ((ret = bench_mux(&res, fmt, nb_streams, nb_packets, burst, max_delay)) < 0)
+            break;
+        fprintf(stderr, "%s: %6.3fs %"PRId64" packets %10.0f packets/s\n",
+                fmt->name, res.time.wall / 1000000.0, res.packets,
+                res.packets * 1000000.0 / FFMAX(res.time.wall, 1));
+        if (!r || res.time.wall < best.time.wall)
+            best = res;
+    }
+    if (ret < 0)
+        return 1;
+
+    printf("name,elapsed,user,sys,packets,pps,md5\n");
+    printf("\"%s\",%.6f,%.6f,%.6f,%"PRId64",%.0f,", fmt->name,
+           best.time.wall / 1000000.0, best.time.user / 1000000.0,
+           best.time.sys / 1000000.0, best.packets,
+           best.packets * 1000000.0 / FFMAX(best.time.wall, 1));
+    for (i = 0; i < 16; i++)
+        printf("%02x", best.md5[i]);
+    printf("\n");
+
+    return 0;
+}